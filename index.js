@@ -39,6 +39,8 @@ var console = require('console');
 
 exports.Canvas = require('lib/Canvas').Canvas;
 exports.Image = require('lib/Image').Image;
+exports.Scene = require('lib/Scene').Scene;
+exports.SceneNode = require('lib/Scene').SceneNode;
 exports.debug = function(s) {
     console.dir(s);
 }
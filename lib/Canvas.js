@@ -7,35 +7,297 @@ global.debug = function(s) {
 var cairo = require('cairo_module'),
     console = require('console');
 
-var CanvasRenderingContext2D = require('CanvasRenderingContext2D').CanvasRenderingContext2D;
+var CanvasRenderingContext2D = require('CanvasRenderingContext2D').CanvasRenderingContext2D,
+    checkMemory = require('Image').checkMemory;
 
-function Canvas(width, height) {
+// images at least this large are written with the parallel PNG encoder
+var PARALLEL_PNG_PIXELS = 1024 * 1024;
+
+/*
+ * options (optional):
+ *   surface - adopt an existing cairo surface instead of creating an image surface.
+ *             The canvas takes ownership and destroys it in destroy().
+ *   mode - 'tiled' for canvases too large to hold in memory.  Drawing is recorded,
+ *          and writeToFile() renders it band by band into tiles kept in a temporary
+ *          file, then streams the PNG out row by row.  Pixel access (getImageData,
+ *          snapshots, shadows) is not available in this mode.
+ *          'banded' for tall images that fit on disk but not comfortably in memory.
+ *          Drawing is recorded, and writeToFile() renders it in horizontal bands
+ *          while a second thread encodes the previous band.  The same restrictions
+ *          on pixel access apply.
+ *   tileSize - for 'tiled' mode, tile width and height in pixels, a multiple of 64 (512).
+ *   bandHeight - for 'banded' mode, rows rendered per band (256).
+ *   deferred - queue drawing instead of performing it, until the pixels are needed
+ *              (writeToFile, getImageData, drawImage of this canvas, snapshots and
+ *              the like, or an explicit flush()).  The queue is optimized before it
+ *              is rasterized, and a canvas that is never read is never rasterized.
+ *   maxPixels - most pixels this canvas may have; larger sizes throw.  Process-wide
+ *               limits are set with Canvas.setMemoryLimits().
+ */
+function Canvas(width, height, options) {
     debug('new Canvas');
-    this.width = width;
-    this.height = height;
-    this.surface = cairo.image_surface_create (cairo.FORMAT_ARGB32, width, height);
+    options = options || {};
+    this._width = width;
+    this._height = height;
+    this._options = options;
+    this._tiled = null;
+    if (options.surface) {
+        this.surface = options.surface;
+    }
+    else {
+        this._admit(width, height);
+        this._createSurface();
+    }
     this._context = null;
     this._patterns = [];
+    this._snapshots = [];
+    // bumped whenever the pixels may change; shared with canvases cropped from this one
+    this._pixels = { version: 0 };
+    // snapshot of the pixels at _pixels.version, for clone() and queued drawImage()
+    this._frozen = null;
 }
 Canvas.prototype.extend({
+    get width() {
+        return this._width;
+    },
+    set width(value) {
+        this.reset(value, this._height);
+    },
+    get height() {
+        return this._height;
+    },
+    set height(value) {
+        this.reset(this._width, value);
+    },
+    // throw if a width x height surface would break the canvas's or the process's limits
+    _admit: function(width, height) {
+        var maxPixels = this._options.maxPixels;
+        if (maxPixels && width * height > maxPixels) {
+            throw 'Canvas - ' + width + 'x' + height + ' is over the limit of ' + maxPixels + ' pixels';
+        }
+        // recordings hold drawing commands, not pixels
+        if (!this._options.mode) {
+            checkMemory(width, height);
+        }
+    },
+    _createSurface: function() {
+        var options = this._options;
+        if (options.mode === 'tiled') {
+            this._tiled = cairo.tiled_surface_create(this._width, this._height, options.tileSize || 512);
+            this.surface = cairo.recording_surface_create(cairo.CONTENT_COLOR_ALPHA, 0, 0, this._width, this._height);
+        }
+        else if (options.mode === 'banded') {
+            this.surface = cairo.recording_surface_create(cairo.CONTENT_COLOR_ALPHA, 0, 0, this._width, this._height);
+        }
+        else {
+            this.surface = cairo.image_surface_create(cairo.FORMAT_ARGB32, this._width, this._height);
+        }
+    },
+    // the pixels may be about to change, so a snapshot cached by clone() is stale
+    _changed: function() {
+        this._pixels.version++;
+    },
+    _destroySurface: function() {
+        if (this._tiled) {
+            cairo.tiled_surface_destroy(this._tiled);
+            this._tiled = null;
+        }
+        cairo.surface_destroy(this.surface);
+    },
     getContext: function(type) {
         if (type !== '2d') {
             return null;
         }
-        if (this._context) {
-            this._context.destroy();
-        }
-//        if (!this._context) {
+        if (!this._context) {
             this._context = new CanvasRenderingContext2D(this);
-//        }
+        }
         return this._context;
     },
+    /**
+     * Returns the canvas to a blank state so it can be reused for another request,
+     * as if it had been newly constructed with the given dimensions.
+     *
+     * If the dimensions are unchanged, the surface is kept and its pixels are zeroed;
+     * otherwise a new surface is allocated.  The 2d context object and its native
+     * context are kept, with their state returned to the defaults.  Patterns created
+     * through the context are destroyed; snapshots are kept.
+     */
+    reset: function(width, height) {
+        width = width === undefined ? this._width : width;
+        height = height === undefined ? this._height : height;
+        this._patterns.each(function(pattern) {
+            pattern.destroy();
+        });
+        this._patterns = [];
+        this._changed();
+        // a recording cannot be cleared, only started over
+        if (width === this._width && height === this._height && !this._options.mode) {
+            cairo.surface_clear(this.surface);
+            if (this._context) {
+                this._context._reset();
+            }
+            return;
+        }
+        this._admit(width, height);
+        this._destroySurface();
+        this._width = width;
+        this._height = height;
+        this._createSurface();
+        if (this._context) {
+            this._context._retarget();
+        }
+    },
+    /**
+     * Rasterizes drawing queued by a deferred canvas.  Only needed before using
+     * canvas.surface directly; getSurface() and the methods that read pixels flush first.
+     */
+    flush: function() {
+        if (this._context) {
+            this._context._flush();
+        }
+    },
+    // the caller may draw on the surface directly
     getSurface: function() {
+        this.flush();
+        this._changed();
         return this.surface;
     },
     writeToFile: function(filename) {
+        this.flush();
+        if (this._tiled) {
+            cairo.tiled_surface_render(this._tiled, this.surface);
+            cairo.tiled_surface_write_to_png(this._tiled, filename);
+            return;
+        }
+        if (this._options.mode === 'banded') {
+            cairo.recording_surface_write_to_png(this.surface, filename, this._width, this._height, this._options.bandHeight || 256);
+            return;
+        }
+        // big images compress on every core; small ones are not worth the threads
+        if (this._width * this._height >= PARALLEL_PNG_PIXELS &&
+            cairo.surface_write_to_png_parallel(this.surface, filename) !== cairo.STATUS_SURFACE_TYPE_MISMATCH) {
+            return;
+        }
         cairo.surface_write_to_png(this.surface, filename);
-
+    },
+    /**
+     * Returns the canvas as a PNG data: URL, encoded in memory.  As in browsers, PNG is
+     * used for any type that is not supported, which is all of them but 'image/png';
+     * quality therefore has no effect.
+     */
+    toDataURL: function(type, quality) {
+        this.flush();
+        return cairo.surface_to_data_url(this.surface);
+    },
+    /**
+     * Returns the bounding box {x, y, width, height} of pixels whose alpha exceeds
+     * alphaThreshold (default 0), or null if the canvas is empty.
+     */
+    contentBounds: function(alphaThreshold) {
+        this.flush();
+        return cairo.surface_content_bounds(this.surface, alphaThreshold || 0);
+    },
+    /**
+     * Copies the pixels of rect ({x, y, width, height}, or the whole canvas if null) into
+     * out, a Uint8Array, in format 'bgra-premul' (cairo's own layout, copied as is),
+     * 'rgba-premul', 'rgba' or 'rgb'.  Returns { x, y, width, height, stride, length };
+     * call without out to find the length it needs.
+     */
+    readPixels: function(rect, format, out) {
+        this.flush();
+        return cairo.surface_read_pixels(this.surface, rect || null, format || 'bgra-premul', out);
+    },
+    /**
+     * Returns a new Canvas that is a view of rect ({x, y, width, height}) within
+     * this canvas.  No pixels are copied; drawing to either canvas is visible in both.
+     * Pixel access (getImageData, readPixels, contentBounds, snapshots and clones) sees
+     * just the rectangle, in the cropped canvas's own coordinates.
+     *
+     * If rect is omitted, the canvas is cropped to its content bounds, and null is
+     * returned if the canvas is empty.
+     */
+    crop: function(rect) {
+        rect = rect || this.contentBounds();
+        if (!rect) {
+            return null;
+        }
+        this.flush();
+        var surface = cairo.surface_create_for_rectangle(this.surface, rect.x, rect.y, rect.width, rect.height);
+        var canvas = new Canvas(rect.width, rect.height, { surface: surface });
+        canvas._pixels = this._pixels;
+        return canvas;
+    },
+    /**
+     * Freezes the current pixels and returns a snapshot handle, for use with
+     * rollback() and clone().  The pixels are copied once; snapshots are released
+     * by destroy().
+     */
+    snapshot: function() {
+        this.flush();
+        var snapshot = cairo.snapshot_create(this.surface);
+        this._snapshots.push(snapshot);
+        return snapshot;
+    },
+    /**
+     * Restores the pixels saved by snapshot().  Drawing state (transform, clip,
+     * path) is not affected.
+     */
+    rollback: function(snapshot) {
+        this.flush();
+        this._changed();
+        cairo.snapshot_restore(snapshot, this.surface);
+    },
+    /**
+     * Returns a new Canvas with the contents of snapshot (or of this canvas now, if
+     * snapshot is omitted).  The clone shares the snapshot's memory and only copies
+     * the pages it draws on, so forking a pre-rendered template per request is cheap.
+     *
+     * Without a snapshot, one is taken on the first call and kept until the canvas is
+     * next drawn on, so cloning an unchanged canvas repeatedly copies its pixels once.
+     * Drawing through the 2d context, reset(), rollback() and getSurface() all count
+     * as drawing, as does drawing on a canvas cropped from this one.
+     *
+     * The clone is checked against the memory limits as a full-size canvas, since
+     * drawing on it may copy every page.
+     */
+    clone: function(snapshot) {
+        if (!snapshot) {
+            snapshot = this._freeze().snapshot;
+        }
+        this._admit(this.width, this.height);
+        return new Canvas(this.width, this.height, { surface: cairo.snapshot_create_surface(snapshot) });
+    },
+    // a snapshot of the current pixels, taken at most once between changes
+    _freeze: function() {
+        this.flush();
+        var frozen = this._frozen;
+        if (!frozen || frozen.version !== this._pixels.version) {
+            this._thaw();
+            frozen = this._frozen = {
+                snapshot: cairo.snapshot_create(this.surface),
+                surface: null,
+                version: this._pixels.version
+            };
+        }
+        return frozen;
+    },
+    // a surface of the current pixels, for drawing that reads them later; it is shared
+    // until the canvas changes, so callers must neither draw on it nor destroy it
+    _frozenSurface: function() {
+        var frozen = this._freeze();
+        if (!frozen.surface) {
+            frozen.surface = cairo.snapshot_create_surface(frozen.snapshot);
+        }
+        return frozen.surface;
+    },
+    _thaw: function() {
+        if (this._frozen) {
+            if (this._frozen.surface) {
+                cairo.surface_destroy(this._frozen.surface);
+            }
+            cairo.snapshot_destroy(this._frozen.snapshot);
+            this._frozen = null;
+        }
     },
     addPattern: function(pattern) {
         this._patterns.push(pattern);
@@ -55,10 +317,47 @@ Canvas.prototype.extend({
         this._patterns.each(function(pattern) {
             pattern.destroy();
         });
+        this._snapshots.each(function(snapshot) {
+            cairo.snapshot_destroy(snapshot);
+        });
+        this._thaw();
         if (this._context) {
             this._context.destroy();
         }
-        cairo.surface_destroy(this.surface);
+        this._destroySurface();
+    }
+});
+
+Canvas.extend({
+    /**
+     * Sets process-wide limits on native memory: { maxPixels, budget }, the most pixels in
+     * one surface and the most bytes held by all surfaces, paths and the like (0 for no
+     * limit).  Allocations that would break them throw; those over the budget only after
+     * decoded images are dropped to make room.  See cairo.memory_stats() for what is in
+     * use; command lists, recordings and the tiles of tiled canvases are not counted.
+     */
+    setMemoryLimits: function(limits) {
+        cairo.memory_set_limits(limits);
+    },
+    /**
+     * Starts capturing a timeline of the native operations of a render: fills, strokes,
+     * text, blurs, image decodes and PNG encodes, with their durations and arguments.
+     * At most maxEvents (100000) are kept.
+     */
+    beginTrace: function(maxEvents) {
+        if (maxEvents === undefined) {
+            cairo.trace_begin();
+        }
+        else {
+            cairo.trace_begin(maxEvents);
+        }
+    },
+    /**
+     * Stops the capture started by beginTrace() and returns it as Chrome trace-event
+     * JSON; save it to a file and open it in chrome://tracing or ui.perfetto.dev.
+     */
+    endTrace: function() {
+        return cairo.trace_end();
     }
 });
 
@@ -272,16 +272,56 @@ function parseColor(s) {
 
 
 
+// most alpha variants kept per gradient; a fade sweeping globalAlpha would otherwise keep one per frame
+var MAX_VARIANTS = 4;
+
 function CanvasGradient(context, pattern) {
     this._context = context;
     this._pattern = pattern;
+    // { alpha, pattern }: copies with their stops' alpha multiplied by a globalAlpha, least
+    // recently used first
+    this._variants = [];
 }
 CanvasGradient.proto = {}.extend({
     addColorStop: function(offset, color) {
         var oColor = parseColor(color);
         cairo.pattern_add_color_stop_rgba(this._pattern, offset, oColor.r/255, oColor.g/255, oColor.b/255, oColor.a/255);
+        this._destroyVariants();
+    },
+    /**
+     * Returns the gradient's pattern with globalAlpha alpha folded into its color stops.
+     * The last few copies are kept, until a stop is added or the gradient is destroyed.
+     */
+    _withAlpha: function(alpha) {
+        if (alpha >= 1) {
+            return this._pattern;
+        }
+        var variants = this._variants,
+            variant = null;
+        for (var i = 0; i < variants.length; i++) {
+            if (variants[i].alpha === alpha) {
+                variant = variants.splice(i, 1)[0];
+                break;
+            }
+        }
+        if (!variant) {
+            variant = { alpha: alpha, pattern: cairo.pattern_create_with_alpha(this._pattern, alpha) };
+            if (variants.length === MAX_VARIANTS) {
+                // a context using it as its source holds its own reference
+                cairo.pattern_destroy(variants.shift().pattern);
+            }
+        }
+        variants.push(variant);
+        return variant.pattern;
+    },
+    _destroyVariants: function() {
+        this._variants.each(function(variant) {
+            cairo.pattern_destroy(variant.pattern);
+        });
+        this._variants = [];
     },
     destroy: function() {
+        this._destroyVariants();
         cairo.pattern_destroy(this._pattern);
     }
 });
@@ -9,6 +9,7 @@ var cairo = require('builtin/cairo'),
     CanvasPathMethods = require('CanvasPathMethods').CanvasPathMethods,
     CanvasGradient = require('CanvasGradient').CanvasGradient,
     CanvasPattern = require('CanvasPattern').CanvasPattern,
+    CommandList = require('CommandList').CommandList,
     CanvasLineStyles = require('CanvasLineStyles').CanvasLineStyles,
     CanvasText = require('CanvasText').CanvasText,
     Image = require('Image').Image,
@@ -122,7 +123,7 @@ function shadow(ctx, fn) {
     fn(c);
 
     if (ctx._shadowBlur) {
-        cairo.surface_blur(cairo.context_get_group_target(c), ctx._shadowBlur);
+        cairo.context_blur_group(c, ctx._shadowBlur);
     }
 
     cairo.context_pop_group_to_source(c);
@@ -135,6 +136,89 @@ function shadow(ctx, fn) {
     cairo.path_destroy(path);
 }
 
+// Set the source for style (a gradient or pattern) or, if there is none, color.  globalAlpha
+// is folded into a color, or into a copy of a gradient's stops; returns false for a pattern,
+// which has to be drawn through drawWithAlpha() instead.
+function setSource(ctx, style, color) {
+    var alpha = ctx._globalAlpha;
+    if (!style) {
+        debug('fill color');
+        cairo.context_set_source_rgba(ctx._context, color.r/255, color.g/255, color.b/255, color.a/255 * alpha);
+        return true;
+    }
+    if ('CanvasGradient' === style.constructor.name) {
+        debug('fill gradient');
+        var pattern = style._withAlpha(alpha);
+        cairo.pattern_set_filter(pattern, patternQualities[ctx._patternQuality]);
+        cairo.context_set_source(ctx._context, pattern);
+        return true;
+    }
+    if ('CanvasPattern' === style.constructor.name) {
+        debug('fill pattern');
+        cairo.context_set_source(ctx._context, style._pattern);
+        cairo.pattern_set_extend(cairo.context_get_source(ctx._context), cairo.EXTEND_REPEAT);
+    }
+    return alpha >= 1;
+}
+
+function setFillSource(ctx) {
+    return setSource(ctx, ctx._fillStyle, ctx._fillColor);
+}
+
+function setStrokeSource(ctx) {
+    return setSource(ctx, ctx._strokeStyle, ctx._strokeColor);
+}
+
+// draw with fn; unless globalAlpha was folded into the source, through a group painted with it
+function drawWithAlpha(ctx, folded, fn) {
+    if (folded) {
+        fn();
+        return;
+    }
+    var c = ctx._context;
+    cairo.context_push_group(c);
+    fn();
+    cairo.context_pop_group_to_source(c);
+    cairo.context_paint_with_alpha(c, ctx._globalAlpha);
+}
+
+// Device-space pixel rectangle a layer is limited to: bounds ({x, y, width, height} in user
+// space) or 'path', the area filling and stroking the current path covers, grown by margin.
+// Null for no limit.
+function layerBounds(ctx, bounds, margin) {
+    if (!bounds) {
+        return null;
+    }
+    var c = ctx._context,
+        rect;
+    if (bounds === 'path') {
+        rect = cairo.context_path_device_extents(c, true);
+    }
+    else {
+        savePath(ctx);
+        cairo.context_rectangle(c, bounds.x, bounds.y, bounds.width, bounds.height);
+        rect = cairo.context_path_device_extents(c, false);
+        restorePath(ctx);
+    }
+    if (!rect) {
+        return { x: 0, y: 0, width: 0, height: 0 };
+    }
+    return { x: rect.x - margin, y: rect.y - margin, width: rect.width + 2 * margin, height: rect.height + 2 * margin };
+}
+
+// clip to a device-space pixel rectangle, which keeps the clip a plain box whatever the CTM
+function clipToDeviceRect(ctx, rect) {
+    var c = ctx._context,
+        matrix = cairo.context_get_matrix(c);
+    cairo.context_identity_matrix(c);
+    savePath(ctx);
+    cairo.context_rectangle(c, rect.x, rect.y, rect.width, rect.height);
+    cairo.context_clip(c);
+    restorePath(ctx);
+    cairo.context_set_matrix(c, matrix);
+    cairo.matrix_destroy(matrix);
+}
+
 function savePath(ctx) {
     ctx._savedPath = cairo.context_copy_path_flat(ctx._context);
     cairo.context_new_path(ctx._context);
@@ -155,24 +239,118 @@ function restorePath(ctx) {
 
 function CanvasRenderingContext2D(canvas) {
     debug('new CanvasRenderingContext2D');
-    var transparent = { r: 0, g: 0, b: 0, a: 1},
-        transparent_black = { r: 0, g: 0, b: 0, a: 0};
     this._canvas = canvas;
     this._context = cairo.context_create(canvas.surface);
-    this._globalAlpha = 1;
-    this._globalCompositeOperation = 'source-over';
-    this._strokeStyle = null;
-    this._strokeColor = transparent;
-    this._fillStyle = null;
-    this._fillColor = transparent;
-    this._patternQuality = 'good';
-    this._shadowOffsetX = this._shadowOffsetY = 0;
-    this._shadowBlur = 0;
-    this._shadowColor = transparent_black;
-    
-    this.initCanvasLineStyles();
-    this.initCanvasText();
+    this._recording = null;
+    this._deferred = null;
+    if (canvas._options.deferred) {
+        this._beginDeferred();
+    }
+    this._initState();
 }
+CanvasRenderingContext2D.prototype.extend({
+    // (re)initialize the JavaScript side of the drawing state
+    _initState: function() {
+        var transparent = { r: 0, g: 0, b: 0, a: 1},
+            transparent_black = { r: 0, g: 0, b: 0, a: 0};
+        this._saveDepth = 0;
+        this._layers = [];
+        this._globalAlpha = 1;
+        this._globalCompositeOperation = 'source-over';
+        this._strokeStyle = null;
+        this._strokeColor = transparent;
+        this._fillStyle = null;
+        this._fillColor = transparent;
+        this._patternQuality = 'good';
+        this._shadowOffsetX = this._shadowOffsetY = 0;
+        this._shadowBlur = 0;
+        this._shadowColor = transparent_black;
+
+        this.initCanvasLineStyles();
+        this.initCanvasText();
+    },
+    // push the JavaScript side of the drawing state to a new native context
+    _applyState: function() {
+        this.lineWidth = this._lineWidth;
+        this.lineCap = this._lineCap;
+        this.lineJoin = this._lineJoin;
+        this.miterLimit = this._miterLimit;
+        this.globalCompositeOperation = this._globalCompositeOperation;
+        if (this._font) {
+            this.font = this._fontString;
+        }
+    },
+    // queue drawing on a command list until the canvas's pixels are needed
+    _beginDeferred: function() {
+        var commands = new CommandList(this._canvas.width, this._canvas.height);
+        this._deferred = {
+            context: this._context,
+            commands: commands
+        };
+        this._context = cairo.commands_get_context(commands._commands);
+    },
+    // discard queued drawing and both native contexts, and start over on the canvas surface
+    _restartDeferred: function() {
+        var deferred = this._deferred;
+        cairo.context_destroy(this._context);
+        deferred.commands.destroy();
+        cairo.context_destroy(deferred.context);
+        this._context = cairo.context_create(this._canvas.surface);
+        this._beginDeferred();
+    },
+    // rasterize queued drawing, if any
+    _flush: function() {
+        var deferred = this._deferred;
+        if (deferred && deferred.commands.length) {
+            deferred.commands.optimize();
+            cairo.commands_replay(deferred.commands._commands, deferred.context);
+            deferred.commands.clear();
+        }
+    },
+    // return to the default drawing state, keeping the native context
+    _reset: function() {
+        if (this._recording) {
+            this.endRecording().destroy();
+        }
+        if (this._deferred) {
+            this._restartDeferred();
+            this._initState();
+            return;
+        }
+        var ctx = this._context;
+        // open layers are dropped, not drawn
+        while (this._layers.length) {
+            var layer = this._layers.pop();
+            while (this._saveDepth > 0) {
+                cairo.context_restore(ctx);
+                this._saveDepth--;
+            }
+            cairo.pattern_destroy(cairo.context_pop_group(ctx));
+            cairo.context_restore(ctx);
+            this._saveDepth = layer.saveDepth;
+        }
+        while (this._saveDepth > 0) {
+            cairo.context_restore(ctx);
+            this._saveDepth--;
+        }
+        cairo.context_reset(ctx);
+        this._initState();
+    },
+    // the canvas has a new surface; the native context has to follow it
+    _retarget: function() {
+        if (this._recording) {
+            this.endRecording().destroy();
+        }
+        if (this._deferred) {
+            this._restartDeferred();
+            this._initState();
+            return;
+        }
+        cairo.context_destroy(this._context);
+        this._context = cairo.context_create(this._canvas.surface);
+        this._initState();
+    }
+});
 CanvasRenderingContext2D.prototype.extend({
     // back-reference to the canvas
     get canvas() {
@@ -182,10 +360,132 @@ CanvasRenderingContext2D.prototype.extend({
     save: function() {
         debug('save');
         cairo.context_save(this._context);
+        this._saveDepth++;
     },
     restore: function() {
         debug('restore');
-        cairo.context_restore(this._context);
+        if (this._saveDepth > 0) {
+            cairo.context_restore(this._context);
+            this._saveDepth--;
+        }
+    },
+    // layers
+    /**
+     * Starts drawing into an offscreen layer, which endLayer() composites onto the canvas
+     * as a whole, for group opacity, blend modes and filters.
+     *
+     * options (all optional):
+     *   bounds - { x, y, width, height } in user space, or 'path' for the area the current
+     *            path covers when filled and stroked.  Drawing outside is cut off, and the
+     *            layer's surface is only that large, rounded out to whole pixels; without
+     *            bounds it is the size of the clip.
+     *   alpha - opacity the layer is composited with, times globalAlpha (1).
+     *   compositeOp - a globalCompositeOperation name (the current one).
+     *   filter - 'blur(Npx)', blurring the layer before it is composited.  The bounds are
+     *            grown by N to leave room for it.
+     *   coverage - true if only the shape of what is drawn matters: the layer holds alpha
+     *              only, and is composited as the fill style current at beginLayer() seen
+     *              through it.  The layer's surface then takes a quarter of the memory.
+     *
+     * Inside the layer, globalAlpha starts at 1 and globalCompositeOperation at
+     * 'source-over'; both are returned to their values when the layer ends.  Layers nest.
+     */
+    beginLayer: function(options) {
+        debug('beginLayer');
+        options = options || {};
+        var ctx = this._context,
+            coverage = !!options.coverage,
+            compositeOp = options.compositeOp || this._globalCompositeOperation,
+            ndx = globalCompositeOperations.indexOf(compositeOp),
+            blur = 0;
+        if (ndx === -1) {
+            throw 'beginLayer - unknown compositeOp ' + compositeOp;
+        }
+        if (options.filter) {
+            var match = /^blur\((\d+(?:\.\d+)?)px\)$/.exec(options.filter);
+            if (!match) {
+                throw 'beginLayer - unsupported filter ' + options.filter;
+            }
+            if (coverage) {
+                throw 'beginLayer - filters need a layer with color';
+            }
+            blur = Math.round(parseFloat(match[1]));
+        }
+        var layer = {
+            context: ctx,
+            saveDepth: this._saveDepth,
+            globalAlpha: this._globalAlpha,
+            globalCompositeOperation: this._globalCompositeOperation,
+            alpha: (options.alpha === undefined ? 1 : options.alpha) * this._globalAlpha,
+            operator: globalCompositeOperations[ndx+1],
+            blur: blur,
+            coverage: coverage,
+            // an alpha-only group can only be taken back as a mask outside of recording
+            mask: coverage && !this._deferred && !this._recording,
+            fillStyle: this._fillStyle,
+            fillColor: this._fillColor
+        };
+        cairo.context_save(ctx);
+        var bounds = layerBounds(this, options.bounds, blur);
+        if (bounds) {
+            clipToDeviceRect(this, bounds);
+        }
+        this._saveDepth = 0;
+        this._globalAlpha = 1;
+        this.globalCompositeOperation = 'source-over';
+        cairo.context_push_group_with_content(ctx, layer.mask ? cairo.CONTENT_ALPHA : cairo.CONTENT_COLOR_ALPHA);
+        this._layers.push(layer);
+    },
+    /**
+     * Ends the layer started by the last beginLayer() and composites it.  Unbalanced
+     * save() calls made inside the layer are closed.
+     */
+    endLayer: function() {
+        debug('endLayer');
+        this._canvas._changed();
+        var layer = this._layers[this._layers.length - 1],
+            ctx = this._context;
+        if (!layer || layer.context !== ctx) {
+            throw 'endLayer - no layer';
+        }
+        this._layers.pop();
+        while (this._saveDepth > 0) {
+            this.restore();
+        }
+        if (layer.blur) {
+            cairo.context_blur_group(ctx, layer.blur);
+        }
+        var fillStyle = this._fillStyle,
+            fillColor = this._fillColor;
+        this._fillStyle = layer.fillStyle;
+        this._fillColor = layer.fillColor;
+        if (layer.mask) {
+            var mask = cairo.context_pop_group(ctx);
+            cairo.context_set_operator(ctx, layer.operator);
+            this._globalAlpha = layer.alpha;
+            drawWithAlpha(this, setFillSource(this), function() {
+                cairo.context_mask(ctx, mask);
+            });
+            cairo.pattern_destroy(mask);
+        }
+        else {
+            if (layer.coverage) {
+                // while recording: keep the fill style where the layer has coverage
+                this._globalAlpha = 1;
+                setFillSource(this);
+                cairo.context_set_operator(ctx, cairo.OPERATOR_IN);
+                cairo.context_paint(ctx);
+            }
+            cairo.context_pop_group_to_source(ctx);
+            cairo.context_set_operator(ctx, layer.operator);
+            cairo.context_paint_with_alpha(ctx, layer.alpha);
+        }
+        this._fillStyle = fillStyle;
+        this._fillColor = fillColor;
+        cairo.context_restore(ctx);
+        this._saveDepth = layer.saveDepth;
+        this._globalAlpha = layer.globalAlpha;
+        this._globalCompositeOperation = layer.globalCompositeOperation;
     },
     // compositing
     get globalAlpha() {
@@ -325,7 +625,12 @@ CanvasRenderingContext2D.prototype.extend({
     // rects
     clearRect: function(x,y, w,h) {
         debug('clearRect ' + [x,y,w,h].join(','));
+        this._canvas._changed();
         var ctx = this._context;
+        // pixel-aligned rectangles are cleared directly
+        if (cairo.context_fill_rectangle(ctx, x,y,w,h, cairo.OPERATOR_CLEAR)) {
+            return;
+        }
         cairo.context_save(ctx);
         savePath(this);
         cairo.context_rectangle(ctx, x,y,w,h);
@@ -336,19 +641,32 @@ CanvasRenderingContext2D.prototype.extend({
     },
     fillRect: function(x,y, w,h) {
         debug('fillRect ' + [x,y,w,h].join(','));
-        var ctx = this._context;
-        savePath(this);
-        cairo.context_rectangle(ctx, x,y,w,h);
-        cairo.context_fill(ctx);
-        restorePath(this);
+        this._canvas._changed();
+        var ctx = this._context,
+            me = this,
+            folded = setFillSource(this);
+        // pixel-aligned rectangles in a solid color are filled directly
+        if (folded && cairo.context_fill_rectangle(ctx, x,y,w,h)) {
+            return;
+        }
+        drawWithAlpha(this, folded, function() {
+            savePath(me);
+            cairo.context_rectangle(ctx, x,y,w,h);
+            cairo.context_fill(ctx);
+            restorePath(me);
+        });
     },
     strokeRect: function(x,y, w,h) {
         debug('strokeRect ' + [x,y,w,h].join(','));
-        var ctx = this._context;
-        savePath(this);
-        cairo.context_rectangle(ctx, x,y,w,h);
-        cairo.context_stroke(ctx);
-        restorePath(this);
+        this._canvas._changed();
+        var ctx = this._context,
+            me = this;
+        drawWithAlpha(this, setStrokeSource(this), function() {
+            savePath(me);
+            cairo.context_rectangle(ctx, x,y,w,h);
+            cairo.context_stroke(ctx);
+            restorePath(me);
+        });
     },
     // [path API (see also CanvasPathMethods)
     beginPath: function() {
@@ -358,54 +676,29 @@ CanvasRenderingContext2D.prototype.extend({
     // fill and apply shadow
     fill: function(preserve) {
         debug('fill');
-        if (this._fillStyle) {
-            if ('CanvasGradient' === this._fillStyle.constructor.name) {
-                debug('fill gradient');
-                cairo.pattern_set_filter(this._fillStyle._pattern, patternQualities[this._patternQuality]);
-                cairo.context_set_source(this._context, this._fillStyle._pattern);
+        this._canvas._changed();
+        var me = this;
+        drawWithAlpha(this, setFillSource(this), function() {
+            if (preserve) {
+                hasShadow(me) ? shadow(me, cairo.context_fill_preserve) : cairo.context_fill_preserve(me._context);
             }
-            else if ('CanvasPattern' === this._fillStyle.constructor.name) {
-                debug('fill pattern');
-                cairo.context_set_source(this._context, this._fillStyle._pattern);
-                cairo.pattern_set_extend(cairo.context_get_source(this._context), cairo.EXTEND_REPEAT);
+            else {
+                hasShadow(me) ? shadow(me, cairo.context_fill) : cairo.context_fill(me._context);
             }
-        }
-        else {
-            var color = this._fillColor;
-            debug('fill color');
-            cairo.context_set_source_rgba(this._context, color.r/255, color.g/255, color.b/255, color.a/255);
-        }
-
-        if (preserve) {
-            hasShadow(this) ? shadow(this, cairo.context_fill_preserve) : cairo.context_fill_preserve(this._context);
-        }
-        else {
-            hasShadow(this) ? shadow(this, cairo.context_fill) : cairo.context_fill(this._context);
-        }
+        });
     },
     stroke: function(preserve) {
         debug('stroke');
-        if (this._strokeStyle) {
-            if ('CanvasGradient' === this._strokeStyle.constructor.name) {
-                cairo.pattern_set_filter(this._strokeStyle._pattern, patternQualities[this._patternQuality]);
-                cairo.context_set_source(this._context, this._strokeStyle._pattern);
+        this._canvas._changed();
+        var me = this;
+        drawWithAlpha(this, setStrokeSource(this), function() {
+            if (preserve) {
+                hasShadow(me) ? shadow(me, cairo.context_stroke_preserve) : cairo.context_stroke_preserve(me._context);
             }
-            else if ('CanvasPattern' === this._strokeStyle.constructor.name) {
-                cairo.context_set_source(this._context, this._strokeStyle._pattern);
-                cairo.pattern_set_extend(cairo.context_get_source(this._context), cairo.EXTEND_REPEAT);
+            else {
+                hasShadow(me) ? shadow(me, cairo.context_stroke) : cairo.context_stroke(me._context);
             }
-        }
-        else {
-            var color = this._strokeColor;
-            cairo.context_set_source_rgba(this._context, color.r/255, color.g/255, color.b/255, color.a/255);
-        }
-
-        if (preserve) {
-            hasShadow(this) ? shadow(this, cairo.context_stroke_preserve) : cairo.context_stroke_preserve(this._context);
-        }
-        else {
-            hasShadow(this) ? shadow(this, cairo.context_stroke) : cairo.context_stroke(this._context);
-        }
+        });
     },
     clip: function() {
         debug('clip');
@@ -421,43 +714,28 @@ CanvasRenderingContext2D.prototype.extend({
     // text (see also CanvasDrawingStyles)
     fillText: function(text, x, y, maxWidth) {
         debug('fillText ' + text + ' ' + x + ',' + y);
-        var ctx = this._context;
+        this._canvas._changed();
+        var ctx = this._context,
+            me = this;
         cairo.context_save(ctx);
-        if (this._fillStyle) {
-            if ('CanvasGradient' === this._fillStyle.constructor.name) {
-                debug('fill gradient');
-                cairo.pattern_set_filter(this._fillStyle._pattern, patternQualities[this._patternQuality]);
-                cairo.context_set_source(this._context, this._fillStyle._pattern);
-            }
-            else if ('CanvasPattern' === this._fillStyle.constructor.name) {
-                debug('fill pattern');
-                cairo.context_set_source(this._context, this._fillStyle._pattern);
-                cairo.pattern_set_extend(cairo.context_get_source(this._context), cairo.EXTEND_REPEAT);
-            }
-        }
-        else {
-            var color = this._fillColor;
-            debug('fill color');
-            cairo.context_set_source_rgba(this._context, color.r/255, color.g/255, color.b/255, color.a/255);
-        }
+        drawWithAlpha(this, setFillSource(this), function() {
+            hasShadow(me) ? shadow(me, cairo.context_fill) : cairo.context_fill(ctx);
 
-        if (false) {
-            hasShadow(this) ? shadow(this, cairo.context_fill_preserve) : cairo.context_fill_preserve(this._context);
-        }
-        else {
-            hasShadow(this) ? shadow(this, cairo.context_fill) : cairo.context_fill(this._context);
-        }
-
-        setTextPath(this, text, x, y);
-        cairo.context_fill(ctx);
+            setTextPath(me, text, x, y);
+            cairo.context_fill(ctx);
+        });
         cairo.context_restore(ctx);
     },
     strokeText: function(text, x, y, maxWidth) {
         debug('strokeText ' + x + ',' + y);
-        var ctx = this._context;
+        this._canvas._changed();
+        var ctx = this._context,
+            me = this;
         cairo.context_save(ctx);
-        setTextPath(this, text, x, y);
-        cairo.context_stroke(ctx);
+        drawWithAlpha(this, setStrokeSource(this), function() {
+            setTextPath(me, text, x, y);
+            cairo.context_stroke(ctx);
+        });
         cairo.context_restore(ctx);
     },
     measureText: function(str) {
@@ -515,11 +793,16 @@ CanvasRenderingContext2D.prototype.extend({
         
         if ('Image' === element.constructor.name) {
             type = 'Image ' + element._filename;
-            surface = element._surface;
+            surface = element.getSurface();
+            if (!surface) {
+                // broken images draw nothing
+                return;
+            }
             sw = element.width;
             sh = element.height;
         }
         else if ('Canvas' === element.constructor.name) {
+            element.flush();
             surface = element.surface;
             sw = element.width;
             sh = element.height;
@@ -528,6 +811,7 @@ CanvasRenderingContext2D.prototype.extend({
             throw 'drawImage - unsupported element type ' + element.constructor.name;
         }
         debug('drawImage ' + type);
+        this._canvas._changed();
         switch (arguments.length) {
             case 9:
                 sx = arguments[1];
@@ -570,6 +854,11 @@ CanvasRenderingContext2D.prototype.extend({
             dy /= fy;
         }
         
+        // a queued draw must see the source canvas as it is now, not as it is when flushed;
+        // the copy is shared by every draw queued until the source changes
+        if ((this._deferred || this._recording) && 'Canvas' === element.constructor.name && !element._options.mode) {
+            surface = element._frozenSurface();
+        }
         cairo.context_set_source_surface(ctx, surface, dx-sx, dy-sy);
         cairo.pattern_set_filter(cairo.context_get_source(ctx), this._patternQuality);
         cairo.context_paint_with_alpha(ctx, this._globalAlpha);
@@ -585,13 +874,83 @@ CanvasRenderingContext2D.prototype.extend({
     },
     getImageData: function(sx, sy, sw, sh) {
         debug('getImageData ' + [sx,sy,sw,sh].join(','));
+        this._canvas.flush();
         return cairo.image_surface_get_data(this._canvas.surface, sx, sy, sw, sh);
     },
     putImageData: function(imagedata, dx,dy, dirtyX, dirtyY, dirtyWidth, dirtyHeight) {
         throw 'Not implemented';
     },
+    /**
+     * Starts recording instead of drawing.  Until endRecording() is called, drawing
+     * operations are collected without touching the canvas.  Styles, the current
+     * path and text measurement work as usual; the transformation and clip start
+     * out as the identity and no clip, relative to wherever the recording is
+     * replayed.
+     */
+    beginRecording: function() {
+        debug('beginRecording');
+        if (this._recording) {
+            throw 'beginRecording - already recording';
+        }
+        var commands = new CommandList(this._canvas.width, this._canvas.height);
+        this._recording = {
+            context: this._context,
+            saveDepth: this._saveDepth,
+            commands: commands
+        };
+        this._context = cairo.commands_get_context(commands._commands);
+        this._saveDepth = 0;
+        this._applyState();
+    },
+    /**
+     * While recording, makes the next value of a kind that reaches cairo a named
+     * parameter, to be filled in by CommandList.renderBatch().  For example
+     *
+     *     ctx.bindParameter('title', 'text');
+     *     ctx.fillText('Title', 10, 20);
+     *
+     * See cairo.commands_bind_parameter() for the kinds.
+     */
+    bindParameter: function(name, kind) {
+        if (!this._recording) {
+            throw 'bindParameter - not recording';
+        }
+        this._recording.commands.bind(name, kind);
+    },
+    /**
+     * Stops recording and returns the recorded drawing as a CommandList, which the
+     * caller owns.  Unbalanced save() calls and layers begun while recording are closed.
+     */
+    endRecording: function() {
+        debug('endRecording');
+        var recording = this._recording;
+        if (!recording) {
+            throw 'endRecording - not recording';
+        }
+        while (this._layers.length && this._layers[this._layers.length - 1].context === this._context) {
+            this.endLayer();
+        }
+        while (this._saveDepth > 0) {
+            this.restore();
+        }
+        cairo.context_destroy(this._context);
+        this._context = recording.context;
+        this._saveDepth = recording.saveDepth;
+        this._recording = null;
+        this._applyState();
+        return recording.commands;
+    },
     //
     destroy: function() {
+        if (this._recording) {
+            this.endRecording().destroy();
+        }
+        if (this._deferred) {
+            cairo.context_destroy(this._context);
+            this._deferred.commands.destroy();
+            this._context = this._deferred.context;
+            this._deferred = null;
+        }
         cairo.context_destroy(this._context);
     }
 });
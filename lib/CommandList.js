@@ -0,0 +1,96 @@
+/** @ignore */
+
+"use strict";
+
+var cairo = require('builtin/cairo'),
+    parseColor = require('CanvasGradient').parseColor;
+
+/*
+ * A recorded sequence of drawing operations, as returned by
+ * CanvasRenderingContext2D.endRecording().  It can be optimized once and then
+ * replayed onto any number of contexts (untransformed ones, if optimize() removed
+ * hidden drawing).
+ */
+function CommandList(width, height) {
+    this._commands = cairo.commands_create(width, height);
+    this._parameters = [];
+}
+CommandList.proto = {}.extend({
+    // number of recorded operations
+    get length() {
+        return cairo.commands_count(this._commands);
+    },
+    /**
+     * Removes operations that would not change the result: redundant state changes,
+     * drawing hidden under a later opaque rectangle, and separate fills that can be
+     * done as one.  Returns what was done, see cairo.commands_optimize().
+     *
+     * Hidden drawing is found on the pixel grid of the canvas the list was recorded
+     * for.  Once any has been removed, the list can only be replayed onto contexts
+     * that are not scaled, rotated or translated by a fraction of a pixel; replay()
+     * throws otherwise.  Lists meant for transformed replays should not be optimized.
+     */
+    optimize: function() {
+        return cairo.commands_optimize(this._commands);
+    },
+    /**
+     * Performs the recorded operations on ctx, a CanvasRenderingContext2D, on top of
+     * its current transformation, clip and other state.  If ctx is itself recording
+     * or deferred, the operations are queued there instead.
+     */
+    replay: function(ctx) {
+        ctx._canvas._changed();
+        cairo.commands_replay(this._commands, ctx._context);
+    },
+    /**
+     * Makes part of the next recorded command of a kind the parameter name; see
+     * cairo.commands_bind_parameter() for the kinds.  Usually called through
+     * CanvasRenderingContext2D.bindParameter().
+     */
+    bind: function(name, kind) {
+        var slot = this._parameters.length;
+        cairo.commands_bind_parameter(this._commands, slot, kind);
+        this._parameters.push({ name: name, kind: kind });
+    },
+    /**
+     * Renders the recording once for each object in parameterSets, in parallel on
+     * native threads, and writes PNG files.  Each object maps parameter names to
+     * values; colors may be given as CSS color strings.
+     *
+     * options:
+     *   filenames - array of output filenames, one per parameter set (required).
+     *   threads - most threads to use (all CPUs).
+     *   compression - zlib level 0-9 (default).
+     *
+     * Returns an array of booleans, true for each file written successfully.
+     */
+    renderBatch: function(width, height, parameterSets, options) {
+        var parameters = this._parameters,
+            jobs = [];
+        parameterSets.each(function(set) {
+            var job = [];
+            parameters.each(function(parameter) {
+                var value = set[parameter.name];
+                if (parameter.kind === 'color' && typeof value === 'string') {
+                    var color = parseColor(value);
+                    value = color ? [ color.r/255, color.g/255, color.b/255, color.a/255 ] : undefined;
+                }
+                job.push(value);
+            });
+            jobs.push(job);
+        });
+        return cairo.commands_render_batch(this._commands, width, height, jobs, options.filenames, options.threads || 0, options.compression === undefined ? -1 : options.compression);
+    },
+    clear: function() {
+        cairo.commands_clear(this._commands);
+        this._parameters = [];
+    },
+    destroy: function() {
+        cairo.commands_destroy(this._commands);
+    }
+});
+CommandList.prototype.extend(CommandList.proto);
+
+exports.extend({
+    CommandList: CommandList
+});
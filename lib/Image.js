@@ -2,23 +2,266 @@
 
 var cairo = require('builtin/cairo');
 
-function Image(filename) {
-    this._filename = filename;
-    this._surface = cairo.image_surface_create_from_png(filename);
-    this._pattern = cairo.pattern_create_for_surface(this._surface);
-    this.width = cairo.image_surface_get_width(this._surface);
-    this.height = cairo.image_surface_get_height(this._surface);
+// images whose background decode has not been collected yet
+var loading = [];
+
+// images holding decoded pixels, least recently used first, and the bytes they hold
+var decoded = [],
+    decodedBytes = 0,
+    cacheLimit = 0;
+
+/*
+ * new Image(filename) reads just the PNG header, for width and height.  The pixels are
+ * decoded the first time the image is drawn or made into a pattern, so an image that is
+ * culled, or only measured for layout, is never decoded.
+ *
+ * new Image() followed by setting src decodes in the background, on the native thread
+ * pool, browser style:
+ *
+ *   var img = new Image();
+ *   img.onload = function() { ... };
+ *   img.onerror = function() { ... };
+ *   img.src = 'thumbnail.png';
+ *
+ * Since there is no event loop, onload and onerror are called from Image.poll(),
+ * which delivers them for the loads that have finished, from Image.wait(), which
+ * waits for all of them, or when the image is first used (width, height, drawImage,
+ * createPattern), which waits for that one.
+ *
+ * With Image.setCacheLimit(), decoded pixels of images not drawn recently are dropped
+ * to stay within a memory budget, and decoded again if they are needed.
+ *
+ * options (optional):
+ *   decoder - 'cairo' to load with cairo's own PNG reader instead of the faster
+ *             built-in decoder, for comparing the two.
+ */
+function Image(filename, options) {
+    options = options || {};
+    this._filename = null;
+    this._decoder = options.decoder;
+    this._load = null;
+    this._surface = null;
+    this._pattern = null;
+    this._broken = false;
+    this._width = 0;
+    this._height = 0;
+    this.complete = true;
+    this.onload = null;
+    this.onerror = null;
+    if (filename !== undefined) {
+        this._filename = filename;
+        var size = cairo.image_png_size(filename);
+        if (size) {
+            this._width = size.width;
+            this._height = size.height;
+        }
+        else {
+            // not a PNG we can size; decode it now, so it fails the way it always has
+            this._decode();
+        }
+    }
 }
 Image.prototype.extend({
+    get src() {
+        return this._filename;
+    },
+    set src(filename) {
+        this._wait();
+        this._release();
+        this._filename = filename;
+        this._broken = false;
+        this._load = cairo.image_load_start(filename);
+        this.complete = false;
+        loading.push(this);
+    },
+    get width() {
+        this._wait();
+        return this._width;
+    },
+    get height() {
+        this._wait();
+        return this._height;
+    },
+    getSurface: function() {
+        this._wait();
+        this._decode();
+        return this._surface;
+    },
+    /**
+     * Returns the image's pattern.  An image whose pattern has been handed out keeps
+     * its pixels until it is destroyed.
+     */
     getPattern: function() {
+        var surface = this.getSurface();
+        if (surface && !this._pattern) {
+            this._pattern = cairo.pattern_create_for_surface(surface);
+        }
         return this._pattern;
     },
-    destroy: function() {
-        cairo.pattern_destroy(this._pattern);
+    // collect a background load, waiting for it if necessary, and call onload or onerror
+    _wait: function() {
+        if (!this._load) {
+            return;
+        }
+        var me = this,
+            load = this._load;
+        this._load = null;
+        loading = loading.filter(function(image) {
+            return image !== me;
+        });
+        var ok = this._loaded(cairo.image_load_finish(load));
+        if (ok && this.onload) {
+            this.onload();
+        }
+        else if (!ok && this.onerror) {
+            this.onerror();
+        }
+    },
+    // decode the pixels if they are not in memory, and mark them most recently used
+    _decode: function() {
+        if (this._surface) {
+            var me = this;
+            decoded = decoded.filter(function(image) {
+                return image !== me;
+            });
+            decoded.push(this);
+            return;
+        }
+        if (this._broken || this._filename === null) {
+            return;
+        }
+        checkMemory(this._width, this._height);
+        this._loaded(this._decoder === 'cairo' ?
+            cairo.image_surface_create_from_png(this._filename) :
+            cairo.image_surface_decode_png(this._filename));
+    },
+    _loaded: function(surface) {
+        this.complete = true;
+        if (cairo.surface_status(surface) !== cairo.STATUS_SUCCESS) {
+            cairo.surface_destroy(surface);
+            this._broken = true;
+            return false;
+        }
+        this._surface = surface;
+        this._width = cairo.image_surface_get_width(surface);
+        this._height = cairo.image_surface_get_height(surface);
+        decoded.push(this);
+        decodedBytes += this._bytes();
+        evict(this);
+        return true;
+    },
+    _bytes: function() {
+        return this._width * this._height * 4;
+    },
+    // drop the decoded pixels; width and height are kept
+    _evict: function() {
+        var me = this;
+        decoded = decoded.filter(function(image) {
+            return image !== me;
+        });
+        decodedBytes -= this._bytes();
+        if (this._pattern) {
+            cairo.pattern_destroy(this._pattern);
+            this._pattern = null;
+        }
         cairo.surface_destroy(this._surface);
+        this._surface = null;
+    },
+    _release: function() {
+        if (this._surface) {
+            this._evict();
+        }
+        this._width = 0;
+        this._height = 0;
+    },
+    destroy: function() {
+        this._wait();
+        this._release();
+    }
+});
+
+// drop the least recently used pixels until the cache is within its limit, sparing keep
+function evict(keep) {
+    if (!cacheLimit) {
+        return;
+    }
+    decoded.filter(function(image) {
+        return image !== keep && !image._pattern;
+    }).each(function(image) {
+        if (decodedBytes > cacheLimit) {
+            image._evict();
+        }
+    });
+}
+
+/*
+ * Throws if a width x height surface would break the limits set with
+ * cairo.memory_set_limits(), after dropping decoded images to make room if that helps.
+ */
+function checkMemory(width, height) {
+    var refusal = cairo.memory_check(width, height);
+    // evicting images cannot make a surface over maxPixels fit
+    if (refusal && refusal.limit === 'budget' && Image.releaseMemory()) {
+        refusal = cairo.memory_check(width, height);
+    }
+    if (refusal) {
+        throw refusal.message;
+    }
+}
+
+Image.extend({
+    /**
+     * Calls onload or onerror for background loads that have finished, without
+     * waiting for the rest.  Returns the number still in progress.
+     */
+    poll: function() {
+        loading.filter(function(image) {
+            return cairo.image_load_done(image._load);
+        }).each(function(image) {
+            image._wait();
+        });
+        return loading.length;
+    },
+    /**
+     * Waits for every background load to finish, calling onload or onerror for each.
+     */
+    wait: function() {
+        while (loading.length) {
+            loading[0]._wait();
+        }
+    },
+    /**
+     * Limits the memory held by decoded images to about bytes (0, the default, for no
+     * limit).  Images are dropped least recently drawn first; images whose pattern has
+     * been handed out are kept.
+     */
+    setCacheLimit: function(bytes) {
+        cacheLimit = bytes;
+        evict(null);
+    },
+    /**
+     * Drops the decoded pixels of every image that can decode them again.  Returns the
+     * number of bytes released.
+     */
+    releaseMemory: function() {
+        var before = decodedBytes;
+        decoded.filter(function(image) {
+            return !image._pattern;
+        }).each(function(image) {
+            image._evict();
+        });
+        return before - decodedBytes;
+    },
+    /**
+     * Returns { images, bytes }: the images holding decoded pixels, and how much memory
+     * they hold.
+     */
+    cacheStats: function() {
+        return { images: decoded.length, bytes: decodedBytes };
     }
 });
 
 exports.extend({
-    Image: Image
+    Image: Image,
+    checkMemory: checkMemory
 });
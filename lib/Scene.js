@@ -0,0 +1,414 @@
+/** @ignore */
+
+"use strict";
+
+var cairo = require('builtin/cairo');
+
+var debug = global.debug;
+
+/*
+ * A node of a retained-mode Scene.
+ *
+ * Node types and their properties (all optional unless noted):
+ *   all     - visible (true), transform ([a, b, c, d, e, f], applied to the node and
+ *             its children).
+ *   'group' - a container; add() children to it.
+ *   'rect'  - x, y, width, height, fillStyle, strokeStyle, lineWidth.
+ *   'path'  - path (required; function(ctx) that builds the path with the context's
+ *             path methods), fillStyle, strokeStyle, lineWidth.
+ *   'text'  - text (required), x, y, font, textAlign, textBaseline, fillStyle.
+ *   'image' - image (required; an Image or Canvas), x, y, width, height.
+ *
+ * Properties must be changed through set(), so the scene knows what to redraw.
+ */
+function SceneNode(type, properties) {
+    this._type = type;
+    this._scene = null;
+    this._parent = null;
+    this._children = type === 'group' ? [] : null;
+    // device-space {x, y, width, height} last drawn, or null if unknown or nothing
+    this._bounds = null;
+    this.visible = true;
+    this.transform = null;
+    this.extend(properties || {});
+}
+
+function applyTransform(ctx, node) {
+    var t = node.transform;
+    if (t) {
+        ctx.transform(t[0], t[1], t[2], t[3], t[4], t[5]);
+    }
+}
+
+// run fn with the transforms of node's ancestors applied
+function withAncestorTransforms(ctx, node, fn) {
+    var chain = [];
+    for (var n = node._parent; n; n = n._parent) {
+        chain.unshift(n);
+    }
+    ctx.save();
+    chain.each(function(n) {
+        applyTransform(ctx, n);
+    });
+    fn();
+    ctx.restore();
+}
+
+function applyTextStyle(ctx, node) {
+    if (node.font) {
+        ctx.font = node.font;
+    }
+    ctx.textAlign = node.textAlign || 'start';
+    ctx.textBaseline = node.textBaseline || 'alphabetic';
+}
+
+// build the path whose extents bound what the node draws
+function outline(ctx, node) {
+    var x = node.x || 0,
+        y = node.y || 0;
+    ctx.beginPath();
+    switch (node._type) {
+        case 'rect':
+            ctx.rect(x, y, node.width || 0, node.height || 0);
+            break;
+        case 'path':
+            node.path(ctx);
+            break;
+        case 'text':
+            applyTextStyle(ctx, node);
+            var m = ctx.measureText(node.text);
+            ctx.rect(x - m.actualBoundingBoxLeft, y - m.actualBoundingBoxAscent,
+                     m.actualBoundingBoxLeft + m.actualBoundingBoxRight,
+                     m.actualBoundingBoxAscent + m.actualBoundingBoxDescent);
+            break;
+        case 'image':
+            ctx.rect(x, y, node.width || node.image.width, node.height || node.image.height);
+            break;
+    }
+}
+
+// compute and cache the bounds of node and its descendants; transforms above node are applied
+function computeBounds(ctx, node) {
+    if (!node.visible) {
+        node._bounds = null;
+        return;
+    }
+    ctx.save();
+    applyTransform(ctx, node);
+    if (node._children) {
+        node._children.each(function(child) {
+            computeBounds(ctx, child);
+        });
+        node._bounds = unionBounds(node._children);
+    }
+    else {
+        var stroked = !!node.strokeStyle && (node._type === 'rect' || node._type === 'path');
+        outline(ctx, node);
+        if (stroked) {
+            ctx.lineWidth = node.lineWidth || 1;
+        }
+        node._bounds = cairo.context_path_device_extents(ctx._context, stroked);
+        ctx.beginPath();
+    }
+    ctx.restore();
+}
+
+function unionBounds(nodes) {
+    var x1 = Infinity, y1 = Infinity, x2 = -Infinity, y2 = -Infinity;
+    nodes.each(function(node) {
+        var b = node._bounds;
+        if (b) {
+            x1 = Math.min(x1, b.x);
+            y1 = Math.min(y1, b.y);
+            x2 = Math.max(x2, b.x + b.width);
+            y2 = Math.max(y2, b.y + b.height);
+        }
+    });
+    return x1 < x2 ? { x: x1, y: y1, width: x2 - x1, height: y2 - y1 } : null;
+}
+
+// add everything node and its descendants were drawn over to the damage region
+function damageTree(damage, node) {
+    if (node._children) {
+        node._children.each(function(child) {
+            damageTree(damage, child);
+        });
+    }
+    else if (node._bounds) {
+        cairo.region_union_rectangle(damage, node._bounds);
+    }
+}
+
+function forgetBounds(node) {
+    node._bounds = null;
+    if (node._children) {
+        node._children.each(forgetBounds);
+    }
+}
+
+function fillAndStroke(ctx, node) {
+    if (node.fillStyle) {
+        ctx.fillStyle = node.fillStyle;
+        ctx.fill(true);
+    }
+    if (node.strokeStyle) {
+        ctx.strokeStyle = node.strokeStyle;
+        ctx.lineWidth = node.lineWidth || 1;
+        ctx.stroke(true);
+    }
+    ctx.beginPath();
+}
+
+function paint(ctx, node) {
+    var x = node.x || 0,
+        y = node.y || 0;
+    switch (node._type) {
+        case 'rect':
+            ctx.beginPath();
+            ctx.rect(x, y, node.width || 0, node.height || 0);
+            fillAndStroke(ctx, node);
+            break;
+        case 'path':
+            ctx.beginPath();
+            node.path(ctx);
+            fillAndStroke(ctx, node);
+            break;
+        case 'text':
+            applyTextStyle(ctx, node);
+            if (node.fillStyle) {
+                ctx.fillStyle = node.fillStyle;
+            }
+            ctx.fillText(node.text, x, y);
+            break;
+        case 'image':
+            if (node.width || node.height) {
+                ctx.drawImage(node.image, x, y, node.width || node.image.width, node.height || node.image.height);
+            }
+            else {
+                ctx.drawImage(node.image, x, y);
+            }
+            break;
+    }
+}
+
+function drawNode(ctx, node, damage, stats) {
+    if (!node.visible) {
+        return;
+    }
+    if (!node._children && !node._bounds) {
+        // not drawn before; find out where it goes
+        computeBounds(ctx, node);
+        if (!node._bounds) {
+            return;
+        }
+    }
+    if (node._bounds && cairo.region_contains_rectangle(damage, node._bounds) === cairo.REGION_OVERLAP_OUT) {
+        stats.skipped++;
+        return;
+    }
+    ctx.save();
+    applyTransform(ctx, node);
+    if (node._children) {
+        node._children.each(function(child) {
+            drawNode(ctx, child, damage, stats);
+        });
+        node._bounds = unionBounds(node._children);
+    }
+    else {
+        paint(ctx, node);
+        stats.drawn++;
+    }
+    ctx.restore();
+}
+
+SceneNode.prototype.extend({
+    get type() {
+        return this._type;
+    },
+    get parent() {
+        return this._parent;
+    },
+    get children() {
+        return this._children;
+    },
+    /**
+     * Adds node as the last (topmost) child of this group and returns it.
+     */
+    add: function(node) {
+        if (!this._children) {
+            throw 'SceneNode.add - not a group';
+        }
+        if (node._parent) {
+            node.remove();
+        }
+        node._parent = this;
+        this._children.push(node);
+        node._attach(this._scene);
+        node._changed();
+        return node;
+    },
+    remove: function() {
+        var node = this,
+            parent = this._parent;
+        if (!parent) {
+            return;
+        }
+        this._addDamage();
+        parent._children = parent._children.filter(function(child) {
+            return child !== node;
+        });
+        parent._forgetAncestorBounds();
+        this._parent = null;
+        this._attach(null);
+        forgetBounds(this);
+    },
+    /**
+     * Changes properties of the node; the area it covered before and after is redrawn
+     * by the next Scene.redraw().
+     */
+    set: function(properties) {
+        this._addDamage();
+        this.extend(properties);
+        this._changed();
+        return this;
+    },
+    _attach: function(scene) {
+        this._scene = scene;
+        if (this._children) {
+            this._children.each(function(child) {
+                child._attach(scene);
+            });
+        }
+    },
+    _addDamage: function() {
+        if (this._scene) {
+            damageTree(this._scene._damage, this);
+        }
+    },
+    _forgetAncestorBounds: function() {
+        for (var n = this; n; n = n._parent) {
+            n._bounds = null;
+        }
+    },
+    _changed: function() {
+        forgetBounds(this);
+        this._forgetAncestorBounds();
+        if (this._scene) {
+            this._scene._pending.push(this);
+        }
+    }
+});
+
+/*
+ * A retained-mode scene drawn onto a canvas through its 2d context.
+ *
+ * Changes to nodes record the device-space area they covered before and after as
+ * damage, and redraw() repaints only the damaged area, skipping nodes (and whole
+ * groups) that lie outside it.  So a one-widget update of a dashboard costs about
+ * what drawing that widget costs, not a full frame.
+ *
+ * options:
+ *   background - CSS color the damaged area is filled with before repainting
+ *                (default: cleared to transparent).
+ */
+function Scene(canvas, options) {
+    debug('new Scene');
+    options = options || {};
+    this._canvas = canvas;
+    this._damage = cairo.region_create();
+    this._pending = [];
+    this._root = new SceneNode('group');
+    this._root._attach(this);
+    this.background = options.background || null;
+    this.invalidate();
+}
+Scene.prototype.extend({
+    get root() {
+        return this._root;
+    },
+    add: function(node) {
+        return this._root.add(node);
+    },
+    /**
+     * Marks rect ({x, y, width, height}, in device pixels) for repainting, or the
+     * whole canvas if rect is omitted.
+     */
+    invalidate: function(rect) {
+        cairo.region_union_rectangle(this._damage, rect || { x: 0, y: 0, width: this._canvas.width, height: this._canvas.height });
+    },
+    /**
+     * Repaints the damaged area.  Returns { rectangles, drawn, skipped }: the number
+     * of rectangles in the damage region, nodes painted, and nodes or groups culled.
+     */
+    redraw: function() {
+        var ctx = this._canvas.getContext('2d'),
+            damage = this._damage,
+            stats = { rectangles: 0, drawn: 0, skipped: 0 };
+
+        // the scene's styles are not the caller's
+        var saved = {
+            fillStyle: ctx.fillStyle,
+            strokeStyle: ctx.strokeStyle,
+            lineWidth: ctx.lineWidth,
+            font: ctx.font,
+            textAlign: ctx.textAlign,
+            textBaseline: ctx.textBaseline
+        };
+        ctx.save();
+        ctx.resetTransform();
+
+        // where changed nodes are now
+        this._pending.each(function(node) {
+            if (node._scene) {
+                withAncestorTransforms(ctx, node, function() {
+                    computeBounds(ctx, node);
+                });
+                damageTree(damage, node);
+            }
+        });
+        this._pending = [];
+
+        if (!cairo.region_is_empty(damage)) {
+            this._paint(ctx, damage, stats);
+        }
+        ctx.restore();
+        ctx.fillStyle = saved.fillStyle;
+        ctx.strokeStyle = saved.strokeStyle;
+        ctx.lineWidth = saved.lineWidth;
+        ctx.font = saved.font;
+        ctx.textAlign = saved.textAlign;
+        ctx.textBaseline = saved.textBaseline;
+
+        cairo.region_destroy(damage);
+        this._damage = cairo.region_create();
+        return stats;
+    },
+    _paint: function(ctx, damage, stats) {
+        stats.rectangles = cairo.region_num_rectangles(damage);
+        ctx.beginPath();
+        for (var i = 0; i < stats.rectangles; i++) {
+            var r = cairo.region_get_rectangle(damage, i);
+            ctx.rect(r.x, r.y, r.width, r.height);
+        }
+        ctx.clip();
+        ctx.beginPath();
+        if (this.background) {
+            ctx.fillStyle = this.background;
+            ctx.fillRect(0, 0, this._canvas.width, this._canvas.height);
+        }
+        else {
+            ctx.clearRect(0, 0, this._canvas.width, this._canvas.height);
+        }
+        this._root._children.each(function(node) {
+            drawNode(ctx, node, damage, stats);
+        });
+    },
+    destroy: function() {
+        cairo.region_destroy(this._damage);
+    }
+});
+
+exports.extend({
+    Scene: Scene,
+    SceneNode: SceneNode
+});
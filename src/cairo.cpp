@@ -12,7 +12,22 @@
  */
 #include "SilkJS.h"
 #include <stdint.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <zlib.h>
+#include <pthread.h>
+#include <time.h>
 #include <cairo/cairo.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
 
 ////////////////////////// MISC
 
@@ -32,2859 +47,7321 @@ static JSVAL status_to_string(JSARGS args) {
     return String::New(cairo_status_to_string((cairo_status_t)args[0]->IntegerValue()));
 }
 
-////////////////////////// SURFACE
+// Getters that accept an optional "out" argument write their results into a caller
+// supplied Float64Array instead of allocating a new JavaScript object per call.
+// Returns the array's storage, or NULL if v is not a Float64Array of at least count elements.
+static double *float64_array_data(JSVAL v, int count) {
+    if (!v->IsObject()) {
+        return NULL;
+    }
+    JSOBJ o = v->ToObject();
+    if (!o->HasIndexedPropertiesInExternalArrayData()) {
+        return NULL;
+    }
+    if (o->GetIndexedPropertiesExternalArrayDataType() != kExternalDoubleArray) {
+        return NULL;
+    }
+    if (o->GetIndexedPropertiesExternalArrayDataLength() < count) {
+        return NULL;
+    }
+    return (double *) o->GetIndexedPropertiesExternalArrayData();
+}
+
+// Returns the number of elements in a Float64Array, or -1 if v is not one.
+static int float64_array_length(JSVAL v) {
+    if (float64_array_data(v, 0) == NULL) {
+        return -1;
+    }
+    return v->ToObject()->GetIndexedPropertiesExternalArrayDataLength();
+}
+
+// Throws the exception used by getters when their out argument is unsuitable.
+static JSVAL throw_bad_out_array(const char *fn, int count) {
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%s: out argument must be a Float64Array of at least %d elements", fn, count);
+    return ThrowException(String::New(msg));
+}
+
+// A string whose characters V8 reads in place from a malloc'd buffer, freed with the string.
+class MallocAsciiString : public String::ExternalAsciiStringResource {
+public:
+    MallocAsciiString(char *data, size_t length) : data_(data), length_(length) {}
+    ~MallocAsciiString() {
+        free(data_);
+    }
+    const char *data() const {
+        return data_;
+    }
+    size_t length() const {
+        return length_;
+    }
+private:
+    char *data_;
+    size_t length_;
+};
+
+////////////////////////// MEMORY ACCOUNTING
+
+// Live object counts and sizes, by type, for everything handed to JavaScript.  Surfaces,
+// patterns, scaled fonts and font faces carry a MemoryRecord as cairo user data, whose
+// destroy callback runs when cairo frees the object, whatever thread drops the last
+// reference.  Paths, regions, matrices and font options have no user data and are counted
+// by their create and destroy functions, as are snapshots, whose bytes are the size of their
+// temporary file.  With debug on, each record also keeps the
+// JavaScript stack that allocated it, and live records are kept in a list for
+// memory_live_objects(), for leak hunting.
+enum MemoryType {
+    MEMORY_SURFACE,
+    MEMORY_PATTERN,
+    MEMORY_PATH,
+    MEMORY_SCALED_FONT,
+    MEMORY_FONT_FACE,
+    MEMORY_REGION,
+    MEMORY_MATRIX,
+    MEMORY_FONT_OPTIONS,
+    MEMORY_SNAPSHOT,
+    MEMORY_TYPES
+};
+
+static const char *memory_type_names[MEMORY_TYPES] = {
+    "surfaces", "patterns", "paths", "scaledFonts", "fontFaces", "regions", "matrices", "fontOptions", "snapshots"
+};
+
+// surfaces by format; the last is everything that is not an image surface
+static const char *memory_format_names[] = { "argb32", "rgb24", "a8", "a1", "rgb16_565", "other" };
+#define MEMORY_FORMATS 6
+
+// surfaces by size: under 64KB, 1MB, 16MB, and the rest
+static const char *memory_size_names[] = { "small", "medium", "large", "huge" };
+#define MEMORY_SIZES 4
+
+struct MemoryCounter {
+    long count;
+    long bytes;
+    long peakBytes;
+};
+
+struct MemoryRecord {
+    void *object;
+    int type;
+    int format;
+    int size;
+    long bytes;
+    char *site;
+    MemoryRecord *prev;
+    MemoryRecord *next;
+};
+
+static MemoryCounter memory_counters[MEMORY_TYPES];
+static MemoryCounter memory_formats[MEMORY_FORMATS];
+static MemoryCounter memory_sizes[MEMORY_SIZES];
+static bool memory_debug_enabled = false;
+static MemoryRecord *memory_live = NULL;
+static pthread_mutex_t memory_lock = PTHREAD_MUTEX_INITIALIZER;
+static cairo_user_data_key_t memory_key;
+
+static void memory_count(MemoryCounter *counter, long count, long bytes) {
+    __sync_fetch_and_add(&counter->count, count);
+    long total = __sync_add_and_fetch(&counter->bytes, bytes);
+    for (long peak = counter->peakBytes; total > peak; peak = counter->peakBytes) {
+        __sync_bool_compare_and_swap(&counter->peakBytes, peak, total);
+    }
+}
+
+// "function (script:line) < caller (script:line) ..." for the innermost frames
+static char *memory_site() {
+    Local<StackTrace> trace = StackTrace::CurrentStackTrace(6);
+    char site[1024];
+    size_t used = 0;
+    site[0] = '\0';
+    for (int i = 0; i < trace->GetFrameCount() && used < sizeof(site); i++) {
+        Local<StackFrame> frame = trace->GetFrame(i);
+        String::Utf8Value fn(frame->GetFunctionName());
+        String::Utf8Value script(frame->GetScriptName());
+        used += snprintf(site + used, sizeof(site) - used, "%s%s (%s:%d)",
+            i ? " < " : "", *fn && **fn ? *fn : "<anonymous>", *script ? *script : "?", frame->GetLineNumber());
+    }
+    return strdup(site);
+}
+
+static MemoryRecord *memory_track(int type, void *object, long bytes, int format, int size) {
+    MemoryRecord *record = new MemoryRecord;
+    record->object = object;
+    record->type = type;
+    record->format = format;
+    record->size = size;
+    record->bytes = bytes;
+    record->site = NULL;
+    record->prev = record->next = NULL;
+    memory_count(&memory_counters[type], 1, bytes);
+    if (format >= 0) {
+        memory_count(&memory_formats[format], 1, bytes);
+        memory_count(&memory_sizes[size], 1, bytes);
+    }
+    if (memory_debug_enabled) {
+        record->site = memory_site();
+        pthread_mutex_lock(&memory_lock);
+        record->next = memory_live;
+        if (memory_live) {
+            memory_live->prev = record;
+        }
+        memory_live = record;
+        pthread_mutex_unlock(&memory_lock);
+    }
+    return record;
+}
+
+static void memory_release(void *data) {
+    MemoryRecord *record = (MemoryRecord *) data;
+    memory_count(&memory_counters[record->type], -1, -record->bytes);
+    if (record->format >= 0) {
+        memory_count(&memory_formats[record->format], -1, -record->bytes);
+        memory_count(&memory_sizes[record->size], -1, -record->bytes);
+    }
+    if (record->site) {
+        pthread_mutex_lock(&memory_lock);
+        if (record->prev) {
+            record->prev->next = record->next;
+        }
+        else {
+            memory_live = record->next;
+        }
+        if (record->next) {
+            record->next->prev = record->prev;
+        }
+        pthread_mutex_unlock(&memory_lock);
+        free(record->site);
+    }
+    delete record;
+}
+
+// For types without user data: count an object, or forget one being destroyed.
+static void memory_track_untagged(int type, void *object, long bytes) {
+    if (memory_debug_enabled) {
+        memory_track(type, object, bytes, -1, 0);
+    }
+    else {
+        memory_count(&memory_counters[type], 1, bytes);
+    }
+}
+
+static void memory_untrack_untagged(int type, void *object, long bytes) {
+    if (memory_live) {
+        pthread_mutex_lock(&memory_lock);
+        MemoryRecord *record = memory_live;
+        while (record && (record->object != object || record->type != type)) {
+            record = record->next;
+        }
+        pthread_mutex_unlock(&memory_lock);
+        if (record) {
+            memory_release(record);
+            return;
+        }
+    }
+    memory_count(&memory_counters[type], -1, -bytes);
+}
+
+// The track_* functions return their argument, to wrap creation calls.  Objects already
+// tracked, and nil objects, are left alone.
+static cairo_surface_t *track_surface(cairo_surface_t *surface) {
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS || cairo_surface_get_user_data(surface, &memory_key)) {
+        return surface;
+    }
+    long bytes = 0;
+    int format = MEMORY_FORMATS - 1;
+    if (cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE) {
+        bytes = (long) cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+        switch (cairo_image_surface_get_format(surface)) {
+            case CAIRO_FORMAT_ARGB32: format = 0; break;
+            case CAIRO_FORMAT_RGB24: format = 1; break;
+            case CAIRO_FORMAT_A8: format = 2; break;
+            case CAIRO_FORMAT_A1: format = 3; break;
+            case CAIRO_FORMAT_RGB16_565: format = 4; break;
+            default: break;
+        }
+    }
+    int size = bytes < 64 * 1024 ? 0 : bytes < 1024 * 1024 ? 1 : bytes < 16 * 1024 * 1024 ? 2 : 3;
+    MemoryRecord *record = memory_track(MEMORY_SURFACE, surface, bytes, format, size);
+    if (cairo_surface_set_user_data(surface, &memory_key, record, memory_release) != CAIRO_STATUS_SUCCESS) {
+        memory_release(record);
+    }
+    return surface;
+}
+
+// Surfaces created or destroyed off the JavaScript thread cannot carry a MemoryRecord (with
+// debug on, making one takes a stack trace), so they are only added to, or taken from, the
+// surface totals.
+static void count_surface(cairo_surface_t *surface, int count) {
+    long bytes = (long) cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+    memory_count(&memory_counters[MEMORY_SURFACE], count, count * bytes);
+}
+
+static cairo_pattern_t *track_pattern(cairo_pattern_t *pattern) {
+    if (cairo_pattern_status(pattern) != CAIRO_STATUS_SUCCESS || cairo_pattern_get_user_data(pattern, &memory_key)) {
+        return pattern;
+    }
+    MemoryRecord *record = memory_track(MEMORY_PATTERN, pattern, 0, -1, 0);
+    if (cairo_pattern_set_user_data(pattern, &memory_key, record, memory_release) != CAIRO_STATUS_SUCCESS) {
+        memory_release(record);
+    }
+    return pattern;
+}
+
+static cairo_scaled_font_t *track_scaled_font(cairo_scaled_font_t *font) {
+    if (cairo_scaled_font_status(font) != CAIRO_STATUS_SUCCESS || cairo_scaled_font_get_user_data(font, &memory_key)) {
+        return font;
+    }
+    MemoryRecord *record = memory_track(MEMORY_SCALED_FONT, font, 0, -1, 0);
+    if (cairo_scaled_font_set_user_data(font, &memory_key, record, memory_release) != CAIRO_STATUS_SUCCESS) {
+        memory_release(record);
+    }
+    return font;
+}
+
+static cairo_font_face_t *track_font_face(cairo_font_face_t *face) {
+    if (cairo_font_face_status(face) != CAIRO_STATUS_SUCCESS || cairo_font_face_get_user_data(face, &memory_key)) {
+        return face;
+    }
+    MemoryRecord *record = memory_track(MEMORY_FONT_FACE, face, 0, -1, 0);
+    if (cairo_font_face_set_user_data(face, &memory_key, record, memory_release) != CAIRO_STATUS_SUCCESS) {
+        memory_release(record);
+    }
+    return face;
+}
+
+static cairo_path_t *track_path(cairo_path_t *path) {
+    memory_track_untagged(MEMORY_PATH, path, (long) path->num_data * sizeof(cairo_path_data_t));
+    return path;
+}
+
+static void untrack_path(cairo_path_t *path) {
+    memory_untrack_untagged(MEMORY_PATH, path, (long) path->num_data * sizeof(cairo_path_data_t));
+}
+
+static cairo_matrix_t *matrix_new() {
+    cairo_matrix_t *matrix = new cairo_matrix_t;
+    memory_track_untagged(MEMORY_MATRIX, matrix, sizeof(cairo_matrix_t));
+    return matrix;
+}
+
+static void matrix_delete(cairo_matrix_t *matrix) {
+    memory_untrack_untagged(MEMORY_MATRIX, matrix, sizeof(cairo_matrix_t));
+    delete matrix;
+}
+
+static cairo_font_options_t *track_font_options(cairo_font_options_t *options) {
+    memory_track_untagged(MEMORY_FONT_OPTIONS, options, 0);
+    return options;
+}
+
+#if CAIRO_VERSION_MINOR >= 10
+// A region handle counts once per reference JavaScript holds.
+static cairo_region_t *track_region(cairo_region_t *region) {
+    memory_track_untagged(MEMORY_REGION, region, 0);
+    return region;
+}
+#endif
+
+// Limits.  Surfaces larger than memory_max_pixels, or that would take the tracked total
+// past memory_budget bytes, are refused (0 means no limit), so a request for an absurd
+// canvas gets an exception instead of getting the worker killed.
+static long memory_max_pixels = 0;
+static long memory_budget = 0;
+
+static long memory_in_use() {
+    long total = 0;
+    for (int i = 0; i < MEMORY_TYPES; i++) {
+        total += memory_counters[i].bytes;
+    }
+    return total;
+}
+
+enum MemoryRefusal {
+    MEMORY_ADMITTED,
+    MEMORY_OVER_MAX_PIXELS,
+    MEMORY_OVER_BUDGET
+};
+
+// Returns the limit count image surfaces of width x height would break, writing the reason
+// to msg, or MEMORY_ADMITTED if they may be allocated.  maxPixels applies to each surface,
+// the budget to all of them together.
+static MemoryRefusal memory_refusal(const char *fn, int width, int height, char *msg, size_t size, int count = 1) {
+    long pixels = (long) width * height;
+    long bytes = pixels * 4 * count;
+    if (memory_max_pixels && pixels > memory_max_pixels) {
+        snprintf(msg, size, "%s: %dx%d is %ld pixels, over the limit of %ld", fn, width, height, pixels, memory_max_pixels);
+        return MEMORY_OVER_MAX_PIXELS;
+    }
+    long used = memory_in_use();
+    if (memory_budget && used + bytes > memory_budget) {
+        if (count == 1) {
+            snprintf(msg, size, "%s: %dx%d needs %ld bytes, but %ld of the %ld byte budget are in use", fn, width, height, bytes, used, memory_budget);
+        }
+        else {
+            snprintf(msg, size, "%s: %d surfaces of %dx%d need %ld bytes, but %ld of the %ld byte budget are in use", fn, count, width, height, bytes, used, memory_budget);
+        }
+        return MEMORY_OVER_BUDGET;
+    }
+    return MEMORY_ADMITTED;
+}
+
+static bool memory_admit(const char *fn, int width, int height, char *msg, size_t size, int count = 1) {
+    return memory_refusal(fn, width, height, msg, size, count) == MEMORY_ADMITTED;
+}
 
 /**
- * @function cairo.surface_create_similar
+ * @function cairo.memory_set_limits
  * 
  * ### Synopsis
  * 
- * var newSurface = cairo.surface_create_similar(handle, format, width, height);
+ * cairo.memory_set_limits(limits);
  * 
- * Create a new surface that is as compatible as possible with an existing surface. 
+ * Set the limits on native memory that image surface allocation is checked against.
  * 
- * For example the new surface will have the same fallback resolution and font options as other. Generally, the new surface will also use the same backend as other, unless that is not possible for some reason. The type of the returned surface may be examined with cairo.surface_get_type().
+ * The limits object may have these members; those omitted are left as they are:
  * 
- * Initially the surface contents are all 0 (transparent if contents have transparency, black otherwise.)
+ * + {int} maxPixels - most pixels in one surface, or 0 for no limit.
+ * + {int} budget - most bytes held by all the objects cairo.memory_stats() counts, or 0 for no limit.
  * 
- * Use cairo.surface_create_similar_image() if you need an image surface which can be painted quickly to the target surface.
- *
- * The caller owns the returned surface and should call cairo.surface_destroy() when done with it.
+ * Surfaces that would break a limit are refused: cairo.image_surface_create() and cairo.surface_create_similar() throw an exception, and PNG decoding fails as if the file could not be read.
  * 
- * The format parameter is one of the following:
+ * The budget is checked against the bytes cairo.memory_stats() reports, which include the pixels of groups pushed with cairo.context_push_group(), of the surfaces cairo.commands_render_batch() and cairo.recording_surface_write_to_png() render into, and the temporary files behind snapshots.  It does not include command lists, the drawing held by recording surfaces, or the tiles of a tiled surface, which live in a temporary file and are paged in as needed; nor does it include memory cairo allocates for itself, such as glyph caches.
  * 
- * + cairo.CONTENT_COLOR - the surface will hold color content only.
- * + cairo.CONTENT_ALPHA - the surface will hold alpha content only.
- * + cairo.CONTENT_COLOR_ALPHA - the surface will hold color and alpha content.
- *
- * @param {object} surface - opaque handle to a cairo surface.
- * @param {int} format - format of pixels in the surface to create.
- * @param {int} width - width of the surface, in pixels
- * @param {int} height - height of the surface, in pixels.
- * @return {object} newSurface - opaque handle to the newly created surface.
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} limits - object of the above form.
  */
-static JSVAL surface_create_similar(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    int format = args[1]->IntegerValue();
-    int width = args[2]->IntegerValue();
-    int height = args[3]->IntegerValue();
-    return External::New(cairo_surface_create_similar(surface, (cairo_content_t)format, width, height));
+static JSVAL memory_set_limits(JSARGS args) {
+    JSOBJ o = args[0]->ToObject();
+    if (o->Has(String::New("maxPixels"))) {
+        memory_max_pixels = (long) o->Get(String::New("maxPixels"))->NumberValue();
+    }
+    if (o->Has(String::New("budget"))) {
+        memory_budget = (long) o->Get(String::New("budget"))->NumberValue();
+    }
+    return Undefined();
 }
 
 /**
- * @function cairo.surface_reference
+ * @function cairo.memory_get_limits
  * 
  * ### Synopsis
  * 
- * var surface = cairo.surface_reference(surface);
+ * var limits = cairo.memory_get_limits();
  * 
- * Increases the reference count on surface by one. This prevents surface from being destroyed until a matching call to cairo.surface_destroy() is made.
+ * Get the limits set by cairo.memory_set_limits(), and the memory in use.
  * 
- * The number of references to a cairo surface can be get using cairo.surface_get_reference_count().
+ * ### Note
  * 
- * @param {object} surface - opaque handle to a cairo surface.
- * @return {object} surface - the referenced cairo surface.
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @return {object} limits - { maxPixels, budget, inUse }.
  */
-static JSVAL surface_reference(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return External::New(cairo_surface_reference(surface));
+static JSVAL memory_get_limits(JSARGS args) {
+    JSOBJ o = Object::New();
+    o->Set(String::New("maxPixels"), Number::New(memory_max_pixels));
+    o->Set(String::New("budget"), Number::New(memory_budget));
+    o->Set(String::New("inUse"), Number::New(memory_in_use()));
+    return o;
 }
 
 /**
- * @function cairo.surface_status
+ * @function cairo.memory_check
  * 
  * ### Synopsis
  * 
- * var status = cairo.surface_status(surface);
- * 
- * Checks whether an error has previously occurred for this surface.
+ * var refusal = cairo.memory_check(width, height);
  * 
- * @param {object} surface - opaque handle to a cairo surface.
- * @return {int} status - one of cairo.STATUS_SUCCESS, cairo.STATUS_NULL_POINTER, cairo.STATUS_NO_MEMORY, cairo.STATUS_READ_ERROR, cairo.STATUS_INVALID_CONTENT, cairo.STATUS_INVALID_FORMAT, or cairo.STATUS_INVALID_VISUAL.
- */
-static JSVAL surface_status(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_surface_status(surface));
-}
-
-/**
- * @function cairo.surface_destroy
+ * Determine whether an image surface of the given size may be allocated under the limits set by cairo.memory_set_limits().
  * 
- * ### Synopsis
+ * If it may not, the object returned says which limit it would break:
  * 
- * cairo.surface_destroy(surface);
+ * + {string} limit - 'maxPixels' if the surface is too large on its own, which no amount of freeing memory will change; 'budget' if there is not enough of the budget left.
+ * + {string} message - the reason, for an exception.
  * 
- * Decreases the reference count on surface by one. If the result is zero, then surface and all associated resources are freed. 
+ * ### Note
  * 
- * See cairo.surface_reference().
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
  * 
- * @param {object} surface - opaque handle to a cairo surface.
+ * @param {int} width - width of the surface, in pixels.
+ * @param {int} height - height of the surface, in pixels.
+ * @return {object} refusal - null if the surface may be allocated, otherwise an object of the above form.
  */
-static JSVAL surface_destroy(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    cairo_surface_destroy(surface);
-    return Undefined();
+static JSVAL memory_check(JSARGS args) {
+    char msg[256];
+    MemoryRefusal refusal = memory_refusal("memory_check", args[0]->IntegerValue(), args[1]->IntegerValue(), msg, sizeof(msg));
+    if (refusal == MEMORY_ADMITTED) {
+        return Null();
+    }
+    JSOBJ o = Object::New();
+    o->Set(String::New("limit"), String::New(refusal == MEMORY_OVER_MAX_PIXELS ? "maxPixels" : "budget"));
+    o->Set(String::New("message"), String::New(msg));
+    return o;
+}
+
+static JSOBJ memory_counter_object(MemoryCounter *counter) {
+    JSOBJ o = Object::New();
+    o->Set(String::New("count"), Number::New(counter->count));
+    o->Set(String::New("bytes"), Number::New(counter->bytes));
+    o->Set(String::New("peakBytes"), Number::New(counter->peakBytes));
+    return o;
 }
 
 /**
- * @function cairo.surface_finish
+ * @function cairo.memory_stats
  * 
  * ### Synopsis
  * 
- * cairo.surface_finish(surface);
+ * var stats = cairo.memory_stats();
  * 
- * This function finishes the surface and drops all references to external resources. 
+ * Get the number of live native objects handed out by this module, and the memory they hold, by type.
  * 
- * For example, for the Xlib backend it means that cairo will no longer access the drawable, which can be freed. 
+ * The object returned has a member for each type: surfaces, patterns, paths, scaledFonts, fontFaces, regions, matrices, fontOptions and snapshots.  Each is of the form { count, bytes, peakBytes }.  Bytes are counted for image surface pixels, path data, matrices and snapshots; the memory behind the other types belongs to cairo and is not known.
  * 
- * After calling cairo.surface_finish() the only valid operations on a surface are getting and setting user, referencing and destroying, and flushing and finishing it. Further drawing to the surface will not affect the surface but will instead trigger a cairo.STATUS_SURFACE_FINISHED error.
+ * The surfaces member also has:
  * 
- * @param {object} surface - opaque handle to a cairo surface.
+ * + {object} byFormat - { argb32, rgb24, a8, a1, rgb16_565, other }, each { count, bytes, peakBytes }; other is surfaces that are not image surfaces.
+ * + {object} bySize - { small, medium, large, huge }: surfaces of under 64KB, under 1MB, under 16MB, and larger.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @return {object} stats - object of the above form.
  */
-static JSVAL surface_finish(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    cairo_surface_finish(surface);
-    return Undefined();
+static JSVAL memory_stats(JSARGS args) {
+    JSOBJ o = Object::New();
+    for (int i = 0; i < MEMORY_TYPES; i++) {
+        o->Set(String::New(memory_type_names[i]), memory_counter_object(&memory_counters[i]));
+    }
+    JSOBJ surfaces = o->Get(String::New("surfaces"))->ToObject();
+    JSOBJ formats = Object::New();
+    for (int i = 0; i < MEMORY_FORMATS; i++) {
+        formats->Set(String::New(memory_format_names[i]), memory_counter_object(&memory_formats[i]));
+    }
+    surfaces->Set(String::New("byFormat"), formats);
+    JSOBJ sizes = Object::New();
+    for (int i = 0; i < MEMORY_SIZES; i++) {
+        sizes->Set(String::New(memory_size_names[i]), memory_counter_object(&memory_sizes[i]));
+    }
+    surfaces->Set(String::New("bySize"), sizes);
+    return o;
 }
 
 /**
- * @function cairo.surface_flush
+ * @function cairo.memory_debug
  * 
  * ### Synopsis
  * 
- * cairo.surface_flush(surface);
+ * cairo.memory_debug(enabled);
  * 
- * Do any pending drawing for the surface and also restore any temporary modifications cairo has made to the surface's state. 
+ * Turn allocation site recording on or off.
  * 
- * This function must be called before switching from drawing on the surface with cairo to drawing on it directly with native APIs. 
+ * While it is on, every native object handed to JavaScript records the JavaScript stack that created it, and is listed by cairo.memory_live_objects() until it is freed.  This costs a stack capture per allocation, so it is meant for hunting leaks, not for production.
  * 
- * If the surface doesn't support direct access, then this function does nothing.
+ * ### Note
  * 
- * @param {object} surface - opaque handle to a cairo surface.
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {boolean} enabled - true to record allocation sites.
  */
-static JSVAL surface_flush(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    cairo_surface_flush(surface);
+static JSVAL memory_debug(JSARGS args) {
+    memory_debug_enabled = args[0]->BooleanValue();
     return Undefined();
 }
 
 /**
- * @function cairo.surface_get_device
+ * @function cairo.memory_live_objects
  * 
  * ### Synopsis
  * 
- * var device = cairo.surface_get_device(surface);
+ * var objects = cairo.memory_live_objects();
  * 
- * This function returns the device for a surface.
+ * List the live objects allocated while cairo.memory_debug() was on, newest first.
  * 
- * See device methods.
+ * Each element is of the form:
  * 
- * AVAILABLE IN CAIRO 1.10 OR NEWER
+ * + {string} type - surfaces, patterns, paths, scaledFonts, fontFaces, regions, matrices, fontOptions or snapshots.
+ * + {int} bytes - memory held, as counted by cairo.memory_stats().
+ * + {string} site - the JavaScript functions, with script and line, that allocated it, innermost first.
  * 
- * @param {object} surface - opaque handle to a cairo surface.
- * @return {object} device - opaque handle to the device for the surface, or null if the surface does not have an associated device.
- */
-#if CAIRO_VERSION_MINOR >= 10
-static JSVAL surface_get_device(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    cairo_device_t *device = cairo_surface_get_device(surface);
-    if (device == NULL) {
-        return Null();
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @return {array} objects - array of objects of the above form.
+ */
+static JSVAL memory_live_objects(JSARGS args) {
+    JSARRAY a = Array::New();
+    int n = 0;
+    pthread_mutex_lock(&memory_lock);
+    for (MemoryRecord *record = memory_live; record; record = record->next) {
+        JSOBJ o = Object::New();
+        o->Set(String::New("type"), String::New(memory_type_names[record->type]));
+        o->Set(String::New("bytes"), Number::New(record->bytes));
+        o->Set(String::New("site"), String::New(record->site));
+        a->Set(n++, o);
+    }
+    pthread_mutex_unlock(&memory_lock);
+    return a;
+}
+
+////////////////////////// METRICS
+
+// Latency histograms for the phases of rendering a request, for dashboards.  Buckets are
+// HDR-style, log-linear over nanoseconds: each power of two is split into 8 sub-buckets, so
+// any duration from 1ns to minutes is recorded with 12.5% precision in a fixed array.  Each
+// thread records into one of METRICS_SHARDS shards with atomic adds, so threads on the pool
+// decoding and encoding in parallel do not contend on a lock or, mostly, a cache line.
+// metrics_text() sums the shards.
+enum MetricsPhase {
+    METRICS_CONTEXT_CREATE,
+    METRICS_PATH,
+    METRICS_FILL_STROKE,
+    METRICS_TEXT,
+    METRICS_BLUR,
+    METRICS_IMAGE_DECODE,
+    METRICS_PNG_ENCODE,
+    METRICS_PHASES
+};
+
+static const char *metrics_phase_names[METRICS_PHASES] = {
+    "context_create", "path", "fill_stroke", "text", "blur", "image_decode", "png_encode"
+};
+
+#define METRICS_SUB_BITS 3
+#define METRICS_BUCKETS ((64 - METRICS_SUB_BITS + 1) << METRICS_SUB_BITS)
+#define METRICS_SHARDS 16
+
+struct MetricsHistogram {
+    uint64_t counts[METRICS_BUCKETS];
+    uint64_t count;
+    uint64_t sumNanoseconds;
+} __attribute__((aligned(64)));
+
+static MetricsHistogram metrics_shards[METRICS_SHARDS][METRICS_PHASES];
+static bool metrics_enabled = true;
+static int metrics_next_shard = 0;
+static __thread int metrics_shard = -1;
+
+static inline int metrics_bucket(uint64_t ns) {
+    if (ns < (1 << METRICS_SUB_BITS)) {
+        return (int) ns;
+    }
+    int exponent = 63 - __builtin_clzll(ns);
+    int sub = (int) (ns >> (exponent - METRICS_SUB_BITS)) & ((1 << METRICS_SUB_BITS) - 1);
+    return ((exponent - METRICS_SUB_BITS + 1) << METRICS_SUB_BITS) + sub;
+}
+
+// the largest duration, in nanoseconds, recorded in bucket
+static double metrics_bucket_limit(int bucket) {
+    if (bucket < (1 << METRICS_SUB_BITS)) {
+        return bucket;
+    }
+    int exponent = (bucket >> METRICS_SUB_BITS) + METRICS_SUB_BITS - 1;
+    int sub = bucket & ((1 << METRICS_SUB_BITS) - 1);
+    return ldexp((double) ((1 << METRICS_SUB_BITS) + sub + 1), exponent - METRICS_SUB_BITS) - 1;
+}
+
+static inline uint64_t metrics_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void metrics_record(int phase, uint64_t ns) {
+    if (metrics_shard < 0) {
+        metrics_shard = __sync_fetch_and_add(&metrics_next_shard, 1) % METRICS_SHARDS;
+    }
+    MetricsHistogram *h = &metrics_shards[metrics_shard][phase];
+    __sync_fetch_and_add(&h->counts[metrics_bucket(ns)], 1);
+    __sync_fetch_and_add(&h->count, 1);
+    __sync_fetch_and_add(&h->sumNanoseconds, ns);
+}
+
+// Trace capture.  Between trace_begin() and trace_end(), timers that are given an operation
+// name also append a complete event, with its start, duration, thread and arguments, to a
+// buffer that trace_end() returns as Chrome trace-event JSON, for viewing one render's
+// timeline in chrome://tracing or Perfetto.  Path building is left out; its calls are too
+// many and too small to be worth seeing one by one.
+#define TRACE_ARGS_SIZE 160
+
+struct TraceEvent {
+    const char *name;
+    int phase;
+    int thread;
+    uint64_t start;
+    uint64_t duration;
+    char args[TRACE_ARGS_SIZE];
+};
+
+static bool trace_active = false;
+static TraceEvent *trace_events = NULL;
+static int trace_count = 0;
+static int trace_capacity = 0;
+static long trace_dropped = 0;
+static uint64_t trace_start = 0;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static int trace_next_thread = 0;
+static __thread int trace_thread = -1;
+
+static void trace_add(const char *name, int phase, uint64_t start, uint64_t duration, const char *args) {
+    if (trace_thread < 0) {
+        trace_thread = __sync_fetch_and_add(&trace_next_thread, 1);
+    }
+    pthread_mutex_lock(&trace_lock);
+    if (!trace_active || start < trace_start) {
+        // the capture ended, or this operation began before it did
+    }
+    else if (trace_count == trace_capacity) {
+        trace_dropped++;
+    }
+    else {
+        TraceEvent *event = &trace_events[trace_count++];
+        event->name = name;
+        event->phase = phase;
+        event->thread = trace_thread;
+        event->start = start;
+        event->duration = duration;
+        strcpy(event->args, args);
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+// Times the rest of the enclosing block as phase and, while tracing, as operation name.
+class MetricsTimer {
+public:
+    MetricsTimer(int phase, const char *name = NULL) : phase_(phase), name_(trace_active ? name : NULL), start_(0), length_(0) {
+        args_[0] = '\0';
+        if (metrics_enabled || name_) {
+            start_ = metrics_now();
+        }
+    }
+    ~MetricsTimer() {
+        if (!start_) {
+            return;
+        }
+        uint64_t ns = metrics_now() - start_;
+        if (metrics_enabled) {
+            metrics_record(phase_, ns);
+        }
+        if (name_) {
+            trace_add(name_, phase_, start_, ns, args_);
+        }
+    }
+    // Add an argument to the trace event; ignored when not tracing.
+    void arg(const char *key, const char *value) {
+        if (!fits(key)) {
+            return;
+        }
+        append("%s\"%s\":\"", length_ ? "," : "", key);
+        for (const char *p = value; *p && length_ < TRACE_ARGS_SIZE - 8; p++) {
+            unsigned char ch = *p;
+            if (ch == '"' || ch == '\\') {
+                append("\\%c", ch);
+            }
+            else if (ch < 0x20) {
+                append("\\u%04x", ch);
+            }
+            else {
+                append("%c", ch);
+            }
+        }
+        append("\"");
+    }
+    void arg(const char *key, double value) {
+        if (fits(key)) {
+            append("%s\"%s\":%g", length_ ? "," : "", key, value);
+        }
+    }
+private:
+    // whether there is room for key and a short value; a long string value is cut short
+    bool fits(const char *key) {
+        return name_ && length_ + strlen(key) + 32 < TRACE_ARGS_SIZE;
+    }
+    void append(const char *format, ...) {
+        va_list ap;
+        va_start(ap, format);
+        int n = vsnprintf(args_ + length_, TRACE_ARGS_SIZE - length_, format, ap);
+        va_end(ap);
+        if (n > 0) {
+            length_ = length_ + n < TRACE_ARGS_SIZE ? length_ + n : TRACE_ARGS_SIZE - 1;
+        }
+    }
+    int phase_;
+    const char *name_;
+    uint64_t start_;
+    int length_;
+    char args_[TRACE_ARGS_SIZE];
+};
+
+static void metrics_append(char **text, size_t *length, size_t *capacity, const char *format, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, format);
+        int n = vsnprintf(*text + *length, *capacity - *length, format, ap);
+        va_end(ap);
+        if (n >= 0 && (size_t) n < *capacity - *length) {
+            *length += n;
+            return;
+        }
+        *capacity *= 2;
+        *text = (char *) realloc(*text, *capacity);
     }
-    return External::New(device);
 }
-#endif
 
 /**
- * @function cairo.surface_get_font_options
+ * @function cairo.metrics_text
  * 
  * ### Synopsis
  * 
- * var options = cairo.surface_get_font_options(surface);
- * 
- * Retrieves the default font rendering options for the surface. 
- * 
- * This allows display surfaces to report the correct subpixel order for rendering on them, print surfaces to disable hinting of metrics and so forth. 
- * 
- * The result can then be used with cairo.scaled_font_create().
+ * var text = cairo.metrics_text();
  * 
- * NOTE: the resulting options object should be freed with cairo.font_options_destroy().
+ * Render the rendering metrics in the Prometheus text exposition format, to be served from a /metrics route.
  * 
- * The options object returned is an opaque structure holding all options that are used when rendering fonts.
+ * canvas_phase_duration_seconds is a histogram labelled by phase: context_create, path (path building), fill_stroke (fill, stroke and paint), text, blur, image_decode and png_encode.  Its buckets run from 1 microsecond to 10 seconds in 1, 2.5, 5 steps.
  * 
- * Individual features of a cairo font_options object can be set or accessed using functions named cairo.font_options_set_feature_name() and cairo.font_options_get_feature_name(), like cairo.font_options_set_antialias() and cairo.font_options_get_antialias().
+ * canvas_native_objects and canvas_native_bytes are gauges of the live objects counted by cairo.memory_stats(), labelled by type.
  * 
- * New features may be added to a cairo font_options object in the future. For this reason, cairo.font_options_copy(), cairo.font_options_equal(), cairo.font_options_merge(), and cairo.font_options_hash() should be used to copy, check for equality, merge, or compute a hash value of cairo font_options objects. 
+ * ### Note
  * 
- * See font_options methods.
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
  * 
- * @param {object} surface - opaque handle to a cairo surface.
- * @return {object} options - opaque handle to the font options for the surface, or null if the surface does not have an associated device.
+ * @return {string} text - the metrics.
  */
-static JSVAL surface_get_font_options(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    cairo_font_options_t *options = cairo_font_options_create();
-    cairo_surface_get_font_options(surface, options);
-    return External::New(options);
+static JSVAL metrics_text(JSARGS args) {
+    static const double bounds[] = {
+        1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3,
+        1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+    };
+    size_t length = 0, capacity = 16 * 1024;
+    char *text = (char *) malloc(capacity);
+    metrics_append(&text, &length, &capacity,
+        "# HELP canvas_phase_duration_seconds Time spent in each phase of rendering.\n"
+        "# TYPE canvas_phase_duration_seconds histogram\n");
+    for (int phase = 0; phase < METRICS_PHASES; phase++) {
+        uint64_t counts[METRICS_BUCKETS] = { 0 };
+        uint64_t count = 0, sum = 0;
+        for (int s = 0; s < METRICS_SHARDS; s++) {
+            MetricsHistogram *h = &metrics_shards[s][phase];
+            for (int b = 0; b < METRICS_BUCKETS; b++) {
+                counts[b] += h->counts[b];
+            }
+            count += h->count;
+            sum += h->sumNanoseconds;
+        }
+        // a bucket counts toward a bound if everything it holds is within the bound
+        uint64_t cumulative = 0;
+        int b = 0;
+        for (size_t i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+            for (; b < METRICS_BUCKETS && metrics_bucket_limit(b) <= bounds[i] * 1e9; b++) {
+                cumulative += counts[b];
+            }
+            metrics_append(&text, &length, &capacity, "canvas_phase_duration_seconds_bucket{phase=\"%s\",le=\"%g\"} %llu\n",
+                metrics_phase_names[phase], bounds[i], (unsigned long long) cumulative);
+        }
+        metrics_append(&text, &length, &capacity,
+            "canvas_phase_duration_seconds_bucket{phase=\"%s\",le=\"+Inf\"} %llu\n"
+            "canvas_phase_duration_seconds_sum{phase=\"%s\"} %.9f\n"
+            "canvas_phase_duration_seconds_count{phase=\"%s\"} %llu\n",
+            metrics_phase_names[phase], (unsigned long long) count,
+            metrics_phase_names[phase], sum / 1e9,
+            metrics_phase_names[phase], (unsigned long long) count);
+    }
+    metrics_append(&text, &length, &capacity,
+        "# HELP canvas_native_objects Live native objects held by the canvas module.\n"
+        "# TYPE canvas_native_objects gauge\n");
+    for (int i = 0; i < MEMORY_TYPES; i++) {
+        metrics_append(&text, &length, &capacity, "canvas_native_objects{type=\"%s\"} %ld\n", memory_type_names[i], memory_counters[i].count);
+    }
+    metrics_append(&text, &length, &capacity,
+        "# HELP canvas_native_bytes Native memory held by live objects of the canvas module.\n"
+        "# TYPE canvas_native_bytes gauge\n");
+    for (int i = 0; i < MEMORY_TYPES; i++) {
+        metrics_append(&text, &length, &capacity, "canvas_native_bytes{type=\"%s\"} %ld\n", memory_type_names[i], memory_counters[i].bytes);
+    }
+    return String::NewExternal(new MallocAsciiString(text, length));
 }
 
 /**
- * @function cairo.surface_get_content
+ * @function cairo.metrics_enable
  * 
  * ### Synopsis
  * 
- * var content = cairo.surface_get_content(surface);
+ * cairo.metrics_enable(enabled);
  * 
- * This function returns the content type of surface which indicates whether the surface contains color and/or alpha information.
+ * Turn the recording of rendering metrics on or off.  It is on by default; each timed call costs two clock reads.
  * 
- * The content type returned is one of:
+ * ### Note
  * 
- * + cairo.CONTENT_COLOR
- * + cairo.CONTENT_ALPHA
- * + cairo.CONTENT_COLOR_ALPHA
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
  * 
- * @param {object} surface - opaque handle to a cairo surface.
- * @return {int} content - type content type of surface.
+ * @param {boolean} enabled - true to record metrics.
  */
-static JSVAL surface_get_content(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_surface_get_content(surface));
+static JSVAL metrics_enable(JSARGS args) {
+    metrics_enabled = args[0]->BooleanValue();
+    return Undefined();
 }
 
 /**
- * @function cairo.surface_mark_dirty
+ * @function cairo.metrics_reset
  * 
  * ### Synopsis
  * 
- * cairo.surface_mark_dirty(surface);
+ * cairo.metrics_reset();
  * 
- * Tells cairo that drawing has been done to surface using means other than cairo, and that cairo should reread any cached areas. 
+ * Clear the rendering metrics.  Recording threads are not stopped, so a duration recorded at the same moment may be partly kept.
  * 
- * Note that you must call cairo.surface_flush() before doing such drawing.
+ * ### Note
  * 
- * @param {object} surface - opaque handle to a cairo surface.
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
  */
-static JSVAL surface_mark_dirty(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    cairo_surface_mark_dirty(surface);
+static JSVAL metrics_reset(JSARGS args) {
+    memset(metrics_shards, 0, sizeof(metrics_shards));
     return Undefined();
 }
 
 /**
- * @function cairo.surface_mark_dirty_rectangle
+ * @function cairo.trace_begin
  * 
  * ### Synopsis
  * 
- * cairo.surface_mark_dirty(surface, x,y, w,h);
+ * cairo.trace_begin();
+ * cairo.trace_begin(maxEvents);
  * 
- * Like cairo.surface_mark_dirty(), but drawing has been done only to the specified rectangle, so that cairo can retain cached contents for other parts of the surface.
+ * Start capturing a timeline of native operations: fill, stroke, paint, show_text, text_path, surface_blur, context_create, decode, write_to_png and to_data_url, each with its start, duration, thread and arguments such as the text drawn or the file written.  Path building is not captured.
  * 
- * Any cached clip set on the surface will be reset by this function, to make sure that future cairo calls have the clip set that they expect.
+ * Any timeline already being captured is discarded.  Events past maxEvents (default 100000) are counted but not kept.
  * 
- * Note that you must call cairo.surface_flush() before doing such drawing.
+ * ### Note
  * 
- * @param {object} surface - opaque handle to a cairo surface.
- * @param {int} x - upper left x coordinate of dirty rectangle
- * @param {int} y - upper left y coordinate of dirty rectangle
- * @param {int} w - width of dirty rectangle
- * @param {int} h - height of dirty rectangle
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {int} maxEvents - most events to keep.
  */
-static JSVAL surface_mark_dirty_rectangle(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    int x = args[1]->IntegerValue();
-    int y = args[2]->IntegerValue();
-    int w = args[3]->IntegerValue();
-    int h = args[4]->IntegerValue();
-    cairo_surface_mark_dirty_rectangle(surface, x,y, w,h);
+static JSVAL trace_begin(JSARGS args) {
+    int maxEvents = args.Length() > 0 ? args[0]->IntegerValue() : 100000;
+    if (maxEvents <= 0) {
+        return ThrowException(String::New("trace_begin: maxEvents must be positive"));
+    }
+    pthread_mutex_lock(&trace_lock);
+    if (maxEvents != trace_capacity) {
+        free(trace_events);
+        trace_events = (TraceEvent *) malloc(maxEvents * sizeof(TraceEvent));
+        trace_capacity = trace_events ? maxEvents : 0;
+    }
+    trace_count = 0;
+    trace_dropped = 0;
+    trace_start = metrics_now();
+    trace_active = trace_events != NULL;
+    pthread_mutex_unlock(&trace_lock);
+    if (!trace_active) {
+        return ThrowException(String::New("trace_begin: out of memory"));
+    }
     return Undefined();
 }
 
 /**
- * @function cairo.surface_set_device_offset
+ * @function cairo.trace_end
  * 
  * ### Synopsis
  * 
- * cairo.surface_set_device_offset(surface, x_offset, y_offset);
+ * var json = cairo.trace_end();
  * 
- * Sets an offset that is added to the device coordinates determined by the CTM when drawing to surface. 
+ * Stop capturing the timeline started by cairo.trace_begin() and return it as Chrome trace-event JSON, which chrome://tracing and ui.perfetto.dev open directly.
  * 
- * One use case for this function is when we want to create a cairo surface that redirects drawing for a portion of an on-screen surface to an offscreen surface in a way that is completely invisible to the user of the cairo API. Setting a transformation via cairo.translate() isn't sufficient to do this, since functions like cairo.device_to_user() will expose the hidden offset.
+ * Each operation is a complete ("X") event whose category is its metrics phase; times are in microseconds from trace_begin().  Threads are numbered in the order they first recorded an event, so background decodes show on their own tracks.  otherData.dropped counts the events past maxEvents.
  * 
- * Note that the offset affects drawing to the surface as well as using the surface in a source pattern.
+ * Operations still running on other threads when the capture stops are not included.
  * 
- * @param {object} surface - opaque handle to a cairo surface.
- * @param {number} x_offset - the offset in the X direction, in device units
- * @param {number} y_offset - the offset in the Y direction, in device units
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @return {string} json - the timeline, or null if no capture was started.
  */
-static JSVAL surface_set_device_offset(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    double dx = args[1]->NumberValue();
-    double dy = args[2]->NumberValue();
-    cairo_surface_set_device_offset(surface, dx, dy);
-    return Undefined();
+static JSVAL trace_end(JSARGS args) {
+    pthread_mutex_lock(&trace_lock);
+    if (!trace_active) {
+        pthread_mutex_unlock(&trace_lock);
+        return Null();
+    }
+    trace_active = false;
+    size_t length = 0, capacity = 256 + (size_t) trace_count * (TRACE_ARGS_SIZE + 128);
+    char *text = (char *) malloc(capacity);
+    metrics_append(&text, &length, &capacity, "{\"traceEvents\":[");
+    for (int i = 0; i < trace_count; i++) {
+        TraceEvent *event = &trace_events[i];
+        metrics_append(&text, &length, &capacity,
+            "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{%s}}",
+            i ? "," : "", event->name, metrics_phase_names[event->phase],
+            (event->start - trace_start) / 1e3, event->duration / 1e3,
+            (int) getpid(), event->thread, event->args);
+    }
+    metrics_append(&text, &length, &capacity, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%ld}}\n", trace_dropped);
+    pthread_mutex_unlock(&trace_lock);
+    return String::NewExternal(new MallocAsciiString(text, length));
+}
+
+////////////////////////// SURFACE
+
+// A surface made by surface_create_for_rectangle() from an image surface remembers which
+// rectangle of it it covers, so that the bindings that work on pixels directly (reading
+// them, finding content bounds, snapshots) also work on a cropped canvas.
+struct SurfaceView {
+    cairo_surface_t *image;
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+static cairo_user_data_key_t surface_view_key;
+
+static void surface_view_destroy(void *data) {
+    delete (SurfaceView *) data;
+}
+
+// The pixels behind a surface: all of an image surface, or the rectangle of one that a view
+// covers.  data points at the first pixel of the rectangle; rows are stride bytes apart.
+struct SurfacePixels {
+    cairo_surface_t *image;
+    uint8_t *data;
+    cairo_format_t format;
+    int width;
+    int height;
+    int stride;
+};
+
+// bytes per pixel, for the formats a view can be made of; 0 for the others
+static int surface_pixel_bytes(cairo_format_t format) {
+    switch (format) {
+        case CAIRO_FORMAT_ARGB32:
+        case CAIRO_FORMAT_RGB24:
+            return 4;
+        case CAIRO_FORMAT_RGB16_565:
+            return 2;
+        case CAIRO_FORMAT_A8:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Returns false if surface is neither an image surface nor a view of one.  The caller
+// should flush pixels->image before reading, and mark it dirty after writing.  An empty
+// image surface has no data; its width or height is 0, so there is nothing to address.
+static bool surface_pixels(cairo_surface_t *surface, SurfacePixels *pixels) {
+    SurfaceView *view = (SurfaceView *) cairo_surface_get_user_data(surface, &surface_view_key);
+    cairo_surface_t *image = view ? view->image : surface;
+    if (cairo_surface_get_type(image) != CAIRO_SURFACE_TYPE_IMAGE
+        || (!cairo_image_surface_get_data(image) && cairo_image_surface_get_width(image) && cairo_image_surface_get_height(image))) {
+        return false;
+    }
+    pixels->image = image;
+    pixels->data = cairo_image_surface_get_data(image);
+    pixels->format = cairo_image_surface_get_format(image);
+    pixels->stride = cairo_image_surface_get_stride(image);
+    if (view) {
+        if (pixels->data) {
+            pixels->data += (size_t) view->y * pixels->stride + view->x * surface_pixel_bytes(pixels->format);
+        }
+        pixels->width = view->width;
+        pixels->height = view->height;
+    }
+    else {
+        pixels->width = cairo_image_surface_get_width(image);
+        pixels->height = cairo_image_surface_get_height(image);
+    }
+    return true;
 }
 
 /**
- * @function cairo.surface_get_device_offset
+ * @function cairo.surface_create_similar
  * 
  * ### Synopsis
  * 
- * var offsets = cairo.surface_get_device_offset(surface);
+ * var newSurface = cairo.surface_create_similar(handle, format, width, height);
  * 
- * This function returns the previous device offset set by cairo.surface_set_device_offset().
+ * Create a new surface that is as compatible as possible with an existing surface. 
  * 
- * The object returned is of the form:
+ * For example the new surface will have the same fallback resolution and font options as other. Generally, the new surface will also use the same backend as other, unless that is not possible for some reason. The type of the returned surface may be examined with cairo.surface_get_type().
  * 
- * + {number} x_offset: the offset in the X direction, in device units
- * + {number} y_offset: the offset in the Y direction, in device units
+ * Initially the surface contents are all 0 (transparent if contents have transparency, black otherwise.)
+ * 
+ * Use cairo.surface_create_similar_image() if you need an image surface which can be painted quickly to the target surface.
+ *
+ * The caller owns the returned surface and should call cairo.surface_destroy() when done with it.
+ * 
+ * The format parameter is one of the following:
  * 
+ * + cairo.CONTENT_COLOR - the surface will hold color content only.
+ * + cairo.CONTENT_ALPHA - the surface will hold alpha content only.
+ * + cairo.CONTENT_COLOR_ALPHA - the surface will hold color and alpha content.
+ *
  * @param {object} surface - opaque handle to a cairo surface.
- * @return {object} offsets - offsets.x,offsets.y are floating point x_offset,y_offset values.
+ * @param {int} format - format of pixels in the surface to create.
+ * @param {int} width - width of the surface, in pixels
+ * @param {int} height - height of the surface, in pixels.
+ * @return {object} newSurface - opaque handle to the newly created surface.
  */
-static JSVAL surface_get_device_offset(JSARGS args) {
+static JSVAL surface_create_similar(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    double dx;
-    double dy;
-    cairo_surface_get_device_offset(surface, &dx, &dy);
-    JSOBJ o = Object::New();
-    o->Set(String::New("x_offset"), Number::New(dx));
-    o->Set(String::New("y_offset"), Number::New(dy));
-    return o;
+    int format = args[1]->IntegerValue();
+    int width = args[2]->IntegerValue();
+    int height = args[3]->IntegerValue();
+    char msg[256];
+    if (!memory_admit("surface_create_similar", width, height, msg, sizeof(msg))) {
+        return ThrowException(String::New(msg));
+    }
+    return External::New(track_surface(cairo_surface_create_similar(surface, (cairo_content_t)format, width, height)));
 }
 
 /**
- * @function cairo.surface_set_fallback_resolution
+ * @function cairo.surface_create_for_rectangle
  * 
  * ### Synopsis
  * 
- * cairo.surface_set_fallback_resolution(surface, x_pixels_per_inch, y_pixels_per_inch);
+ * var subsurface = cairo.surface_create_for_rectangle(surface, x, y, width, height);
  * 
- * Set the horizontal and vertical resolution for image fallbacks.
+ * Create a new surface that is a rectangle within the target surface. 
  * 
- * When certain operations aren't supported natively by a backend, cairo will fallback by rendering operations to an image and then overlaying that image onto the output. For backends that are natively vector-oriented, this function can be used to set the resolution used for these image fallbacks, (larger values will result in more detailed images, but also larger file sizes).
+ * All operations drawn to this surface are then clipped and translated onto the target surface. Nothing drawn via this sub-surface outside of its bounds is drawn onto the target surface, making this a useful method for passing constrained child surfaces to library routines that draw directly onto the parent surface, i.e. with no further backend allocations, double buffering or copies.
  * 
- * Some examples of natively vector-oriented backends are the ps, pdf, and svg backends.
+ * The semantics of subsurfaces have not been finalized yet unless the rectangle is in full device units, is contained within the extents of the target surface, and the target or subsurface's device transforms are not changed.
  * 
- * For backends that are natively raster-oriented, image fallbacks are still possible, but they are always performed at the native device resolution. So this function has no effect on those backends.
+ * The caller owns the returned surface and should call cairo.surface_destroy() when done with it.  The subsurface holds a reference to the target surface.
  * 
- * Note: The fallback resolution only takes effect at the time of completing a page (with cairo.show_page() or cairo.copy_page()) so there is currently no way to have more than one fallback resolution in effect on a single page.
+ * If the target is an image surface, or itself a subsurface of one, and the rectangle is in whole pixels within it, the subsurface can also be passed to the functions that work on an image surface's pixels directly: cairo.image_surface_get_data(), cairo.surface_read_pixels(), cairo.surface_content_bounds(), cairo.surface_clear(), cairo.snapshot_create() and cairo.snapshot_restore().  They see just the rectangle.
  * 
- * The default fallback resoultion is 300 pixels per inch in both dimensions.
- *  
- * @param {object} surface - opaque handle to a cairo surface.
- * @param {number} x_pixels_per_inch - horizontal setting for pixels per inch.
- * @param {number} y_pixels_per_inch - vertical setting for pixels per inch.
+ * AVAILABLE IN CAIRO 1.10 OR NEWER
+ * 
+ * @param {object} surface - opaque handle to the target cairo surface.
+ * @param {number} x - the x-origin of the sub-surface from the top-left of the target surface (in device-space units)
+ * @param {number} y - the y-origin of the sub-surface from the top-left of the target surface (in device-space units)
+ * @param {number} width - width of the sub-surface (in device-space units)
+ * @param {number} height - height of the sub-surface (in device-space units)
+ * @return {object} subsurface - opaque handle to the newly created surface.
  */
-static JSVAL surface_set_fallback_resolution(JSARGS args) {
+#if CAIRO_VERSION_MINOR >= 10
+static JSVAL surface_create_for_rectangle(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    double dx = args[1]->NumberValue();
-    double dy = args[2]->NumberValue();
-    cairo_surface_set_fallback_resolution(surface, dx, dy);
-    return Undefined();
+    double x = args[1]->NumberValue();
+    double y = args[2]->NumberValue();
+    double width = args[3]->NumberValue();
+    double height = args[4]->NumberValue();
+    cairo_surface_t *subsurface = cairo_surface_create_for_rectangle(surface, x, y, width, height);
+
+    SurfacePixels target;
+    if (cairo_surface_status(subsurface) == CAIRO_STATUS_SUCCESS && surface_pixels(surface, &target)
+        && surface_pixel_bytes(target.format)
+        && x == (int) x && y == (int) y && width == (int) width && height == (int) height
+        && x >= 0 && y >= 0 && x + width <= target.width && y + height <= target.height) {
+        SurfaceView *parent = (SurfaceView *) cairo_surface_get_user_data(surface, &surface_view_key);
+        SurfaceView *view = new SurfaceView;
+        view->image = target.image;
+        view->x = (int) x + (parent ? parent->x : 0);
+        view->y = (int) y + (parent ? parent->y : 0);
+        view->width = (int) width;
+        view->height = (int) height;
+        if (cairo_surface_set_user_data(subsurface, &surface_view_key, view, surface_view_destroy) != CAIRO_STATUS_SUCCESS) {
+            delete view;
+        }
+    }
+    return External::New(track_surface(subsurface));
 }
+#endif
 
 /**
- * @function cairo.surface_get_fallback_resolution
+ * @function cairo.surface_reference
  * 
  * ### Synopsis
  * 
- * var resolution = cairo.surface_get_fallback_resolution(surface);
- * 
- * This function returns the previous device offset set by cairo.surface_set_fallback_resolution().
+ * var surface = cairo.surface_reference(surface);
  * 
- * The object returned is of the form:
+ * Increases the reference count on surface by one. This prevents surface from being destroyed until a matching call to cairo.surface_destroy() is made.
  * 
- * + {number} x_pixels_per_inch: the offset in the X direction, in device units
- * + {number} y_pixels_per_inch: the offset in the Y direction, in device units
+ * The number of references to a cairo surface can be get using cairo.surface_get_reference_count().
  * 
  * @param {object} surface - opaque handle to a cairo surface.
- * @return {object} resolution - resolution.x,resolution.y are floating point pixels_per_inch values.
+ * @return {object} surface - the referenced cairo surface.
  */
-static JSVAL surface_get_fallback_resolution(JSARGS args) {
+static JSVAL surface_reference(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    double dx;
-    double dy;
-    cairo_surface_get_fallback_resolution(surface, &dx, &dy);
-    JSOBJ o = Object::New();
-    o->Set(String::New("x_offset"), Number::New(dx));
-    o->Set(String::New("y_offset"), Number::New(dy));
-    return o;
+    return External::New(cairo_surface_reference(surface));
 }
 
 /**
- * @function cairo.surface_get_type
+ * @function cairo.surface_status
  * 
  * ### Synopsis
  * 
- * var type = cairo.surface_get_type(surface);
- * 
- * This function returns the type of the backend used to create a surface.
- * 
- * The returned type will be one of the following:
+ * var status = cairo.surface_status(surface);
  * 
- * + cairo.SURFACE_TYPE_IMAGE - The surface is of type image
- * + cairo.SURFACE_TYPE_PDF - The surface is of type pdf
- * + cairo.SURFACE_TYPE_PS - The surface is of type ps
- * + cairo.SURFACE_TYPE_XLIB - The surface is of type xlib
- * + cairo.SURFACE_TYPE_XCB - The surface is of type xcb
- * + cairo.SURFACE_TYPE_GLITZ - The surface is of type glitz
- * + cairo.SURFACE_TYPE_QUARTZ - The surface is of type quartz
- * + cairo.SURFACE_TYPE_WIN32 - The surface is of type win32
- * + cairo.SURFACE_TYPE_BEOS - The surface is of type beos
- * + cairo.SURFACE_TYPE_DIRECTFB - The surface is of type directfb
- * + cairo.SURFACE_TYPE_SVG - The surface is of type svg
- * + cairo.SURFACE_TYPE_OS2 - The surface is of type os2
- * + cairo.SURFACE_TYPE_WIN32_PRINTING - The surface is a win32 printing surface
- * + cairo.SURFACE_TYPE_QUARTZ_IMAGE - The surface is of type quartz_image
- * + cairo.SURFACE_TYPE_SCRIPT - The surface is of type script, since 1.10
- * + cairo.SURFACE_TYPE_QT - The surface is of type Qt, since 1.10
- * + cairo.SURFACE_TYPE_RECORDING - The surface is of type recording, since 1.10
- * + cairo.SURFACE_TYPE_VG - The surface is a OpenVG surface, since 1.10
- * + cairo.SURFACE_TYPE_GL - The surface is of type OpenGL, since 1.10
- * + cairo.SURFACE_TYPE_DRM - The surface is of type Direct Render Manager, since 1.10
- * + cairo.SURFACE_TYPE_TEE - The surface is of type 'tee' (a multiplexing surface), since 1.10
- * + cairo.SURFACE_TYPE_XML - The surface is of type XML (for debugging), since 1.10
- * + cairo.SURFACE_TYPE_SKIA - The surface is of type Skia, since 1.10
- * + cairo.SURFACE_TYPE_SUBSURFACE - The surface is a subsurface created with cairo_surface_create_for_rectangle(), since 1.10
- * + cairo.SURFACE_TYPE_COGL - This surface is of type Cogl, since 1.12
+ * Checks whether an error has previously occurred for this surface.
  * 
  * @param {object} surface - opaque handle to a cairo surface.
- * @return {int} type - one of the types above.
+ * @return {int} status - one of cairo.STATUS_SUCCESS, cairo.STATUS_NULL_POINTER, cairo.STATUS_NO_MEMORY, cairo.STATUS_READ_ERROR, cairo.STATUS_INVALID_CONTENT, cairo.STATUS_INVALID_FORMAT, or cairo.STATUS_INVALID_VISUAL.
  */
-static JSVAL surface_get_type(JSARGS args) {
+static JSVAL surface_status(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_surface_get_type(surface));
+    return Integer::New(cairo_surface_status(surface));
 }
 
 /**
- * @function cairo.surface_get_reference_count
+ * @function cairo.surface_destroy
  * 
  * ### Synopsis
  * 
- * var count = cairo.surface_get_reference_count(surface);
+ * cairo.surface_destroy(surface);
  * 
- * Returns the current reference count of surface.
+ * Decreases the reference count on surface by one. If the result is zero, then surface and all associated resources are freed. 
+ * 
+ * See cairo.surface_reference().
  * 
  * @param {object} surface - opaque handle to a cairo surface.
- * @return {int} count - reference count of surface.  If the object is a nil object, 0 will be returned.
  */
-static JSVAL surface_get_reference_count(JSARGS args) {
+static JSVAL surface_destroy(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_surface_get_reference_count(surface));
+    cairo_surface_destroy(surface);
+    return Undefined();
 }
 
 /**
- * @function cairo.surface_copy_page
+ * @function cairo.surface_finish
  * 
  * ### Synopsis
  * 
- * cairo.surface_copy_page(surface);
+ * cairo.surface_finish(surface);
  * 
- * Emits the current page for backends that support multiple pages, but doesn't clear it, so that the contents of the current page will be retained for the next page. 
+ * This function finishes the surface and drops all references to external resources. 
  * 
- * Use cairo.surface_show_page() if you want to get an empty page after the emission.
+ * For example, for the Xlib backend it means that cairo will no longer access the drawable, which can be freed. 
  * 
- * There is a convenience function for this that takes a Context, namely cairo.copy_page().
+ * After calling cairo.surface_finish() the only valid operations on a surface are getting and setting user, referencing and destroying, and flushing and finishing it. Further drawing to the surface will not affect the surface but will instead trigger a cairo.STATUS_SURFACE_FINISHED error.
  * 
  * @param {object} surface - opaque handle to a cairo surface.
  */
-static JSVAL surface_copy_page(JSARGS args) {
+static JSVAL surface_finish(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    cairo_surface_copy_page(surface);
+    cairo_surface_finish(surface);
     return Undefined();
 }
 
 /**
- * @function cairo.surface_show_page
+ * @function cairo.surface_flush
  * 
  * ### Synopsis
  * 
- * cairo.surface_show_page(surface);
+ * cairo.surface_flush(surface);
  * 
- * Emits and clears the current page for backends that support multiple pages. Use cairo.surface_copy_page() if you don't want to clear the page.
+ * Do any pending drawing for the surface and also restore any temporary modifications cairo has made to the surface's state. 
  * 
- * There is a convenience function for this that takes a Context, namely cairo.show_page().
+ * This function must be called before switching from drawing on the surface with cairo to drawing on it directly with native APIs. 
+ * 
+ * If the surface doesn't support direct access, then this function does nothing.
  * 
  * @param {object} surface - opaque handle to a cairo surface.
  */
-static JSVAL surface_show_page(JSARGS args) {
+static JSVAL surface_flush(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    cairo_surface_show_page(surface);
+    cairo_surface_flush(surface);
     return Undefined();
 }
 
 /**
- * @function cairo.surface_has_show_text_glyphs
+ * @function cairo.surface_get_device
  * 
  * ### Synopsis
  * 
- * var status = cairo.surface_has_show_text_glyphs(surface);
+ * var device = cairo.surface_get_device(surface);
  * 
- * Returns whether the surface supports sophisticated cairo.show_text_glyphs() operations. That is, whether it actually uses the provided text and cluster data to a cairo.show_text_glyphs() call.
+ * This function returns the device for a surface.
  * 
- * Note: Even if this function returns false, a cairo.show_text_glyphs() operation targeted at surface will still succeed. It just will act like a cairo.show_glyphs() operation. 
+ * See device methods.
  * 
- * Users can use this function to avoid computing UTF-8 text and cluster mapping if the target surface does not use it.
+ * AVAILABLE IN CAIRO 1.10 OR NEWER
  * 
  * @param {object} surface - opaque handle to a cairo surface.
- * @return {boolean} status - true if the surface supports show_text_glyphs().
+ * @return {object} device - opaque handle to the device for the surface, or null if the surface does not have an associated device.
  */
-static JSVAL surface_has_show_text_glyphs(JSARGS args) {
+#if CAIRO_VERSION_MINOR >= 10
+static JSVAL surface_get_device(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return cairo_surface_has_show_text_glyphs(surface) ? True() : False();
+    cairo_device_t *device = cairo_surface_get_device(surface);
+    if (device == NULL) {
+        return Null();
+    }
+    return External::New(device);
 }
-
+#endif
 
 /**
- * @function cairo.image_surface_create
+ * @function cairo.surface_get_font_options
  * 
  * ### Synopsis
  * 
- * var surface = cairo.image_surface_create(format, width, height);
+ * var options = cairo.surface_get_font_options(surface);
  * 
- * Creates an image surface of the specified format and dimensions. Initially the surface contents are all 0. (Specifically, within each pixel, each color or alpha channel belonging to format will be 0. The contents of bits within a pixel, but not belonging to the given format are undefined).
+ * Retrieves the default font rendering options for the surface. 
  * 
- * This function always returns a valid handle, but it will return a handle to a "nil" surface if an error such as out of memory occurs. 
+ * This allows display surfaces to report the correct subpixel order for rendering on them, print surfaces to disable hinting of metrics and so forth. 
  * 
- * You can use cairo.surface_status() to check for this.
+ * The result can then be used with cairo.scaled_font_create().
  * 
- * The format parameter is one of the following:
+ * NOTE: the resulting options object should be freed with cairo.font_options_destroy().
  * 
- * + cairo.CONTENT_COLOR - the surface will hold color content only.
- * + cairo.CONTENT_ALPHA - the surface will hold alpha content only.
- * + cairo.CONTENT_COLOR_ALPHA - the surface will hold color and alpha content.
- *
- * @param {int} format - format of pixels in the surface to create.
- * @param {int} width - width of the surface, in pixels
- * @param {int} height - height of the surface, in pixels.
- * @return {object} surface - opaque handle to the newly created surface. The caller owns the surface and should call cairo.surface_destroy() when done with it. 
+ * The options object returned is an opaque structure holding all options that are used when rendering fonts.
+ * 
+ * Individual features of a cairo font_options object can be set or accessed using functions named cairo.font_options_set_feature_name() and cairo.font_options_get_feature_name(), like cairo.font_options_set_antialias() and cairo.font_options_get_antialias().
+ * 
+ * New features may be added to a cairo font_options object in the future. For this reason, cairo.font_options_copy(), cairo.font_options_equal(), cairo.font_options_merge(), and cairo.font_options_hash() should be used to copy, check for equality, merge, or compute a hash value of cairo font_options objects. 
+ * 
+ * See font_options methods.
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @return {object} options - opaque handle to the font options for the surface, or null if the surface does not have an associated device.
  */
-static JSVAL image_surface_create(JSARGS args) {
-    int format = args[0]->IntegerValue();
-    int width = args[1]->IntegerValue();
-    int height = args[2]->IntegerValue();
-    return External::New(cairo_image_surface_create((cairo_format_t)format, width, height));
+static JSVAL surface_get_font_options(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    cairo_font_options_t *options = track_font_options(cairo_font_options_create());
+    cairo_surface_get_font_options(surface, options);
+    return External::New(options);
 }
 
 /**
- * @functino cairo.image_surface_get_format
+ * @function cairo.surface_get_content
  * 
  * ### Synopsis
  * 
- * var format = cairo.image_surface_get_format(surface);
+ * var content = cairo.surface_get_content(surface);
  * 
- * Get the format of the surface.
+ * This function returns the content type of surface which indicates whether the surface contains color and/or alpha information.
  * 
- * The format returned will be one of the following:
+ * The content type returned is one of:
  * 
- * + cairo.FORMAT_ARGB32
- * + cairo.FORMAT_RGB24
- * + cairo.FORMAT_A8
- * + cairo.FORMAT_A1
- * + cairo.FORMAT_RGB16_565
- * + cairo.FORMAT_RGB30
+ * + cairo.CONTENT_COLOR
+ * + cairo.CONTENT_ALPHA
+ * + cairo.CONTENT_COLOR_ALPHA
  * 
  * @param {object} surface - opaque handle to a cairo surface.
- * @return {int} format - one of the above values.
+ * @return {int} content - type content type of surface.
  */
-static JSVAL image_surface_get_format(JSARGS args) {
+static JSVAL surface_get_content(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_image_surface_get_format(surface));
+    return Integer::New(cairo_surface_get_content(surface));
 }
 
 /**
- * @functino cairo.image_surface_get_width
+ * @function cairo.surface_mark_dirty
  * 
  * ### Synopsis
  * 
- * var width = cairo.image_surface_get_width(surface);
+ * cairo.surface_mark_dirty(surface);
  * 
- * Get the width of the surface.
+ * Tells cairo that drawing has been done to surface using means other than cairo, and that cairo should reread any cached areas. 
+ * 
+ * Note that you must call cairo.surface_flush() before doing such drawing.
  * 
  * @param {object} surface - opaque handle to a cairo surface.
- * @return {int} width - width of the surface in pixels.
  */
-static JSVAL image_surface_get_width(JSARGS args) {
+static JSVAL surface_mark_dirty(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_image_surface_get_width(surface));
+    cairo_surface_mark_dirty(surface);
+    return Undefined();
 }
 
 /**
- * @functino cairo.image_surface_get_height
+ * @function cairo.surface_mark_dirty_rectangle
  * 
  * ### Synopsis
  * 
- * var height = cairo.image_surface_get_height(surface);
+ * cairo.surface_mark_dirty(surface, x,y, w,h);
  * 
- * Get the height of the surface.
+ * Like cairo.surface_mark_dirty(), but drawing has been done only to the specified rectangle, so that cairo can retain cached contents for other parts of the surface.
+ * 
+ * Any cached clip set on the surface will be reset by this function, to make sure that future cairo calls have the clip set that they expect.
+ * 
+ * Note that you must call cairo.surface_flush() before doing such drawing.
  * 
  * @param {object} surface - opaque handle to a cairo surface.
- * @return {int} height - height of the surface in pixels.
+ * @param {int} x - upper left x coordinate of dirty rectangle
+ * @param {int} y - upper left y coordinate of dirty rectangle
+ * @param {int} w - width of dirty rectangle
+ * @param {int} h - height of dirty rectangle
  */
-static JSVAL image_surface_get_height(JSARGS args) {
+static JSVAL surface_mark_dirty_rectangle(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_image_surface_get_height(surface));
+    int x = args[1]->IntegerValue();
+    int y = args[2]->IntegerValue();
+    int w = args[3]->IntegerValue();
+    int h = args[4]->IntegerValue();
+    cairo_surface_mark_dirty_rectangle(surface, x,y, w,h);
+    return Undefined();
 }
 
 /**
- * @function cairo.image_surface_get_data
+ * @function cairo.surface_set_device_offset
  * 
  * ### Synopsis
  * 
- * var imageData = cairo.image_surface_get_data(surface, sx, sy, width, height);
+ * cairo.surface_set_device_offset(surface, x_offset, y_offset);
  * 
- * Gets a canvas style ImageData object.
+ * Sets an offset that is added to the device coordinates determined by the CTM when drawing to surface. 
  * 
- * The imageData object returned is of the following form:
+ * One use case for this function is when we want to create a cairo surface that redirects drawing for a portion of an on-screen surface to an offscreen surface in a way that is completely invisible to the user of the cairo API. Setting a transformation via cairo.translate() isn't sufficient to do this, since functions like cairo.device_to_user() will expose the hidden offset.
  * 
- * + {int} width - width of the image data pixel array in device pixels.
- * + {int} height - height of the image data pixel array in device pixels.
- * + {array} data - pixel data as a one dimensional array in RGBA order, as integers in the range 0..255.
+ * Note that the offset affects drawing to the surface as well as using the surface in a source pattern.
  * 
  * @param {object} surface - opaque handle to a cairo surface.
- * @return {object} imageData - object of the above form.
+ * @param {number} x_offset - the offset in the X direction, in device units
+ * @param {number} y_offset - the offset in the Y direction, in device units
  */
-static JSVAL image_surface_get_data(JSARGS args) {
+static JSVAL surface_set_device_offset(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    int sx = args[1]->IntegerValue();
-    int sy = args[2]->IntegerValue();
-    int width = args[3]->IntegerValue();
-    int height = args[4]->IntegerValue();
-    int length = width * height;
-    int stride = cairo_image_surface_get_stride(surface);
-    int cWidth = cairo_image_surface_get_width(surface);
-    int cHeight = cairo_image_surface_get_height(surface);
-    if (sx < 0) {
-        width += sx;
-        sx = 0;
-    }
-    if (sy < 0) {
-        height += sy;
-        sy = 0;
-    }
-    if (sx + width > cWidth) {
-        width = cWidth - sx;
-    }
-    if (sy + height > cHeight) {
-        height = cHeight - sy;
-    }
-    cairo_surface_flush(surface);
-    uint8_t *src = cairo_image_surface_get_data(surface);
-    Handle<Array>bytes = Array::New(length*4);
-    int ndx = 0;
-    for (int y = 0; y<height; y++) {
-        uint32_t *row = (uint32_t *)(src + stride * (y + sy));
-        for (int x=0; x<width; x++) {
-//            int bx = x*4;
-            uint32_t *pixel = row + x + sx;
-            uint8_t a = *pixel >> 24;
-            uint8_t r = *pixel >> 16;
-            uint8_t g = *pixel >> 8;
-            uint8_t b = *pixel;
-            float alpha = (float)a / 255;
-            bytes->Set(ndx++, Integer::New((int)((float) r / alpha)));
-            bytes->Set(ndx++, Integer::New((int)((float) g / alpha)));
-            bytes->Set(ndx++, Integer::New((int)((float) b / alpha)));
-            bytes->Set(ndx++, Integer::New(a));
+    double dx = args[1]->NumberValue();
+    double dy = args[2]->NumberValue();
+    cairo_surface_set_device_offset(surface, dx, dy);
+    return Undefined();
+}
+
+/**
+ * @function cairo.surface_get_device_offset
+ * 
+ * ### Synopsis
+ * 
+ * var offsets = cairo.surface_get_device_offset(surface);
+ * var out = cairo.surface_get_device_offset(surface, out);
+ * 
+ * This function returns the previous device offset set by cairo.surface_set_device_offset().
+ * 
+ * The object returned is of the form:
+ * 
+ * + {number} x_offset: the offset in the X direction, in device units
+ * + {number} y_offset: the offset in the Y direction, in device units
+ * 
+ * If the optional out argument is given, it must be a Float64Array of at least 2 elements.  The offsets are written to it as [x_offset, y_offset] and out is returned.
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @param {Float64Array} out - optional array to receive [x_offset, y_offset].
+ * @return {object} offsets - offsets.x,offsets.y are floating point x_offset,y_offset values.
+ */
+static JSVAL surface_get_device_offset(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    double dx;
+    double dy;
+    cairo_surface_get_device_offset(surface, &dx, &dy);
+    if (args.Length() > 1) {
+        double *out = float64_array_data(args[1], 2);
+        if (out == NULL) {
+            return throw_bad_out_array("surface_get_device_offset", 2);
         }
+        out[0] = dx;
+        out[1] = dy;
+        return args[1];
     }
     JSOBJ o = Object::New();
-    o->Set(String::New("data"), bytes);
-    o->Set(String::New("width"), Integer::New(width));
-    o->Set(String::New("height"), Integer::New(height));
+    o->Set(String::New("x_offset"), Number::New(dx));
+    o->Set(String::New("y_offset"), Number::New(dy));
     return o;
 }
 
 /**
- * @function cairo.surface_blur
+ * @function cairo.surface_set_fallback_resolution
  * 
  * ### Synopsis
  * 
- * cairo.surface_blur(surface, radius);
+ * cairo.surface_set_fallback_resolution(surface, x_pixels_per_inch, y_pixels_per_inch);
  * 
- * Blur the given surface with the given radius.
+ * Set the horizontal and vertical resolution for image fallbacks.
  * 
- * ### Note
+ * When certain operations aren't supported natively by a backend, cairo will fallback by rendering operations to an image and then overlaying that image onto the output. For backends that are natively vector-oriented, this function can be used to set the resolution used for these image fallbacks, (larger values will result in more detailed images, but also larger file sizes).
  * 
- * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * Some examples of natively vector-oriented backends are the ps, pdf, and svg backends.
+ * 
+ * For backends that are natively raster-oriented, image fallbacks are still possible, but they are always performed at the native device resolution. So this function has no effect on those backends.
+ * 
+ * Note: The fallback resolution only takes effect at the time of completing a page (with cairo.show_page() or cairo.copy_page()) so there is currently no way to have more than one fallback resolution in effect on a single page.
  * 
+ * The default fallback resoultion is 300 pixels per inch in both dimensions.
+ *  
  * @param {object} surface - opaque handle to a cairo surface.
- * @param {int} radius - radius to blur
+ * @param {number} x_pixels_per_inch - horizontal setting for pixels per inch.
+ * @param {number} y_pixels_per_inch - vertical setting for pixels per inch.
  */
-static JSVAL surface_blur(JSARGS args) {
-    // see implementation at https://github.com/LearnBoost/node-canvas/blob/master/src/CanvasRenderingContext2d.cc
+static JSVAL surface_set_fallback_resolution(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    int radius = args[1]->IntegerValue();
+    double dx = args[1]->NumberValue();
+    double dy = args[2]->NumberValue();
+    cairo_surface_set_fallback_resolution(surface, dx, dy);
+    return Undefined();
+}
 
-    // Steve Hanov, 2009
-    // Released into the public domain.
-    --radius;
-    // get width, height
-    int width = cairo_image_surface_get_width(surface);
-    int height = cairo_image_surface_get_height(surface);
-    unsigned* precalc =
-        (unsigned*) malloc(width * height * sizeof (unsigned));
-    unsigned char* src = cairo_image_surface_get_data(surface);
-    double mul = 1.f / ((radius * 2)*(radius * 2));
-    int channel;
+/**
+ * @function cairo.surface_get_fallback_resolution
+ * 
+ * ### Synopsis
+ * 
+ * var resolution = cairo.surface_get_fallback_resolution(surface);
+ * 
+ * This function returns the previous device offset set by cairo.surface_set_fallback_resolution().
+ * 
+ * The object returned is of the form:
+ * 
+ * + {number} x_pixels_per_inch: the offset in the X direction, in device units
+ * + {number} y_pixels_per_inch: the offset in the Y direction, in device units
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @return {object} resolution - resolution.x,resolution.y are floating point pixels_per_inch values.
+ */
+static JSVAL surface_get_fallback_resolution(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    double dx;
+    double dy;
+    cairo_surface_get_fallback_resolution(surface, &dx, &dy);
+    JSOBJ o = Object::New();
+    o->Set(String::New("x_offset"), Number::New(dx));
+    o->Set(String::New("y_offset"), Number::New(dy));
+    return o;
+}
 
-    // The number of times to perform the averaging. According to wikipedia,
-    // three iterations is good enough to pass for a gaussian.
-    const int MAX_ITERATIONS = 3;
-    int iteration;
+/**
+ * @function cairo.surface_get_type
+ * 
+ * ### Synopsis
+ * 
+ * var type = cairo.surface_get_type(surface);
+ * 
+ * This function returns the type of the backend used to create a surface.
+ * 
+ * The returned type will be one of the following:
+ * 
+ * + cairo.SURFACE_TYPE_IMAGE - The surface is of type image
+ * + cairo.SURFACE_TYPE_PDF - The surface is of type pdf
+ * + cairo.SURFACE_TYPE_PS - The surface is of type ps
+ * + cairo.SURFACE_TYPE_XLIB - The surface is of type xlib
+ * + cairo.SURFACE_TYPE_XCB - The surface is of type xcb
+ * + cairo.SURFACE_TYPE_GLITZ - The surface is of type glitz
+ * + cairo.SURFACE_TYPE_QUARTZ - The surface is of type quartz
+ * + cairo.SURFACE_TYPE_WIN32 - The surface is of type win32
+ * + cairo.SURFACE_TYPE_BEOS - The surface is of type beos
+ * + cairo.SURFACE_TYPE_DIRECTFB - The surface is of type directfb
+ * + cairo.SURFACE_TYPE_SVG - The surface is of type svg
+ * + cairo.SURFACE_TYPE_OS2 - The surface is of type os2
+ * + cairo.SURFACE_TYPE_WIN32_PRINTING - The surface is a win32 printing surface
+ * + cairo.SURFACE_TYPE_QUARTZ_IMAGE - The surface is of type quartz_image
+ * + cairo.SURFACE_TYPE_SCRIPT - The surface is of type script, since 1.10
+ * + cairo.SURFACE_TYPE_QT - The surface is of type Qt, since 1.10
+ * + cairo.SURFACE_TYPE_RECORDING - The surface is of type recording, since 1.10
+ * + cairo.SURFACE_TYPE_VG - The surface is a OpenVG surface, since 1.10
+ * + cairo.SURFACE_TYPE_GL - The surface is of type OpenGL, since 1.10
+ * + cairo.SURFACE_TYPE_DRM - The surface is of type Direct Render Manager, since 1.10
+ * + cairo.SURFACE_TYPE_TEE - The surface is of type 'tee' (a multiplexing surface), since 1.10
+ * + cairo.SURFACE_TYPE_XML - The surface is of type XML (for debugging), since 1.10
+ * + cairo.SURFACE_TYPE_SKIA - The surface is of type Skia, since 1.10
+ * + cairo.SURFACE_TYPE_SUBSURFACE - The surface is a subsurface created with cairo_surface_create_for_rectangle(), since 1.10
+ * + cairo.SURFACE_TYPE_COGL - This surface is of type Cogl, since 1.12
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @return {int} type - one of the types above.
+ */
+static JSVAL surface_get_type(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    return Integer::New(cairo_surface_get_type(surface));
+}
 
-    for (iteration = 0; iteration < MAX_ITERATIONS; iteration++) {
-        for (channel = 0; channel < 4; channel++) {
-            int x, y;
+/**
+ * @function cairo.surface_get_reference_count
+ * 
+ * ### Synopsis
+ * 
+ * var count = cairo.surface_get_reference_count(surface);
+ * 
+ * Returns the current reference count of surface.
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @return {int} count - reference count of surface.  If the object is a nil object, 0 will be returned.
+ */
+static JSVAL surface_get_reference_count(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    return Integer::New(cairo_surface_get_reference_count(surface));
+}
 
-            // precomputation step.
-            unsigned char* pix = src;
-            unsigned* pre = precalc;
+/**
+ * @function cairo.surface_copy_page
+ * 
+ * ### Synopsis
+ * 
+ * cairo.surface_copy_page(surface);
+ * 
+ * Emits the current page for backends that support multiple pages, but doesn't clear it, so that the contents of the current page will be retained for the next page. 
+ * 
+ * Use cairo.surface_show_page() if you want to get an empty page after the emission.
+ * 
+ * There is a convenience function for this that takes a Context, namely cairo.copy_page().
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ */
+static JSVAL surface_copy_page(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    cairo_surface_copy_page(surface);
+    return Undefined();
+}
 
-            pix += channel;
-            for (y = 0; y < height; y++) {
-                for (x = 0; x < width; x++) {
-                    int tot = pix[0];
-                    if (x > 0) tot += pre[-1];
-                    if (y > 0) tot += pre[-width];
-                    if (x > 0 && y > 0) tot -= pre[-width - 1];
-                    *pre++ = tot;
-                    pix += 4;
-                }
-            }
+/**
+ * @function cairo.surface_show_page
+ * 
+ * ### Synopsis
+ * 
+ * cairo.surface_show_page(surface);
+ * 
+ * Emits and clears the current page for backends that support multiple pages. Use cairo.surface_copy_page() if you don't want to clear the page.
+ * 
+ * There is a convenience function for this that takes a Context, namely cairo.show_page().
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ */
+static JSVAL surface_show_page(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    cairo_surface_show_page(surface);
+    return Undefined();
+}
 
-            // blur step.
-            pix = src + (int) radius * width * 4 + (int) radius * 4 + channel;
-            for (y = radius; y < height - radius; y++) {
-                for (x = radius; x < width - radius; x++) {
-                    int l = x < radius ? 0 : x - radius;
-                    int t = y < radius ? 0 : y - radius;
-                    int r = x + radius >= width ? width - 1 : x + radius;
-                    int b = y + radius >= height ? height - 1 : y + radius;
-                    int tot = precalc[r + b * width] + precalc[l + t * width] -
-                        precalc[l + b * width] - precalc[r + t * width];
-                    *pix = (unsigned char) (tot * mul);
-                    pix += 4;
-                }
-                pix += (int) radius * 2 * 4;
-            }
+/**
+ * @function cairo.surface_has_show_text_glyphs
+ * 
+ * ### Synopsis
+ * 
+ * var status = cairo.surface_has_show_text_glyphs(surface);
+ * 
+ * Returns whether the surface supports sophisticated cairo.show_text_glyphs() operations. That is, whether it actually uses the provided text and cluster data to a cairo.show_text_glyphs() call.
+ * 
+ * Note: Even if this function returns false, a cairo.show_text_glyphs() operation targeted at surface will still succeed. It just will act like a cairo.show_glyphs() operation. 
+ * 
+ * Users can use this function to avoid computing UTF-8 text and cluster mapping if the target surface does not use it.
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @return {boolean} status - true if the surface supports show_text_glyphs().
+ */
+static JSVAL surface_has_show_text_glyphs(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    return cairo_surface_has_show_text_glyphs(surface) ? True() : False();
+}
+
+
+// Large image surfaces.  Above large_surface_threshold bytes, image_surface_create() allocates
+// pixel memory itself rather than leaving it to cairo's malloc: the buffer is mmap'd directly,
+// rows are padded to 64 bytes so every row starts on a cache line, and the kernel is asked to
+// back it with transparent huge pages, which cuts page faults and TLB misses when a
+// multi-hundred-megabyte surface is swept by blur, encode and the like.  With prefault
+// enabled, the pages are populated at allocation time instead of on first touch.
+struct LargeSurfaceStats {
+    long surfaces;
+    long bytes;
+    long peakBytes;
+    long hugePages;
+    long fallbacks;
+};
+
+static size_t large_surface_threshold = 16 * 1024 * 1024;
+static bool large_surface_prefault = false;
+static LargeSurfaceStats large_surface_stats;
+static cairo_user_data_key_t large_surface_key;
+
+struct LargeSurfaceBuffer {
+    void *addr;
+    size_t size;
+};
+
+static void large_surface_release(void *data) {
+    LargeSurfaceBuffer *buffer = (LargeSurfaceBuffer *) data;
+    munmap(buffer->addr, buffer->size);
+    __sync_fetch_and_sub(&large_surface_stats.surfaces, 1);
+    __sync_fetch_and_sub(&large_surface_stats.bytes, (long) buffer->size);
+    delete buffer;
+}
+
+static cairo_surface_t *large_surface_create(cairo_format_t format, int width, int height) {
+    int stride = cairo_format_stride_for_width(format, width);
+    // past cairo's limit; let cairo return its error surface rather than map the memory first
+    if (stride <= 0 || height <= 0 || width > 32767 || height > 32767) {
+        return cairo_image_surface_create(format, width, height);
+    }
+    stride = (stride + 63) & ~63;
+    size_t size = (size_t) stride * height;
+    if (size < large_surface_threshold) {
+        return cairo_image_surface_create(format, width, height);
+    }
+
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+    if (large_surface_prefault) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (addr == MAP_FAILED) {
+        __sync_fetch_and_add(&large_surface_stats.fallbacks, 1);
+        return cairo_image_surface_create(format, width, height);
+    }
+#ifdef MADV_HUGEPAGE
+    if (madvise(addr, size, MADV_HUGEPAGE) == 0) {
+        __sync_fetch_and_add(&large_surface_stats.hugePages, 1);
+    }
+#endif
+#ifndef MAP_POPULATE
+    if (large_surface_prefault) {
+        long page = sysconf(_SC_PAGESIZE);
+        for (size_t offset = 0; offset < size; offset += page) {
+            ((volatile uint8_t *) addr)[offset] = 0;
         }
     }
+#endif
 
-    free(precalc);
-    return Undefined();
+    cairo_surface_t *surface = cairo_image_surface_create_for_data((unsigned char *) addr, format, width, height, stride);
+    LargeSurfaceBuffer *buffer = new LargeSurfaceBuffer;
+    buffer->addr = addr;
+    buffer->size = size;
+    if (cairo_surface_set_user_data(surface, &large_surface_key, buffer, large_surface_release) != CAIRO_STATUS_SUCCESS) {
+        munmap(addr, size);
+        delete buffer;
+        cairo_surface_destroy(surface);
+        __sync_fetch_and_add(&large_surface_stats.fallbacks, 1);
+        return cairo_image_surface_create(format, width, height);
+    }
+    __sync_fetch_and_add(&large_surface_stats.surfaces, 1);
+    long bytes = __sync_add_and_fetch(&large_surface_stats.bytes, (long) size);
+    for (long peak = large_surface_stats.peakBytes; bytes > peak; peak = large_surface_stats.peakBytes) {
+        __sync_bool_compare_and_swap(&large_surface_stats.peakBytes, peak, bytes);
+    }
+    return surface;
 }
 
-////////////////////// CONTEXTS
+/**
+ * @function cairo.image_surface_create
+ * 
+ * ### Synopsis
+ * 
+ * var surface = cairo.image_surface_create(format, width, height);
+ * 
+ * Creates an image surface of the specified format and dimensions. Initially the surface contents are all 0. (Specifically, within each pixel, each color or alpha channel belonging to format will be 0. The contents of bits within a pixel, but not belonging to the given format are undefined).
+ * 
+ * This function always returns a valid handle, but it will return a handle to a "nil" surface if an error such as out of memory occurs. 
+ * 
+ * You can use cairo.surface_status() to check for this.
+ * 
+ * The format parameter is one of the following:
+ * 
+ * + cairo.CONTENT_COLOR - the surface will hold color content only.
+ * + cairo.CONTENT_ALPHA - the surface will hold alpha content only.
+ * + cairo.CONTENT_COLOR_ALPHA - the surface will hold color and alpha content.
+ *
+ * @param {int} format - format of pixels in the surface to create.
+ * @param {int} width - width of the surface, in pixels
+ * @param {int} height - height of the surface, in pixels.
+ * @return {object} surface - opaque handle to the newly created surface. The caller owns the surface and should call cairo.surface_destroy() when done with it. 
+ */
+static JSVAL image_surface_create(JSARGS args) {
+    int format = args[0]->IntegerValue();
+    int width = args[1]->IntegerValue();
+    int height = args[2]->IntegerValue();
+    char msg[256];
+    if (!memory_admit("image_surface_create", width, height, msg, sizeof(msg))) {
+        return ThrowException(String::New(msg));
+    }
+    return External::New(track_surface(large_surface_create((cairo_format_t)format, width, height)));
+}
 
 /**
- * @function cairo.context_create
+ * @function cairo.image_surface_configure_allocator
  * 
  * ### Synopsis
  * 
- * var context = cairo.context_create(surface);
+ * cairo.image_surface_configure_allocator(threshold, prefault);
  * 
- * Creates a new context with all graphics state parameters set to default values and with surface as a target surface. The target surface should be constructed with a backend-specific function such as cairo.image_surface_create() (or any other cairo.backend_surface_create() variant).
+ * Configure how cairo.image_surface_create() allocates large surfaces.
  * 
- * This function references surface, so you can immediately call cairo.surface_destroy() on it if you don't need to maintain a separate reference to it.
+ * Surfaces whose pixel data is at least threshold bytes are allocated with mmap, with each row padded to a multiple of 64 bytes, and the memory is advised for transparent huge pages where the system supports them.  If prefault is true, the memory is populated when the surface is created rather than page by page as it is first drawn on.  Smaller surfaces are allocated by cairo as usual.
  * 
- * @param {object} surface - opaque handle to a cairo surface.
- * @return {object} context - opaque handle to a cairo context.
+ * The defaults are a threshold of 16MB and no prefaulting.  Surfaces that already exist are not affected.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {int} threshold - size in bytes from which surfaces are allocated this way.
+ * @param {boolean} prefault - true to populate the memory up front.
  */
-static JSVAL context_create(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return External::New(cairo_create(surface));
+static JSVAL image_surface_configure_allocator(JSARGS args) {
+    large_surface_threshold = (size_t) args[0]->IntegerValue();
+    if (args.Length() > 1) {
+        large_surface_prefault = args[1]->BooleanValue();
+    }
+    return Undefined();
+}
+
+/**
+ * @function cairo.image_surface_allocator_stats
+ * 
+ * ### Synopsis
+ * 
+ * var stats = cairo.image_surface_allocator_stats();
+ * 
+ * Get statistics about the large surfaces allocated by cairo.image_surface_create().
+ * 
+ * The returned object has the following members:
+ * 
+ * + surfaces - number of large surfaces currently allocated.
+ * + bytes - bytes of pixel memory held by them.
+ * + peakBytes - the most bytes held at any one time.
+ * + hugePages - number of allocations the kernel accepted the huge page advice for.
+ * + fallbacks - number of large surfaces that had to be allocated by cairo instead.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @return {object} stats - allocation statistics.
+ */
+static JSVAL image_surface_allocator_stats(JSARGS args) {
+    JSOBJ o = Object::New();
+    o->Set(String::New("surfaces"), Number::New(large_surface_stats.surfaces));
+    o->Set(String::New("bytes"), Number::New(large_surface_stats.bytes));
+    o->Set(String::New("peakBytes"), Number::New(large_surface_stats.peakBytes));
+    o->Set(String::New("hugePages"), Number::New(large_surface_stats.hugePages));
+    o->Set(String::New("fallbacks"), Number::New(large_surface_stats.fallbacks));
+    return o;
+}
+
+/**
+ * @functino cairo.image_surface_get_format
+ * 
+ * ### Synopsis
+ * 
+ * var format = cairo.image_surface_get_format(surface);
+ * 
+ * Get the format of the surface.
+ * 
+ * The format returned will be one of the following:
+ * 
+ * + cairo.FORMAT_ARGB32
+ * + cairo.FORMAT_RGB24
+ * + cairo.FORMAT_A8
+ * + cairo.FORMAT_A1
+ * + cairo.FORMAT_RGB16_565
+ * + cairo.FORMAT_RGB30
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @return {int} format - one of the above values.
+ */
+static JSVAL image_surface_get_format(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    return Integer::New(cairo_image_surface_get_format(surface));
+}
+
+/**
+ * @functino cairo.image_surface_get_width
+ * 
+ * ### Synopsis
+ * 
+ * var width = cairo.image_surface_get_width(surface);
+ * 
+ * Get the width of the surface.
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @return {int} width - width of the surface in pixels.
+ */
+static JSVAL image_surface_get_width(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    return Integer::New(cairo_image_surface_get_width(surface));
+}
+
+/**
+ * @functino cairo.image_surface_get_height
+ * 
+ * ### Synopsis
+ * 
+ * var height = cairo.image_surface_get_height(surface);
+ * 
+ * Get the height of the surface.
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @return {int} height - height of the surface in pixels.
+ */
+static JSVAL image_surface_get_height(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    return Integer::New(cairo_image_surface_get_height(surface));
+}
+
+/**
+ * @function cairo.image_surface_get_data
+ * 
+ * ### Synopsis
+ * 
+ * var imageData = cairo.image_surface_get_data(surface, sx, sy, width, height);
+ * 
+ * Gets a canvas style ImageData object.
+ * 
+ * The imageData object returned is of the following form:
+ * 
+ * + {int} width - width of the image data pixel array in device pixels.
+ * + {int} height - height of the image data pixel array in device pixels.
+ * + {array} data - pixel data as a one dimensional array in RGBA order, as integers in the range 0..255.
+ * 
+ * @param {object} surface - opaque handle to an image surface, or a subsurface of one made by cairo.surface_create_for_rectangle().
+ * @return {object} imageData - object of the above form.
+ */
+static JSVAL image_surface_get_data(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    SurfacePixels pixels;
+    if (!surface_pixels(surface, &pixels)) {
+        return ThrowException(String::New("image_surface_get_data: not an image surface"));
+    }
+    int sx = args[1]->IntegerValue();
+    int sy = args[2]->IntegerValue();
+    int width = args[3]->IntegerValue();
+    int height = args[4]->IntegerValue();
+    int length = width * height;
+    int stride = pixels.stride;
+    int cWidth = pixels.width;
+    int cHeight = pixels.height;
+    if (sx < 0) {
+        width += sx;
+        sx = 0;
+    }
+    if (sy < 0) {
+        height += sy;
+        sy = 0;
+    }
+    if (sx + width > cWidth) {
+        width = cWidth - sx;
+    }
+    if (sy + height > cHeight) {
+        height = cHeight - sy;
+    }
+    cairo_surface_flush(pixels.image);
+    uint8_t *src = pixels.data;
+    Handle<Array>bytes = Array::New(length*4);
+    int ndx = 0;
+    for (int y = 0; y<height; y++) {
+        uint32_t *row = (uint32_t *)(src + stride * (y + sy));
+        for (int x=0; x<width; x++) {
+//            int bx = x*4;
+            uint32_t *pixel = row + x + sx;
+            uint8_t a = *pixel >> 24;
+            uint8_t r = *pixel >> 16;
+            uint8_t g = *pixel >> 8;
+            uint8_t b = *pixel;
+            float alpha = (float)a / 255;
+            bytes->Set(ndx++, Integer::New((int)((float) r / alpha)));
+            bytes->Set(ndx++, Integer::New((int)((float) g / alpha)));
+            bytes->Set(ndx++, Integer::New((int)((float) b / alpha)));
+            bytes->Set(ndx++, Integer::New(a));
+        }
+    }
+    JSOBJ o = Object::New();
+    o->Set(String::New("data"), bytes);
+    o->Set(String::New("width"), Integer::New(width));
+    o->Set(String::New("height"), Integer::New(height));
+    return o;
+}
+
+// Pixel export kernels.  Rows of cairo's native-endian premultiplied ARGB32 are converted to
+// byte-ordered formats: R and B swapped (rgba-premul), un-premultiplied (rgba), or
+// un-premultiplied without alpha (rgb).  With SSE2, four pixels are swizzled per step, and
+// un-premultiplying takes the swizzle path for runs of opaque pixels, which dominate most images.
+enum PixelLayout {
+    PIXELS_BGRA_PREMUL,
+    PIXELS_RGBA_PREMUL,
+    PIXELS_RGBA,
+    PIXELS_RGB
+};
+
+// force is OR'd into each pixel: 0xff000000 for RGB24 surfaces, whose top byte is undefined
+static void pixels_copy_row(uint8_t *dst, const uint32_t *src, int count, uint32_t force) {
+    if (!force) {
+        memcpy(dst, src, (size_t) count * 4);
+        return;
+    }
+    for (int x = 0; x < count; x++) {
+        uint32_t pixel = src[x] | force;
+        memcpy(dst + x * 4, &pixel, 4);
+    }
+}
+
+static void pixels_swap_row(uint8_t *dst, const uint32_t *src, int count, uint32_t force) {
+    int x = 0;
+#ifdef __SSE2__
+    __m128i ag = _mm_set1_epi32(0xff00ff00), low = _mm_set1_epi32(0xff), f = _mm_set1_epi32(force);
+    for (; x + 4 <= count; x += 4) {
+        __m128i v = _mm_or_si128(_mm_loadu_si128((const __m128i *) (src + x)), f);
+        __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+        _mm_storeu_si128((__m128i *) (dst + x * 4), _mm_or_si128(_mm_and_si128(v, ag), _mm_or_si128(r, b)));
+    }
+#endif
+    for (; x < count; x++) {
+        uint32_t pixel = src[x] | force;
+        uint8_t *p = dst + x * 4;
+        p[0] = pixel >> 16;
+        p[1] = pixel >> 8;
+        p[2] = pixel;
+        p[3] = pixel >> 24;
+    }
+}
+
+static inline void pixels_unpremultiply_pixel(uint8_t *p, uint32_t pixel, bool alpha) {
+    uint32_t a = pixel >> 24;
+    if (a == 255) {
+        p[0] = pixel >> 16;
+        p[1] = pixel >> 8;
+        p[2] = pixel;
+    }
+    else if (a == 0) {
+        p[0] = p[1] = p[2] = 0;
+    }
+    else {
+        p[0] = (((pixel >> 16) & 0xff) * 255 + a / 2) / a;
+        p[1] = (((pixel >> 8) & 0xff) * 255 + a / 2) / a;
+        p[2] = ((pixel & 0xff) * 255 + a / 2) / a;
+    }
+    if (alpha) {
+        p[3] = a;
+    }
+}
+
+static void pixels_unpremultiply_row(uint8_t *dst, const uint32_t *src, int count, uint32_t force, bool alpha) {
+    int bpp = alpha ? 4 : 3;
+    int x = 0;
+#ifdef __SSE2__
+    if (alpha) {
+        __m128i a = _mm_set1_epi32(0xff000000), f = _mm_set1_epi32(force);
+        for (; x + 4 <= count; x += 4) {
+            __m128i v = _mm_or_si128(_mm_loadu_si128((const __m128i *) (src + x)), f);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, a), a)) == 0xffff) {
+                pixels_swap_row(dst + x * 4, src + x, 4, force);
+            }
+            else {
+                for (int i = x; i < x + 4; i++) {
+                    pixels_unpremultiply_pixel(dst + i * 4, src[i] | force, true);
+                }
+            }
+        }
+    }
+#endif
+    for (; x < count; x++) {
+        pixels_unpremultiply_pixel(dst + x * bpp, src[x] | force, alpha);
+    }
+}
+
+/**
+ * @function cairo.surface_read_pixels
+ * 
+ * ### Synopsis
+ * 
+ * var info = cairo.surface_read_pixels(surface, rect, format);
+ * var info = cairo.surface_read_pixels(surface, rect, format, out);
+ * 
+ * Copies the pixels of a rectangle of an image surface into a Uint8Array, in one of these layouts:
+ * 
+ * + 'bgra-premul' - premultiplied, exactly as cairo stores them (B, G, R, A bytes on little-endian machines).  Rows are copied with memcpy.
+ * + 'rgba-premul' - premultiplied, R, G, B, A bytes.
+ * + 'rgba' - R, G, B, A bytes, not premultiplied, as in canvas ImageData.
+ * + 'rgb' - R, G, B bytes, not premultiplied; alpha is dropped.
+ * 
+ * The rows are packed, with no padding between them.  RGB24 surfaces read as opaque.
+ * 
+ * If out is omitted, nothing is copied; the returned object tells how large out has to be.
+ * 
+ * The object returned is of the following form:
+ * 
+ * + {int} x, y, width, height - the rectangle read, after clipping rect to the surface.
+ * + {int} stride - bytes per row in out.
+ * + {int} length - bytes needed in out.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} surface - opaque handle to an ARGB32 or RGB24 image surface, or a subsurface of one made by cairo.surface_create_for_rectangle().
+ * @param {object} rect - {x, y, width, height} to read, or null for the whole surface.
+ * @param {string} format - one of the layouts above; the default is 'bgra-premul'.
+ * @param {Uint8Array} out - optional array of at least length bytes to receive the pixels.
+ * @return {object} info - object of the above form.
+ */
+static JSVAL surface_read_pixels(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    SurfacePixels pixels;
+    if (!surface_pixels(surface, &pixels)) {
+        return ThrowException(String::New("surface_read_pixels: not an image surface"));
+    }
+    cairo_format_t format = pixels.format;
+    if (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24) {
+        return ThrowException(String::New("surface_read_pixels: unsupported surface format"));
+    }
+    int cWidth = pixels.width;
+    int cHeight = pixels.height;
+    int sx = 0, sy = 0, width = cWidth, height = cHeight;
+    if (args.Length() > 1 && args[1]->IsObject()) {
+        JSOBJ o = args[1]->ToObject();
+        sx = o->Get(String::New("x"))->IntegerValue();
+        sy = o->Get(String::New("y"))->IntegerValue();
+        width = o->Get(String::New("width"))->IntegerValue();
+        height = o->Get(String::New("height"))->IntegerValue();
+    }
+    if (sx < 0) {
+        width += sx;
+        sx = 0;
+    }
+    if (sy < 0) {
+        height += sy;
+        sy = 0;
+    }
+    if (sx + width > cWidth) {
+        width = cWidth - sx;
+    }
+    if (sy + height > cHeight) {
+        height = cHeight - sy;
+    }
+    if (width <= 0 || height <= 0) {
+        width = height = 0;
+    }
+
+    PixelLayout layout = PIXELS_BGRA_PREMUL;
+    if (args.Length() > 2 && !args[2]->IsUndefined()) {
+        String::Utf8Value name(args[2]->ToString());
+        if (!strcmp(*name, "rgba-premul")) {
+            layout = PIXELS_RGBA_PREMUL;
+        }
+        else if (!strcmp(*name, "rgba")) {
+            layout = PIXELS_RGBA;
+        }
+        else if (!strcmp(*name, "rgb")) {
+            layout = PIXELS_RGB;
+        }
+        else if (strcmp(*name, "bgra-premul")) {
+            return ThrowException(String::New("surface_read_pixels: unknown pixel format"));
+        }
+    }
+    int stride = width * (layout == PIXELS_RGB ? 3 : 4);
+    int length = stride * height;
+
+    if (args.Length() > 3 && !args[3]->IsUndefined()) {
+        JSOBJ out = args[3]->IsObject() ? args[3]->ToObject() : JSOBJ();
+        if (out.IsEmpty()
+            || !out->HasIndexedPropertiesInExternalArrayData()
+            || out->GetIndexedPropertiesExternalArrayDataType() != kExternalUnsignedByteArray
+            || out->GetIndexedPropertiesExternalArrayDataLength() < length) {
+            char msg[128];
+            snprintf(msg, sizeof(msg), "surface_read_pixels: out argument must be a Uint8Array of at least %d elements", length);
+            return ThrowException(String::New(msg));
+        }
+        uint8_t *dst = (uint8_t *) out->GetIndexedPropertiesExternalArrayData();
+        uint32_t force = format == CAIRO_FORMAT_RGB24 ? 0xff000000 : 0;
+        cairo_surface_flush(pixels.image);
+        uint8_t *src = pixels.data;
+        int srcStride = pixels.stride;
+        for (int y = 0; y < height; y++) {
+            const uint32_t *row = (const uint32_t *) (src + (size_t) srcStride * (y + sy)) + sx;
+            uint8_t *p = dst + (size_t) stride * y;
+            switch (layout) {
+                case PIXELS_BGRA_PREMUL:
+                    pixels_copy_row(p, row, width, force);
+                    break;
+                case PIXELS_RGBA_PREMUL:
+                    pixels_swap_row(p, row, width, force);
+                    break;
+                case PIXELS_RGBA:
+                    pixels_unpremultiply_row(p, row, width, force, true);
+                    break;
+                case PIXELS_RGB:
+                    pixels_unpremultiply_row(p, row, width, force, false);
+                    break;
+            }
+        }
+    }
+
+    JSOBJ o = Object::New();
+    o->Set(String::New("x"), Integer::New(sx));
+    o->Set(String::New("y"), Integer::New(sy));
+    o->Set(String::New("width"), Integer::New(width));
+    o->Set(String::New("height"), Integer::New(height));
+    o->Set(String::New("stride"), Integer::New(stride));
+    o->Set(String::New("length"), Integer::New(length));
+    return o;
+}
+
+static void blur_image_surface(cairo_surface_t *surface, int radius) {
+    MetricsTimer timer(METRICS_BLUR, "surface_blur");
+    timer.arg("radius", radius);
+    // see implementation at https://github.com/LearnBoost/node-canvas/blob/master/src/CanvasRenderingContext2d.cc
+    // Steve Hanov, 2009
+    // Released into the public domain.
+    --radius;
+    // 32 bit image surfaces only; rows are stride bytes apart, which may be more than width * 4
+    if (cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE
+        || (cairo_image_surface_get_format(surface) != CAIRO_FORMAT_ARGB32 && cairo_image_surface_get_format(surface) != CAIRO_FORMAT_RGB24)) {
+        return;
+    }
+    // get width, height
+    int width = cairo_image_surface_get_width(surface);
+    int height = cairo_image_surface_get_height(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    unsigned* precalc =
+        (unsigned*) malloc(width * height * sizeof (unsigned));
+    cairo_surface_flush(surface);
+    unsigned char* src = cairo_image_surface_get_data(surface);
+    double mul = 1.f / ((radius * 2)*(radius * 2));
+    int channel;
+
+    // The number of times to perform the averaging. According to wikipedia,
+    // three iterations is good enough to pass for a gaussian.
+    const int MAX_ITERATIONS = 3;
+    int iteration;
+
+    for (iteration = 0; iteration < MAX_ITERATIONS; iteration++) {
+        for (channel = 0; channel < 4; channel++) {
+            int x, y;
+
+            // precomputation step.
+            unsigned char* pix;
+            unsigned* pre = precalc;
+
+            for (y = 0; y < height; y++) {
+                pix = src + (size_t) y * stride + channel;
+                for (x = 0; x < width; x++) {
+                    int tot = pix[0];
+                    if (x > 0) tot += pre[-1];
+                    if (y > 0) tot += pre[-width];
+                    if (x > 0 && y > 0) tot -= pre[-width - 1];
+                    *pre++ = tot;
+                    pix += 4;
+                }
+            }
+
+            // blur step.
+            for (y = radius; y < height - radius; y++) {
+                pix = src + (size_t) y * stride + (int) radius * 4 + channel;
+                for (x = radius; x < width - radius; x++) {
+                    int l = x < radius ? 0 : x - radius;
+                    int t = y < radius ? 0 : y - radius;
+                    int r = x + radius >= width ? width - 1 : x + radius;
+                    int b = y + radius >= height ? height - 1 : y + radius;
+                    int tot = precalc[r + b * width] + precalc[l + t * width] -
+                        precalc[l + b * width] - precalc[r + t * width];
+                    *pix = (unsigned char) (tot * mul);
+                    pix += 4;
+                }
+            }
+        }
+    }
+
+    free(precalc);
+    cairo_surface_mark_dirty(surface);
+}
+
+/**
+ * @function cairo.surface_blur
+ * 
+ * ### Synopsis
+ * 
+ * cairo.surface_blur(surface, radius);
+ * 
+ * Blur the given surface with the given radius.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @param {int} radius - radius to blur
+ */
+static JSVAL surface_blur(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    blur_image_surface(surface, args[1]->IntegerValue());
+    return Undefined();
+}
+
+// Content bounds scanning.  A pixel is "content" when its alpha is greater than the threshold.
+//
+// first_content_column() returns the first column in [from, to) holding content, or to if there is none.
+// last_content_column() returns the last column in [from, to) holding content, or from - 1 if there is none.
+// With SSE2 four ARGB32 pixels are tested per compare.
+static int first_content_column(const uint32_t *row, int from, int to, int threshold) {
+    int x = from;
+#ifdef __SSE2__
+    __m128i t = _mm_set1_epi32(threshold);
+    for (; x + 4 <= to; x += 4) {
+        __m128i alpha = _mm_srli_epi32(_mm_loadu_si128((const __m128i *)(row + x)), 24);
+        int mask = _mm_movemask_epi8(_mm_cmpgt_epi32(alpha, t));
+        if (mask) {
+            return x + (__builtin_ctz(mask) >> 2);
+        }
+    }
+#endif
+    for (; x < to; x++) {
+        if ((int)(row[x] >> 24) > threshold) {
+            return x;
+        }
+    }
+    return to;
+}
+
+static int last_content_column(const uint32_t *row, int from, int to, int threshold) {
+    int x = to;
+#ifdef __SSE2__
+    __m128i t = _mm_set1_epi32(threshold);
+    for (; x - 4 >= from; x -= 4) {
+        __m128i alpha = _mm_srli_epi32(_mm_loadu_si128((const __m128i *)(row + x - 4)), 24);
+        int mask = _mm_movemask_epi8(_mm_cmpgt_epi32(alpha, t));
+        if (mask) {
+            return x - 4 + ((31 - __builtin_clz(mask)) >> 2);
+        }
+    }
+#endif
+    while (--x >= from) {
+        if ((int)(row[x] >> 24) > threshold) {
+            return x;
+        }
+    }
+    return from - 1;
+}
+
+static int first_content_byte(const uint8_t *row, int from, int to, int threshold) {
+    for (int x = from; x < to; x++) {
+        if (row[x] > threshold) {
+            return x;
+        }
+    }
+    return to;
+}
+
+static int last_content_byte(const uint8_t *row, int from, int to, int threshold) {
+    for (int x = to - 1; x >= from; x--) {
+        if (row[x] > threshold) {
+            return x;
+        }
+    }
+    return from - 1;
+}
+
+/**
+ * @function cairo.surface_content_bounds
+ * 
+ * ### Synopsis
+ * 
+ * var bounds = cairo.surface_content_bounds(surface);
+ * var bounds = cairo.surface_content_bounds(surface, alphaThreshold);
+ * 
+ * Find the bounding box of the visible content of an image surface; that is, the smallest rectangle containing every pixel whose alpha value is greater than alphaThreshold.
+ * 
+ * The object returned is of the form:
+ * 
+ * + {int} x - left edge of the bounding box, in pixels.
+ * + {int} y - top edge of the bounding box, in pixels.
+ * + {int} width - width of the bounding box, in pixels.
+ * + {int} height - height of the bounding box, in pixels.
+ * 
+ * If the surface has no pixels above the threshold, null is returned.
+ * 
+ * Rows are scanned from the top and bottom to find the vertical extent, then only the columns outside the bounds found so far are scanned in each remaining row.  RGB24 surfaces are opaque, so their bounds are the whole surface.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} surface - opaque handle to an ARGB32, RGB24 or A8 image surface, or a subsurface of one made by cairo.surface_create_for_rectangle().
+ * @param {int} alphaThreshold - optional alpha value (0-255) a pixel must exceed to count as content; default is 0.
+ * @return {object} bounds - object of the above form, or null.
+ */
+static JSVAL surface_content_bounds(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    int threshold = args.Length() > 1 ? args[1]->IntegerValue() : 0;
+    SurfacePixels pixels;
+    if (!surface_pixels(surface, &pixels)) {
+        return ThrowException(String::New("surface_content_bounds: not an image surface"));
+    }
+    cairo_format_t format = pixels.format;
+    int width = pixels.width;
+    int height = pixels.height;
+    int stride = pixels.stride;
+
+    if (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24 && format != CAIRO_FORMAT_A8) {
+        return ThrowException(String::New("surface_content_bounds: unsupported surface format"));
+    }
+    if (threshold < 0) {
+        threshold = 0;
+    }
+    if (width <= 0 || height <= 0 || threshold > 254) {
+        return Null();
+    }
+
+    int left = width, right = -1, top = -1, bottom = -1;
+    if (format == CAIRO_FORMAT_RGB24) {
+        left = 0; right = width - 1; top = 0; bottom = height - 1;
+    }
+    else {
+        cairo_surface_flush(pixels.image);
+        uint8_t *data = pixels.data;
+        bool a8 = format == CAIRO_FORMAT_A8;
+
+        for (int y = 0; y < height; y++) {
+            uint8_t *row = data + y * stride;
+            int x = a8 ? first_content_byte(row, 0, width, threshold) : first_content_column((uint32_t *)row, 0, width, threshold);
+            if (x < width) {
+                top = y;
+                left = x;
+                break;
+            }
+        }
+        if (top < 0) {
+            return Null();
+        }
+        for (int y = height - 1; y >= top; y--) {
+            uint8_t *row = data + y * stride;
+            int x = a8 ? last_content_byte(row, 0, width, threshold) : last_content_column((uint32_t *)row, 0, width, threshold);
+            if (x >= 0) {
+                bottom = y;
+                right = x;
+                break;
+            }
+        }
+        // the top and bottom rows have been scanned fully from one side; every row
+        // in between only needs the columns outside [left, right] examined.
+        for (int y = top; y <= bottom && (left > 0 || right < width - 1); y++) {
+            uint8_t *row = data + y * stride;
+            if (a8) {
+                left = first_content_byte(row, 0, left, threshold);
+                int r = last_content_byte(row, right + 1, width, threshold);
+                if (r > right) {
+                    right = r;
+                }
+            }
+            else {
+                left = first_content_column((uint32_t *)row, 0, left, threshold);
+                int r = last_content_column((uint32_t *)row, right + 1, width, threshold);
+                if (r > right) {
+                    right = r;
+                }
+            }
+        }
+    }
+
+    JSOBJ o = Object::New();
+    o->Set(String::New("x"), Integer::New(left));
+    o->Set(String::New("y"), Integer::New(top));
+    o->Set(String::New("width"), Integer::New(right - left + 1));
+    o->Set(String::New("height"), Integer::New(bottom - top + 1));
+    return o;
+}
+
+/**
+ * @function cairo.surface_clear
+ * 
+ * ### Synopsis
+ * 
+ * cairo.surface_clear(surface);
+ * 
+ * Set every pixel of surface to transparent black.
+ * 
+ * For image surfaces, and subsurfaces of them made by cairo.surface_create_for_rectangle(), the pixel buffer is zeroed directly, which is much cheaper than painting with cairo.OPERATOR_CLEAR.  Other surfaces are cleared by painting.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ */
+static JSVAL surface_clear(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    SurfacePixels pixels;
+    if (surface_pixels(surface, &pixels)) {
+        cairo_surface_flush(pixels.image);
+        if (!pixels.data) {
+            return Undefined();
+        }
+        if (pixels.image == surface) {
+            memset(pixels.data, 0, (size_t) pixels.stride * pixels.height);
+        }
+        else {
+            size_t rowBytes = (size_t) pixels.width * surface_pixel_bytes(pixels.format);
+            for (int y = 0; y < pixels.height; y++) {
+                memset(pixels.data + (size_t) y * pixels.stride, 0, rowBytes);
+            }
+        }
+        cairo_surface_mark_dirty(pixels.image);
+        return Undefined();
+    }
+    cairo_t *context = cairo_create(surface);
+    cairo_set_operator(context, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(context);
+    cairo_destroy(context);
+    return Undefined();
+}
+
+////////////////////////// SNAPSHOTS
+
+// A snapshot is a frozen copy of an image surface's pixels held in an unlinked temporary
+// file.  Surfaces created from a snapshot map the file MAP_PRIVATE, so they share the
+// snapshot's pages until written to, at which point the kernel copies just the touched page.
+struct Snapshot {
+    int fd;
+    size_t size;
+    int width;
+    int height;
+    int stride;
+    cairo_format_t format;
+    int refs;
+};
+
+// attached to surfaces created by snapshot_create_surface()
+struct SnapshotMapping {
+    Snapshot *snapshot;
+    void *addr;
+};
+
+static cairo_user_data_key_t snapshot_mapping_key;
+
+static void snapshot_release(Snapshot *snapshot) {
+    if (--snapshot->refs == 0) {
+        memory_untrack_untagged(MEMORY_SNAPSHOT, snapshot, snapshot->size);
+        close(snapshot->fd);
+        delete snapshot;
+    }
+}
+
+// Write or read all of size bytes at offset in a snapshot's file.
+static bool snapshot_write(int fd, const uint8_t *data, size_t size, off_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pwrite(fd, data + done, size - done, offset + done);
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+static bool snapshot_read(int fd, uint8_t *data, size_t size, off_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, data + done, size - done, offset + done);
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+static void snapshot_mapping_destroy(void *data) {
+    SnapshotMapping *mapping = (SnapshotMapping *) data;
+    munmap(mapping->addr, mapping->snapshot->size);
+    snapshot_release(mapping->snapshot);
+    delete mapping;
+}
+
+/**
+ * @function cairo.snapshot_create
+ * 
+ * ### Synopsis
+ * 
+ * var snapshot = cairo.snapshot_create(surface);
+ * 
+ * Take a snapshot of the pixels of an image surface.
+ * 
+ * The pixels are copied once into an unlinked temporary file.  Any number of surfaces can then be created from the snapshot with cairo.snapshot_create_surface(); they share the snapshot's memory and only copy the pages they draw on.  A surface can be returned to the snapshot's contents with cairo.snapshot_restore().
+ * 
+ * The snapshot should be released with cairo.snapshot_destroy().  Surfaces created from it remain valid after it is destroyed.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} surface - opaque handle to an image surface, or a subsurface of one made by cairo.surface_create_for_rectangle().
+ * @return {object} snapshot - opaque handle to the snapshot.
+ */
+static JSVAL snapshot_create(JSARGS args) {
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    SurfacePixels pixels;
+    if (!surface_pixels(surface, &pixels)) {
+        return ThrowException(String::New("snapshot_create: not an image surface"));
+    }
+    cairo_surface_flush(pixels.image);
+
+    const char *tmpdir = getenv("TMPDIR");
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/silkjs-canvas-XXXXXX", tmpdir ? tmpdir : "/tmp");
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        return ThrowException(String::New("snapshot_create: could not create temporary file"));
+    }
+    unlink(path);
+
+    Snapshot *snapshot = new Snapshot;
+    snapshot->fd = fd;
+    snapshot->width = pixels.width;
+    snapshot->height = pixels.height;
+    snapshot->format = pixels.format;
+    // a view's rows are repacked at the usual stride for its width
+    snapshot->stride = pixels.image == surface ? pixels.stride : cairo_format_stride_for_width(pixels.format, pixels.width);
+    snapshot->size = (size_t) snapshot->stride * snapshot->height;
+    snapshot->refs = 1;
+    memory_track_untagged(MEMORY_SNAPSHOT, snapshot, snapshot->size);
+
+    bool ok;
+    if (pixels.image == surface) {
+        ok = snapshot_write(fd, pixels.data, snapshot->size, 0);
+    }
+    else {
+        size_t rowBytes = (size_t) pixels.width * surface_pixel_bytes(pixels.format);
+        ok = ftruncate(fd, snapshot->size) == 0;
+        for (int y = 0; ok && y < pixels.height; y++) {
+            ok = snapshot_write(fd, pixels.data + (size_t) y * pixels.stride, rowBytes, (off_t) y * snapshot->stride);
+        }
+    }
+    if (!ok) {
+        snapshot_release(snapshot);
+        return ThrowException(String::New("snapshot_create: could not write snapshot"));
+    }
+    return External::New(snapshot);
+}
+
+/**
+ * @function cairo.snapshot_create_surface
+ * 
+ * ### Synopsis
+ * 
+ * var surface = cairo.snapshot_create_surface(snapshot);
+ * 
+ * Create an image surface whose initial contents are those of the snapshot.
+ * 
+ * The surface's pixels are mapped copy-on-write from the snapshot, so creating it does not copy any pixels; each page is copied the first time it is drawn on.  A snapshot of an empty (zero width or height) surface gives an ordinary empty image surface.  The surface is still checked against the limits set by cairo.memory_set_limits() as a surface of its full size, since drawing may copy every page; an exception is thrown if it does not fit.
+ * 
+ * The caller owns the returned surface and should call cairo.surface_destroy() when done with it.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} snapshot - opaque handle to a snapshot.
+ * @return {object} surface - opaque handle to a new image surface.
+ */
+static JSVAL snapshot_create_surface(JSARGS args) {
+    Snapshot *snapshot = (Snapshot *) JSEXTERN(args[0]);
+    char msg[256];
+    if (!memory_admit("snapshot_create_surface", snapshot->width, snapshot->height, msg, sizeof(msg))) {
+        return ThrowException(String::New(msg));
+    }
+    // an empty image has nothing to map, and mmap() refuses a length of 0
+    if (snapshot->size == 0) {
+        return External::New(track_surface(cairo_image_surface_create(snapshot->format, snapshot->width, snapshot->height)));
+    }
+    void *addr = mmap(NULL, snapshot->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, snapshot->fd, 0);
+    if (addr == MAP_FAILED) {
+        return ThrowException(String::New("snapshot_create_surface: mmap failed"));
+    }
+    cairo_surface_t *surface = cairo_image_surface_create_for_data((unsigned char *) addr, snapshot->format, snapshot->width, snapshot->height, snapshot->stride);
+
+    SnapshotMapping *mapping = new SnapshotMapping;
+    mapping->snapshot = snapshot;
+    mapping->addr = addr;
+    snapshot->refs++;
+    if (cairo_surface_set_user_data(surface, &snapshot_mapping_key, mapping, snapshot_mapping_destroy) != CAIRO_STATUS_SUCCESS) {
+        snapshot_mapping_destroy(mapping);
+        cairo_surface_destroy(surface);
+        return ThrowException(String::New("snapshot_create_surface: out of memory"));
+    }
+    return External::New(track_surface(surface));
+}
+
+/**
+ * @function cairo.snapshot_restore
+ * 
+ * ### Synopsis
+ * 
+ * cairo.snapshot_restore(snapshot, surface);
+ * 
+ * Replace the pixels of surface with the contents of the snapshot.
+ * 
+ * The surface must be an image surface, or a subsurface of one made by cairo.surface_create_for_rectangle(), of the same format and dimensions as the snapshot.  If the surface was created from this snapshot by cairo.snapshot_create_surface(), its modified pages are simply discarded and remapped, which costs nothing per untouched page.  Otherwise the pixels are copied from the snapshot.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} snapshot - opaque handle to a snapshot.
+ * @param {object} surface - opaque handle to an image surface.
+ */
+static JSVAL snapshot_restore(JSARGS args) {
+    Snapshot *snapshot = (Snapshot *) JSEXTERN(args[0]);
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[1]);
+    SurfacePixels pixels;
+    if (!surface_pixels(surface, &pixels)
+        || pixels.format != snapshot->format
+        || pixels.width != snapshot->width
+        || pixels.height != snapshot->height) {
+        return ThrowException(String::New("snapshot_restore: surface does not match snapshot"));
+    }
+    cairo_surface_flush(pixels.image);
+
+    SnapshotMapping *mapping = (SnapshotMapping *) cairo_surface_get_user_data(surface, &snapshot_mapping_key);
+    if (mapping && mapping->snapshot == snapshot) {
+        if (mmap(mapping->addr, snapshot->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, snapshot->fd, 0) == MAP_FAILED) {
+            return ThrowException(String::New("snapshot_restore: mmap failed"));
+        }
+    }
+    else {
+        bool ok;
+        if (pixels.image == surface && pixels.stride == snapshot->stride) {
+            ok = snapshot_read(snapshot->fd, pixels.data, snapshot->size, 0);
+        }
+        else {
+            size_t rowBytes = (size_t) pixels.width * surface_pixel_bytes(pixels.format);
+            ok = true;
+            for (int y = 0; ok && y < pixels.height; y++) {
+                ok = snapshot_read(snapshot->fd, pixels.data + (size_t) y * pixels.stride, rowBytes, (off_t) y * snapshot->stride);
+            }
+        }
+        if (!ok) {
+            return ThrowException(String::New("snapshot_restore: could not read snapshot"));
+        }
+    }
+    cairo_surface_mark_dirty(pixels.image);
+    return Undefined();
+}
+
+/**
+ * @function cairo.snapshot_destroy
+ * 
+ * ### Synopsis
+ * 
+ * cairo.snapshot_destroy(snapshot);
+ * 
+ * Release a snapshot.  The memory is freed once every surface created from the snapshot has also been destroyed.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} snapshot - opaque handle to a snapshot.
+ */
+static JSVAL snapshot_destroy(JSARGS args) {
+    Snapshot *snapshot = (Snapshot *) JSEXTERN(args[0]);
+    snapshot_release(snapshot);
+    return Undefined();
+}
+
+////////////////////////// COMMAND LISTS
+
+// A command list records drawing instead of performing it.  Recording happens through the
+// ordinary context_* functions: cairo.commands_get_context() returns a "shadow" context
+// with the list attached as user data, and each drawing binding checks for it.  State and
+// path operations are both recorded and applied to the shadow, so that queries (current
+// point, extents, in_fill and so on) keep working; fills, strokes and paints are only
+// recorded.  The list can then be optimized and replayed against any context.
+enum {
+    COMMAND_SAVE,
+    COMMAND_RESTORE,
+    COMMAND_PUSH_GROUP,
+    COMMAND_PUSH_GROUP_WITH_CONTENT,
+    COMMAND_POP_GROUP_TO_SOURCE,
+    COMMAND_SET_SOURCE_RGBA,
+    COMMAND_SET_SOURCE,
+    COMMAND_SET_ANTIALIAS,
+    COMMAND_SET_DASH,
+    COMMAND_SET_FILL_RULE,
+    COMMAND_SET_LINE_CAP,
+    COMMAND_SET_LINE_JOIN,
+    COMMAND_SET_LINE_WIDTH,
+    COMMAND_SET_MITER_LIMIT,
+    COMMAND_SET_OPERATOR,
+    COMMAND_SET_TOLERANCE,
+    COMMAND_SELECT_FONT_FACE,
+    COMMAND_SET_FONT_SIZE,
+    COMMAND_TRANSLATE,
+    COMMAND_SCALE,
+    COMMAND_ROTATE,
+    COMMAND_TRANSFORM,
+    COMMAND_SET_MATRIX,
+    COMMAND_IDENTITY_MATRIX,
+    COMMAND_CLIP,
+    COMMAND_CLIP_PRESERVE,
+    COMMAND_RESET_CLIP,
+    COMMAND_NEW_PATH,
+    COMMAND_NEW_SUB_PATH,
+    COMMAND_CLOSE_PATH,
+    COMMAND_MOVE_TO,
+    COMMAND_LINE_TO,
+    COMMAND_CURVE_TO,
+    COMMAND_REL_MOVE_TO,
+    COMMAND_REL_LINE_TO,
+    COMMAND_REL_CURVE_TO,
+    COMMAND_ARC,
+    COMMAND_ARC_NEGATIVE,
+    COMMAND_RECTANGLE,
+    COMMAND_APPEND_PATH,
+    COMMAND_TEXT_PATH,
+    COMMAND_FILL,
+    COMMAND_FILL_PRESERVE,
+    COMMAND_STROKE,
+    COMMAND_STROKE_PRESERVE,
+    COMMAND_PAINT,
+    COMMAND_PAINT_WITH_ALPHA,
+    COMMAND_SHOW_TEXT,
+    COMMAND_BLUR_GROUP
+};
+
+// command flags; the first group is worked out while recording, the rest by the optimizer
+enum {
+    COMMAND_BOUNDED = 1 << 0,       // bounds holds the device-space area a draw can touch
+    COMMAND_OPAQUE = 1 << 1,        // the source was an opaque solid color
+    COMMAND_OVER = 1 << 2,          // the operator was OVER
+    COMMAND_GROUPED = 1 << 3,       // drawn inside push_group, not onto the target
+    COMMAND_OWNS_PATH = 1 << 4,     // no other command used the path this draw consumed
+    COMMAND_COVERS = 1 << 5,        // a fill that leaves every pixel in cover opaque
+    COMMAND_DEAD = 1 << 6,          // eliminated
+    COMMAND_SAMPLES_SURFACE = 1 << 7,   // the source was a surface, which may be the target
+    COMMAND_USE_SOURCE = 1 << 8,    // replay with OPERATOR_SOURCE
+    COMMAND_PARAMETER = 1 << 9      // arguments are substituted when rendering a batch
+};
+
+struct Command {
+    int op;
+    int flags;
+    double args[6];
+    void *data;         // pattern, text, path or dash array, owned by the command
+    int pathStart;      // for fills and strokes, the first command that built their path
+    double bounds[4];   // x1, y1, x2, y2
+    double cover[4];
+};
+
+// A parameter slot feeding some of a command's arguments, or its text.
+struct CommandBinding {
+    int command;
+    int argOffset;
+    int slot;
+};
+
+// a binding waiting for the next command of one of two ops
+struct PendingBinding {
+    int ops[2];
+    int argOffset;
+    int slot;
+};
+
+// the value of one slot for one job of a batch
+struct ParameterValue {
+    double values[6];
+    int count;
+    char *text;
+};
+
+#define MAX_PENDING_BINDINGS 16
+
+struct CommandList {
+    Command *commands;
+    int count;
+    int capacity;
+    CommandBinding *bindings;
+    int bindingCount;
+    int bindingCapacity;
+    PendingBinding pending[MAX_PENDING_BINDINGS];
+    int pendingCount;
+    int width;
+    int height;
+    cairo_surface_t *shadowSurface;
+    cairo_t *shadow;
+    // recording state
+    int pathStart;
+    int pathOps;
+    bool pathRect;
+    bool pathShared;
+    double rect[4];
+    bool clipped;
+    char *clipStack;
+    int clipDepth;
+    int groupDepth;
+    // optimize_covered_draws() dropped draws, judging coverage on this target's pixel grid
+    bool pixelExact;
+};
+
+struct CommandStats {
+    int stateChanges;
+    int covered;
+    int merged;
+    int sourceOperators;
+};
+
+static cairo_user_data_key_t command_list_key;
+
+static inline CommandList *command_list_for(cairo_t *context) {
+    return (CommandList *) cairo_get_user_data(context, &command_list_key);
+}
+
+static bool command_is_path_op(int op) {
+    return op >= COMMAND_NEW_SUB_PATH && op <= COMMAND_TEXT_PATH;
+}
+
+static bool command_is_draw(int op) {
+    return op >= COMMAND_FILL;
+}
+
+static void command_release(Command *command) {
+    switch (command->op) {
+        case COMMAND_SET_SOURCE:
+            cairo_pattern_destroy((cairo_pattern_t *) command->data);
+            break;
+        case COMMAND_APPEND_PATH:
+            if (command->data) {
+                free(((cairo_path_t *) command->data)->data);
+            }
+            free(command->data);
+            break;
+        default:
+            free(command->data);
+            break;
+    }
+    command->data = NULL;
+}
+
+static void command_list_reset_path(CommandList *list) {
+    list->pathStart = list->count;
+    list->pathOps = 0;
+    list->pathRect = false;
+    list->pathShared = false;
+}
+
+static Command *command_append(CommandList *list, int op) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 256;
+        list->commands = (Command *) realloc(list->commands, list->capacity * sizeof(Command));
+    }
+    Command *command = &list->commands[list->count++];
+    memset(command, 0, sizeof(Command));
+    command->op = op;
+    for (int i = 0; i < list->pendingCount; i++) {
+        PendingBinding *pending = &list->pending[i];
+        if (pending->ops[0] != op && pending->ops[1] != op) {
+            continue;
+        }
+        if (list->bindingCount == list->bindingCapacity) {
+            list->bindingCapacity = list->bindingCapacity ? list->bindingCapacity * 2 : 32;
+            list->bindings = (CommandBinding *) realloc(list->bindings, list->bindingCapacity * sizeof(CommandBinding));
+        }
+        CommandBinding *binding = &list->bindings[list->bindingCount++];
+        binding->command = list->count - 1;
+        binding->argOffset = pending->argOffset;
+        binding->slot = pending->slot;
+        command->flags |= COMMAND_PARAMETER;
+        list->pending[i--] = list->pending[--list->pendingCount];
+    }
+    return command;
+}
+
+// device-space bounding box of a user-space rectangle
+static void user_rect_to_device(cairo_t *context, double x1, double y1, double x2, double y2, double *out) {
+    double xs[4] = { x1, x2, x1, x2 }, ys[4] = { y1, y1, y2, y2 };
+    for (int i = 0; i < 4; i++) {
+        cairo_user_to_device(context, &xs[i], &ys[i]);
+        if (i == 0 || xs[i] < out[0]) out[0] = xs[i];
+        if (i == 0 || ys[i] < out[1]) out[1] = ys[i];
+        if (i == 0 || xs[i] > out[2]) out[2] = xs[i];
+        if (i == 0 || ys[i] > out[3]) out[3] = ys[i];
+    }
+}
+
+// Record a state or path operation on a shadow context.  Returns the new command so the
+// caller can attach data, or NULL if the context is not recording.  The caller goes on to
+// apply the operation to the context.
+static Command *record_values(cairo_t *context, int op, const double *values, int count) {
+    CommandList *list = command_list_for(context);
+    if (!list) {
+        return NULL;
+    }
+    Command *command = command_append(list, op);
+    memcpy(command->args, values, count * sizeof(double));
+
+    if (command_is_path_op(op)) {
+        cairo_matrix_t m;
+        cairo_get_matrix(context, &m);
+        list->pathRect = op == COMMAND_RECTANGLE && list->pathOps == 0 && m.xy == 0 && m.yx == 0;
+        if (list->pathRect) {
+            double *a = command->args;
+            user_rect_to_device(context, a[0], a[1], a[0] + a[2], a[1] + a[3], list->rect);
+        }
+        list->pathOps++;
+        return command;
+    }
+    switch (op) {
+        case COMMAND_NEW_PATH:
+            command_list_reset_path(list);
+            break;
+        case COMMAND_CLIP:
+            list->clipped = true;
+            command_list_reset_path(list);
+            break;
+        case COMMAND_CLIP_PRESERVE:
+            list->clipped = true;
+            list->pathShared = true;
+            break;
+        case COMMAND_RESET_CLIP:
+            list->clipped = false;
+            break;
+        case COMMAND_SAVE:
+        case COMMAND_PUSH_GROUP:
+        case COMMAND_PUSH_GROUP_WITH_CONTENT:
+            if (list->clipDepth % 64 == 0) {
+                list->clipStack = (char *) realloc(list->clipStack, list->clipDepth + 64);
+            }
+            list->clipStack[list->clipDepth++] = list->clipped;
+            if (op != COMMAND_SAVE) {
+                list->groupDepth++;
+            }
+            break;
+        case COMMAND_RESTORE:
+        case COMMAND_POP_GROUP_TO_SOURCE:
+            if (list->clipDepth > 0) {
+                list->clipped = list->clipStack[--list->clipDepth];
+            }
+            if (op != COMMAND_RESTORE && list->groupDepth > 0) {
+                list->groupDepth--;
+            }
+            break;
+    }
+    return command;
+}
+
+// record_values() taking count numeric arguments from args[1...]
+static Command *record_command(cairo_t *context, int op, JSARGS args, int count) {
+    if (!command_list_for(context)) {
+        return NULL;
+    }
+    double values[6];
+    for (int i = 0; i < count; i++) {
+        values[i] = args[i + 1]->NumberValue();
+    }
+    return record_values(context, op, values, count);
+}
+
+// Record a fill, stroke or paint on a shadow context.  Returns NULL if the context is not
+// recording, in which case the caller draws as usual.  The shadow's path is consumed as the
+// draw would have consumed it.
+static Command *record_draw(cairo_t *context, int op, double arg) {
+    CommandList *list = command_list_for(context);
+    if (!list) {
+        return NULL;
+    }
+    Command *command = command_append(list, op);
+    command->args[0] = arg;
+
+    double x1, y1, x2, y2, cx1, cy1, cx2, cy2;
+    cairo_operator_t op_ = cairo_get_operator(context);
+    // these operators clear the destination outside the shape, up to the clip
+    bool unbounded = op_ == CAIRO_OPERATOR_IN || op_ == CAIRO_OPERATOR_OUT
+        || op_ == CAIRO_OPERATOR_DEST_IN || op_ == CAIRO_OPERATOR_DEST_ATOP;
+    cairo_clip_extents(context, &cx1, &cy1, &cx2, &cy2);
+    switch (unbounded ? COMMAND_PAINT : op) {
+        case COMMAND_FILL:
+        case COMMAND_FILL_PRESERVE:
+            cairo_path_extents(context, &x1, &y1, &x2, &y2);
+            break;
+        case COMMAND_STROKE:
+        case COMMAND_STROKE_PRESERVE:
+            cairo_stroke_extents(context, &x1, &y1, &x2, &y2);
+            break;
+        default:
+            x1 = cx1, y1 = cy1, x2 = cx2, y2 = cy2;
+            break;
+    }
+    x1 = x1 > cx1 ? x1 : cx1;
+    y1 = y1 > cy1 ? y1 : cy1;
+    x2 = x2 < cx2 ? x2 : cx2;
+    y2 = y2 < cy2 ? y2 : cy2;
+    user_rect_to_device(context, x1, y1, x2, y2, command->bounds);
+    // antialiasing can touch the pixel beyond the geometry
+    command->bounds[0] -= 1;
+    command->bounds[1] -= 1;
+    command->bounds[2] += 1;
+    command->bounds[3] += 1;
+    command->flags |= COMMAND_BOUNDED;
+
+    double r, g, b, a;
+    cairo_pattern_t *source = cairo_get_source(context);
+    if (cairo_pattern_get_type(source) == CAIRO_PATTERN_TYPE_SOLID
+        && cairo_pattern_get_rgba(source, &r, &g, &b, &a) == CAIRO_STATUS_SUCCESS && a >= 1.0) {
+        command->flags |= COMMAND_OPAQUE;
+    }
+    else if (cairo_pattern_get_type(source) == CAIRO_PATTERN_TYPE_SURFACE) {
+        command->flags |= COMMAND_SAMPLES_SURFACE;
+    }
+    if (op_ == CAIRO_OPERATOR_OVER) {
+        command->flags |= COMMAND_OVER;
+    }
+    if (list->groupDepth > 0) {
+        command->flags |= COMMAND_GROUPED;
+    }
+
+    // a single axis-aligned rectangle filled with an opaque color covers its whole pixels
+    if ((op == COMMAND_FILL || op == COMMAND_FILL_PRESERVE) && list->pathRect && list->pathOps == 1
+        && (command->flags & (COMMAND_OPAQUE | COMMAND_GROUPED)) == COMMAND_OPAQUE
+        && (op_ == CAIRO_OPERATOR_OVER || op_ == CAIRO_OPERATOR_SOURCE)) {
+        double clip[4] = { 0, 0, (double) list->width, (double) list->height };
+        bool known = true;
+        if (list->clipped) {
+            cairo_rectangle_list_t *rects = cairo_copy_clip_rectangle_list(context);
+            known = rects->status == CAIRO_STATUS_SUCCESS && rects->num_rectangles == 1;
+            if (known) {
+                cairo_rectangle_t *rc = &rects->rectangles[0];
+                user_rect_to_device(context, rc->x, rc->y, rc->x + rc->width, rc->y + rc->height, clip);
+            }
+            cairo_rectangle_list_destroy(rects);
+        }
+        double *cover = command->cover;
+        cover[0] = ceil(list->rect[0] > clip[0] ? list->rect[0] : clip[0]);
+        cover[1] = ceil(list->rect[1] > clip[1] ? list->rect[1] : clip[1]);
+        cover[2] = floor(list->rect[2] < clip[2] ? list->rect[2] : clip[2]);
+        cover[3] = floor(list->rect[3] < clip[3] ? list->rect[3] : clip[3]);
+        if (known && cover[0] < cover[2] && cover[1] < cover[3]) {
+            command->flags |= COMMAND_COVERS;
+        }
+    }
+
+    switch (op) {
+        case COMMAND_FILL:
+        case COMMAND_STROKE:
+            command->pathStart = list->pathStart;
+            if (!list->pathShared) {
+                command->flags |= COMMAND_OWNS_PATH;
+            }
+            command_list_reset_path(list);
+            cairo_new_path(context);
+            break;
+        case COMMAND_FILL_PRESERVE:
+        case COMMAND_STROKE_PRESERVE:
+            list->pathShared = true;
+            break;
+    }
+    return command;
+}
+
+static cairo_path_t *path_copy(const cairo_path_t *path) {
+    cairo_path_t *copy = (cairo_path_t *) malloc(sizeof(cairo_path_t));
+    *copy = *path;
+    copy->data = (cairo_path_data_t *) malloc(path->num_data * sizeof(cairo_path_data_t));
+    memcpy(copy->data, path->data, path->num_data * sizeof(cairo_path_data_t));
+    return copy;
+}
+
+// A new pattern with the same source, stops (their alpha times alpha), matrix, extend and
+// filter, so later changes to pattern do not reach the copy.  The pixels of a surface are
+// shared, not copied.  Other kinds of pattern are referenced rather than copied.
+static cairo_pattern_t *pattern_copy(cairo_pattern_t *pattern, double alpha) {
+    cairo_pattern_t *copy;
+    double a[6];
+    switch (cairo_pattern_get_type(pattern)) {
+        case CAIRO_PATTERN_TYPE_SOLID:
+            cairo_pattern_get_rgba(pattern, &a[0], &a[1], &a[2], &a[3]);
+            return cairo_pattern_create_rgba(a[0], a[1], a[2], a[3] * alpha);
+        case CAIRO_PATTERN_TYPE_SURFACE: {
+            cairo_surface_t *surface = NULL;
+            cairo_pattern_get_surface(pattern, &surface);
+            copy = cairo_pattern_create_for_surface(surface);
+            break;
+        }
+        case CAIRO_PATTERN_TYPE_LINEAR:
+            cairo_pattern_get_linear_points(pattern, &a[0], &a[1], &a[2], &a[3]);
+            copy = cairo_pattern_create_linear(a[0], a[1], a[2], a[3]);
+            break;
+        case CAIRO_PATTERN_TYPE_RADIAL:
+            cairo_pattern_get_radial_circles(pattern, &a[0], &a[1], &a[2], &a[3], &a[4], &a[5]);
+            copy = cairo_pattern_create_radial(a[0], a[1], a[2], a[3], a[4], a[5]);
+            break;
+        default:
+            return cairo_pattern_reference(pattern);
+    }
+    int count = 0;
+    cairo_pattern_get_color_stop_count(pattern, &count);
+    for (int i = 0; i < count; i++) {
+        double offset, red, green, blue, stopAlpha;
+        cairo_pattern_get_color_stop_rgba(pattern, i, &offset, &red, &green, &blue, &stopAlpha);
+        cairo_pattern_add_color_stop_rgba(copy, offset, red, green, blue, stopAlpha * alpha);
+    }
+    cairo_matrix_t matrix;
+    cairo_pattern_get_matrix(pattern, &matrix);
+    cairo_pattern_set_matrix(copy, &matrix);
+    cairo_pattern_set_extend(copy, cairo_pattern_get_extend(pattern));
+    cairo_pattern_set_filter(copy, cairo_pattern_get_filter(pattern));
+    return copy;
+}
+
+// move the current point past text, as showing it would have
+static void advance_past_text(cairo_t *context, const char *text) {
+    cairo_text_extents_t extents;
+    double x = 0, y = 0;
+    cairo_text_extents(context, text, &extents);
+    if (cairo_has_current_point(context)) {
+        cairo_get_current_point(context, &x, &y);
+    }
+    cairo_move_to(context, x + extents.x_advance, y + extents.y_advance);
+}
+
+static JSVAL not_recordable(const char *fn) {
+    char message[256];
+    snprintf(message, sizeof(message), "%s: not supported while recording", fn);
+    return ThrowException(String::New(message));
+}
+
+static void command_execute(cairo_t *context, const Command *command) {
+    const double *a = command->args;
+    switch (command->op) {
+        case COMMAND_SAVE: cairo_save(context); break;
+        case COMMAND_RESTORE: cairo_restore(context); break;
+        case COMMAND_PUSH_GROUP: cairo_push_group(context); break;
+        case COMMAND_PUSH_GROUP_WITH_CONTENT: cairo_push_group_with_content(context, (cairo_content_t) a[0]); break;
+        case COMMAND_POP_GROUP_TO_SOURCE: cairo_pop_group_to_source(context); break;
+        case COMMAND_SET_SOURCE_RGBA: cairo_set_source_rgba(context, a[0], a[1], a[2], a[3]); break;
+        case COMMAND_SET_SOURCE: cairo_set_source(context, (cairo_pattern_t *) command->data); break;
+        case COMMAND_SET_ANTIALIAS: cairo_set_antialias(context, (cairo_antialias_t) a[0]); break;
+        case COMMAND_SET_DASH: cairo_set_dash(context, (const double *) command->data, (int) a[0], a[1]); break;
+        case COMMAND_SET_FILL_RULE: cairo_set_fill_rule(context, (cairo_fill_rule_t) a[0]); break;
+        case COMMAND_SET_LINE_CAP: cairo_set_line_cap(context, (cairo_line_cap_t) a[0]); break;
+        case COMMAND_SET_LINE_JOIN: cairo_set_line_join(context, (cairo_line_join_t) a[0]); break;
+        case COMMAND_SET_LINE_WIDTH: cairo_set_line_width(context, a[0]); break;
+        case COMMAND_SET_MITER_LIMIT: cairo_set_miter_limit(context, a[0]); break;
+        case COMMAND_SET_OPERATOR: cairo_set_operator(context, (cairo_operator_t) a[0]); break;
+        case COMMAND_SET_TOLERANCE: cairo_set_tolerance(context, a[0]); break;
+        case COMMAND_SELECT_FONT_FACE: cairo_select_font_face(context, (const char *) command->data, (cairo_font_slant_t) a[0], (cairo_font_weight_t) a[1]); break;
+        case COMMAND_SET_FONT_SIZE: cairo_set_font_size(context, a[0]); break;
+        case COMMAND_TRANSLATE: cairo_translate(context, a[0], a[1]); break;
+        case COMMAND_SCALE: cairo_scale(context, a[0], a[1]); break;
+        case COMMAND_ROTATE: cairo_rotate(context, a[0]); break;
+        case COMMAND_TRANSFORM: cairo_transform(context, (const cairo_matrix_t *) a); break;
+        case COMMAND_SET_MATRIX: cairo_set_matrix(context, (const cairo_matrix_t *) a); break;
+        case COMMAND_IDENTITY_MATRIX: cairo_identity_matrix(context); break;
+        case COMMAND_CLIP: cairo_clip(context); break;
+        case COMMAND_CLIP_PRESERVE: cairo_clip_preserve(context); break;
+        case COMMAND_RESET_CLIP: cairo_reset_clip(context); break;
+        case COMMAND_NEW_PATH: cairo_new_path(context); break;
+        case COMMAND_NEW_SUB_PATH: cairo_new_sub_path(context); break;
+        case COMMAND_CLOSE_PATH: cairo_close_path(context); break;
+        case COMMAND_MOVE_TO: cairo_move_to(context, a[0], a[1]); break;
+        case COMMAND_LINE_TO: cairo_line_to(context, a[0], a[1]); break;
+        case COMMAND_CURVE_TO: cairo_curve_to(context, a[0], a[1], a[2], a[3], a[4], a[5]); break;
+        case COMMAND_REL_MOVE_TO: cairo_rel_move_to(context, a[0], a[1]); break;
+        case COMMAND_REL_LINE_TO: cairo_rel_line_to(context, a[0], a[1]); break;
+        case COMMAND_REL_CURVE_TO: cairo_rel_curve_to(context, a[0], a[1], a[2], a[3], a[4], a[5]); break;
+        case COMMAND_ARC: cairo_arc(context, a[0], a[1], a[2], a[3], a[4]); break;
+        case COMMAND_ARC_NEGATIVE: cairo_arc_negative(context, a[0], a[1], a[2], a[3], a[4]); break;
+        case COMMAND_RECTANGLE: cairo_rectangle(context, a[0], a[1], a[2], a[3]); break;
+        case COMMAND_APPEND_PATH: cairo_append_path(context, (const cairo_path_t *) command->data); break;
+        case COMMAND_TEXT_PATH: cairo_text_path(context, (const char *) command->data); break;
+        case COMMAND_FILL: cairo_fill(context); break;
+        case COMMAND_FILL_PRESERVE: cairo_fill_preserve(context); break;
+        case COMMAND_STROKE: cairo_stroke(context); break;
+        case COMMAND_STROKE_PRESERVE: cairo_stroke_preserve(context); break;
+        case COMMAND_PAINT: cairo_paint(context); break;
+        case COMMAND_PAINT_WITH_ALPHA: cairo_paint_with_alpha(context, a[0]); break;
+        case COMMAND_SHOW_TEXT: cairo_show_text(context, (const char *) command->data); break;
+        case COMMAND_BLUR_GROUP: blur_image_surface(cairo_get_group_target(context), (int) a[0]); break;
+    }
+}
+
+static void command_copy_data(const Command *from, Command *to) {
+    if (!from->data) {
+        return;
+    }
+    switch (from->op) {
+        case COMMAND_SET_SOURCE:
+            to->data = cairo_pattern_reference((cairo_pattern_t *) from->data);
+            break;
+        case COMMAND_APPEND_PATH:
+            to->data = path_copy((const cairo_path_t *) from->data);
+            break;
+        case COMMAND_SET_DASH:
+            to->data = malloc((size_t) from->args[0] * sizeof(double));
+            memcpy(to->data, from->data, (size_t) from->args[0] * sizeof(double));
+            break;
+        default:
+            to->data = strdup((const char *) from->data);
+            break;
+    }
+}
+
+// Replaying onto a context that is itself recording appends the commands to its list, as
+// though they had been issued through the bindings, so nothing is rasterized early.
+static void command_list_append(CommandList *list, cairo_t *context) {
+    int count = list->count;
+    for (int i = 0; i < count; i++) {
+        // a list replayed into itself grows, and may move, while this runs
+        Command from = list->commands[i];
+        if (from.flags & COMMAND_DEAD) {
+            continue;
+        }
+        if (command_is_draw(from.op)) {
+            Command *command = record_draw(context, from.op, from.args[0]);
+            command_copy_data(&from, command);
+            if (from.op == COMMAND_SHOW_TEXT) {
+                advance_past_text(context, (const char *) from.data);
+            }
+        }
+        else {
+            Command *command = record_values(context, from.op, from.args, 6);
+            command_copy_data(&from, command);
+            if (from.op != COMMAND_BLUR_GROUP) {
+                command_execute(context, command);
+            }
+        }
+    }
+}
+
+// Replay the live commands of a list.  SET_OPERATOR is applied lazily, so that draws the
+// optimizer switched to OPERATOR_SOURCE only cost an operator change at the boundaries of
+// a run; the context is left with the operator the recording asked for.  If parameters is
+// given, bound commands take their arguments from it, indexed by slot.
+static void command_list_replay(CommandList *list, cairo_t *context, const ParameterValue *parameters) {
+    cairo_operator_t logical = cairo_get_operator(context), applied = logical;
+    cairo_operator_t *stack = NULL;
+    int depth = 0, binding = 0;
+    Command substituted;
+    for (int i = 0; i < list->count; i++) {
+        const Command *command = &list->commands[i];
+        if (parameters && binding < list->bindingCount && list->bindings[binding].command == i) {
+            substituted = *command;
+            for (; binding < list->bindingCount && list->bindings[binding].command == i; binding++) {
+                const CommandBinding *b = &list->bindings[binding];
+                const ParameterValue *value = &parameters[b->slot];
+                if (value->text) {
+                    substituted.data = value->text;
+                }
+                for (int k = 0; k < value->count && b->argOffset + k < 6; k++) {
+                    substituted.args[b->argOffset + k] = value->values[k];
+                }
+            }
+            command = &substituted;
+        }
+        if (command->flags & COMMAND_DEAD) {
+            continue;
+        }
+        switch (command->op) {
+            case COMMAND_SET_OPERATOR:
+                logical = (cairo_operator_t) command->args[0];
+                continue;
+            case COMMAND_SAVE:
+            case COMMAND_PUSH_GROUP:
+            case COMMAND_PUSH_GROUP_WITH_CONTENT:
+                if (depth % 32 == 0) {
+                    stack = (cairo_operator_t *) realloc(stack, (depth + 32) * 2 * sizeof(cairo_operator_t));
+                }
+                stack[depth * 2] = logical;
+                stack[depth * 2 + 1] = applied;
+                depth++;
+                break;
+            case COMMAND_RESTORE:
+            case COMMAND_POP_GROUP_TO_SOURCE:
+                command_execute(context, command);
+                if (depth > 0) {
+                    depth--;
+                    logical = stack[depth * 2];
+                    applied = stack[depth * 2 + 1];
+                }
+                else {
+                    logical = applied = cairo_get_operator(context);
+                }
+                continue;
+            default:
+                if (command_is_draw(command->op)) {
+                    cairo_operator_t wanted = (command->flags & COMMAND_USE_SOURCE) ? CAIRO_OPERATOR_SOURCE : logical;
+                    if (wanted != applied) {
+                        cairo_set_operator(context, wanted);
+                        applied = wanted;
+                    }
+                }
+                break;
+        }
+        command_execute(context, command);
+    }
+    if (applied != logical) {
+        cairo_set_operator(context, logical);
+    }
+    free(stack);
+}
+
+// The kinds of state the optimizer tracks.  Setting one kind never affects another.
+enum {
+    STATE_SOURCE,
+    STATE_OPERATOR,
+    STATE_ANTIALIAS,
+    STATE_DASH,
+    STATE_FILL_RULE,
+    STATE_LINE_CAP,
+    STATE_LINE_JOIN,
+    STATE_LINE_WIDTH,
+    STATE_MITER_LIMIT,
+    STATE_TOLERANCE,
+    STATE_FONT_FACE,
+    STATE_FONT_SIZE,
+    STATE_COUNT
+};
+
+struct KnownState {
+    bool known[STATE_COUNT];
+    double value[STATE_COUNT][4];
+};
+
+static int command_state_kind(int op) {
+    switch (op) {
+        case COMMAND_SET_SOURCE_RGBA:
+        case COMMAND_SET_SOURCE: return STATE_SOURCE;
+        case COMMAND_SET_OPERATOR: return STATE_OPERATOR;
+        case COMMAND_SET_ANTIALIAS: return STATE_ANTIALIAS;
+        case COMMAND_SET_DASH: return STATE_DASH;
+        case COMMAND_SET_FILL_RULE: return STATE_FILL_RULE;
+        case COMMAND_SET_LINE_CAP: return STATE_LINE_CAP;
+        case COMMAND_SET_LINE_JOIN: return STATE_LINE_JOIN;
+        case COMMAND_SET_LINE_WIDTH: return STATE_LINE_WIDTH;
+        case COMMAND_SET_MITER_LIMIT: return STATE_MITER_LIMIT;
+        case COMMAND_SET_TOLERANCE: return STATE_TOLERANCE;
+        case COMMAND_SELECT_FONT_FACE: return STATE_FONT_FACE;
+        case COMMAND_SET_FONT_SIZE: return STATE_FONT_SIZE;
+    }
+    return -1;
+}
+
+// Pass 1: drop state changes that set what is already set, and ones overwritten before
+// anything used them.
+static int optimize_state_changes(CommandList *list) {
+    int eliminated = 0;
+    int pending[STATE_COUNT];
+    KnownState state, *stack = NULL;
+    int depth = 0;
+    memset(&state, 0, sizeof(state));
+    for (int k = 0; k < STATE_COUNT; k++) {
+        pending[k] = -1;
+    }
+    for (int i = 0; i < list->count; i++) {
+        Command *command = &list->commands[i];
+        int op = command->op;
+        if (command->flags & COMMAND_DEAD) {
+            continue;
+        }
+        int kind = command_state_kind(op);
+        if (kind >= 0) {
+            // only plain numeric settings can be compared
+            bool comparable = op != COMMAND_SET_SOURCE && op != COMMAND_SET_DASH && op != COMMAND_SELECT_FONT_FACE
+                && !(command->flags & COMMAND_PARAMETER);
+            if (comparable && state.known[kind] && !memcmp(state.value[kind], command->args, sizeof(state.value[kind]))) {
+                command->flags |= COMMAND_DEAD;
+                eliminated++;
+                continue;
+            }
+            if (pending[kind] >= 0) {
+                list->commands[pending[kind]].flags |= COMMAND_DEAD;
+                eliminated++;
+            }
+            pending[kind] = i;
+            state.known[kind] = comparable;
+            memcpy(state.value[kind], command->args, sizeof(state.value[kind]));
+            continue;
+        }
+        switch (op) {
+            case COMMAND_SAVE:
+            case COMMAND_PUSH_GROUP:
+            case COMMAND_PUSH_GROUP_WITH_CONTENT:
+                if (depth % 16 == 0) {
+                    stack = (KnownState *) realloc(stack, (depth + 16) * sizeof(KnownState));
+                }
+                stack[depth++] = state;
+                for (int k = 0; k < STATE_COUNT; k++) {
+                    pending[k] = -1;
+                }
+                break;
+            case COMMAND_RESTORE:
+            case COMMAND_POP_GROUP_TO_SOURCE:
+            case COMMAND_BLUR_GROUP:
+                if (op != COMMAND_BLUR_GROUP) {
+                    if (depth > 0) {
+                        state = stack[--depth];
+                    }
+                    else {
+                        memset(&state, 0, sizeof(state));
+                    }
+                }
+                if (op == COMMAND_POP_GROUP_TO_SOURCE) {
+                    state.known[STATE_SOURCE] = false;
+                }
+                for (int k = 0; k < STATE_COUNT; k++) {
+                    pending[k] = -1;
+                }
+                break;
+            case COMMAND_CLIP:
+            case COMMAND_CLIP_PRESERVE:
+                pending[STATE_FILL_RULE] = pending[STATE_TOLERANCE] = pending[STATE_ANTIALIAS] = -1;
+                break;
+            case COMMAND_TEXT_PATH:
+                pending[STATE_FONT_FACE] = pending[STATE_FONT_SIZE] = pending[STATE_TOLERANCE] = -1;
+                break;
+            default:
+                if (command_is_draw(op)) {
+                    for (int k = 0; k < STATE_COUNT; k++) {
+                        pending[k] = -1;
+                    }
+                }
+                else if (command_is_path_op(op)) {
+                    pending[STATE_TOLERANCE] = -1;
+                }
+                break;
+        }
+    }
+    free(stack);
+    return eliminated;
+}
+
+// Eliminate a draw.  A fill or stroke that owned its path takes the commands that built
+// the path with it; otherwise it becomes a plain new_path, which is what it did to the path.
+static void optimize_drop_draw(CommandList *list, int index) {
+    Command *command = &list->commands[index];
+    if (command->op == COMMAND_FILL || command->op == COMMAND_STROKE) {
+        if (!(command->flags & COMMAND_OWNS_PATH)) {
+            command->op = COMMAND_NEW_PATH;
+            command->flags = 0;
+            return;
+        }
+        for (int i = command->pathStart; i < index; i++) {
+            if (command_is_path_op(list->commands[i].op)) {
+                list->commands[i].flags |= COMMAND_DEAD;
+            }
+        }
+    }
+    command->flags |= COMMAND_DEAD;
+}
+
+// Pass 2: drop draws whose every pixel a later opaque rectangle overwrites.  Scanning back
+// from each covering fill stops at sources that read a surface, which might be the target.
+static int optimize_covered_draws(CommandList *list) {
+    int eliminated = 0;
+    for (int j = 0; j < list->count; j++) {
+        const Command *cover = &list->commands[j];
+        if ((cover->flags & (COMMAND_COVERS | COMMAND_DEAD)) != COMMAND_COVERS) {
+            continue;
+        }
+        for (int i = j - 1; i >= 0; i--) {
+            Command *command = &list->commands[i];
+            if (command->flags & COMMAND_DEAD) {
+                continue;
+            }
+            if (command->flags & COMMAND_SAMPLES_SURFACE) {
+                break;
+            }
+            if (!command_is_draw(command->op) || command->op == COMMAND_SHOW_TEXT
+                || (command->flags & (COMMAND_BOUNDED | COMMAND_GROUPED)) != COMMAND_BOUNDED) {
+                continue;
+            }
+            const double *b = command->bounds, *c = cover->cover;
+            if (b[0] >= c[0] && b[1] >= c[1] && b[2] <= c[2] && b[3] <= c[3]) {
+                optimize_drop_draw(list, i);
+                eliminated++;
+            }
+        }
+    }
+    return eliminated;
+}
+
+// Pass 3: merge a fill into the next one when nothing but path building comes between them.
+// Only fills with disjoint bounds are merged, so neither winding nor blending can tell the
+// difference; the first fill becomes a new_sub_path, keeping its path for the second.
+static int optimize_merge_fills(CommandList *list) {
+    int merged = 0;
+    int last = -1;
+    bool building = false;
+    for (int i = 0; i < list->count; i++) {
+        Command *command = &list->commands[i];
+        if (command->flags & COMMAND_DEAD) {
+            continue;
+        }
+        int op = command->op;
+        if (op == COMMAND_FILL && (command->flags & COMMAND_BOUNDED)) {
+            if (last >= 0) {
+                Command *prev = &list->commands[last];
+                const double *a = prev->bounds, *b = command->bounds;
+                if (a[2] <= b[0] || b[2] <= a[0] || a[3] <= b[1] || b[3] <= a[1]) {
+                    for (int k = last + 1; k < i; k++) {
+                        if (list->commands[k].op == COMMAND_NEW_PATH) {
+                            list->commands[k].flags |= COMMAND_DEAD;
+                        }
+                    }
+                    prev->op = COMMAND_NEW_SUB_PATH;
+                    prev->flags = 0;
+                    command->bounds[0] = a[0] < b[0] ? a[0] : b[0];
+                    command->bounds[1] = a[1] < b[1] ? a[1] : b[1];
+                    command->bounds[2] = a[2] > b[2] ? a[2] : b[2];
+                    command->bounds[3] = a[3] > b[3] ? a[3] : b[3];
+                    command->flags &= ~COMMAND_OWNS_PATH;
+                    merged++;
+                }
+            }
+            last = i;
+            building = false;
+        }
+        else if (command_is_path_op(op)) {
+            building = true;
+        }
+        else if (!(op == COMMAND_NEW_PATH && !building)) {
+            last = -1;
+        }
+    }
+    return merged;
+}
+
+// Pass 4: an opaque color composited with OVER replaces what is underneath, so the draw can
+// use SOURCE and skip reading the destination.
+static int optimize_source_operators(CommandList *list) {
+    int converted = 0;
+    for (int i = 0; i < list->count; i++) {
+        Command *command = &list->commands[i];
+        int op = command->op;
+        if ((op == COMMAND_FILL || op == COMMAND_FILL_PRESERVE || op == COMMAND_STROKE || op == COMMAND_STROKE_PRESERVE)
+            && (command->flags & (COMMAND_OPAQUE | COMMAND_OVER | COMMAND_DEAD | COMMAND_USE_SOURCE)) == (COMMAND_OPAQUE | COMMAND_OVER)) {
+            command->flags |= COMMAND_USE_SOURCE;
+            converted++;
+        }
+    }
+    return converted;
+}
+
+// Remove eliminated commands, keeping the path starts of the survivors in step.
+static void command_list_compact(CommandList *list) {
+    int *map = (int *) malloc((list->count + 1) * sizeof(int));
+    int n = 0;
+    for (int i = 0; i < list->count; i++) {
+        map[i] = n;
+        Command *command = &list->commands[i];
+        if (command->flags & COMMAND_DEAD) {
+            command_release(command);
+        }
+        else {
+            list->commands[n++] = *command;
+        }
+    }
+    map[list->count] = n;
+    for (int i = 0; i < n; i++) {
+        list->commands[i].pathStart = map[list->commands[i].pathStart];
+    }
+    list->pathStart = map[list->pathStart];
+    int bindings = 0;
+    for (int i = 0; i < list->bindingCount; i++) {
+        CommandBinding binding = list->bindings[i];
+        // a surviving command is the only one mapping below its successor
+        if (map[binding.command] != map[binding.command + 1]) {
+            binding.command = map[binding.command];
+            list->bindings[bindings++] = binding;
+        }
+    }
+    list->bindingCount = bindings;
+    list->count = n;
+    free(map);
+}
+
+static void command_list_clear(CommandList *list) {
+    for (int i = 0; i < list->count; i++) {
+        command_release(&list->commands[i]);
+    }
+    list->count = 0;
+    list->bindingCount = 0;
+    list->pendingCount = 0;
+    list->pathStart = 0;
+    // whatever path the shadow holds now was built by commands that are gone
+    list->pathShared = true;
+    list->pathRect = false;
+    list->pixelExact = false;
+}
+
+/**
+ * @function cairo.commands_create
+ * 
+ * ### Synopsis
+ * 
+ * var commands = cairo.commands_create(width, height);
+ * 
+ * Create an empty command list for recording drawing on a target of the given size.
+ * 
+ * Drawing is recorded by calling the usual cairo.context_* functions on the context returned by cairo.commands_get_context().  Nothing is rasterized until the list is replayed with cairo.commands_replay().  Before replaying, cairo.commands_optimize() can remove work that would not change the result.
+ * 
+ * The list should be released with cairo.commands_destroy().
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {int} width - width of the target, in pixels.
+ * @param {int} height - height of the target, in pixels.
+ * @return {object} commands - opaque handle to the command list.
+ */
+static JSVAL commands_create(JSARGS args) {
+    CommandList *list = new CommandList;
+    memset(list, 0, sizeof(CommandList));
+    list->width = args[0]->IntegerValue();
+    list->height = args[1]->IntegerValue();
+#if CAIRO_VERSION_MINOR >= 10
+    // the shadow never draws; a bounded recording surface gives it the target's extents for free
+    cairo_rectangle_t extents = { 0, 0, (double) list->width, (double) list->height };
+    list->shadowSurface = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, &extents);
+#else
+    list->shadowSurface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, list->width, list->height);
+#endif
+    list->shadow = cairo_create(list->shadowSurface);
+    cairo_set_user_data(list->shadow, &command_list_key, list, NULL);
+    return External::New(list);
+}
+
+/**
+ * @function cairo.commands_get_context
+ * 
+ * ### Synopsis
+ * 
+ * var context = cairo.commands_get_context(commands);
+ * 
+ * Get the context that records into a command list.
+ * 
+ * Drawing operations on this context are appended to the list instead of being performed.  State, path and query functions behave as they would on an ordinary context.  A few functions cannot be recorded (context_mask, context_pop_group, the glyph and font face/options functions, copy_page and show_page) and throw.
+ * 
+ * The caller owns a reference to the context and should call cairo.context_destroy() when done with it.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} commands - opaque handle to a command list.
+ * @return {object} context - opaque handle to the recording context.
+ */
+static JSVAL commands_get_context(JSARGS args) {
+    CommandList *list = (CommandList *) JSEXTERN(args[0]);
+    return External::New(cairo_reference(list->shadow));
+}
+
+/**
+ * @function cairo.commands_count
+ * 
+ * ### Synopsis
+ * 
+ * var count = cairo.commands_count(commands);
+ * 
+ * Get the number of commands in a command list.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} commands - opaque handle to a command list.
+ * @return {int} count - number of commands.
+ */
+static JSVAL commands_count(JSARGS args) {
+    CommandList *list = (CommandList *) JSEXTERN(args[0]);
+    return Integer::New(list->count);
+}
+
+/**
+ * @function cairo.commands_bind_parameter
+ * 
+ * ### Synopsis
+ * 
+ * cairo.commands_bind_parameter(commands, slot, kind);
+ * 
+ * Make part of the next recorded command of a kind a parameter, so that cairo.commands_render_batch() can render the same recording with different values.
+ * 
+ * The kinds, and the values they take, are:
+ * 
+ * + color - the next set_source_rgb/rgba; [red, green, blue, alpha], each 0 to 1.
+ * + text - the next show_text or text_path; a string.
+ * + point - the next move_to or line_to; [x, y].
+ * + rect - the next rectangle; [x, y, width, height].
+ * + width - the width of the next rectangle; a number.
+ * + height - the height of the next rectangle; a number.
+ * + lineWidth - the next set_line_width; a number.
+ * + alpha - the next paint_with_alpha; a number.
+ * 
+ * When a job gives no value for a slot, the recorded value is used.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} commands - opaque handle to a command list.
+ * @param {int} slot - index of the value in each job's array of parameters.
+ * @param {string} kind - which command and arguments the value replaces.
+ */
+static JSVAL commands_bind_parameter(JSARGS args) {
+    static const struct {
+        const char *name;
+        int ops[2];
+        int argOffset;
+    } kinds[] = {
+        { "color", { COMMAND_SET_SOURCE_RGBA, -1 }, 0 },
+        { "text", { COMMAND_SHOW_TEXT, COMMAND_TEXT_PATH }, 0 },
+        { "point", { COMMAND_MOVE_TO, COMMAND_LINE_TO }, 0 },
+        { "rect", { COMMAND_RECTANGLE, -1 }, 0 },
+        { "width", { COMMAND_RECTANGLE, -1 }, 2 },
+        { "height", { COMMAND_RECTANGLE, -1 }, 3 },
+        { "lineWidth", { COMMAND_SET_LINE_WIDTH, -1 }, 0 },
+        { "alpha", { COMMAND_PAINT_WITH_ALPHA, -1 }, 0 }
+    };
+    CommandList *list = (CommandList *) JSEXTERN(args[0]);
+    int slot = args[1]->IntegerValue();
+    String::Utf8Value kind(args[2]->ToString());
+    if (slot < 0) {
+        return ThrowException(String::New("commands_bind_parameter: slot must not be negative"));
+    }
+    if (list->pendingCount == MAX_PENDING_BINDINGS) {
+        return ThrowException(String::New("commands_bind_parameter: too many parameters waiting for a command"));
+    }
+    for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+        if (!strcmp(*kind, kinds[i].name)) {
+            PendingBinding *pending = &list->pending[list->pendingCount++];
+            pending->ops[0] = kinds[i].ops[0];
+            pending->ops[1] = kinds[i].ops[1];
+            pending->argOffset = kinds[i].argOffset;
+            pending->slot = slot;
+            return Undefined();
+        }
+    }
+    return ThrowException(String::New("commands_bind_parameter: unknown kind"));
+}
+
+/**
+ * @function cairo.commands_optimize
+ * 
+ * ### Synopsis
+ * 
+ * var stats = cairo.commands_optimize(commands);
+ * 
+ * Rewrite a command list so that it does less work when replayed, without changing what it draws.
+ * 
+ * The passes are:
+ * 
+ * + redundant state changes are dropped: settings equal to the current value, and settings overwritten before any drawing used them.
+ * + draws completely hidden by a later opaque, pixel-aligned rectangle fill are dropped, along with the path they used.  Coverage is judged in the device pixels of the recording, so once this pass has dropped anything, the list can only be replayed without scaling, rotation or fractional translation; cairo.commands_replay() throws otherwise.
+ * + consecutive fills with nothing but path construction between them and non-overlapping bounds are merged into one fill.
+ * + fills and strokes with an opaque solid color and OPERATOR_OVER are replayed with OPERATOR_SOURCE.
+ * 
+ * The returned object has the following members:
+ * 
+ * + before - number of commands before optimizing.
+ * + after - number of commands after optimizing.
+ * + eliminated - before - after.
+ * + stateChanges - state changes dropped.
+ * + covered - draws dropped because they were covered.
+ * + merged - fills merged into the following fill.
+ * + sourceOperators - draws switched to OPERATOR_SOURCE.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} commands - opaque handle to a command list.
+ * @return {object} stats - what the optimizer did.
+ */
+static JSVAL commands_optimize(JSARGS args) {
+    CommandList *list = (CommandList *) JSEXTERN(args[0]);
+    int before = list->count;
+    CommandStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.stateChanges = optimize_state_changes(list);
+    // the other passes rely on colors and geometry that parameters could change
+    if (list->bindingCount == 0) {
+        stats.covered = optimize_covered_draws(list);
+        if (stats.covered) {
+            list->pixelExact = true;
+        }
+        stats.merged = optimize_merge_fills(list);
+        stats.sourceOperators = optimize_source_operators(list);
+    }
+    command_list_compact(list);
+
+    JSOBJ o = Object::New();
+    o->Set(String::New("before"), Integer::New(before));
+    o->Set(String::New("after"), Integer::New(list->count));
+    o->Set(String::New("eliminated"), Integer::New(before - list->count));
+    o->Set(String::New("stateChanges"), Integer::New(stats.stateChanges));
+    o->Set(String::New("covered"), Integer::New(stats.covered));
+    o->Set(String::New("merged"), Integer::New(stats.merged));
+    o->Set(String::New("sourceOperators"), Integer::New(stats.sourceOperators));
+    return o;
+}
+
+// Whether the context maps user space to its target's pixels by a whole-pixel translation.
+static bool context_translates_by_pixels(cairo_t *context) {
+    cairo_matrix_t m;
+    cairo_get_matrix(context, &m);
+    double dx, dy;
+    cairo_surface_get_device_offset(cairo_get_group_target(context), &dx, &dy);
+    double x = m.x0 + dx, y = m.y0 + dy;
+    return m.xx == 1 && m.yy == 1 && m.xy == 0 && m.yx == 0 && x == floor(x) && y == floor(y);
+}
+
+/**
+ * @function cairo.commands_replay
+ * 
+ * ### Synopsis
+ * 
+ * cairo.commands_replay(commands, context);
+ * 
+ * Perform the commands of a command list on a context.
+ * 
+ * The commands are applied on top of the context's current state, so, for example, a recording replayed on a translated context is drawn translated.  The list is not modified and can be replayed any number of times.
+ * 
+ * A list from which cairo.commands_optimize() dropped covered draws can only be replayed on a context whose transformation, together with its target's device offset, is a translation by whole pixels; elsewhere the covering rectangle's edges would fall between pixels and leave the dropped draws' edges showing, so an exception is thrown instead.
+ * 
+ * If the context is itself recording, as returned by cairo.commands_get_context(), the commands are appended to its list rather than performed.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} commands - opaque handle to a command list.
+ * @param {object} context - opaque handle to the context to draw on.
+ */
+static JSVAL commands_replay(JSARGS args) {
+    CommandList *list = (CommandList *) JSEXTERN(args[0]);
+    cairo_t *context = (cairo_t *) JSEXTERN(args[1]);
+    if (list->pixelExact && !context_translates_by_pixels(context)) {
+        return ThrowException(String::New("commands_replay: covered draws were optimized away; the list can only be replayed without scaling, rotation or fractional translation"));
+    }
+    CommandList *target = command_list_for(context);
+    if (target) {
+        command_list_append(list, context);
+        target->pixelExact = target->pixelExact || list->pixelExact;
+    }
+    else {
+        command_list_replay(list, context, NULL);
+    }
+    return Undefined();
+}
+
+/**
+ * @function cairo.commands_clear
+ * 
+ * ### Synopsis
+ * 
+ * cairo.commands_clear(commands);
+ * 
+ * Remove all commands from a command list.  The state of the recording context is not changed.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} commands - opaque handle to a command list.
+ */
+static JSVAL commands_clear(JSARGS args) {
+    CommandList *list = (CommandList *) JSEXTERN(args[0]);
+    command_list_clear(list);
+    return Undefined();
+}
+
+/**
+ * @function cairo.commands_destroy
+ * 
+ * ### Synopsis
+ * 
+ * cairo.commands_destroy(commands);
+ * 
+ * Release a command list.  A recording context obtained from it stops recording and becomes an ordinary context on an empty surface.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} commands - opaque handle to a command list.
+ */
+static JSVAL commands_destroy(JSARGS args) {
+    CommandList *list = (CommandList *) JSEXTERN(args[0]);
+    command_list_clear(list);
+    cairo_set_user_data(list->shadow, &command_list_key, NULL, NULL);
+    cairo_destroy(list->shadow);
+    cairo_surface_destroy(list->shadowSurface);
+    free(list->commands);
+    free(list->bindings);
+    free(list->clipStack);
+    delete list;
+    return Undefined();
+}
+
+////////////////////// CONTEXTS
+
+/**
+ * @function cairo.context_create
+ * 
+ * ### Synopsis
+ * 
+ * var context = cairo.context_create(surface);
+ * 
+ * Creates a new context with all graphics state parameters set to default values and with surface as a target surface. The target surface should be constructed with a backend-specific function such as cairo.image_surface_create() (or any other cairo.backend_surface_create() variant).
+ * 
+ * This function references surface, so you can immediately call cairo.surface_destroy() on it if you don't need to maintain a separate reference to it.
+ * 
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @return {object} context - opaque handle to a cairo context.
+ */
+static JSVAL context_create(JSARGS args) {
+    MetricsTimer timer(METRICS_CONTEXT_CREATE, "context_create");
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    return External::New(cairo_create(surface));
+}
+
+/**
+ * @function cairo.context_reference
+ * 
+ * ### Synopsis
+ * 
+ * var context = cairo.context_reference(context);
+ * 
+ * Increases the reference count on context by one. This prevents context from being destroyed until a matching call to cairo.context_destroy() is made.
+ * 
+ * The number of references to a context can be get using cairo.context_get_reference_count().
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @return {object} context - opaque handle to the referenced cairo context.
+ */
+static JSVAL context_reference(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    return External::New(cairo_reference(context));
+}
+
+/**
+ * @function cairo.context_get_reference_count
+ * 
+ * ### Synopsis
+ * 
+ * var count = cairo.context_get_reference_count(context);
+ * 
+ * Returns the current reference count of context.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @return {int} count - reference count of the context.
+ */
+static JSVAL context_get_reference_count(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    return Integer::New(cairo_get_reference_count(context));
+}
+
+/**
+ * @function cairo.context_destroy
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_destroy(context);
+ * 
+ * Decreases the reference count on context by one. If the result is zero, then context and all associated resources are freed. 
+ * 
+ * See cairo.context_reference().
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ */
+static JSVAL context_destroy(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    cairo_destroy(context);
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_reset
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_reset(context);
+ * 
+ * Return a context's graphics state to the defaults of a newly created context, without reallocating it.
+ * 
+ * The current path is cleared, the clip is reset, the CTM is set to the identity matrix, and the source, operator, line, dash, fill rule, tolerance, antialias and font settings are returned to their defaults.
+ * 
+ * States saved with cairo.context_save() are not popped; callers that track their save depth should call cairo.context_restore() for each outstanding save first.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ */
+static JSVAL context_reset(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    cairo_new_path(context);
+    cairo_reset_clip(context);
+    cairo_identity_matrix(context);
+    cairo_set_source_rgb(context, 0, 0, 0);
+    cairo_set_operator(context, CAIRO_OPERATOR_OVER);
+    cairo_set_line_width(context, 2.0);
+    cairo_set_line_cap(context, CAIRO_LINE_CAP_BUTT);
+    cairo_set_line_join(context, CAIRO_LINE_JOIN_MITER);
+    cairo_set_miter_limit(context, 10.0);
+    cairo_set_dash(context, NULL, 0, 0);
+    cairo_set_fill_rule(context, CAIRO_FILL_RULE_WINDING);
+    cairo_set_tolerance(context, 0.1);
+    cairo_set_antialias(context, CAIRO_ANTIALIAS_DEFAULT);
+    cairo_set_font_face(context, NULL);
+    cairo_set_font_size(context, 10.0);
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_status
+ * 
+ * ### Synopsis
+ * 
+ * var status = cairo.context_status(context);
+ * 
+ * Returns the previous error status code for this context.
+ * 
+ * The status returned is one of the following:
+ *  
+ * + cairo.STATUS_SUCCESS - no error has occurred
+ * + cairo.STATUS_NO_MEMORY - out of memory
+ * + cairo.STATUS_INVALID_RESTORE - cairo_restore() called without matching cairo_save()
+ * + cairo.STATUS_INVALID_POP_GROUP - no saved group to pop, i.e. cairo_pop_group() without matching cairo_push_group()
+ * + cairo.STATUS_NO_CURRENT_POINT - no current point defined
+ * + cairo.STATUS_INVALID_MATRIX - invalid matrix (not invertible)
+ * + cairo.STATUS_INVALID_STATUS - invalid value for an input + cairo.STATUS_t
+ * + cairo.STATUS_NULL_POINTER - NULL pointer
+ * + cairo.STATUS_INVALID_STRING - input string not valid UTF-8
+ * + cairo.STATUS_INVALID_PATH_DATA - input path data not valid
+ * + cairo.STATUS_READ_ERROR - error while reading from input stream
+ * + cairo.STATUS_WRITE_ERROR - error while writing to output stream
+ * + cairo.STATUS_SURFACE_FINISHED - target surface has been finished
+ * + cairo.STATUS_SURFACE_TYPE_MISMATCH - the surface type is not appropriate for the operation
+ * + cairo.STATUS_PATTERN_TYPE_MISMATCH - the pattern type is not appropriate for the operation
+ * + cairo.STATUS_INVALID_CONTENT - invalid value for an input cairo_content_t
+ * + cairo.STATUS_INVALID_FORMAT - invalid value for an input cairo_format_t
+ * + cairo.STATUS_INVALID_VISUAL - invalid value for an input Visual*
+ * + cairo.STATUS_FILE_NOT_FOUND - file not found
+ * + cairo.STATUS_INVALID_DASH - invalid value for a dash setting
+ * + cairo.STATUS_INVALID_DSC_COMMENT - invalid value for a DSC comment (Since 1.2)
+ * + cairo.STATUS_INVALID_INDEX - invalid index passed to getter (Since 1.4)
+ * + cairo.STATUS_CLIP_NOT_REPRESENTABLE - clip region not representable in desired format (Since 1.4)
+ * + cairo.STATUS_TEMP_FILE_ERROR - error creating or writing to a temporary file (Since 1.6)
+ * + cairo.STATUS_INVALID_STRIDE - invalid value for stride (Since 1.6)
+ * + cairo.STATUS_FONT_TYPE_MISMATCH - the font type is not appropriate for the operation (Since 1.8)
+ * + cairo.STATUS_USER_FONT_IMMUTABLE - the user-font is immutable (Since 1.8)
+ * + cairo.STATUS_USER_FONT_ERROR - error occurred in a user-font callback function (Since 1.8)
+ * + cairo.STATUS_NEGATIVE_COUNT - negative number used where it is not allowed (Since 1.8)
+ * + cairo.STATUS_INVALID_CLUSTERS - input clusters do not represent the accompanying text and glyph array (Since 1.8)
+ * + cairo.STATUS_INVALID_SLANT - invalid value for an input cairo_font_slant_t (Since 1.8)
+ * + cairo.STATUS_INVALID_WEIGHT - invalid value for an input cairo_font_weight_t (Since 1.8)
+ * + cairo.STATUS_INVALID_SIZE - invalid value (typically too big) for the size of the input (surface, pattern, etc.) (Since 1.10)
+ * + cairo.STATUS_USER_FONT_NOT_IMPLEMENTED - user-font method not implemented (Since 1.10)
+ * + cairo.STATUS_DEVICE_TYPE_MISMATCH - the device type is not appropriate for the operation (Since 1.10)
+ * + cairo.STATUS_DEVICE_ERROR - an operation to the device caused an unspecified error (Since 1.10)
+ * + cairo.STATUS_INVALID_MESH_CONSTRUCTION - a mesh pattern construction operation was used outside of a cairo_mesh_pattern_begin_patch()/cairo_mesh_pattern_end_patch() pair (Since 1.12)
+ * + cairo.STATUS_DEVICE_FINISHED - target device has been finished (Since 1.12)
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @return {int} status - see possible values above.
+ */
+static JSVAL context_status(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    return Integer::New(cairo_status(context));
+}
+
+/**
+ * @function cairo.context_save
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_save(context);
+ * 
+ * Makes a copy of the current state of context and saves it on an internal stack of saved states for context. 
+ * 
+ * When cairo.context_restore() is called, context will be restored to the saved state. 
+ * 
+ * Multiple calls to cairo.context_save() and cairo.context_restore() can be nested; each call to cairo.context_restore() restores the state from the matching paired cairo.context_save().
+ * 
+ * It isn't necessary to clear all saved states before a context is freed. 
+ * 
+ * If the reference count of a context drops to zero in response to a call to cairo.context_destroy(), any saved states will be freed along with the context.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ */
+static JSVAL context_save(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    record_command(context, COMMAND_SAVE, args, 0);
+    cairo_save(context);
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_restore
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_restore(context);
+ * 
+ * Restores context to the state saved by a preceding call to cairo.context_save() and removes that state from the stack of saved states.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ */
+static JSVAL context_restore(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    record_command(context, COMMAND_RESTORE, args, 0);
+    cairo_restore(context);
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_get_target
+ * 
+ * ### Synopsis
+ * 
+ * var surface = cairo.context_get_target(context);
+ * 
+ * Gets the target surface for the cairo context as passed to cairo.context_create().
+ * 
+ * This function will always return a valid pointer, but the result can be a "nil" surface if cr is already in an error state, (ie. cairo.context_status() != cairo.STATUS_SUCCESS).
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @return {object} surface - opaque handle to the cairo surface.
+ */
+static JSVAL context_get_target(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    return External::New(cairo_get_target(context));
+}
+
+/**
+ * @function cairo.context_push_group
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_push_group(context);
+ * 
+ * Temporarily redirects drawing to an intermediate surface known as a group. 
+ * 
+ * The redirection lasts until the group is completed by a call to cairo.context_pop_group() or cairo.context_pop_group_to_source(). 
+ * 
+ * These calls provide the result of any drawing to the group as a pattern, (either as an explicit object, or set as the source pattern).
+ * 
+ * This group functionality can be convenient for performing intermediate compositing. One common use of a group is to render objects as opaque within the group, (so that they occlude each other), and then blend the result with translucence onto the destination.
+ * 
+ * Groups can be nested arbitrarily deep by making balanced calls to cairo.context_push_group()/cairo.context_pop_group(). Each call pushes/pops the new target group onto/from a stack.
+ * 
+ * The cairo.context_push_group() function calls cairo.context_save() so that any changes to the graphics state will not be visible outside the group, (the cairo.content_pop_group() functions call cairo.context__restore()).
+ * 
+ * By default the intermediate group will have a content type of cairo.CONTENT_COLOR_ALPHA. Other content types can be chosen for the group by using cairo.context_push_group_with_content() instead.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * 
+ * ### Example
+ * 
+ * As an example, here is how one might fill and stroke a path with translucence, but without any portion of the fill being visible under the stroke:
+ * 
+ * ```
+ * cairo.context_push_group (context);
+ * cairo.context_set_source (context, fill_pattern);
+ * cairo.context_fill_preserve (context);
+ * cairo.context_set_source (context, stroke_pattern);
+ * cairo.context_stroke (context);
+ * cairo.context_pop_group_to_source (context);
+ * cairo.context_paint_with_alpha (context, alpha);
+ * ```
+ */
+static JSVAL context_push_group(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    record_command(context, COMMAND_PUSH_GROUP, args, 0);
+    cairo_push_group(context);
+    track_surface(cairo_get_group_target(context));
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_push_group_with_content
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_push_group_with_content(context, content);
+ * 
+ * Temporarily redirects drawing to an intermediate surface known as a group. The redirection lasts until the group is completed by a call to cairo.context_pop_group() or cairo.context_pop_group_to_source(). These calls provide the result of any drawing to the group as a pattern, (either as an explicit object, or set as the source pattern).
+ * 
+ * The group will have a content type of content. The ability to control this content type is the only distinction between this function and cairo.content_push_group() which you should see for a more detailed description of group rendering.
+ * 
+ * The content parameter is one of the following value:
+ * 
+ * + cairo.CONTENT_COLOR - the surface will hold color content only.
+ * + cairo.CONTENT_ALPHA - the surface will hold alpha content only.
+ * + cairo.CONTENT_COLOR_ALPHA - the surface will hold color and alpha content.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ */
+static JSVAL context_push_group_with_content(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    record_command(context, COMMAND_PUSH_GROUP_WITH_CONTENT, args, 1);
+    cairo_push_group_with_content(context, (cairo_content_t)args[1]->IntegerValue());
+    track_surface(cairo_get_group_target(context));
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_pop_group
+ * 
+ * ### Synopsis
+ * 
+ * var pattern = cairo.context_pop_group(context);
+ * 
+ * Terminates the redirection begun by a call to cairo.context_push_group() or cairo.context_push_group_with_content() and returns a new pattern containing the results of all drawing operations performed to the group.
+ * 
+ * The cairo.context_pop_group() function calls cairo.context_restore(), (balancing a call to cairo.context_save() by the cairo.context_push_group() function), so that any changes to the graphics state will not be visible outside the group.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @return {object} pattern - opaque handle to a cairo pattern.
+ */
+static JSVAL context_pop_group(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    if (command_list_for(context)) {
+        return not_recordable("context_pop_group");
+    }
+    return External::New(track_pattern(cairo_pop_group(context)));
+}
+
+/**
+ * @function cairo.context_pop_group_to_source
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_pop_group_to_source(context);
+ * 
+ * Terminates the redirection begun by a call to cairo.context_push_group() or cairo,context_push_group_with_content() and installs the resulting pattern as the source pattern in the given cairo context.
+ * 
+ * The behavior of this function is equivalent to the sequence of operations:
+ * 
+ * ```
+ * var group = cairo.context_pop_group (context);
+ * cairo.context_set_source (context, group);
+ * cairo.pattern_destroy (group);
+ * ```
+ * but is more convenient as their is no need for a variable to store the short-lived pointer to the pattern.
+ * 
+ * The cairo.context_pop_group() function calls cairo.context_restore(), (balancing a call to cairo.context_save() by the cairo.context_push_group()function), so that any changes to the graphics state will not be visible outside the group.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ */
+static JSVAL context_pop_group_to_source(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    record_command(context, COMMAND_POP_GROUP_TO_SOURCE, args, 0);
+    cairo_pop_group_to_source(context);
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_get_group_target
+ * 
+ * ### Synopsis
+ * 
+ * var surface = cairo.context_get_group_target(context);
+ * 
+ * Gets the current destination surface for the context. This is either the original target surface as passed to cairo.context_create() or the target surface for the current group as started by the most recent call to cairo.context_push_group() or cairo.context_push_group_with_content().
+ * 
+ * This function will always return a valid pointer, but the result can be a "nil" surface if context is already in an error state, (ie. cairo.context_status() != cairo.STATUS_SUCCESS).
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @return {object} surface - opaque handle to the cairo surface.
+ */
+static JSVAL context_get_group_target(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    return External::New(cairo_get_group_target(context));
+}
+
+/**
+ * @function cairo.context_blur_group
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_blur_group(context, radius);
+ * 
+ * Blur what has been drawn into the current group, as started by cairo.context_push_group().
+ * 
+ * This is the same as calling cairo.surface_blur() on cairo.context_get_group_target(), except that it can be recorded by a command list.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @param {int} radius - blur radius in pixels.
+ */
+static JSVAL context_blur_group(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    if (record_command(context, COMMAND_BLUR_GROUP, args, 1)) {
+        return Undefined();
+    }
+    blur_image_surface(cairo_get_group_target(context), args[1]->IntegerValue());
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_set_source_rgb
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_set_source_rgb(context, red, green, blue);
+ * 
+ * Sets the source pattern within context to an opaque color. 
+ * 
+ * This opaque color will then be used for any subsequent drawing operation until a new source pattern is set.
+ * 
+ * The color components are floating point numbers in the range 0 to 1. If the values passed in are outside that range, they will be clamped.
+ * 
+ * The default source pattern is opaque black, (that is, it is equivalent to cairo.context_set_source_rgb(context, 0.0, 0.0, 0.0)).
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @param {number} red - red component of color
+ * @param {number} green - green component of color
+ * @param {number} blue - blue component of color
+ */
+static JSVAL context_set_source_rgb(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    Command *command = record_command(context, COMMAND_SET_SOURCE_RGBA, args, 3);
+    if (command) {
+        command->args[3] = 1;
+    }
+    cairo_set_source_rgb(context, args[1]->NumberValue(), args[2]->NumberValue(), args[3]->NumberValue());
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_set_source_rgba
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_set_source_rgba(context, red, green, blue, alpha);
+ * 
+ * Sets the source pattern within context to a translucent color. 
+ * 
+ * This color will then be used for any subsequent drawing operation until a new source pattern is set.
+ * 
+ * The color and alpha components are floating point numbers in the range 0 to 1. If the values passed in are outside that range, they will be clamped.
+ * 
+ * The default source pattern is opaque black, (that is, it is equivalent to cairo.context_set_source_rgba(context, 0.0, 0.0, 0.0, 1.0)).
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @param {number} red - red component of color
+ * @param {number} green - green component of color
+ * @param {number} blue - blue component of color
+ * @param {number} alpha - alpha component of color
+ */
+static JSVAL context_set_source_rgba(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    record_command(context, COMMAND_SET_SOURCE_RGBA, args, 4);
+    cairo_set_source_rgba(context, args[1]->NumberValue(), args[2]->NumberValue(), args[3]->NumberValue(), args[4]->NumberValue());
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_set_source
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_set_source(context, pattern);
+ * 
+ * Sets the source pattern within context to pattern. 
+ * 
+ * This pattern will then be used for any subsequent drawing operation until a new source pattern is set.
+ * 
+ * Note: The pattern's transformation matrix will be locked to the user space in effect at the time of cairo.context_set_source(). This means that further modifications of the current transformation matrix will not affect the source pattern. See cairo.pattern_set_matrix().
+ * 
+ * The default source pattern is a solid pattern that is opaque black, (that is, it is equivalent to cairo.context_set_source_rgb(context, 0.0, 0.0, 0.0)).
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @param {object} pattern - opaque handle to a cairo pattern.
+ */
+static JSVAL context_set_source(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    cairo_pattern_t *pattern = (cairo_pattern_t *) JSEXTERN(args[1]);
+    Command *command = record_command(context, COMMAND_SET_SOURCE, args, 0);
+    if (command) {
+        // the recording keeps the pattern as it is now; later changes to the caller's pattern
+        // are for later draws.  The copy is also what get_source() returns, so an extend or
+        // filter set through it right away is recorded too.
+        cairo_pattern_t *copy = pattern_copy(pattern, 1.0);
+        command->data = copy;
+        cairo_set_source(context, copy);
+        return Undefined();
+    }
+    cairo_set_source(context, pattern);
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_set_source_surface
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_set_source_surface(context, surface, x, y);
+ * 
+ * This is a convenience function for creating a pattern from surface and setting it as the source in context with cairo.context_set_source().
+ * 
+ * The x and y parameters give the user-space coordinate at which the surface origin should appear. (The surface origin is its upper-left corner before any transformation has been applied.) The x and y parameters are negated and then set as translation values in the pattern matrix.
+ * 
+ * Other than the initial translation pattern matrix, as described above, all other pattern attributes, (such as its extend mode), are set to the default values as in cairo.pattern_create_for_surface(). The resulting pattern can be queried with cairo.context_get_source() so that these attributes can be modified if desired, (eg. to create a repeating pattern with cairo.pattern_set_extend()).
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @param {object} surface - opaque handle to a cairo surface..
+ * @param {number} x - x coordinate of surface origin.
+ * @param {number} y - y coordinate of surface origin.
+ */
+static JSVAL context_set_source_surface(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[1]);
+    double x = args[2]->NumberValue();
+    double y = args[3]->NumberValue();
+    Command *command = record_command(context, COMMAND_SET_SOURCE, args, 0);
+    if (command) {
+        // the recording keeps its own pattern, the one get_source() returns for filter changes
+        cairo_pattern_t *pattern = cairo_pattern_create_for_surface(surface);
+        cairo_matrix_t matrix;
+        cairo_matrix_init_translate(&matrix, -x, -y);
+        cairo_pattern_set_matrix(pattern, &matrix);
+        command->data = pattern;
+        cairo_set_source(context, pattern);
+        return Undefined();
+    }
+    cairo_set_source_surface(context, surface, x, y);
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_get_source
+ * 
+ * ### Synopsis
+ * 
+ * var pattern = cairo.context_get_source(context, pattern);
+ * 
+ * Gets the current source pattern within context. 
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @return {object} pattern - opaque handle to a cairo pattern.
+ */
+static JSVAL context_get_source(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    return External::New(cairo_get_source(context));
+}
+
+/**
+ * @function cairo.context_set_antialias
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_set_antialias(context, mode);
+ * 
+ * Set the antialiasing mode of the rasterizer used for drawing shapes. 
+ * 
+ * This value is a hint, and a particular backend may or may not support a particular value. At the current time, no backend supports cairo.ANTIALIAS_SUBPIXEL when drawing shapes.
+ * 
+ * Note that this option does not affect text rendering, instead see cairo.context_font_options_set_antialias().
+ * 
+ * Valid modes are:
+ * 
+ * + cairo.ANTIALIAS_DEFAULT - use the default antialiasing for the subsystem and target device.
+ * + cairo.ANTIALIAS_NONE - use a bilevel alpha mask.
+ * + cairo.ANTIALIAS_GRAY - perform single-color antialiasing (using shades of gray for black text on a white background, for example).
+ * + cairo.ANTIALIAS_SUBPIXEL - perform antialiasing by taking advantage of the order of subpixel elements on devices such as LCD panels.
+ * + cairo_ANTIALIAS_FAST - Hint that the backend should perform some antialiasing but prefer speed over quality, since 1.12.
+ * + cairo.ANTIALIAS_GOOD - The backend should balance quality against performance, since 1.12.
+ * + CAIRO_ANTIALIAS_BEST - Hint that the backend should render at the highest quality, sacrificing speed if necessary, since 1.12
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @param {int} mode - one of the above modes.
+ */
+static JSVAL context_set_antialias(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    record_command(context, COMMAND_SET_ANTIALIAS, args, 1);
+    cairo_set_antialias(context, (cairo_antialias_t)args[1]->IntegerValue());
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_get_antialias
+ * 
+ * ### Synopsis
+ * 
+ * var mode = cairo.context_get_antialias(context);
+ * 
+ * Gets the current shape antialiasing mode, as set by cairo.context_set_antialias().
+ * 
+ * The return value is a mode:
+ * 
+ * Valid modes are:
+ * 
+ * + cairo.ANTIALIAS_DEFAULT - use the default antialiasing for the subsystem and target device.
+ * + cairo.ANTIALIAS_NONE - use a bilevel alpha mask.
+ * + cairo.ANTIALIAS_GRAY - perform single-color antialiasing (using shades of gray for black text on a white background, for example).
+ * + cairo.ANTIALIAS_SUBPIXEL - perform antialiasing by taking advantage of the order of subpixel elements on devices such as LCD panels.
+ * + cairo_ANTIALIAS_FAST - Hint that the backend should perform some antialiasing but prefer speed over quality, since 1.12.
+ * + cairo.ANTIALIAS_GOOD - The backend should balance quality against performance, since 1.12.
+ * + CAIRO_ANTIALIAS_BEST - Hint that the backend should render at the highest quality, sacrificing speed if necessary, since 1.12
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @return {int} mode - see list above.
+ */
+static JSVAL context_get_antialias(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    return Integer::New(cairo_get_antialias(context));
+}
+
+/**
+ * @function cairo.content_set_dash
+ * 
+ * ### Synopsis
+ * 
+ * cairo.context_set_dash(context, dashes, offset);
+ * 
+ * Sets the dash pattern to be used by cairo.context_stroke(). 
+ * 
+ * A dash pattern is specified by dashes, an array of positive values. 
+ * 
+ * Each value provides the length of alternate "on" and "off" portions of the stroke. 
+ * 
+ * The offset specifies an offset into the pattern at which the stroke begins.
+ * 
+ * Each "on" segment will have caps applied as if the segment were a separate sub-path. In particular, it is valid to use an "on" length of 0.0 with cairo.LINE_CAP_ROUND or cairo.LINE_CAP_SQUARE in order to distributed dots or squares along a path.
+ * 
+ * Note: The length values are in user-space units as evaluated at the time of stroking. This is not necessarily the same as the user space at the time of cairo.context_set_dash()..
+ * 
+ * If the dashes array has length 0, dashing is disabled.
+ * 
+ * If the dashes array has a single element,  a symmetric pattern is assumed with alternating on and off portions of the size specified by the single value in dashes.
+ * 
+ * If any value in dashes is negative, or if all values are 0, then context will be put into an error state with a status of cairo.STATUS_INVALID_DASH.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @param {array} dashes - array of dash information, described above.
+ * @param {number} offset - offset into pattern at which the stroke begins.
+ */
+static JSVAL context_set_dash(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    Handle<Array>dashes = Handle<Array>::Cast(args[1]->ToObject());
+    double offset = args[2]->NumberValue();
+    
+    int numDashes = dashes->Length();
+    if (numDashes == 0) {
+        cairo_set_dash(context, NULL, 0, offset);
+    }
+    double *dashArray = new double[numDashes];
+    for (int i=0; i<numDashes; i++) {
+        dashArray[i] = dashes->Get(i)->NumberValue();
+    }
+    cairo_set_dash(context, dashArray, numDashes, offset);
+    Command *command = record_command(context, COMMAND_SET_DASH, args, 0);
+    if (command) {
+        command->args[0] = numDashes;
+        command->args[1] = offset;
+        command->data = malloc(numDashes * sizeof(double));
+        memcpy(command->data, dashArray, numDashes * sizeof(double));
+    }
+    delete [] dashArray;
+    
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_get_dash_count
+ * 
+ * ### Synopsis
+ * 
+ * var count = cairo.context_get_dash_count(context);
+ * 
+ * Returns the length of the dash array in the context, or 0 if dashing is not in effect.
+ * 
+ * See also cairo.context_set_dash() and cairo_context.get_dash().
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @return {int} count - length of dashes array.
+ */
+static JSVAL context_get_dash_count(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    return Integer::New(cairo_get_dash_count(context));
+}
+
+/**
+ * @function cairo.context_get_dash
+ * 
+ * ### Synopsis
+ * 
+ * var dashes = cairo.context_get_dash(context);
+ * 
+ * Gets the current dash array.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @return {array} dashes = array of Number values of the dash array for the context.
+ */
+static JSVAL context_get_dash(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    
+    int count = cairo_get_dash_count(context);
+    double *dashes = new double[count];
+    double offset;
+    cairo_get_dash(context, dashes, &offset);
+    Handle<Array>a = Array::New(count);
+    for (int i=0; i<count; i++) {
+        a->Set(i, Number::New(dashes[i]));
+    }
+    delete [] dashes;
+    return a;
 }
 
 /**
- * @function cairo.context_reference
+ * @function cairo.context_set_fill_rule
  * 
  * ### Synopsis
  * 
- * var context = cairo.context_reference(context);
+ * cairo.context_set_fill_rule(context, rule);
  * 
- * Increases the reference count on context by one. This prevents context from being destroyed until a matching call to cairo.context_destroy() is made.
+ * Set the current fill rule within the cairo context. The fill rule is used to determine which regions are inside or outside a complex (potentially self-intersecting) path. The current fill rule affects both cairo.context_fill() and cairo.context_clip().
  * 
- * The number of references to a context can be get using cairo.context_get_reference_count().
+ * The rule argument may be:
+ * 
+ * cairo.FILL_RULE_WINDING
+ *   If the path crosses the ray from left-to-right, counts +1. If the path crosses the ray from right to left, counts -1. (Left and right are determined from the perspective of looking along the ray from the starting point.) If the total count is non-zero, the point will be filled.
+ * cairo.FILL_RULE_EVEN_ODD
+ *   Counts the total number of intersections, without regard to the orientation of the contour. If the total number of intersections is odd, the point will be filled.
+ * 
+ * For both fill rules, whether or not a point is included in the fill is determined by taking a ray from that point to infinity and looking at intersections with the path. The ray can be in any direction, as long as it doesn't pass through the end point of a segment or have a tricky intersection such as intersecting tangent to the path. (Note that filling is not actually implemented in this way. This is just a description of the rule that is applied.)
+ * 
+ * The default fill rule is cairo.FILL_RULE_WINDING.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} context - opaque handle to the referenced cairo context.
+ * @param {int} rule - one of the above fill rules.
  */
-static JSVAL context_reference(JSARGS args) {
+static JSVAL context_set_fill_rule(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return External::New(cairo_reference(context));
+    int rule = args[1]->IntegerValue();
+    record_command(context, COMMAND_SET_FILL_RULE, args, 1);
+    cairo_set_fill_rule(context, (cairo_fill_rule_t)rule);
+    return Undefined();
 }
 
 /**
- * @function cairo.context_get_reference_count
+ * @function cairo.context_get_fill_rule
  * 
  * ### Synopsis
  * 
- * var count = cairo.context_get_reference_count(context);
+ * var rule = cairo.context_get_fill_rule(context);
  * 
- * Returns the current reference count of context.
+ * Gets the current fill rule, as set by cairo.context_set_fill_rule().
+ * 
+ * See cairo.context_set_fill_rule() for description of the fill rule values.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {int} count - reference count of the context.
+ * @return {int} rule - fill rule
  */
-static JSVAL context_get_reference_count(JSARGS args) {
+static JSVAL context_get_fill_rule(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_get_reference_count(context));
+    return Integer::New(cairo_get_fill_rule(context));
 }
 
 /**
- * @function cairo.context_destroy
+ * @function cairo.context_set_line_cap
  * 
  * ### Synopsis
  * 
- * cairo.context_destroy(context);
+ * cairo.context_set_line_cap(context, line_cap);
  * 
- * Decreases the reference count on context by one. If the result is zero, then context and all associated resources are freed. 
+ * Sets the current line cap style within the cairo context. 
  * 
- * See cairo.context_reference().
+ * As with the other stroke parameters, the current line cap style is examined by cairo.context_stroke(), cairo.context_stroke_extents(), and cairo.context_stroke_to_path(), but does not have any effect during path construction.
+ * 
+ * The line_cap values may be:
+ * 
+ * cairo.LINE_CAP_BUTT
+ *   start(stop) the line exactly at the start(end) point
+ * cairo.LINE_CAP_ROUND
+ *   use a round ending, the center of the circle is the end point
+ * cairo.LINE_CAP_SQUARE
+ *   use squared ending, the center of the square is the end point
+ * 
+ * The default line cap style is cairo.LINE_CAP_BUTT.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {int} line_cap - one of the above line_cap values.
  */
-static JSVAL context_destroy(JSARGS args) {
+static JSVAL context_set_line_cap(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_destroy(context);
+    int line_cap = args[1]->IntegerValue();
+    record_command(context, COMMAND_SET_LINE_CAP, args, 1);
+    cairo_set_line_cap(context, (cairo_line_cap_t)line_cap);
     return Undefined();
 }
 
 /**
- * @function cairo.context_status
+ * @function cairo.context_get_line_cap
  * 
  * ### Synopsis
  * 
- * var status = cairo.context_status(context);
+ * var line_cap = cairo.context_get_line_cap(context);
  * 
- * Returns the previous error status code for this context.
+ * Gets the current line cap style, as set by cairo.context_set_line_cap().
  * 
- * The status returned is one of the following:
- *  
- * + cairo.STATUS_SUCCESS - no error has occurred
- * + cairo.STATUS_NO_MEMORY - out of memory
- * + cairo.STATUS_INVALID_RESTORE - cairo_restore() called without matching cairo_save()
- * + cairo.STATUS_INVALID_POP_GROUP - no saved group to pop, i.e. cairo_pop_group() without matching cairo_push_group()
- * + cairo.STATUS_NO_CURRENT_POINT - no current point defined
- * + cairo.STATUS_INVALID_MATRIX - invalid matrix (not invertible)
- * + cairo.STATUS_INVALID_STATUS - invalid value for an input + cairo.STATUS_t
- * + cairo.STATUS_NULL_POINTER - NULL pointer
- * + cairo.STATUS_INVALID_STRING - input string not valid UTF-8
- * + cairo.STATUS_INVALID_PATH_DATA - input path data not valid
- * + cairo.STATUS_READ_ERROR - error while reading from input stream
- * + cairo.STATUS_WRITE_ERROR - error while writing to output stream
- * + cairo.STATUS_SURFACE_FINISHED - target surface has been finished
- * + cairo.STATUS_SURFACE_TYPE_MISMATCH - the surface type is not appropriate for the operation
- * + cairo.STATUS_PATTERN_TYPE_MISMATCH - the pattern type is not appropriate for the operation
- * + cairo.STATUS_INVALID_CONTENT - invalid value for an input cairo_content_t
- * + cairo.STATUS_INVALID_FORMAT - invalid value for an input cairo_format_t
- * + cairo.STATUS_INVALID_VISUAL - invalid value for an input Visual*
- * + cairo.STATUS_FILE_NOT_FOUND - file not found
- * + cairo.STATUS_INVALID_DASH - invalid value for a dash setting
- * + cairo.STATUS_INVALID_DSC_COMMENT - invalid value for a DSC comment (Since 1.2)
- * + cairo.STATUS_INVALID_INDEX - invalid index passed to getter (Since 1.4)
- * + cairo.STATUS_CLIP_NOT_REPRESENTABLE - clip region not representable in desired format (Since 1.4)
- * + cairo.STATUS_TEMP_FILE_ERROR - error creating or writing to a temporary file (Since 1.6)
- * + cairo.STATUS_INVALID_STRIDE - invalid value for stride (Since 1.6)
- * + cairo.STATUS_FONT_TYPE_MISMATCH - the font type is not appropriate for the operation (Since 1.8)
- * + cairo.STATUS_USER_FONT_IMMUTABLE - the user-font is immutable (Since 1.8)
- * + cairo.STATUS_USER_FONT_ERROR - error occurred in a user-font callback function (Since 1.8)
- * + cairo.STATUS_NEGATIVE_COUNT - negative number used where it is not allowed (Since 1.8)
- * + cairo.STATUS_INVALID_CLUSTERS - input clusters do not represent the accompanying text and glyph array (Since 1.8)
- * + cairo.STATUS_INVALID_SLANT - invalid value for an input cairo_font_slant_t (Since 1.8)
- * + cairo.STATUS_INVALID_WEIGHT - invalid value for an input cairo_font_weight_t (Since 1.8)
- * + cairo.STATUS_INVALID_SIZE - invalid value (typically too big) for the size of the input (surface, pattern, etc.) (Since 1.10)
- * + cairo.STATUS_USER_FONT_NOT_IMPLEMENTED - user-font method not implemented (Since 1.10)
- * + cairo.STATUS_DEVICE_TYPE_MISMATCH - the device type is not appropriate for the operation (Since 1.10)
- * + cairo.STATUS_DEVICE_ERROR - an operation to the device caused an unspecified error (Since 1.10)
- * + cairo.STATUS_INVALID_MESH_CONSTRUCTION - a mesh pattern construction operation was used outside of a cairo_mesh_pattern_begin_patch()/cairo_mesh_pattern_end_patch() pair (Since 1.12)
- * + cairo.STATUS_DEVICE_FINISHED - target device has been finished (Since 1.12)
+ * See cairo.context_set_line_cap() for description of the line_cap values.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {int} status - see possible values above.
+ * @return {int} line_cap - line cap style.
  */
-static JSVAL context_status(JSARGS args) {
+static JSVAL context_get_line_cap(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_status(context));
+    return Integer::New(cairo_get_line_cap(context));
 }
 
 /**
- * @function cairo.context_save
+ * @function cairo.context_set_line_join
  * 
  * ### Synopsis
  * 
- * cairo.context_save(context);
+ * cairo.context_set_line_join(context, line_join);
  * 
- * Makes a copy of the current state of context and saves it on an internal stack of saved states for context. 
+ * Sets the current line join style within the cairo context. 
  * 
- * When cairo.context_restore() is called, context will be restored to the saved state. 
+ * As with the other stroke parameters, the current line join style is examined by cairo.context_stroke(), cairo.context_stroke_extents(), and cairo.context_stroke_to_path(), but does not have any effect during path construction.
  * 
- * Multiple calls to cairo.context_save() and cairo.context_restore() can be nested; each call to cairo.context_restore() restores the state from the matching paired cairo.context_save().
+ * Line join styles may be:
  * 
- * It isn't necessary to clear all saved states before a context is freed. 
+ * cairo.LINE_JOIN_MITER
+ *   use a sharp (angled) corner, see cairo.context_set_miter_limit().
+ * cairo.LINE_JOIN_ROUND
+ *   use a rounded join, the center of the circle is the joint point.
+ * cairo.LINE_JOIN_BEVEL
+ *   use a cut-off join, the join is cut off at half the line width from the joint point
  * 
- * If the reference count of a context drops to zero in response to a call to cairo.context_destroy(), any saved states will be freed along with the context.
+ * The default line join style is cairo.LINE_JOIN_MITER.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {int} line_join - one of the above line_join values.
  */
-static JSVAL context_save(JSARGS args) {
+static JSVAL context_set_line_join(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_save(context);
+    int line_join = args[1]->IntegerValue();
+    record_command(context, COMMAND_SET_LINE_JOIN, args, 1);
+    cairo_set_line_join(context, (cairo_line_join_t)line_join);
     return Undefined();
 }
 
 /**
- * @function cairo.context_restore
+ * @function cairo.context_get_line_join
  * 
  * ### Synopsis
  * 
- * cairo.context_restore(context);
+ * var line_join = cairo.context_get_line_join(context);
  * 
- * Restores context to the state saved by a preceding call to cairo.context_save() and removes that state from the stack of saved states.
+ * Gets the current line join style, as set by cairo.context_set_line_join().
+ * 
+ * See cairo.context_set_line_join() for description of the line_join values.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @return {int} line_join - line join style.
  */
-static JSVAL context_restore(JSARGS args) {
+static JSVAL context_get_line_join(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_restore(context);
-    return Undefined();
+    return Integer::New(cairo_get_line_join(context));
 }
 
 /**
- * @function cairo.context_get_target
+ * @function cairo.context_set_line_width
  * 
  * ### Synopsis
  * 
- * var surface = cairo.context_get_target(context);
+ * cairo.context_set_line_width(context, width);
  * 
- * Gets the target surface for the cairo context as passed to cairo.context_create().
+ * Sets the current line width within the cairo context. The line width value specifies the diameter of a pen that is circular in user space, (though device-space pen may be an ellipse in general due to scaling/shear/rotation of the CTM).
  * 
- * This function will always return a valid pointer, but the result can be a "nil" surface if cr is already in an error state, (ie. cairo.context_status() != cairo.STATUS_SUCCESS).
+ * Note: When the description above refers to user space and CTM it refers to the user space and CTM in effect at the time of the stroking operation, not the user space and CTM in effect at the time of the call to cairo_set_line_width(). The simplest usage makes both of these spaces identical. That is, if there is no change to the CTM between a call to cairo_set_line_width() and the stroking operation, then one can just pass user-space values to cairo.context_set_line_width() and ignore this note.
+ * 
+ * As with the other stroke parameters, the current line width is examined by cairo.context_stroke(), cairo.context_stroke_extents(), and cairo.context_stroke_to_path(), but does not have any effect during path construction.
+ * 
+ * The default line width value is 2.0.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} surface - opaque handle to the cairo surface.
+ * @param {number} width - setting for line width.
  */
-static JSVAL context_get_target(JSARGS args) {
+static JSVAL context_set_line_width(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return External::New(cairo_get_target(context));
+    double width = args[1]->NumberValue();
+    record_command(context, COMMAND_SET_LINE_WIDTH, args, 1);
+    cairo_set_line_width(context, width);
+    return Undefined();
 }
 
 /**
- * @function cairo.context_push_group
+ * @function cairo.context_get_line_width
  * 
  * ### Synopsis
  * 
- * cairo.context_push_group(context);
- * 
- * Temporarily redirects drawing to an intermediate surface known as a group. 
- * 
- * The redirection lasts until the group is completed by a call to cairo.context_pop_group() or cairo.context_pop_group_to_source(). 
- * 
- * These calls provide the result of any drawing to the group as a pattern, (either as an explicit object, or set as the source pattern).
- * 
- * This group functionality can be convenient for performing intermediate compositing. One common use of a group is to render objects as opaque within the group, (so that they occlude each other), and then blend the result with translucence onto the destination.
- * 
- * Groups can be nested arbitrarily deep by making balanced calls to cairo.context_push_group()/cairo.context_pop_group(). Each call pushes/pops the new target group onto/from a stack.
+ * var width = cairo.context_get_line_width(context);
  * 
- * The cairo.context_push_group() function calls cairo.context_save() so that any changes to the graphics state will not be visible outside the group, (the cairo.content_pop_group() functions call cairo.context__restore()).
+ * This function returns the current line width value exactly as set by cairo.context_set_line_width(). 
  * 
- * By default the intermediate group will have a content type of cairo.CONTENT_COLOR_ALPHA. Other content types can be chosen for the group by using cairo.context_push_group_with_content() instead.
+ * Note that the value is unchanged even if the CTM has changed between the calls to cairo.context_set_line_width() and cairo.context_get_line_width().
  * 
  * @param {object} context - opaque handle to a cairo context.
- * 
- * ### Example
- * 
- * As an example, here is how one might fill and stroke a path with translucence, but without any portion of the fill being visible under the stroke:
- * 
- * ```
- * cairo.context_push_group (context);
- * cairo.context_set_source (context, fill_pattern);
- * cairo.context_fill_preserve (context);
- * cairo.context_set_source (context, stroke_pattern);
- * cairo.context_stroke (context);
- * cairo.context_pop_group_to_source (context);
- * cairo.context_paint_with_alpha (context, alpha);
- * ```
+ * @return {number} width - current line width.
  */
-static JSVAL context_push_group(JSARGS args) {
+static JSVAL context_get_line_width(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_push_group(context);
-    return Undefined();
+    return Number::New(cairo_get_line_width(context));
 }
 
 /**
- * @function cairo.context_push_group_with_content
+ * @function cairo.context_set_miter_limit
  * 
  * ### Synopsis
  * 
- * cairo.context_push_group_with_content(context, content);
+ * cairo.context_set_miter_limit(context, limit);
  * 
- * Temporarily redirects drawing to an intermediate surface known as a group. The redirection lasts until the group is completed by a call to cairo.context_pop_group() or cairo.context_pop_group_to_source(). These calls provide the result of any drawing to the group as a pattern, (either as an explicit object, or set as the source pattern).
+ * Sets the current miter limit within the cairo context.
  * 
- * The group will have a content type of content. The ability to control this content type is the only distinction between this function and cairo.content_push_group() which you should see for a more detailed description of group rendering.
+ * If the current line join style is set to CAIRO_LINE_JOIN_MITER (see cairo.context_set_line_join()), the miter limit is used to determine whether the lines should be joined with a bevel instead of a miter. Cairo divides the length of the miter by the line width. If the result is greater than the miter limit, the style is converted to a bevel.
  * 
- * The content parameter is one of the following value:
+ * As with the other stroke parameters, the current line miter limit is examined by cairo.context_stroke(), cairo.context_stroke_extents(), and cairo.context_stroke_to_path(), but does not have any effect during path construction.
  * 
- * + cairo.CONTENT_COLOR - the surface will hold color content only.
- * + cairo.CONTENT_ALPHA - the surface will hold alpha content only.
- * + cairo.CONTENT_COLOR_ALPHA - the surface will hold color and alpha content.
+ * The default miter limit value is 10.0, which will convert joins with interior angles less than 11 degrees to bevels instead of miters. For reference, a miter limit of 2.0 makes the miter cutoff at 60 degrees, and a miter limit of 1.414 makes the cutoff at 90 degrees.
+ * 
+ * A miter limit for a desired angle can be computed as: miter limit = 1/sin(angle/2)
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {number} limit - setting for miter limit.
  */
-static JSVAL context_push_group_with_content(JSARGS args) {
+static JSVAL context_set_miter_limit(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_push_group_with_content(context, (cairo_content_t)args[0]->IntegerValue());
+    double limit = args[1]->NumberValue();
+    record_command(context, COMMAND_SET_MITER_LIMIT, args, 1);
+    cairo_set_miter_limit(context, limit);
     return Undefined();
 }
 
 /**
- * @function cairo.context_pop_group
+ * @function cairo.context_get_miter_limit
  * 
  * ### Synopsis
  * 
- * var pattern = cairo.context_pop_group(context);
- * 
- * Terminates the redirection begun by a call to cairo.context_push_group() or cairo.context_push_group_with_content() and returns a new pattern containing the results of all drawing operations performed to the group.
+ * var limit = cairo.context_get_miter_limit(context);
  * 
- * The cairo.context_pop_group() function calls cairo.context_restore(), (balancing a call to cairo.context_save() by the cairo.context_push_group() function), so that any changes to the graphics state will not be visible outside the group.
+ * This function returns the current miter limit value exactly as set by cairo.context_set_miter_limit(). 
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} pattern - opaque handle to a cairo pattern.
+ * @return {number} width - current line width.
  */
-static JSVAL context_pop_group(JSARGS args) {
+static JSVAL context_get_miter_limit(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return External::New(cairo_pop_group(context));
+    return Number::New(cairo_get_miter_limit(context));
 }
 
 /**
- * @function cairo.context_pop_group_to_source
+ * @function cairo.context_set_operator
  * 
  * ### Synopsis
  * 
- * cairo.context_pop_group_to_source(context);
+ * cairo.context_set_operator(context, operator);
  * 
- * Terminates the redirection begun by a call to cairo.context_push_group() or cairo,context_push_group_with_content() and installs the resulting pattern as the source pattern in the given cairo context.
+ * Sets the compositing operator to be used for all drawing operations.
  * 
- * The behavior of this function is equivalent to the sequence of operations:
+ * The default operator is CAIRO_OPERATOR_OVER.
  * 
- * ```
- * var group = cairo.context_pop_group (context);
- * cairo.context_set_source (context, group);
- * cairo.pattern_destroy (group);
- * ```
- * but is more convenient as their is no need for a variable to store the short-lived pointer to the pattern.
+ * The operator parameter may be one of the following values:
  * 
- * The cairo.context_pop_group() function calls cairo.context_restore(), (balancing a call to cairo.context_save() by the cairo.context_push_group()function), so that any changes to the graphics state will not be visible outside the group.
+ * cairo.OPERATOR_CLEAR - clear destination layer (bounded)
+ * cairo.OPERATOR_SOURCE - replace destination layer (bounded)
+ * cairo.OPERATOR_OVER - draw source layer on top of destination layer (bounded)
+ * cairo.OPERATOR_IN - draw source where there was destination content (unbounded)
+ * cairo.OPERATOR_OUT - draw source where there was no destination content (unbounded)
+ * cairo.OPERATOR_ATOP - draw source on top of destination content and only there
+ * cairo.OPERATOR_DEST - ignore the source
+ * cairo.OPERATOR_DEST_OVER - draw destination on top of source
+ * cairo.OPERATOR_DEST_IN - leave destination only where there was source content (unbounded)
+ * cairo.OPERATOR_DEST_OUT - leave destination only where there was no source content
+ * cairo.OPERATOR_DEST_ATOP - leave destination on top of source content and only there (unbounded)
+ * cairo.OPERATOR_XOR - source and destination are shown where there is only one of them
+ * cairo.OPERATOR_ADD - source and destination layers are accumulated
+ * cairo.OPERATOR_SATURATE - like over, but assuming source and dest are disjoint geometries
+ * cairo.OPERATOR_MULTIPLY - source and destination layers are multiplied. This causes the result to be at least as dark as the darker inputs.
+ * cairo.OPERATOR_SCREEN - source and destination are complemented and multiplied. This causes the result to be at least as light as the lighter inputs.
+ * cairo.OPERATOR_OVERLAY - multiplies or screens, depending on the lightness of the destination color.
+ * cairo.OPERATOR_DARKEN - replaces the destination with the source if it is darker, otherwise keeps the source.
+ * cairo.OPERATOR_LIGHTEN - replaces the destination with the source if it is lighter, otherwise keeps the source.
+ * cairo.OPERATOR_COLOR_DODGE - brightens the destination color to reflect the source color.
+ * cairo.OPERATOR_COLOR_BURN - darkens the destination color to reflect the source color.
+ * cairo.OPERATOR_HARD_LIGHT - Multiplies or screens, dependent on source color.
+ * cairo.OPERATOR_SOFT_LIGHT - Darkens or lightens, dependent on source color.
+ * cairo.OPERATOR_DIFFERENCE - Takes the difference of the source and destination color.
+ * cairo.OPERATOR_EXCLUSION - Produces an effect similar to difference, but with lower contrast.
+ * cairo.OPERATOR_HSL_HUE - Creates a color with the hue of the source and the saturation and luminosity of the target.
+ * cairo.OPERATOR_HSL_SATURATION - Creates a color with the saturation of the source and the hue and luminosity of the target. Painting with this mode onto a gray area produces no change.
+ * cairo.OPERATOR_HSL_COLOR - Creates a color with the hue and saturation of the source and the luminosity of the target. This preserves the gray levels of the target and is useful for coloring monochrome images or tinting color images.
+ * cairo.OPERATOR_HSL_LUMINOSITY - Creates a color with the luminosity of the source and the hue and saturation of the target. This produces an inverse effect to cairo.OPERATOR_HSL_COLOR.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {int} operator - one of the above operators.
  */
-static JSVAL context_pop_group_to_source(JSARGS args) {
+static JSVAL context_set_operator(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_pop_group_to_source(context);
+    record_command(context, COMMAND_SET_OPERATOR, args, 1);
+    cairo_set_operator(context, (cairo_operator_t)args[1]->IntegerValue());
     return Undefined();
 }
 
 /**
- * @function cairo.context_get_group_target
+ * @function cairo.context_get_operator
  * 
  * ### Synopsis
  * 
- * var surface = cairo.context_get_group_target(context);
- * 
- * Gets the current destination surface for the context. This is either the original target surface as passed to cairo.context_create() or the target surface for the current group as started by the most recent call to cairo.context_push_group() or cairo.context_push_group_with_content().
+ * var operator = cairo.context_get_operator(context);
  * 
- * This function will always return a valid pointer, but the result can be a "nil" surface if context is already in an error state, (ie. cairo.context_status() != cairo.STATUS_SUCCESS).
+ * Gets the current compositing operator for a cairo context.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} surface - opaque handle to the cairo surface.
+ * @param {int} operator - one of the operators, as described in cairo.context_set_operator().
  */
-static JSVAL context_get_group_target(JSARGS args) {
+static JSVAL context_get_operator(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return External::New(cairo_get_group_target(context));
+    return Integer::New(cairo_get_operator(context));
 }
 
 /**
- * @function cairo.context_set_source_rgb
+ * @function cairo.context_set_tolerance
  * 
  * ### Synopsis
  * 
- * cairo.context_set_source_rgb(context, red, green, blue);
+ * cairo.context_set_tolerance(context, tolerance);
  * 
- * Sets the source pattern within context to an opaque color. 
+ * Sets the tolerance used when converting paths into trapezoids. 
  * 
- * This opaque color will then be used for any subsequent drawing operation until a new source pattern is set.
+ * Curved segments of the path will be subdivided until the maximum deviation between the original path and the polygonal approximation is less than tolerance. 
  * 
- * The color components are floating point numbers in the range 0 to 1. If the values passed in are outside that range, they will be clamped.
+ * The default value is 0.1. 
  * 
- * The default source pattern is opaque black, (that is, it is equivalent to cairo.context_set_source_rgb(context, 0.0, 0.0, 0.0)).
+ * A larger value will give better performance, a smaller value, better appearance. (Reducing the value from the default value of 0.1 is unlikely to improve appearance significantly.) 
+ * 
+ * The accuracy of paths within Cairo is limited by the precision of its internal arithmetic, and the prescribed tolerance is restricted to the smallest representable internal value.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} red - red component of color
- * @param {number} green - green component of color
- * @param {number} blue - blue component of color
+ * @param {number} tolerance - setting for tolerance, in device units (typically pixels).
  */
-static JSVAL context_set_source_rgb(JSARGS args) {
+static JSVAL context_set_tolerance(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_set_source_rgb(context, args[1]->NumberValue(), args[2]->NumberValue(), args[3]->NumberValue());
+    double tolerance = args[1]->NumberValue();
+    record_command(context, COMMAND_SET_TOLERANCE, args, 1);
+    cairo_set_tolerance(context, tolerance);
     return Undefined();
 }
 
 /**
- * @function cairo.context_set_source_rgba
+ * @function cairo.context_get_tolerance
  * 
  * ### Synopsis
  * 
- * cairo.context_set_source_rgba(context, red, green, blue, alpha);
- * 
- * Sets the source pattern within context to a translucent color. 
- * 
- * This color will then be used for any subsequent drawing operation until a new source pattern is set.
- * 
- * The color and alpha components are floating point numbers in the range 0 to 1. If the values passed in are outside that range, they will be clamped.
+ * var tolerance = cairo.context_get_tolerance(context);
  * 
- * The default source pattern is opaque black, (that is, it is equivalent to cairo.context_set_source_rgba(context, 0.0, 0.0, 0.0, 1.0)).
+ * This function returns the current tolerance value exactly as set by cairo.context_set_tolerance(). 
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} red - red component of color
- * @param {number} green - green component of color
- * @param {number} blue - blue component of color
- * @param {number} alpha - alpha component of color
+ * @return {number} tolerance - current tolerance value.
  */
-static JSVAL context_set_source_rgba(JSARGS args) {
+static JSVAL context_get_tolerance(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_set_source_rgba(context, args[1]->NumberValue(), args[2]->NumberValue(), args[3]->NumberValue(), args[4]->NumberValue());
-    return Undefined();
+    return Number::New(cairo_get_tolerance(context));
 }
 
 /**
- * @function cairo.context_set_source
+ * @function cairo.context_clip
  * 
  * ### Synopsis
  * 
- * cairo.context_set_source(context, pattern);
+ * cairo.context_clip(context);
  * 
- * Sets the source pattern within context to pattern. 
+ * Establishes a new clip region by intersecting the current clip region with the current path as it would be filled by cairo.context_fill() and according to the current fill rule (see cairo.context_set_fill_rule()).
  * 
- * This pattern will then be used for any subsequent drawing operation until a new source pattern is set.
+ * After cairo.context_clip(), the current path will be cleared from the cairo context.
  * 
- * Note: The pattern's transformation matrix will be locked to the user space in effect at the time of cairo.context_set_source(). This means that further modifications of the current transformation matrix will not affect the source pattern. See cairo.pattern_set_matrix().
+ * The current clip region affects all drawing operations by effectively masking out any changes to the surface that are outside the current clip region.
  * 
- * The default source pattern is a solid pattern that is opaque black, (that is, it is equivalent to cairo.context_set_source_rgb(context, 0.0, 0.0, 0.0)).
+ * Calling cairo.context_clip() can only make the clip region smaller, never larger. But the current clip is part of the graphics state, so a temporary restriction of the clip region can be achieved by calling cairo.context_clip() within a cairo.context_save()/cairo.context_restore() pair. The only other means of increasing the size of the clip region is cairo.context_reset_clip().
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {object} pattern - opaque handle to a cairo pattern.
  */
-static JSVAL context_set_source(JSARGS args) {
+static JSVAL context_clip(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_pattern_t *pattern = (cairo_pattern_t *) JSEXTERN(args[1]);
-    cairo_set_source(context, pattern);
+    record_command(context, COMMAND_CLIP, args, 0);
+    cairo_clip(context);
     return Undefined();
 }
 
 /**
- * @function cairo.context_set_source_surface
+ * @function cairo.context_clip_preserve
  * 
  * ### Synopsis
  * 
- * cairo.context_set_source_surface(context, surface, x, y);
+ * cairo.context_clip_preserve(context);
  * 
- * This is a convenience function for creating a pattern from surface and setting it as the source in context with cairo.context_set_source().
+ * Establishes a new clip region by intersecting the current clip region with the current path as it would be filled by cairo.context_fill() and according to the current fill rule (see cairo.context_set_fill_rule()).
  * 
- * The x and y parameters give the user-space coordinate at which the surface origin should appear. (The surface origin is its upper-left corner before any transformation has been applied.) The x and y parameters are negated and then set as translation values in the pattern matrix.
+ * Unlike cairo.context_clip(), cairo.context_clip_preserve() preserves the path within the cairo context.
  * 
- * Other than the initial translation pattern matrix, as described above, all other pattern attributes, (such as its extend mode), are set to the default values as in cairo.pattern_create_for_surface(). The resulting pattern can be queried with cairo.context_get_source() so that these attributes can be modified if desired, (eg. to create a repeating pattern with cairo.pattern_set_extend()).
+ * The current clip region affects all drawing operations by effectively masking out any changes to the surface that are outside the current clip region.
+ * 
+ * Calling cairo.context_clip_preserve() can only make the clip region smaller, never larger. But the current clip is part of the graphics state, so a temporary restriction of the clip region can be achieved by calling cairo.context_clip_preserve() within a cairo.context_save()/cairo.context_restore() pair. The only other means of increasing the size of the clip region is cairo.context_reset_clip().
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {object} surface - opaque handle to a cairo surface..
- * @param {number} x - x coordinate of surface origin.
- * @param {number} y - y coordinate of surface origin.
  */
-static JSVAL context_set_source_surface(JSARGS args) {
+static JSVAL context_clip_preserve(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[1]);
-    double x = args[2]->NumberValue();
-    double y = args[3]->NumberValue();
-    cairo_set_source_surface(context, surface, x, y);
+    record_command(context, COMMAND_CLIP_PRESERVE, args, 0);
+    cairo_clip_preserve(context);
     return Undefined();
 }
 
 /**
- * @function cairo.context_get_source
+ * @function cairo.context_clip_extents
  * 
  * ### Synopsis
  * 
- * var pattern = cairo.context_get_source(context, pattern);
+ * var extents = cairo.context_clip_extents(context);
+ * var extents = cairo.context_clip_extents(context, out);
  * 
- * Gets the current source pattern within context. 
+ * Computes a bounding box in user coordinates covering the area inside the current clip.
+ * 
+ * The object returned has the following members:
+ * 
+ * + x1: x coordinate of the top left corner of the resulting extents.
+ * + y1: y coordinate of the top left corner of the resulting extents.
+ * + x2: x coordinate of the lower right corner of the resulting extents.
+ * + y2: y coordinate of the lower right corner of the resulting extents.
+ * 
+ * If the optional out argument is given, it must be a Float64Array of at least 4 elements.  The extents are written to it as [x1, y1, x2, y2] and out is returned instead of a new object.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} pattern - opaque handle to a cairo pattern.
+ * @param {Float64Array} out - optional array to receive [x1, y1, x2, y2].
+ * @return {object} extents - see object description above.
  */
-static JSVAL context_get_source(JSARGS args) {
+static JSVAL context_clip_extents(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return External::New(cairo_get_source(context));
+    double x1,y1, x2,y2;
+    cairo_clip_extents(context, &x1,&y1, &x2,&y2);
+    
+    if (args.Length() > 1) {
+        double *out = float64_array_data(args[1], 4);
+        if (out == NULL) {
+            return throw_bad_out_array("context_clip_extents", 4);
+        }
+        out[0] = x1;
+        out[1] = y1;
+        out[2] = x2;
+        out[3] = y2;
+        return args[1];
+    }
+    JSOBJ o = Object::New();
+    o->Set(String::New("x1"), Number::New(x1));
+    o->Set(String::New("y1"), Number::New(y1));
+    o->Set(String::New("x2"), Number::New(x2));
+    o->Set(String::New("y2"), Number::New(y2));
+    return o;
 }
 
 /**
- * @function cairo.context_set_antialias
+ * @function cairo.context_in_clip
  * 
  * ### Synopsis
  * 
- * cairo.context_set_antialias(context, mode);
- * 
- * Set the antialiasing mode of the rasterizer used for drawing shapes. 
- * 
- * This value is a hint, and a particular backend may or may not support a particular value. At the current time, no backend supports cairo.ANTIALIAS_SUBPIXEL when drawing shapes.
- * 
- * Note that this option does not affect text rendering, instead see cairo.context_font_options_set_antialias().
- * 
- * Valid modes are:
+ * var inClip = cairo.context_in_clip(context, x, y);
  * 
- * + cairo.ANTIALIAS_DEFAULT - use the default antialiasing for the subsystem and target device.
- * + cairo.ANTIALIAS_NONE - use a bilevel alpha mask.
- * + cairo.ANTIALIAS_GRAY - perform single-color antialiasing (using shades of gray for black text on a white background, for example).
- * + cairo.ANTIALIAS_SUBPIXEL - perform antialiasing by taking advantage of the order of subpixel elements on devices such as LCD panels.
- * + cairo_ANTIALIAS_FAST - Hint that the backend should perform some antialiasing but prefer speed over quality, since 1.12.
- * + cairo.ANTIALIAS_GOOD - The backend should balance quality against performance, since 1.12.
- * + CAIRO_ANTIALIAS_BEST - Hint that the backend should render at the highest quality, sacrificing speed if necessary, since 1.12
+ * Tests whether the given point is inside the area that would be visible through the current clip, i.e. the area that would be filled by a cairo.context_paint() operation.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {int} mode - one of the above modes.
+ * @return {boolean} inClip - true if the point is inside the clip rectangle, false if not.
  */
-static JSVAL context_set_antialias(JSARGS args) {
+#if CAIRO_VERSION_MINOR >= 10
+static JSVAL context_in_clip(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_set_antialias(context, (cairo_antialias_t)args[1]->IntegerValue());
-    return Undefined();
+    return cairo_in_clip(context, args[1]->NumberValue(), args[2]->NumberValue()) ? True() : False();
 }
+#endif
 
 /**
- * @function cairo.context_get_antialias
+ * @function cairo.context_reset_clip
  * 
  * ### Synopsis
  * 
- * var mode = cairo.context_get_antialias(context);
- * 
- * Gets the current shape antialiasing mode, as set by cairo.context_set_antialias().
+ * cairo.context_reset_clip(context);
  * 
- * The return value is a mode:
+ * Reset the current clip region to its original, unrestricted state. 
  * 
- * Valid modes are:
+ * That is, set the clip region to an infinitely large shape containing the target surface. Equivalently, if infinity is too hard to grasp, one can imagine the clip region being reset to the exact bounds of the target surface.
  * 
- * + cairo.ANTIALIAS_DEFAULT - use the default antialiasing for the subsystem and target device.
- * + cairo.ANTIALIAS_NONE - use a bilevel alpha mask.
- * + cairo.ANTIALIAS_GRAY - perform single-color antialiasing (using shades of gray for black text on a white background, for example).
- * + cairo.ANTIALIAS_SUBPIXEL - perform antialiasing by taking advantage of the order of subpixel elements on devices such as LCD panels.
- * + cairo_ANTIALIAS_FAST - Hint that the backend should perform some antialiasing but prefer speed over quality, since 1.12.
- * + cairo.ANTIALIAS_GOOD - The backend should balance quality against performance, since 1.12.
- * + CAIRO_ANTIALIAS_BEST - Hint that the backend should render at the highest quality, sacrificing speed if necessary, since 1.12
+ * Note that code meant to be reusable should not call cairo.context_reset_clip() as it will cause results unexpected by higher-level code which calls cairo.context_clip(). Consider using cairo.context_save() and cairo.context_restore() around cairo.context_clip() as a more robust means of temporarily restricting the clip region.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {int} mode - see list above.
  */
-static JSVAL context_get_antialias(JSARGS args) {
+static JSVAL context_reset_clip(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_get_antialias(context));
+    record_command(context, COMMAND_RESET_CLIP, args, 0);
+    cairo_reset_clip(context);
+    return Undefined();
 }
 
+// rectangle list stuff not implemented (yet)
+
 /**
- * @function cairo.content_set_dash
+ * @function cairo.context_fill
  * 
  * ### Synopsis
  * 
- * cairo.context_set_dash(context, dashes, offset);
- * 
- * Sets the dash pattern to be used by cairo.context_stroke(). 
- * 
- * A dash pattern is specified by dashes, an array of positive values. 
- * 
- * Each value provides the length of alternate "on" and "off" portions of the stroke. 
- * 
- * The offset specifies an offset into the pattern at which the stroke begins.
- * 
- * Each "on" segment will have caps applied as if the segment were a separate sub-path. In particular, it is valid to use an "on" length of 0.0 with cairo.LINE_CAP_ROUND or cairo.LINE_CAP_SQUARE in order to distributed dots or squares along a path.
- * 
- * Note: The length values are in user-space units as evaluated at the time of stroking. This is not necessarily the same as the user space at the time of cairo.context_set_dash()..
+ * cairo.context_fill(context);
  * 
- * If the dashes array has length 0, dashing is disabled.
+ * A drawing operator that fills the current path according to the current fill rule, (each sub-path is implicitly closed before being filled). 
  * 
- * If the dashes array has a single element,  a symmetric pattern is assumed with alternating on and off portions of the size specified by the single value in dashes.
+ * After cairo.context_fill(), the current path will be cleared from the cairo context. 
  * 
- * If any value in dashes is negative, or if all values are 0, then context will be put into an error state with a status of cairo.STATUS_INVALID_DASH.
+ * See cairo.context_set_fill_rule() and cairo.context_fill_preserve().
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {array} dashes - array of dash information, described above.
- * @param {number} offset - offset into pattern at which the stroke begins.
  */
-static JSVAL context_set_dash(JSARGS args) {
+static JSVAL context_fill(JSARGS args) {
+    MetricsTimer timer(METRICS_FILL_STROKE, "fill");
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    Handle<Array>dashes = Handle<Array>::Cast(args[1]->ToObject());
-    double offset = args[2]->NumberValue();
-    
-    int numDashes = dashes->Length();
-    if (numDashes == 0) {
-        cairo_set_dash(context, NULL, 0, offset);
-    }
-    double *dashArray = new double[numDashes];
-    for (int i=0; i<numDashes; i++) {
-        dashArray[i] = dashes->Get(i)->NumberValue();
+    if (record_draw(context, COMMAND_FILL, 0)) {
+        return Undefined();
     }
-    cairo_set_dash(context, dashArray, numDashes, offset);
-    delete [] dashArray;
-    
+    cairo_fill(context);
     return Undefined();
 }
 
 /**
- * @function cairo.context_get_dash_count
+ * @function cairo.context_fill_preserve
  * 
  * ### Synopsis
  * 
- * var count = cairo.context_get_dash_count(context);
+ * cairo.context_fill_preserve(context);
  * 
- * Returns the length of the dash array in the context, or 0 if dashing is not in effect.
+ * A drawing operator that fills the current path according to the current fill rule, (each sub-path is implicitly closed before being filled). 
  * 
- * See also cairo.context_set_dash() and cairo_context.get_dash().
+ * Unlike cairo.context_fill(), cairo.context_fill_preserve() preserves the path within the cairo context.
+ * 
+ * See cairo.context_set_fill_rule() and cairo.context_fill().
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {int} count - length of dashes array.
  */
-static JSVAL context_get_dash_count(JSARGS args) {
+static JSVAL context_fill_preserve(JSARGS args) {
+    MetricsTimer timer(METRICS_FILL_STROKE, "fill_preserve");
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_get_dash_count(context));
+    if (record_draw(context, COMMAND_FILL_PRESERVE, 0)) {
+        return Undefined();
+    }
+    cairo_fill_preserve(context);
+    return Undefined();
+}
+
+// Solid rectangle fills.  Backgrounds, chart bars, table stripes and clearRect() are
+// rectangles on whole device pixels filled with a solid color, which cairo takes through
+// path construction, the rasterizer and pixman.  When the rectangle, the clip and the
+// transform line up with the pixel grid, the rows are filled directly here instead.
+
+// Premultiply a color the way cairo does for pixman: through 16 bits, then the high byte.
+static uint32_t solid_pixel(double r, double g, double b, double a) {
+    uint32_t a16 = (uint32_t) (a * 65535.0 + 0.5),
+        r16 = (uint32_t) (r * a * 65535.0 + 0.5),
+        g16 = (uint32_t) (g * a * 65535.0 + 0.5),
+        b16 = (uint32_t) (b * a * 65535.0 + 0.5);
+    return (a16 >> 8) << 24 | (r16 >> 8) << 16 | (g16 >> 8) << 8 | b16 >> 8;
+}
+
+static void solid_fill_span(uint32_t *p, int n, uint32_t pixel) {
+    int i = 0;
+#ifdef __SSE2__
+    __m128i v = _mm_set1_epi32(pixel);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128((__m128i *) (p + i), v);
+    }
+#endif
+    for (; i < n; i++) {
+        p[i] = pixel;
+    }
+}
+
+// OVER with a premultiplied solid color: d = s + d * (255 - sa) / 255, rounded as pixman does.
+static void solid_over_span(uint32_t *p, int n, uint32_t pixel) {
+    uint32_t ia = 255 - (pixel >> 24);
+    int i = 0;
+#ifdef __SSE2__
+    __m128i zero = _mm_setzero_si128(),
+        src = _mm_set1_epi32(pixel),
+        alpha = _mm_set1_epi16(ia),
+        half = _mm_set1_epi16(0x80);
+    for (; i + 4 <= n; i += 4) {
+        __m128i d = _mm_loadu_si128((__m128i *) (p + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), alpha), half);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), alpha), half);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128((__m128i *) (p + i), _mm_adds_epu8(_mm_packus_epi16(lo, hi), src));
+    }
+#endif
+    for (; i < n; i++) {
+        uint32_t d = p[i], out = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            uint32_t t = ((d >> shift) & 0xff) * ia + 0x80;
+            t = ((t + (t >> 8)) >> 8) + ((pixel >> shift) & 0xff);
+            out |= (t > 255 ? 255 : t) << shift;
+        }
+        p[i] = out;
+    }
+}
+
+// round v to a whole pixel, or return false if it is not on one
+static bool pixel_aligned(double v, int *out) {
+    double r = floor(v + 0.5);
+    if (fabs(v - r) > 1e-6 || fabs(r) > 1 << 30) {
+        return false;
+    }
+    *out = (int) r;
+    return true;
+}
+
+// Fill the device-space rectangle of user-space x, y, w, h on the context's image target, with
+// the current solid source and op, without touching the path.  Returns false, having drawn
+// nothing, if the fill cannot be done this way.
+static bool fill_solid_rectangle(cairo_t *context, double x, double y, double w, double h, cairo_operator_t op) {
+    if (op != CAIRO_OPERATOR_SOURCE && op != CAIRO_OPERATOR_OVER && op != CAIRO_OPERATOR_CLEAR) {
+        return false;
+    }
+    if (command_list_for(context) || cairo_status(context) != CAIRO_STATUS_SUCCESS) {
+        return false;
+    }
+    cairo_matrix_t m;
+    cairo_get_matrix(context, &m);
+    if (m.xy != 0 || m.yx != 0) {
+        return false;
+    }
+    double r = 0, g = 0, b = 0, a = 0;
+    if (op != CAIRO_OPERATOR_CLEAR) {
+        cairo_pattern_t *source = cairo_get_source(context);
+        if (cairo_pattern_get_type(source) != CAIRO_PATTERN_TYPE_SOLID) {
+            return false;
+        }
+        cairo_pattern_get_rgba(source, &r, &g, &b, &a);
+    }
+    cairo_surface_t *target = cairo_get_group_target(context);
+    if (cairo_surface_get_type(target) != CAIRO_SURFACE_TYPE_IMAGE || cairo_surface_status(target) != CAIRO_STATUS_SUCCESS) {
+        return false;
+    }
+    cairo_format_t format = cairo_image_surface_get_format(target);
+    if (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24) {
+        return false;
+    }
+    double device[4];
+    int box[4];
+    user_rect_to_device(context, x, y, x + w, y + h, device);
+    for (int i = 0; i < 4; i++) {
+        if (!pixel_aligned(device[i], &box[i])) {
+            return false;
+        }
+    }
+
+    // the clip, as device-space rectangles on the pixel grid
+    cairo_rectangle_list_t *clip = cairo_copy_clip_rectangle_list(context);
+    int (*clipBoxes)[4] = NULL;
+    bool aligned = clip->status == CAIRO_STATUS_SUCCESS;
+    if (aligned) {
+        clipBoxes = (int (*)[4]) malloc((clip->num_rectangles + 1) * sizeof(*clipBoxes));
+        for (int i = 0; i < clip->num_rectangles && aligned; i++) {
+            cairo_rectangle_t *rc = &clip->rectangles[i];
+            user_rect_to_device(context, rc->x, rc->y, rc->x + rc->width, rc->y + rc->height, device);
+            for (int j = 0; j < 4 && aligned; j++) {
+                aligned = pixel_aligned(device[j], &clipBoxes[i][j]);
+            }
+        }
+    }
+    if (!aligned) {
+        free(clipBoxes);
+        cairo_rectangle_list_destroy(clip);
+        return false;
+    }
+
+    MetricsTimer timer(METRICS_FILL_STROKE, "fill_rectangle");
+    timer.arg("width", box[2] - box[0]);
+    timer.arg("height", box[3] - box[1]);
+    uint32_t pixel = solid_pixel(r, g, b, a);
+    bool over = op == CAIRO_OPERATOR_OVER && pixel >> 24 != 0xff;
+    if (op == CAIRO_OPERATOR_OVER && pixel >> 24 == 0) {
+        // nothing to draw
+        clip->num_rectangles = 0;
+    }
+    double dx, dy;
+    cairo_surface_get_device_offset(target, &dx, &dy);
+    int width = cairo_image_surface_get_width(target),
+        height = cairo_image_surface_get_height(target),
+        stride = cairo_image_surface_get_stride(target);
+    cairo_surface_flush(target);
+    unsigned char *data = cairo_image_surface_get_data(target);
+    for (int i = 0; i < clip->num_rectangles; i++) {
+        // device space to the target's pixels
+        int x1 = (box[0] > clipBoxes[i][0] ? box[0] : clipBoxes[i][0]) + (int) dx,
+            y1 = (box[1] > clipBoxes[i][1] ? box[1] : clipBoxes[i][1]) + (int) dy,
+            x2 = (box[2] < clipBoxes[i][2] ? box[2] : clipBoxes[i][2]) + (int) dx,
+            y2 = (box[3] < clipBoxes[i][3] ? box[3] : clipBoxes[i][3]) + (int) dy;
+        x1 = x1 > 0 ? x1 : 0;
+        y1 = y1 > 0 ? y1 : 0;
+        x2 = x2 < width ? x2 : width;
+        y2 = y2 < height ? y2 : height;
+        if (x1 >= x2 || y1 >= y2) {
+            continue;
+        }
+        for (int row = y1; row < y2; row++) {
+            uint32_t *p = (uint32_t *) (data + (size_t) row * stride) + x1;
+            if (over) {
+                solid_over_span(p, x2 - x1, pixel);
+            }
+            else {
+                solid_fill_span(p, x2 - x1, pixel);
+            }
+        }
+        cairo_surface_mark_dirty_rectangle(target, x1 - (int) dx, y1 - (int) dy, x2 - x1, y2 - y1);
+    }
+    free(clipBoxes);
+    cairo_rectangle_list_destroy(clip);
+    return true;
 }
 
 /**
- * @function cairo.context_get_dash
+ * @function cairo.context_fill_rectangle
  * 
  * ### Synopsis
  * 
- * var dashes = cairo.context_get_dash(context);
+ * var drawn = cairo.context_fill_rectangle(context, x, y, width, height);
+ * var drawn = cairo.context_fill_rectangle(context, x, y, width, height, op);
  * 
- * Gets the current dash array.
+ * Fill a rectangle with the current source, as cairo.context_rectangle() followed by cairo.context_fill() would, but without touching the current path, by writing the pixels of the target directly.
+ * 
+ * This is only done when it gives the same pixels: the target (or the group being drawn) is an ARGB32 or RGB24 image surface, the transformation only scales and translates, the rectangle and the clip fall on whole pixels, the source is a solid color and the operator is SOURCE, OVER or CLEAR.  Otherwise nothing is drawn and false is returned, and the caller fills the rectangle the usual way.  Contexts that are recording never take this path.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {array} dashes = array of Number values of the dash array for the context.
- */
-static JSVAL context_get_dash(JSARGS args) {
+ * @param {number} x - X coordinate of the top left corner of the rectangle.
+ * @param {number} y - Y coordinate of the top left corner of the rectangle.
+ * @param {number} width - width of the rectangle.
+ * @param {number} height - height of the rectangle.
+ * @param {int} op - operator to use instead of the context's, e.g. cairo.OPERATOR_CLEAR.
+ * @return {boolean} drawn - true if the rectangle was filled.
+ */
+static JSVAL context_fill_rectangle(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    
-    int count = cairo_get_dash_count(context);
-    double *dashes = new double[count];
-    double offset;
-    cairo_get_dash(context, dashes, &offset);
-    Handle<Array>a = Array::New(count);
-    for (int i=0; i<count; i++) {
-        a->Set(i, Number::New(dashes[i]));
-    }
-    delete [] dashes;
-    return a;
+    cairo_operator_t op = args.Length() > 5 ? (cairo_operator_t) args[5]->IntegerValue() : cairo_get_operator(context);
+    return fill_solid_rectangle(context, args[1]->NumberValue(), args[2]->NumberValue(),
+        args[3]->NumberValue(), args[4]->NumberValue(), op) ? True() : False();
 }
 
 /**
- * @function cairo.context_set_fill_rule
+ * @function cairo.context_fill_extents
  * 
  * ### Synopsis
  * 
- * cairo.context_set_fill_rule(context, rule);
+ * var extents = cairo.context_fill_extents(context);
+ * var extents = cairo.context_fill_extents(context, out);
  * 
- * Set the current fill rule within the cairo context. The fill rule is used to determine which regions are inside or outside a complex (potentially self-intersecting) path. The current fill rule affects both cairo.context_fill() and cairo.context_clip().
+ * Computes a bounding box in user coordinates covering the area that would be affected, (the "inked" area), by a cairo.context_fill() operation given the current path and fill parameters. If the current path is empty, returns an empty rectangle ((0,0), (0,0)). Surface dimensions and clipping are not taken into account.
  * 
- * The rule argument may be:
+ * Contrast with cairo.context_path_extents(), which is similar, but returns non-zero extents for some paths with no inked area, (such as a simple line segment).
  * 
- * cairo.FILL_RULE_WINDING
- *   If the path crosses the ray from left-to-right, counts +1. If the path crosses the ray from right to left, counts -1. (Left and right are determined from the perspective of looking along the ray from the starting point.) If the total count is non-zero, the point will be filled.
- * cairo.FILL_RULE_EVEN_ODD
- *   Counts the total number of intersections, without regard to the orientation of the contour. If the total number of intersections is odd, the point will be filled.
+ * Note that cairo.context_fill_extents() must necessarily do more work to compute the precise inked areas in light of the fill rule, so cairo.context_path_extents() may be more desirable for sake of performance if the non-inked path extents are desired.
  * 
- * For both fill rules, whether or not a point is included in the fill is determined by taking a ray from that point to infinity and looking at intersections with the path. The ray can be in any direction, as long as it doesn't pass through the end point of a segment or have a tricky intersection such as intersecting tangent to the path. (Note that filling is not actually implemented in this way. This is just a description of the rule that is applied.)
+ * See cairo.context_fill(), cairo.context_set_fill_rule() and cairo.context_fill_preserve().
  * 
- * The default fill rule is cairo.FILL_RULE_WINDING.
+ * The object returned has the following members:
+ * 
+ * + x1: x coordinate of the top left corner of the resulting extents.
+ * + y1: y coordinate of the top left corner of the resulting extents.
+ * + x2: x coordinate of the lower right corner of the resulting extents.
+ * + y2: y coordinate of the lower right corner of the resulting extents.
+ * 
+ * If the optional out argument is given, it must be a Float64Array of at least 4 elements.  The extents are written to it as [x1, y1, x2, y2] and out is returned instead of a new object.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {int} rule - one of the above fill rules.
+ * @param {Float64Array} out - optional array to receive [x1, y1, x2, y2].
+ * @return {object} extents - see object description above.
  */
-static JSVAL context_set_fill_rule(JSARGS args) {
+static JSVAL context_fill_extents(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    int rule = args[1]->IntegerValue();
-    cairo_set_fill_rule(context, (cairo_fill_rule_t)rule);
-    return Undefined();
+    double x1,y1, x2,y2;
+    cairo_fill_extents(context, &x1,&y1, &x2,&y2);
+    
+    if (args.Length() > 1) {
+        double *out = float64_array_data(args[1], 4);
+        if (out == NULL) {
+            return throw_bad_out_array("context_fill_extents", 4);
+        }
+        out[0] = x1;
+        out[1] = y1;
+        out[2] = x2;
+        out[3] = y2;
+        return args[1];
+    }
+    JSOBJ o = Object::New();
+    o->Set(String::New("x1"), Number::New(x1));
+    o->Set(String::New("y1"), Number::New(y1));
+    o->Set(String::New("x2"), Number::New(x2));
+    o->Set(String::New("y2"), Number::New(y2));
+    return o;
 }
 
 /**
- * @function cairo.context_get_fill_rule
+ * @function cairo.context_in_fill
  * 
  * ### Synopsis
  * 
- * var rule = cairo.context_get_fill_rule(context);
+ * var inFill = cairo.context_in_fill(context, x, y);
  * 
- * Gets the current fill rule, as set by cairo.context_set_fill_rule().
+ * Tests whether the given point is inside the area that would be affected by a cairo.context_fill() operation given the current path and filling parameters. Surface dimensions and clipping are not taken into account.
  * 
- * See cairo.context_set_fill_rule() for description of the fill rule values.
+ * See cairo.context_fill(), cairo.context_set_fill_rule() and cairo.context_fill_preserve().
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {int} rule - fill rule
+ * @return {boolean} inFill - true if the point is inside the area that would be affected, false if not.
  */
-static JSVAL context_get_fill_rule(JSARGS args) {
+static JSVAL context_in_fill(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_get_fill_rule(context));
+    return cairo_in_fill(context, args[1]->NumberValue(), args[2]->NumberValue()) ? True() : False();
 }
 
 /**
- * @function cairo.context_set_line_cap
+ * @function cairo.context_mask
  * 
  * ### Synopsis
  * 
- * cairo.context_set_line_cap(context, line_cap);
- * 
- * Sets the current line cap style within the cairo context. 
- * 
- * As with the other stroke parameters, the current line cap style is examined by cairo.context_stroke(), cairo.context_stroke_extents(), and cairo.context_stroke_to_path(), but does not have any effect during path construction.
- * 
- * The line_cap values may be:
+ * cairo.context_mask(context, pattern);
  * 
- * cairo.LINE_CAP_BUTT
- *   start(stop) the line exactly at the start(end) point
- * cairo.LINE_CAP_ROUND
- *   use a round ending, the center of the circle is the end point
- * cairo.LINE_CAP_SQUARE
- *   use squared ending, the center of the square is the end point
+ * A drawing operator that paints the current source using the alpha channel of pattern as a mask. 
  * 
- * The default line cap style is cairo.LINE_CAP_BUTT.
+ * Opaque areas of pattern are painted with the source, transparent areas are not painted.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {int} line_cap - one of the above line_cap values.
+ * @return {object} pattern - opaque handle to a cairo pattern.
  */
-static JSVAL context_set_line_cap(JSARGS args) {
+static JSVAL context_mask(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    int line_cap = args[1]->IntegerValue();
-    cairo_set_line_cap(context, (cairo_line_cap_t)line_cap);
+    if (command_list_for(context)) {
+        return not_recordable("context_mask");
+    }
+    cairo_pattern_t *pattern = (cairo_pattern_t *) JSEXTERN(args[1]);
+    cairo_mask(context, pattern);
     return Undefined();
 }
 
 /**
- * @function cairo.context_get_line_cap
+ * @function cairo.context_mask_surface
  * 
  * ### Synopsis
  * 
- * var line_cap = cairo.context_get_line_cap(context);
+ * cairo.context_mask_surface(context, surface, surface_x, surface_y);
  * 
- * Gets the current line cap style, as set by cairo.context_set_line_cap().
+ * A drawing operator that paints the current source using the alpha channel of surface as a mask. 
  * 
- * See cairo.context_set_line_cap() for description of the line_cap values.
+ * Opaque areas of surface are painted with the source, transparent areas are not painted.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {int} line_cap - line cap style.
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @param {number} surface_x - x coordinate at which to place the origin of surface.
+ * @param {number} surface_y - y coordinate at which to place the origin of surface.
  */
-static JSVAL context_get_line_cap(JSARGS args) {
+static JSVAL context_mask_surface(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_get_line_cap(context));
+    if (command_list_for(context)) {
+        return not_recordable("context_mask_surface");
+    }
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[1]);
+    cairo_mask_surface(context, surface, args[2]->NumberValue(), args[3]->NumberValue());
+    return Undefined();
 }
 
 /**
- * @function cairo.context_set_line_join
+ * @function cairo.context_paint
  * 
  * ### Synopsis
  * 
- * cairo.context_set_line_join(context, line_join);
- * 
- * Sets the current line join style within the cairo context. 
- * 
- * As with the other stroke parameters, the current line join style is examined by cairo.context_stroke(), cairo.context_stroke_extents(), and cairo.context_stroke_to_path(), but does not have any effect during path construction.
- * 
- * Line join styles may be:
- * 
- * cairo.LINE_JOIN_MITER
- *   use a sharp (angled) corner, see cairo.context_set_miter_limit().
- * cairo.LINE_JOIN_ROUND
- *   use a rounded join, the center of the circle is the joint point.
- * cairo.LINE_JOIN_BEVEL
- *   use a cut-off join, the join is cut off at half the line width from the joint point
+ * cairo.context_paint(context);
  * 
- * The default line join style is cairo.LINE_JOIN_MITER.
+ * A drawing operator that paints the current source everywhere within the current clip region.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {int} line_join - one of the above line_join values.
  */
-static JSVAL context_set_line_join(JSARGS args) {
+static JSVAL context_paint(JSARGS args) {
+    MetricsTimer timer(METRICS_FILL_STROKE, "paint");
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    int line_join = args[1]->IntegerValue();
-    cairo_set_line_join(context, (cairo_line_join_t)line_join);
+    if (record_draw(context, COMMAND_PAINT, 0)) {
+        return Undefined();
+    }
+    cairo_paint(context);
     return Undefined();
 }
 
 /**
- * @function cairo.context_get_line_join
+ * @function cairo.context_paint_with_alpha
  * 
  * ### Synopsis
  * 
- * var line_join = cairo.context_get_line_join(context);
+ * cairo.context_paint_with_alpha(context, alpha);
  * 
- * Gets the current line join style, as set by cairo.context_set_line_join().
+ * A drawing operator that paints the current source everywhere within the current clip region using a mask of constant alpha value alpha. 
  * 
- * See cairo.context_set_line_join() for description of the line_join values.
+ * The effect is similar to cairo.context_paint(), but the drawing is faded out using the alpha value.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {int} line_join - line join style.
+ * @param {number} alpha - alpha value, between 0 (transparent) and 1 (opaque).
  */
-static JSVAL context_get_line_join(JSARGS args) {
+static JSVAL context_paint_with_alpha(JSARGS args) {
+    MetricsTimer timer(METRICS_FILL_STROKE, "paint_with_alpha");
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_get_line_join(context));
+    if (record_draw(context, COMMAND_PAINT_WITH_ALPHA, args[1]->NumberValue())) {
+        return Undefined();
+    }
+    cairo_paint_with_alpha(context, args[1]->NumberValue());
+    return Undefined();
 }
 
 /**
- * @function cairo.context_set_line_width
+ * @function cairo.context_stroke
  * 
  * ### Synopsis
  * 
- * cairo.context_set_line_width(context, width);
+ * cairo.context_stroke(context);
  * 
- * Sets the current line width within the cairo context. The line width value specifies the diameter of a pen that is circular in user space, (though device-space pen may be an ellipse in general due to scaling/shear/rotation of the CTM).
+ * A drawing operator that strokes the current path according to the current line width, line join, line cap, and dash settings. After cairo.context_stroke(), the current path will be cleared from the cairo context. 
  * 
- * Note: When the description above refers to user space and CTM it refers to the user space and CTM in effect at the time of the stroking operation, not the user space and CTM in effect at the time of the call to cairo_set_line_width(). The simplest usage makes both of these spaces identical. That is, if there is no change to the CTM between a call to cairo_set_line_width() and the stroking operation, then one can just pass user-space values to cairo.context_set_line_width() and ignore this note.
+ * See cairo.context_set_line_width(), cairo.context_set_line_join(), cairo.context_set_line_cap(), cairo.context_set_dash(), and cairo.context_stroke_preserve().
  * 
- * As with the other stroke parameters, the current line width is examined by cairo.context_stroke(), cairo.context_stroke_extents(), and cairo.context_stroke_to_path(), but does not have any effect during path construction.
+ * Note: Degenerate segments and sub-paths are treated specially and provide a useful result. These can result in two different situations:
  * 
- * The default line width value is 2.0.
+ * 1. Zero-length "on" segments set in cairo.context_set_dash(). If the cap style is cairo.LINE_CAP_ROUND or cairo.LINE_CAP_SQUARE then these segments will be drawn as circular dots or squares respectively. In the case of cairo.LINE_CAP_SQUARE, the orientation of the squares is determined by the direction of the underlying path.
+ * 2. A sub-path created by cairo.context_move_to() followed by either a cairo.context_close_path() or one or more calls to cairo.context_line_to() to the same coordinate as the cairo_move_to(). If the cap style is cairo._LINE_CAP_ROUND then these sub-paths will be drawn as circular dots. Note that in the case of cairo.LINE_CAP_SQUARE a degenerate sub-path will not be drawn at all, (since the correct orientation is indeterminate).
+ * 
+ * In no case will a cap style of cairo.LINE_CAP_BUTT cause anything to be drawn in the case of either degenerate segments or sub-paths.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} width - setting for line width.
  */
-static JSVAL context_set_line_width(JSARGS args) {
+static JSVAL context_stroke(JSARGS args) {
+    MetricsTimer timer(METRICS_FILL_STROKE, "stroke");
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    double width = args[1]->NumberValue();
-    cairo_set_line_width(context, width);
+    timer.arg("lineWidth", cairo_get_line_width(context));
+    if (record_draw(context, COMMAND_STROKE, 0)) {
+        return Undefined();
+    }
+    cairo_stroke(context);
     return Undefined();
 }
 
 /**
- * @function cairo.context_get_line_width
+ * @function cairo.context_stroke_preserve
  * 
  * ### Synopsis
  * 
- * var width = cairo.context_get_line_width(context);
+ * cairo.stroke_preserve(context);
  * 
- * This function returns the current line width value exactly as set by cairo.context_set_line_width(). 
+ * A drawing operator that strokes the current path according to the current line width, line join, line cap, and dash settings. 
  * 
- * Note that the value is unchanged even if the CTM has changed between the calls to cairo.context_set_line_width() and cairo.context_get_line_width().
+ * Unlike cairo.context_stroke(), cairo.context_stroke_preserve() preserves the path within the cairo context.
+ * 
+ * See cairo.context_set_line_width(), cairo.context_set_line_join(), cairo.context_set_line_cap(), and cairo.context_set_dash().
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {number} width - current line width.
  */
-static JSVAL context_get_line_width(JSARGS args) {
+static JSVAL context_stroke_preserve(JSARGS args) {
+    MetricsTimer timer(METRICS_FILL_STROKE, "stroke_preserve");
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Number::New(cairo_get_line_width(context));
+    timer.arg("lineWidth", cairo_get_line_width(context));
+    if (record_draw(context, COMMAND_STROKE_PRESERVE, 0)) {
+        return Undefined();
+    }
+    cairo_stroke_preserve(context);
+    return Undefined();
 }
 
 /**
- * @function cairo.context_set_miter_limit
+ * @function cairo.context_stroke_extents
  * 
  * ### Synopsis
  * 
- * cairo.context_set_miter_limit(context, limit);
+ * var extents = cairo.context_stroke_extents(context);
+ * var extents = cairo.context_stroke_extents(context, out);
  * 
- * Sets the current miter limit within the cairo context.
+ * Computes a bounding box in user coordinates covering the area that would be affected, (the "inked" area), by a cairo.context_stroke() operation given the current path and stroke parameters. If the current path is empty, returns an empty rectangle ((0,0), (0,0)). Surface dimensions and clipping are not taken into account.
  * 
- * If the current line join style is set to CAIRO_LINE_JOIN_MITER (see cairo.context_set_line_join()), the miter limit is used to determine whether the lines should be joined with a bevel instead of a miter. Cairo divides the length of the miter by the line width. If the result is greater than the miter limit, the style is converted to a bevel.
+ * Note that if the line width is set to exactly zero, then cairo.context_stroke_extents() will return an empty rectangle. Contrast with cairo.context_path_extents() which can be used to compute the non-empty bounds as the line width approaches zero.
  * 
- * As with the other stroke parameters, the current line miter limit is examined by cairo.context_stroke(), cairo.context_stroke_extents(), and cairo.context_stroke_to_path(), but does not have any effect during path construction.
+ * Note that cairo.context_stroke_extents() must necessarily do more work to compute the precise inked areas in light of the stroke parameters, so cairo.context_path_extents() may be more desirable for sake of performance if non-inked path extents are desired.
  * 
- * The default miter limit value is 10.0, which will convert joins with interior angles less than 11 degrees to bevels instead of miters. For reference, a miter limit of 2.0 makes the miter cutoff at 60 degrees, and a miter limit of 1.414 makes the cutoff at 90 degrees.
+ * See cairo.context_stroke(), cairo.context_set_line_width(), cairo.context_set_line_join(), cairo.context_set_line_cap(), cairo.context_set_dash(), and cairo.context_stroke_preserve().
  * 
- * A miter limit for a desired angle can be computed as: miter limit = 1/sin(angle/2)
+ * The object returned has the following members:
+ * 
+ * + x1: x coordinate of the top left corner of the resulting extents.
+ * + y1: y coordinate of the top left corner of the resulting extents.
+ * + x2: x coordinate of the lower right corner of the resulting extents.
+ * + y2: y coordinate of the lower right corner of the resulting extents.
+ * 
+ * If the optional out argument is given, it must be a Float64Array of at least 4 elements.  The extents are written to it as [x1, y1, x2, y2] and out is returned instead of a new object.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} limit - setting for miter limit.
+ * @param {Float64Array} out - optional array to receive [x1, y1, x2, y2].
+ * @return {object} extents - see object description above.
  */
-static JSVAL context_set_miter_limit(JSARGS args) {
+static JSVAL context_stroke_extents(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    double limit = args[1]->NumberValue();
-    cairo_set_miter_limit(context, limit);
-    return Undefined();
+    double x1,y1, x2,y2;
+    cairo_stroke_extents(context, &x1,&y1, &x2,&y2);
+    
+    if (args.Length() > 1) {
+        double *out = float64_array_data(args[1], 4);
+        if (out == NULL) {
+            return throw_bad_out_array("context_stroke_extents", 4);
+        }
+        out[0] = x1;
+        out[1] = y1;
+        out[2] = x2;
+        out[3] = y2;
+        return args[1];
+    }
+    JSOBJ o = Object::New();
+    o->Set(String::New("x1"), Number::New(x1));
+    o->Set(String::New("y1"), Number::New(y1));
+    o->Set(String::New("x2"), Number::New(x2));
+    o->Set(String::New("y2"), Number::New(y2));
+    return o;
 }
 
 /**
- * @function cairo.context_get_miter_limit
+ * @function cairo.context_in_stroke
  * 
  * ### Synopsis
  * 
- * var limit = cairo.context_get_miter_limit(context);
+ * var inStroke = cairo.context_in_stroke(context, x, y);
  * 
- * This function returns the current miter limit value exactly as set by cairo.context_set_miter_limit(). 
+ * Tests whether the given point is inside the area that would be affected by a cairo.context_stroke() operation given the current path and stroking parameters. 
+ * 
+ * Surface dimensions and clipping are not taken into account.
+ * 
+ * See cairo.context_stroke(), cairo.context_set_line_width(), cairo.context_set_line_join(), cairo.context_set_line_cap(), cairo.context_set_dash(), and cairo.context_stroke_preserve().
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {number} width - current line width.
+ * @return {boolean} inStroke - true if the point is inside the area that would be affected, false if not.
  */
-static JSVAL context_get_miter_limit(JSARGS args) {
+static JSVAL context_in_stroke(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Number::New(cairo_get_miter_limit(context));
+    return cairo_in_stroke(context, args[1]->NumberValue(), args[2]->NumberValue()) ? True() : False();
 }
 
 /**
- * @function cairo.context_set_operator
+ * @function cairo.context_copy_page
  * 
  * ### Synopsis
  * 
- * cairo.context_set_operator(context, operator);
- * 
- * Sets the compositing operator to be used for all drawing operations.
- * 
- * The default operator is CAIRO_OPERATOR_OVER.
+ * cairo.context_copy_page(context);
  * 
- * The operator parameter may be one of the following values:
+ * Emits the current page for backends that support multiple pages, but doesn't clear it, so, the contents of the current page will be retained for the next page too. Use cairo.conext_show_page() if you want to get an empty page after the emission.
  * 
- * cairo.OPERATOR_CLEAR - clear destination layer (bounded)
- * cairo.OPERATOR_SOURCE - replace destination layer (bounded)
- * cairo.OPERATOR_OVER - draw source layer on top of destination layer (bounded)
- * cairo.OPERATOR_IN - draw source where there was destination content (unbounded)
- * cairo.OPERATOR_OUT - draw source where there was no destination content (unbounded)
- * cairo.OPERATOR_ATOP - draw source on top of destination content and only there
- * cairo.OPERATOR_DEST - ignore the source
- * cairo.OPERATOR_DEST_OVER - draw destination on top of source
- * cairo.OPERATOR_DEST_IN - leave destination only where there was source content (unbounded)
- * cairo.OPERATOR_DEST_OUT - leave destination only where there was no source content
- * cairo.OPERATOR_DEST_ATOP - leave destination on top of source content and only there (unbounded)
- * cairo.OPERATOR_XOR - source and destination are shown where there is only one of them
- * cairo.OPERATOR_ADD - source and destination layers are accumulated
- * cairo.OPERATOR_SATURATE - like over, but assuming source and dest are disjoint geometries
- * cairo.OPERATOR_MULTIPLY - source and destination layers are multiplied. This causes the result to be at least as dark as the darker inputs.
- * cairo.OPERATOR_SCREEN - source and destination are complemented and multiplied. This causes the result to be at least as light as the lighter inputs.
- * cairo.OPERATOR_OVERLAY - multiplies or screens, depending on the lightness of the destination color.
- * cairo.OPERATOR_DARKEN - replaces the destination with the source if it is darker, otherwise keeps the source.
- * cairo.OPERATOR_LIGHTEN - replaces the destination with the source if it is lighter, otherwise keeps the source.
- * cairo.OPERATOR_COLOR_DODGE - brightens the destination color to reflect the source color.
- * cairo.OPERATOR_COLOR_BURN - darkens the destination color to reflect the source color.
- * cairo.OPERATOR_HARD_LIGHT - Multiplies or screens, dependent on source color.
- * cairo.OPERATOR_SOFT_LIGHT - Darkens or lightens, dependent on source color.
- * cairo.OPERATOR_DIFFERENCE - Takes the difference of the source and destination color.
- * cairo.OPERATOR_EXCLUSION - Produces an effect similar to difference, but with lower contrast.
- * cairo.OPERATOR_HSL_HUE - Creates a color with the hue of the source and the saturation and luminosity of the target.
- * cairo.OPERATOR_HSL_SATURATION - Creates a color with the saturation of the source and the hue and luminosity of the target. Painting with this mode onto a gray area produces no change.
- * cairo.OPERATOR_HSL_COLOR - Creates a color with the hue and saturation of the source and the luminosity of the target. This preserves the gray levels of the target and is useful for coloring monochrome images or tinting color images.
- * cairo.OPERATOR_HSL_LUMINOSITY - Creates a color with the luminosity of the source and the hue and saturation of the target. This produces an inverse effect to cairo.OPERATOR_HSL_COLOR.
+ * This is a convenience function that simply calls cairo.surface_copy_page() on context's target.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {int} operator - one of the above operators.
  */
-static JSVAL context_set_operator(JSARGS args) {
+static JSVAL context_copy_page(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_set_operator(context, (cairo_operator_t)args[1]->IntegerValue());
+    if (command_list_for(context)) {
+        return not_recordable("context_copy_page");
+    }
+    cairo_copy_page(context);
     return Undefined();
 }
 
 /**
- * @function cairo.context_get_operator
+ * @function cairo.context_show_page
  * 
  * ### Synopsis
  * 
- * var operator = cairo.context_get_operator(context);
+ * cairo.context_show_page(context);
  * 
- * Gets the current compositing operator for a cairo context.
+ * Emits and clears the current page for backends that support multiple pages. Use cairo.context_copy_page() if you don't want to clear the page.
+ * 
+ * This is a convenience function that simply calls cairo.surface_show_page() on context's target.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {int} operator - one of the operators, as described in cairo.context_set_operator().
  */
-static JSVAL context_get_operator(JSARGS args) {
+static JSVAL context_show_page(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Integer::New(cairo_get_operator(context));
+    if (command_list_for(context)) {
+        return not_recordable("context_show_page");
+    }
+    cairo_show_page(context);
+    return Undefined();
 }
 
 /**
- * @function cairo.context_set_tolerance
+ * @function cairo.context_translate
  * 
  * ### Synopsis
  * 
- * cairo.context_set_tolerance(context, tolerance);
- * 
- * Sets the tolerance used when converting paths into trapezoids. 
- * 
- * Curved segments of the path will be subdivided until the maximum deviation between the original path and the polygonal approximation is less than tolerance. 
+ * cairo.context_translate(context, tx,ty);
  * 
- * The default value is 0.1. 
+ * Modifies the current transformation matrix (CTM) by translating the user-space origin by (tx, ty). 
  * 
- * A larger value will give better performance, a smaller value, better appearance. (Reducing the value from the default value of 0.1 is unlikely to improve appearance significantly.) 
+ * This offset is interpreted as a user-space coordinate according to the CTM in place before the new call to cairo.context_translate(). 
  * 
- * The accuracy of paths within Cairo is limited by the precision of its internal arithmetic, and the prescribed tolerance is restricted to the smallest representable internal value.
+ * In other words, the translation of the user-space origin takes place after any existing transformation.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} tolerance - setting for tolerance, in device units (typically pixels).
+ * @param {number} tx - amount to translate in the x direction.
+ * @param {number} ty - amount to translate in the y direction.
  */
-static JSVAL context_set_tolerance(JSARGS args) {
+static JSVAL context_translate(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    double tolerance = args[1]->NumberValue();
-    cairo_set_tolerance(context, tolerance);
+    record_command(context, COMMAND_TRANSLATE, args, 2);
+    cairo_translate(context, args[1]->NumberValue(), args[2]->NumberValue());
     return Undefined();
 }
 
 /**
- * @function cairo.context_get_tolerance
+ * @function cairo.context_scale
  * 
  * ### Synopsis
  * 
- * var tolerance = cairo.context_get_tolerance(context);
+ * cairo.context_scale(context, sx,sy);
  * 
- * This function returns the current tolerance value exactly as set by cairo.context_set_tolerance(). 
+ * Modifies the current transformation matrix (CTM) by scaling the X and Y user-space axes by sx and sy respectively. 
+ * 
+ * The scaling of the axes takes place after any existing transformation of user space.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {number} tolerance - current tolerance value.
+ * @param {number} sx - scale factor for the x dimension.
+ * @param {number} sy - scale factor for the y dimension.
  */
-static JSVAL context_get_tolerance(JSARGS args) {
+static JSVAL context_scale(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return Number::New(cairo_get_tolerance(context));
+    record_command(context, COMMAND_SCALE, args, 2);
+    cairo_scale(context, args[1]->NumberValue(), args[2]->NumberValue());
+    return Undefined();
 }
 
 /**
- * @function cairo.context_clip
+ * @function cairo.context_rotate
  * 
  * ### Synopsis
  * 
- * cairo.context_clip(context);
- * 
- * Establishes a new clip region by intersecting the current clip region with the current path as it would be filled by cairo.context_fill() and according to the current fill rule (see cairo.context_set_fill_rule()).
+ * cairo.context_rotate(context, angle);
  * 
- * After cairo.context_clip(), the current path will be cleared from the cairo context.
+ * Modifies the current transformation matrix (CTM) by rotating the user-space axes by angle radians. 
  * 
- * The current clip region affects all drawing operations by effectively masking out any changes to the surface that are outside the current clip region.
+ * The rotation of the axes takes places after any existing transformation of user space. 
  * 
- * Calling cairo.context_clip() can only make the clip region smaller, never larger. But the current clip is part of the graphics state, so a temporary restriction of the clip region can be achieved by calling cairo.context_clip() within a cairo.context_save()/cairo.context_restore() pair. The only other means of increasing the size of the clip region is cairo.context_reset_clip().
+ * The rotation direction for positive angles is from the positive X axis toward the positive Y axis.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {number} angle - angle in radians by which the user space axes will be rotated.
  */
-static JSVAL context_clip(JSARGS args) {
+static JSVAL context_rotate(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_clip(context);
+    record_command(context, COMMAND_ROTATE, args, 1);
+    cairo_rotate(context, args[1]->NumberValue());
     return Undefined();
 }
 
 /**
- * @function cairo.context_clip_preserve
+ * @function cairo.context_transform
  * 
  * ### Synopsis
  * 
- * cairo.context_clip_preserve(context);
+ * cairo.context_transform(context, matrix);
  * 
- * Establishes a new clip region by intersecting the current clip region with the current path as it would be filled by cairo.context_fill() and according to the current fill rule (see cairo.context_set_fill_rule()).
+ * Modifies the current transformation matrix (CTM) by applying matrix as an additional transformation. 
  * 
- * Unlike cairo.context_clip(), cairo.context_clip_preserve() preserves the path within the cairo context.
+ * The new transformation of user space takes place after any existing transformation.
  * 
- * The current clip region affects all drawing operations by effectively masking out any changes to the surface that are outside the current clip region.
+ * @param {object} context - opaque handle to a cairo context.
+ * @param {object} matrix - opaque handle to a cairo matrix.
+ */
+static JSVAL context_transform(JSARGS args) {
+    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[1]);
+    Command *command = record_command(context, COMMAND_TRANSFORM, args, 0);
+    if (command) {
+        memcpy(command->args, matrix, sizeof(cairo_matrix_t));
+    }
+    cairo_transform(context, matrix);
+    return Undefined();
+}
+
+/**
+ * @function cairo.context_set_matrix
  * 
- * Calling cairo.context_clip_preserve() can only make the clip region smaller, never larger. But the current clip is part of the graphics state, so a temporary restriction of the clip region can be achieved by calling cairo.context_clip_preserve() within a cairo.context_save()/cairo.context_restore() pair. The only other means of increasing the size of the clip region is cairo.context_reset_clip().
+ * ### Synopsis
+ * 
+ * cairo.context_set_matrix(pattern, matrix);
+ * 
+ * Modifies the current transformation matrix (CTM) by setting it equal to matrix.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {object} matrix - opaque handle to a cairo matrix.
  */
-static JSVAL context_clip_preserve(JSARGS args) {
+static JSVAL context_set_matrix(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_clip_preserve(context);
+    cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[1]);
+    Command *command = record_command(context, COMMAND_SET_MATRIX, args, 0);
+    if (command) {
+        memcpy(command->args, matrix, sizeof(cairo_matrix_t));
+    }
+    cairo_set_matrix(context, matrix);
     return Undefined();
 }
 
+
 /**
- * @function cairo.context_clip_extents
+ * @function cairo.context_get_matrix
  * 
  * ### Synopsis
  * 
- * var extents = cairo.context_clip_extents(context);
+ * var matrix = cairo.context_get_matrix(context);
+ * var out = cairo.context_get_matrix(context, out);
  * 
- * Computes a bounding box in user coordinates covering the area inside the current clip.
+ * Gets the context's transformation matrix.
  * 
- * The object returned has the following members:
+ * The matrix returned is owned by the caller and must be released by calling cairo.matrix_destroy() when it is no longer needed.
  * 
- * + x1: x coordinate of the top left corner of the resulting extents.
- * + y1: y coordinate of the top left corner of the resulting extents.
- * + x2: x coordinate of the lower right corner of the resulting extents.
- * + y2: y coordinate of the lower right corner of the resulting extents.
+ * If the optional out argument is given, it must be a Float64Array of at least 6 elements.  The matrix components are written to it as [xx, yx, xy, yy, x0, y0] and out is returned; no matrix is allocated, so there is nothing to destroy.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} extents - see object description above.
+ * @param {Float64Array} out - optional array to receive [xx, yx, xy, yy, x0, y0].
+ * @return {object} matrix - opaque handle to a cairo matrix.
  */
-static JSVAL context_clip_extents(JSARGS args) {
+static JSVAL context_get_matrix(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    double x1,y1, x2,y2;
-    cairo_clip_extents(context, &x1,&y1, &x2,&y2);
-    
-    JSOBJ o = Object::New();
-    o->Set(String::New("x1"), Number::New(x1));
-    o->Set(String::New("y1"), Number::New(y1));
-    o->Set(String::New("x2"), Number::New(x2));
-    o->Set(String::New("y2"), Number::New(y2));
-    return o;
+    if (args.Length() > 1) {
+        double *out = float64_array_data(args[1], 6);
+        if (out == NULL) {
+            return throw_bad_out_array("context_get_matrix", 6);
+        }
+        cairo_matrix_t m;
+        cairo_get_matrix(context, &m);
+        out[0] = m.xx;
+        out[1] = m.yx;
+        out[2] = m.xy;
+        out[3] = m.yy;
+        out[4] = m.x0;
+        out[5] = m.y0;
+        return args[1];
+    }
+    cairo_matrix_t *matrix = matrix_new();
+    cairo_get_matrix(context, matrix);
+    return External::New(matrix);
 }
 
 /**
- * @function cairo.context_in_clip
+ * @function cairo.context_identity_matrix
  * 
  * ### Synopsis
  * 
- * var inClip = cairo.context_in_clip(context, x, y);
+ * cairo.context_identity_matrix(context);
  * 
- * Tests whether the given point is inside the area that would be visible through the current clip, i.e. the area that would be filled by a cairo.context_paint() operation.
+ * Resets the current transformation matrix (CTM) by setting it equal to the identity matrix. 
+ * 
+ * That is, the user-space and device-space axes will be aligned and one user-space unit will transform to one device-space unit.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {boolean} inClip - true if the point is inside the clip rectangle, false if not.
  */
-#if CAIRO_VERSION_MINOR >= 10
-static JSVAL context_in_clip(JSARGS args) {
+static JSVAL context_identity_matrix(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return cairo_in_clip(context, args[1]->NumberValue(), args[2]->NumberValue()) ? True() : False();
+    record_command(context, COMMAND_IDENTITY_MATRIX, args, 0);
+    cairo_identity_matrix(context);
+    return Undefined();
 }
-#endif
 
 /**
- * @function cairo.context_reset_clip
+ * @function cairo.context_user_to_device
  * 
  * ### Synopsis
  * 
- * cairo.context_reset_clip(context);
+ * var vector = cairo.context_user_to_device(context, vector);
  * 
- * Reset the current clip region to its original, unrestricted state. 
+ * Transform a coordinate from user space to device space by multiplying the given point by the current transformation matrix (CTM).
  * 
- * That is, set the clip region to an infinitely large shape containing the target surface. Equivalently, if infinity is too hard to grasp, one can imagine the clip region being reset to the exact bounds of the target surface.
+ * The input vector and output vector are the same object, of the form:
  * 
- * Note that code meant to be reusable should not call cairo.context_reset_clip() as it will cause results unexpected by higher-level code which calls cairo.context_clip(). Consider using cairo.context_save() and cairo.context_restore() around cairo.context_clip() as a more robust means of temporarily restricting the clip region.
+ * + {number} x - x coordinate.
+ * + {number} y - y coordinate
+ * 
+ * The dx,dy members are modified by this routine.
+ * 
+ * The vector may instead be a Float64Array of at least 2 elements holding [x, y], which is transformed in place and returned.  This avoids property lookups and allocation in tight loops.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {object} vector - JavaScript object of the form described above, or a Float64Array.
+ * @return {object} vector - JavaScript object of the form described above.
  */
-static JSVAL context_reset_clip(JSARGS args) {
+static JSVAL context_user_to_device(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_reset_clip(context);
-    return Undefined();
+    double *v = float64_array_data(args[1], 2);
+    if (v != NULL) {
+        cairo_user_to_device(context, &v[0], &v[1]);
+        return args[1];
+    }
+    Local<String>_x = String::New("x");
+    Local<String>_y = String::New("y");
+    JSOBJ o = args[1]->ToObject();
+    double x = o->Get(_x)->NumberValue();
+    double y = o->Get(_y)->NumberValue();
+    cairo_user_to_device(context, &x, &y);
+    o->Set(_x, Number::New(x));
+    o->Set(_y, Number::New(y));
+    return o;
 }
 
-// rectangle list stuff not implemented (yet)
-
 /**
- * @function cairo.context_fill
+ * @function cairo.context_user_to_device_distance
  * 
  * ### Synopsis
  * 
- * cairo.context_fill(context);
+ * var vector = cairo.context_user_to_device_distance(context, vector);
  * 
- * A drawing operator that fills the current path according to the current fill rule, (each sub-path is implicitly closed before being filled). 
+ * Transform a distance vector from user space to device space. 
  * 
- * After cairo.context_fill(), the current path will be cleared from the cairo context. 
+ * This function is similar to cairo.context_user_to_device() except that the translation components of the CTM will be ignored when transforming (dx,dy).
  * 
- * See cairo.context_set_fill_rule() and cairo.context_fill_preserve().
+ * The input vector and output vector are the same object, of the form:
+ * 
+ * + {number} dx - x component of distance vector.
+ * + {number} dy - y component of distance vector.
+ * 
+ * The dx,dy members are modified by this routine.
+ * 
+ * The vector may instead be a Float64Array of at least 2 elements holding [dx, dy], which is transformed in place and returned.  This avoids property lookups and allocation in tight loops.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {object} vector - JavaScript object of the form described above, or a Float64Array.
+ * @return {object} vector - JavaScript object of the form described above.
  */
-static JSVAL context_fill(JSARGS args) {
+static JSVAL context_user_to_device_distance(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_fill(context);
-    return Undefined();
+    double *v = float64_array_data(args[1], 2);
+    if (v != NULL) {
+        cairo_user_to_device_distance(context, &v[0], &v[1]);
+        return args[1];
+    }
+    Local<String>_dx = String::New("dx");
+    Local<String>_dy = String::New("dy");
+    JSOBJ o = args[1]->ToObject();
+    double dx = o->Get(_dx)->NumberValue();
+    double dy = o->Get(_dy)->NumberValue();
+    cairo_user_to_device_distance(context, &dx, &dy);
+    o->Set(_dx, Number::New(dx));
+    o->Set(_dy, Number::New(dy));
+    return o;
 }
 
 /**
- * @function cairo.context_fill_preserve
+ * @function cairo.context_device_to_user
  * 
  * ### Synopsis
  * 
- * cairo.context_fill_preserve(context);
+ * var vector = cairo.context_device_to_user(context, vector);
  * 
- * A drawing operator that fills the current path according to the current fill rule, (each sub-path is implicitly closed before being filled). 
+ * Transform a coordinate from device space to user space by multiplying the given point by the inverse of the current transformation matrix (CTM).
  * 
- * Unlike cairo.context_fill(), cairo.context_fill_preserve() preserves the path within the cairo context.
+ * The input vector and output vector are the same object, of the form:
  * 
- * See cairo.context_set_fill_rule() and cairo.context_fill().
+ * + {number} x - x component of distance vector.
+ * + {number} y - y component of distance vector.
+ * 
+ * The dx,dy members are modified by this routine.
+ * 
+ * The vector may instead be a Float64Array of at least 2 elements holding [x, y], which is transformed in place and returned.  This avoids property lookups and allocation in tight loops.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {object} vector - JavaScript object of the form described above, or a Float64Array.
+ * @return {object} vector - JavaScript object of the form described above.
  */
-static JSVAL context_fill_preserve(JSARGS args) {
+static JSVAL context_device_to_user(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_fill_preserve(context);
-    return Undefined();
+    double *v = float64_array_data(args[1], 2);
+    if (v != NULL) {
+        cairo_device_to_user(context, &v[0], &v[1]);
+        return args[1];
+    }
+    Local<String>_x = String::New("x");
+    Local<String>_y = String::New("y");
+    JSOBJ o = args[1]->ToObject();
+    double x = o->Get(_x)->NumberValue();
+    double y = o->Get(_y)->NumberValue();
+    cairo_device_to_user(context, &x, &y);
+    o->Set(_x, Number::New(x));
+    o->Set(_y, Number::New(y));
+    return o;
 }
 
 /**
- * @function cairo.context_fill_extents
+ * @function cairo.context_device_to_user_distance
  * 
  * ### Synopsis
  * 
- * var extents = cairo.context_fill_extents(context);
+ * var vector = cairo.context_device_to_user_distance(context, vector);
  * 
- * Computes a bounding box in user coordinates covering the area that would be affected, (the "inked" area), by a cairo.context_fill() operation given the current path and fill parameters. If the current path is empty, returns an empty rectangle ((0,0), (0,0)). Surface dimensions and clipping are not taken into account.
+ * Transform a distance vector from device space to user space. 
  * 
- * Contrast with cairo.context_path_extents(), which is similar, but returns non-zero extents for some paths with no inked area, (such as a simple line segment).
+ * This function is similar to cairo.context_device_to_user() except that the translation components of the inverse CTM will be ignored when transforming (dx,dy).
  * 
- * Note that cairo.context_fill_extents() must necessarily do more work to compute the precise inked areas in light of the fill rule, so cairo.context_path_extents() may be more desirable for sake of performance if the non-inked path extents are desired.
+ * The input vector and output vector are the same object, of the form:
  * 
- * See cairo.context_fill(), cairo.context_set_fill_rule() and cairo.context_fill_preserve().
+ * + {number} dx - x component of distance vector.
+ * + {number} dy - y component of distance vector.
  * 
- * The object returned has the following members:
+ * The dx,dy members are modified by this routine.
  * 
- * + x1: x coordinate of the top left corner of the resulting extents.
- * + y1: y coordinate of the top left corner of the resulting extents.
- * + x2: x coordinate of the lower right corner of the resulting extents.
- * + y2: y coordinate of the lower right corner of the resulting extents.
+ * The vector may instead be a Float64Array of at least 2 elements holding [dx, dy], which is transformed in place and returned.  This avoids property lookups and allocation in tight loops.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} extents - see object description above.
+ * @param {object} vector - JavaScript object of the form described above, or a Float64Array.
+ * @return {object} vector - JavaScript object of the form described above.
  */
-static JSVAL context_fill_extents(JSARGS args) {
+static JSVAL context_device_to_user_distance(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    double x1,y1, x2,y2;
-    cairo_fill_extents(context, &x1,&y1, &x2,&y2);
-    
-    JSOBJ o = Object::New();
-    o->Set(String::New("x1"), Number::New(x1));
-    o->Set(String::New("y1"), Number::New(y1));
-    o->Set(String::New("x2"), Number::New(x2));
-    o->Set(String::New("y2"), Number::New(y2));
+    double *v = float64_array_data(args[1], 2);
+    if (v != NULL) {
+        cairo_device_to_user_distance(context, &v[0], &v[1]);
+        return args[1];
+    }
+    Local<String>_dx = String::New("dx");
+    Local<String>_dy = String::New("dy");
+    JSOBJ o = args[1]->ToObject();
+    double dx = o->Get(_dx)->NumberValue();
+    double dy = o->Get(_dy)->NumberValue();
+    cairo_device_to_user_distance(context, &dx, &dy);
+    o->Set(_dx, Number::New(dx));
+    o->Set(_dy, Number::New(dy));
     return o;
 }
 
+
+// Applies the affine transformation m to count interleaved x,y pairs in place.
+//
+// With SSE2 each point is one 128-bit lane pair: x' and y' are computed together as
+// (xx,yx)*x + (xy,yy)*y + (x0,y0).
+static void transform_points(const cairo_matrix_t *m, double *points, int count) {
+#ifdef __SSE2__
+    __m128d cx = _mm_set_pd(m->yx, m->xx);
+    __m128d cy = _mm_set_pd(m->yy, m->xy);
+    __m128d c0 = _mm_set_pd(m->y0, m->x0);
+    for (int i = 0; i < count; i++) {
+        __m128d p = _mm_loadu_pd(points);
+        __m128d px = _mm_unpacklo_pd(p, p);
+        __m128d py = _mm_unpackhi_pd(p, p);
+        p = _mm_add_pd(_mm_add_pd(_mm_mul_pd(px, cx), _mm_mul_pd(py, cy)), c0);
+        _mm_storeu_pd(points, p);
+        points += 2;
+    }
+#else
+    double xx = m->xx, yx = m->yx, xy = m->xy, yy = m->yy, x0 = m->x0, y0 = m->y0;
+    for (int i = 0; i < count; i++) {
+        double x = points[0], y = points[1];
+        points[0] = xx * x + xy * y + x0;
+        points[1] = yx * x + yy * y + y0;
+        points += 2;
+    }
+#endif
+}
+
+// Validates the points/count arguments shared by the batch transform methods.
+// Returns the number of points to transform, or -1 (with an exception thrown) on error.
+static int batch_point_count(JSARGS args, const char *fn) {
+    int length = float64_array_length(args[1]);
+    if (length < 0) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%s: points must be a Float64Array", fn);
+        ThrowException(String::New(msg));
+        return -1;
+    }
+    int count = length / 2;
+    if (args.Length() > 2 && !args[2]->IsUndefined()) {
+        int n = args[2]->IntegerValue();
+        if (n < 0 || n > count) {
+            ThrowException(String::New("points array is too short for count"));
+            return -1;
+        }
+        count = n;
+    }
+    return count;
+}
+
 /**
- * @function cairo.context_in_fill
+ * @function cairo.context_user_to_device_points
  * 
  * ### Synopsis
  * 
- * var inFill = cairo.context_in_fill(context, x, y);
+ * var points = cairo.context_user_to_device_points(context, points);
+ * var points = cairo.context_user_to_device_points(context, points, count);
  * 
- * Tests whether the given point is inside the area that would be affected by a cairo.context_fill() operation given the current path and filling parameters. Surface dimensions and clipping are not taken into account.
+ * Transform many coordinates from user space to device space in one call, by multiplying each point by the current transformation matrix (CTM).
  * 
- * See cairo.context_fill(), cairo.context_set_fill_rule() and cairo.context_fill_preserve().
+ * The points argument is a Float64Array of interleaved coordinates: [x0, y0, x1, y1, ...].  The points are transformed in place and the same array is returned.
+ * 
+ * This is equivalent to calling cairo.context_user_to_device() once per point, without the per-point call overhead or object allocation.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {boolean} inFill - true if the point is inside the area that would be affected, false if not.
+ * @param {Float64Array} points - interleaved x,y coordinates.
+ * @param {int} count - optional number of points to transform; defaults to all of them (points.length / 2).
+ * @return {Float64Array} points - the transformed points.
  */
-static JSVAL context_in_fill(JSARGS args) {
+static JSVAL context_user_to_device_points(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return cairo_in_fill(context, args[1]->NumberValue(), args[2]->NumberValue()) ? True() : False();
+    int count = batch_point_count(args, "context_user_to_device_points");
+    if (count < 0) {
+        return Undefined();
+    }
+    cairo_matrix_t m;
+    cairo_get_matrix(context, &m);
+    transform_points(&m, float64_array_data(args[1], 0), count);
+    return args[1];
 }
 
 /**
- * @function cairo.context_mask
+ * @function cairo.context_device_to_user_points
  * 
  * ### Synopsis
  * 
- * cairo.context_mask(context, pattern);
+ * var points = cairo.context_device_to_user_points(context, points);
+ * var points = cairo.context_device_to_user_points(context, points, count);
  * 
- * A drawing operator that paints the current source using the alpha channel of pattern as a mask. 
+ * Transform many coordinates from device space to user space in one call, by multiplying each point by the inverse of the current transformation matrix (CTM).
  * 
- * Opaque areas of pattern are painted with the source, transparent areas are not painted.
+ * The points argument is a Float64Array of interleaved coordinates: [x0, y0, x1, y1, ...].  The points are transformed in place and the same array is returned.
+ * 
+ * The CTM is inverted once per call rather than once per point.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} pattern - opaque handle to a cairo pattern.
+ * @param {Float64Array} points - interleaved x,y coordinates.
+ * @param {int} count - optional number of points to transform; defaults to all of them (points.length / 2).
+ * @return {Float64Array} points - the transformed points.
+ * 
+ * ### Note
+ * 
+ * This function will throw an exception if the CTM is not invertible.
  */
-static JSVAL context_mask(JSARGS args) {
+static JSVAL context_device_to_user_points(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_pattern_t *pattern = (cairo_pattern_t *) JSEXTERN(args[1]);
-    cairo_mask(context, pattern);
-    return Undefined();
+    int count = batch_point_count(args, "context_device_to_user_points");
+    if (count < 0) {
+        return Undefined();
+    }
+    cairo_matrix_t m;
+    cairo_get_matrix(context, &m);
+    cairo_status_t status = cairo_matrix_invert(&m);
+    if (status != CAIRO_STATUS_SUCCESS) {
+        return ThrowException(String::New(cairo_status_to_string(status)));
+    }
+    transform_points(&m, float64_array_data(args[1], 0), count);
+    return args[1];
 }
 
+
+////////////////////////// PATHS
+// http://www.cairographics.org/manual/cairo-Paths.html
+
+// functions to return cario_path_t and manipulate them not done.
+
+
 /**
- * @function cairo.context_mask_surface
+ * @function cairo.context_copy_path
  * 
  * ### Synopsis
  * 
- * cairo.context_mask_surface(context, surface, surface_x, surface_y);
+ * var path = cairo.context_copy_path(context);
  * 
- * A drawing operator that paints the current source using the alpha channel of surface as a mask. 
+ * Creates a copy of the current path.
  * 
- * Opaque areas of surface are painted with the source, transparent areas are not painted.
+ * The caller owns the returned object and should call cairo.path_destroy() when finished with it.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {object} surface - opaque handle to a cairo surface.
- * @param {number} surface_x - x coordinate at which to place the origin of surface.
- * @param {number} surface_y - y coordinate at which to place the origin of surface.
+ * @return {object} path - opaque handle to a cairo path
  */
-static JSVAL context_mask_surface(JSARGS args) {
+static JSVAL context_copy_path(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[1]);
-    cairo_mask_surface(context, surface, args[2]->NumberValue(), args[3]->NumberValue());
-    return Undefined();
+    return External::New(track_path(cairo_copy_path(context)));
 }
 
 /**
- * @function cairo.context_paint
+ * @function cairo.context_copy_path_flat
  * 
  * ### Synopsis
  * 
- * cairo.context_paint(context);
+ * var path = cairo.context_copy_path_flat(context);
  * 
- * A drawing operator that paints the current source everywhere within the current clip region.
+ * Creates a copy of the current path.
+ * 
+ * Gets a flattened copy of the current path and returns it to the user as a cairo_path_t. See cairo_path_data_t for hints on how to iterate over the returned data structure.
+ * 
+ * This function is like cairo.context_copy_path() except that any curves in the path will be approximated with piecewise-linear approximations, (accurate to within the current tolerance value). 
+ * 
+ * That is, the result is guaranteed to not have any elements of type cairo.PATH_CURVE_TO which will instead be replaced by a series of cairo.PATH_LINE_TO elements.
+ * 
+ * The caller owns the returned object and should call cairo.path_destroy() when finished with it.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @return {object} path - opaque handle to a cairo path
  */
-static JSVAL context_paint(JSARGS args) {
+static JSVAL context_copy_path_flat(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_paint(context);
-    return Undefined();
+    return External::New(track_path(cairo_copy_path_flat(context)));
 }
 
 /**
- * @function cairo.context_paint_with_alpha
+ * @function cairo.context_append_path
  * 
  * ### Synopsis
  * 
- * cairo.context_paint_with_alpha(context, alpha);
+ * cairo.context_append_path(context, path);
  * 
- * A drawing operator that paints the current source everywhere within the current clip region using a mask of constant alpha value alpha. 
+ * Append the path onto the current path.
  * 
- * The effect is similar to cairo.context_paint(), but the drawing is faded out using the alpha value.
+ * The path may be either the return value from one of cairo.context_copy_path() or cairo.context_copy_path_flat()
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} alpha - alpha value, between 0 (transparent) and 1 (opaque).
+ * @param {object} path - opaque handle to a cairo path
  */
-static JSVAL context_paint_with_alpha(JSARGS args) {
+static JSVAL context_append_path(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_paint_with_alpha(context, args[1]->NumberValue());
+    cairo_path_t *path = (cairo_path_t *)JSEXTERN(args[1]);
+    Command *command = record_command(context, COMMAND_APPEND_PATH, args, 0);
+    if (command) {
+        command->data = path_copy(path);
+    }
+    cairo_append_path(context, path);
     return Undefined();
 }
-
-/**
- * @function cairo.context_stroke
- * 
- * ### Synopsis
- * 
- * cairo.context_stroke(context);
- * 
- * A drawing operator that strokes the current path according to the current line width, line join, line cap, and dash settings. After cairo.context_stroke(), the current path will be cleared from the cairo context. 
+
+/**
+ * @functino cairo.path_destroy
  * 
- * See cairo.context_set_line_width(), cairo.context_set_line_join(), cairo.context_set_line_cap(), cairo.context_set_dash(), and cairo.context_stroke_preserve().
+ * ### Synopsis
  * 
- * Note: Degenerate segments and sub-paths are treated specially and provide a useful result. These can result in two different situations:
+ * cairo.path_dstroy(path);
  * 
- * 1. Zero-length "on" segments set in cairo.context_set_dash(). If the cap style is cairo.LINE_CAP_ROUND or cairo.LINE_CAP_SQUARE then these segments will be drawn as circular dots or squares respectively. In the case of cairo.LINE_CAP_SQUARE, the orientation of the squares is determined by the direction of the underlying path.
- * 2. A sub-path created by cairo.context_move_to() followed by either a cairo.context_close_path() or one or more calls to cairo.context_line_to() to the same coordinate as the cairo_move_to(). If the cap style is cairo._LINE_CAP_ROUND then these sub-paths will be drawn as circular dots. Note that in the case of cairo.LINE_CAP_SQUARE a degenerate sub-path will not be drawn at all, (since the correct orientation is indeterminate).
+ * Immediately releases all memory associated with path. 
  * 
- * In no case will a cap style of cairo.LINE_CAP_BUTT cause anything to be drawn in the case of either degenerate segments or sub-paths.
+ * After a call to cairo.path_destroy() the path pointer is no longer valid and should not be used further.
  * 
- * @param {object} context - opaque handle to a cairo context.
+ * @param {object} path - opaque handle to a cairo path
  */
-static JSVAL context_stroke(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_stroke(context);
+static JSVAL path_destroy(JSARGS args) {
+    cairo_path_t *path = (cairo_path_t *)JSEXTERN(args[0]);
+    untrack_path(path);
+    cairo_path_destroy(path);
     return Undefined();
 }
 
 /**
- * @function cairo.context_stroke_preserve
+ * @function cairo.context_has_current_point
  * 
  * ### Synopsis
  * 
- * cairo.stroke_preserve(context);
- * 
- * A drawing operator that strokes the current path according to the current line width, line join, line cap, and dash settings. 
+ * var hasPoint = cairo.context_has_current_point(context);
  * 
- * Unlike cairo.context_stroke(), cairo.context_stroke_preserve() preserves the path within the cairo context.
+ * Returns whether a current point is defined on the current path. 
  * 
- * See cairo.context_set_line_width(), cairo.context_set_line_join(), cairo.context_set_line_cap(), and cairo.context_set_dash().
+ * See cairo.context_get_current_point() for details on the current point.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @return {boolean} hasPoint - true if a current point is defined.
  */
-static JSVAL context_stroke_preserve(JSARGS args) {
+static JSVAL context_has_current_point(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_stroke_preserve(context);
-    return Undefined();
+    return cairo_has_current_point(context) ? True() : False();
 }
 
 /**
- * @function cairo.context_stroke_extents
+ * @function cairo.context_get_current_point
  * 
  * ### Synopsis
  * 
- * var extents = cairo.context_stroke_extents(context);
+ * var point = cairo.context_get_current_point(context);
+ * var out = cairo.context_get_current_point(context, out);
  * 
- * Computes a bounding box in user coordinates covering the area that would be affected, (the "inked" area), by a cairo.context_stroke() operation given the current path and stroke parameters. If the current path is empty, returns an empty rectangle ((0,0), (0,0)). Surface dimensions and clipping are not taken into account.
+ * Gets the current point of the current path, which is conceptually the final point reached by the path so far.
  * 
- * Note that if the line width is set to exactly zero, then cairo.context_stroke_extents() will return an empty rectangle. Contrast with cairo.context_path_extents() which can be used to compute the non-empty bounds as the line width approaches zero.
+ * The current point is returned in the user-space coordinate system. If there is no defined current point or if context is in an error status, x and y will both be set to 0.0. It is possible to check this in advance with cairo.context_has_current_point().
  * 
- * Note that cairo.context_stroke_extents() must necessarily do more work to compute the precise inked areas in light of the stroke parameters, so cairo.context_path_extents() may be more desirable for sake of performance if non-inked path extents are desired.
+ * Most path construction functions alter the current point. 
  * 
- * See cairo.context_stroke(), cairo.context_set_line_width(), cairo.context_set_line_join(), cairo.context_set_line_cap(), cairo.context_set_dash(), and cairo.context_stroke_preserve().
+ * See the following for details on how they affect the current point: cairo.context_new_path(), cairo.context_new_sub_path(), cairo.context_append_path(), cairo.context_close_path(), cairo.context_move_to(), cairo.context_line_to(), cairo.context_curve_to(), cairo.context_rel_move_to(), cairo.context_rel_line_to(), cairo.context_rel_curve_to(), cairo.context_arc(), cairo.context_arc_negative(), cairo.context_rectangle(), cairo.context_text_path(), cairo.context_glyph_path(), cairo_stroke_to_path().
  * 
- * The object returned has the following members:
+ * Some functions use and alter the current point but do not otherwise change current path: cairo.context_show_text().
  * 
- * + x1: x coordinate of the top left corner of the resulting extents.
- * + y1: y coordinate of the top left corner of the resulting extents.
- * + x2: x coordinate of the lower right corner of the resulting extents.
- * + y2: y coordinate of the lower right corner of the resulting extents.
+ * Some functions unset the current path and as a result, current point: cairo.context_fill(), cairo.context_stroke().
+ * 
+ * The object returned has just two members:
+ * 
+ * + {number} x: x coordinate of the current point
+ * + {number} y: y coordinate of the current point
+ * 
+ * If the optional out argument is given, it must be a Float64Array of at least 2 elements.  The current point is written to it as [x, y] and out is returned.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} extents - see object description above.
+ * @param {Float64Array} out - optional array to receive [x, y].
+ * @return {object} point - object of the form described above.
  */
-static JSVAL context_stroke_extents(JSARGS args) {
+static JSVAL context_get_current_point(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    double x1,y1, x2,y2;
-    cairo_stroke_extents(context, &x1,&y1, &x2,&y2);
+    double x,y;
     
+    cairo_get_current_point(context, &x, &y);
+    if (args.Length() > 1) {
+        double *out = float64_array_data(args[1], 2);
+        if (out == NULL) {
+            return throw_bad_out_array("context_get_current_point", 2);
+        }
+        out[0] = x;
+        out[1] = y;
+        return args[1];
+    }
     JSOBJ o = Object::New();
-    o->Set(String::New("x1"), Number::New(x1));
-    o->Set(String::New("y1"), Number::New(y1));
-    o->Set(String::New("x2"), Number::New(x2));
-    o->Set(String::New("y2"), Number::New(y2));
+    o->Set(String::New("x"), Number::New(x));
+    o->Set(String::New("y"), Number::New(y));
     return o;
 }
 
 /**
- * @function cairo.context_in_stroke
+ * @function cairo.context_new_path
  * 
  * ### Synopsis
  * 
- * var inStroke = cairo.context_in_stroke(context, x, y);
- * 
- * Tests whether the given point is inside the area that would be affected by a cairo.context_stroke() operation given the current path and stroking parameters. 
- * 
- * Surface dimensions and clipping are not taken into account.
+ * cairo.context_new_path(context);
  * 
- * See cairo.context_stroke(), cairo.context_set_line_width(), cairo.context_set_line_join(), cairo.context_set_line_cap(), cairo.context_set_dash(), and cairo.context_stroke_preserve().
+ * Clears the current path. After this call there will be no path and no current point.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {boolean} inStroke - true if the point is inside the area that would be affected, false if not.
  */
-static JSVAL context_in_stroke(JSARGS args) {
+static JSVAL context_new_path(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return cairo_in_stroke(context, args[1]->NumberValue(), args[2]->NumberValue()) ? True() : False();
+    record_command(context, COMMAND_NEW_PATH, args, 0);
+    cairo_new_path(context);
+    return Undefined();
 }
 
 /**
- * @function cairo.context_copy_page
+ * @function cairo.context_new_sub_path
  * 
  * ### Synopsis
  * 
- * cairo.context_copy_page(context);
+ * cairo.context_new_sub_path(context);
  * 
- * Emits the current page for backends that support multiple pages, but doesn't clear it, so, the contents of the current page will be retained for the next page too. Use cairo.conext_show_page() if you want to get an empty page after the emission.
+ * Begin a new sub-path. 
  * 
- * This is a convenience function that simply calls cairo.surface_copy_page() on context's target.
+ * Note that the existing path is not affected. After this call there will be no current point.
+ * 
+ * In many cases, this call is not needed since new sub-paths are frequently started with cairo.context_move_to().
+ * 
+ * A call to cairo.context_new_sub_path() is particularly useful when beginning a new sub-path with one of the cairo.context_arc() calls. This makes things easier as it is no longer necessary to manually compute the arc's initial coordinates for a call to cairo.context_move_to().
  * 
  * @param {object} context - opaque handle to a cairo context.
  */
-static JSVAL context_copy_page(JSARGS args) {
+static JSVAL context_new_sub_path(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_copy_page(context);
+    record_command(context, COMMAND_NEW_SUB_PATH, args, 0);
+    cairo_new_sub_path(context);
     return Undefined();
 }
 
 /**
- * @function cairo.context_show_page
+ * @function cairo.context_close_path
  * 
  * ### Synopsis
  * 
- * cairo.context_show_page(context);
+ * cairo.context_close_path(context);
  * 
- * Emits and clears the current page for backends that support multiple pages. Use cairo.context_copy_page() if you don't want to clear the page.
+ * Adds a line segment to the path from the current point to the beginning of the current sub-path, (the most recent point passed to cairo.context_move_to()), and closes this sub-path. After this call the current point will be at the joined endpoint of the sub-path.
  * 
- * This is a convenience function that simply calls cairo.surface_show_page() on context's target.
+ * The behavior of cairo.context_close_path() is distinct from simply calling cairo.context_line_to() with the equivalent coordinate in the case of stroking. When a closed sub-path is stroked, there are no caps on the ends of the sub-path. Instead, there is a line join connecting the final and initial segments of the sub-path.
+ * 
+ * If there is no current point before the call to cairo.context_close_path(), this function will have no effect.
+ * 
+ * Note: As of cairo version 1.2.4 any call to cairo.context_close_path() will place an explicit MOVE_TO element into the path immediately after the CLOSE_PATH element, (which can be seen in cairo.context_copy_path() for example). This can simplify path processing in some cases as it may not be necessary to save the "last move_to point" during processing as the MOVE_TO immediately after the CLOSE_PATH will provide that point.
  * 
  * @param {object} context - opaque handle to a cairo context.
  */
-static JSVAL context_show_page(JSARGS args) {
+static JSVAL context_close_path(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_show_page(context);
+    record_command(context, COMMAND_CLOSE_PATH, args, 0);
+    cairo_close_path(context);
     return Undefined();
 }
 
 /**
- * @function cairo.context_translate
+ * @function cairo.context_arc
  * 
  * ### Synopsis
  * 
- * cairo.context_translate(context, tx,ty);
+ * cairo.context_arc(context, xc,yc, radius, angle1, angle2);
  * 
- * Modifies the current transformation matrix (CTM) by translating the user-space origin by (tx, ty). 
+ * Adds a circular arc of the given radius to the current path. 
  * 
- * This offset is interpreted as a user-space coordinate according to the CTM in place before the new call to cairo.context_translate(). 
+ * The arc is centered at (xc, yc), begins at angle1 and proceeds in the direction of increasing angles to end at angle2. If angle2 is less than angle1 it will be progressively increased by 2*M_PI until it is greater than angle1.
  * 
- * In other words, the translation of the user-space origin takes place after any existing transformation.
+ * If there is a current point, an initial line segment will be added to the path to connect the current point to the beginning of the arc. If this initial line is undesired, it can be avoided by calling cairo.context__new_sub_path() before calling cairo.context_arc().
+ * 
+ * Angles are measured in radians. An angle of 0.0 is in the direction of the positive X axis (in user space). An angle of M_PI/2.0 radians (90 degrees) is in the direction of the positive Y axis (in user space). Angles increase in the direction from the positive X axis toward the positive Y axis. So with the default transformation matrix, angles increase in a clockwise direction.
+ * 
+ * (To convert from degrees to radians, use degrees * (M_PI / 180.).)
+ * 
+ * This function gives the arc in the direction of increasing angles; see cairo.context_arc_negative() to get the arc in the direction of decreasing angles.
+ * 
+ * The arc is circular in user space. To achieve an elliptical arc, you can scale the current transformation matrix by different amounts in the X and Y directions. For example, to draw an ellipse in the box given by x, y, width, height:
+ * 
+ * ```
+ * cairo_save (context);
+ * cairo_translate (context, x + width / 2., y + height / 2.);
+ * cairo_scale (context, width / 2., height / 2.);
+ * cairo_arc (context, 0., 0., 1., 0., 2 * M_PI);
+ * cairo_restore (context);
+ * ```
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} tx - amount to translate in the x direction.
- * @param {number} ty - amount to translate in the y direction.
+ * @param {number} xc - x coordinate of the center of the arc.
+ * @param {number} yc - y coordinate of the center of the arc.
+ * @param {number} radius - radius of the arc.
+ * @param {number} angle1 - start angle in radians.
+ * @param {number} angle2 - end angle in radians.
  */
-static JSVAL context_translate(JSARGS args) {
+static JSVAL context_arc(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_translate(context, args[1]->NumberValue(), args[2]->NumberValue());
+    record_command(context, COMMAND_ARC, args, 5);
+    cairo_arc(context,
+              args[1]->NumberValue(),   // xc
+              args[2]->NumberValue(),   // yc
+              args[3]->NumberValue(),   // radius
+              args[4]->NumberValue(),   // angle1
+              args[5]->NumberValue()   // angle2
+    );
     return Undefined();
 }
 
 /**
- * @function cairo.context_scale
+ * @function cairo.context_arc_negative
  * 
  * ### Synopsis
  * 
- * cairo.context_scale(context, sx,sy);
+ * cairo.context_arc_negative(context, xc,yc, radius, angle1, angle2);
  * 
- * Modifies the current transformation matrix (CTM) by scaling the X and Y user-space axes by sx and sy respectively. 
+ * Adds a circular arc of the given radius to the current path. 
  * 
- * The scaling of the axes takes place after any existing transformation of user space.
+ * The arc is centered at (xc, yc), begins at angle1 and proceeds in the direction of decreasing angles to end at angle2. If angle2 is greater than angle1 it will be progressively decreased by 2*M_PI until it is less than angle1.
+ * 
+ * See cairo.context_arc() for more details. This function differs only in the direction of the arc between the two angles.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} sx - scale factor for the x dimension.
- * @param {number} sy - scale factor for the y dimension.
+ * @param {number} xc - x coordinate of the center of the arc.
+ * @param {number} yc - y coordinate of the center of the arc.
+ * @param {number} radius - radius of the arc.
+ * @param {number} angle1 - start angle in radians.
+ * @param {number} angle2 - end angle in radians.
  */
-static JSVAL context_scale(JSARGS args) {
+static JSVAL context_arc_negative(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_scale(context, args[1]->NumberValue(), args[2]->NumberValue());
+    record_command(context, COMMAND_ARC_NEGATIVE, args, 5);
+    cairo_arc_negative(context,
+              args[1]->NumberValue(),   // xc
+              args[2]->NumberValue(),   // yc
+              args[3]->NumberValue(),   // radius
+              args[4]->NumberValue(),   // angle1
+              args[5]->NumberValue()   // angle2
+    );
     return Undefined();
 }
 
 /**
- * @function cairo.context_rotate
+ * @function cairo.context_curve_to
  * 
  * ### Synopsis
  * 
- * cairo.context_rotate(context, angle);
+ * cairo.context_curve_to(context, x1,y1, x2,y2, x3,y3);
  * 
- * Modifies the current transformation matrix (CTM) by rotating the user-space axes by angle radians. 
+ * Adds a cubic Bézier spline to the path from the current point to position (x3, y3) in user-space coordinates, using (x1, y1) and (x2, y2) as the control points. 
  * 
- * The rotation of the axes takes places after any existing transformation of user space. 
+ * After this call the current point will be (x3, y3).
  * 
- * The rotation direction for positive angles is from the positive X axis toward the positive Y axis.
+ * If there is no current point before the call to cairo_curve_to() this function will behave as if preceded by a call to cairo.context_move_to(cr, x1, y1).
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} angle - angle in radians by which the user space axes will be rotated.
+ * @param {number} x1 - x coordinate of the first control point.
+ * @param {number} y1 - y coordinate of the first control point.
+ * @param {number} x2 - x coordinate of the second control point.
+ * @param {number} y2 - y coordinate of the second control point.
+ * @param {number} x3 - x coordinate of the third control point.
+ * @param {number} y3 - y coordinate of the third control point.
  */
-static JSVAL context_rotate(JSARGS args) {
+static JSVAL context_curve_to(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_rotate(context, args[1]->NumberValue());
+    record_command(context, COMMAND_CURVE_TO, args, 6);
+    cairo_curve_to(context,
+              args[1]->NumberValue(),   // x1
+              args[2]->NumberValue(),   // y1
+              args[3]->NumberValue(),   // x2
+              args[4]->NumberValue(),   // y2
+              args[5]->NumberValue(),   // x3
+              args[6]->NumberValue()   // y3
+    );
     return Undefined();
 }
 
 /**
- * @function cairo.context_transform
+ * @function cairo.context_line_to
  * 
  * ### Synopsis
  * 
- * cairo.context_transform(context, matrix);
+ * cairo.context_line_to(context, x,y);
  * 
- * Modifies the current transformation matrix (CTM) by applying matrix as an additional transformation. 
+ * Adds a line to the path from the current point to position (x, y) in user-space coordinates. 
  * 
- * The new transformation of user space takes place after any existing transformation.
+ * After this call the current point will be (x, y).
+ * 
+ * If there is no current point before the call to cairo.context_line_to() this function will behave as cairo.context_move_to(context, x, y).
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {object} matrix - opaque handle to a cairo matrix.
+ * @param {number} x - x coordinate of the end of the new line.
+ * @param {number} y - y coordinate of the end of the new line.
  */
-static JSVAL context_transform(JSARGS args) {
+static JSVAL context_line_to(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[1]);
-    cairo_transform(context, matrix);
+    record_command(context, COMMAND_LINE_TO, args, 2);
+    cairo_line_to(context,
+              args[1]->NumberValue(),   // x
+              args[2]->NumberValue()   // y
+    );
     return Undefined();
 }
 
 /**
- * @function cairo.context_set_matrix
+ * @function cairo.context_move_to
  * 
  * ### Synopsis
  * 
- * cairo.context_set_matrix(pattern, matrix);
+ * cairo.context_move_to(context, x,y);
  * 
- * Modifies the current transformation matrix (CTM) by setting it equal to matrix.
+ * Adds a line to the path from the current point to position (x, y) in user-space coordinates. 
+ * 
+ * After this call the current point will be (x, y).
+ * 
+ * If there is no current point before the call to cairo.context_line_to() this function will behave as cairo.context_move_to(context, x, y).
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {object} matrix - opaque handle to a cairo matrix.
+ * @param {number} x - x coordinate of the end of the new position.
+ * @param {number} y - y coordinate of the end of the new position.
  */
-static JSVAL context_set_matrix(JSARGS args) {
+static JSVAL context_move_to(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[1]);
-    cairo_set_matrix(context, matrix);
+    
+    record_command(context, COMMAND_MOVE_TO, args, 2);
+    cairo_move_to(context,
+              args[1]->NumberValue(),   // x
+              args[2]->NumberValue()   // y
+    );
     return Undefined();
 }
 
-
 /**
- * @function cairo.context_get_matrix
+ * @function cairo.context_rectangle
  * 
  * ### Synopsis
  * 
- * var matrix = cairo.context_get_matrix(context);
+ * cairo.context_rectangle(context, x,y, w,h);
  * 
- * Gets the context's transformation matrix.
+ * Adds a closed sub-path rectangle of the given size to the current path at position (x, y) in user-space coordinates.
  * 
- * The matrix returned is owned by the caller and must be released by calling cairo.matrix_destroy() when it is no longer needed.
+ * This is logically equivalent to:
  * 
+ * ```
+ * cairo_move_to context, x, y);
+ * cairo_rel_line_to (context, width, 0);
+ * cairo_rel_line_to context, 0, height);
+ * cairo_rel_line_to (context, -width, 0);
+ * cairo_close_path (context);
+ * ```
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} matrix - opaque handle to a cairo matrix.
+ * @param {number} x - x coordinate of the top left corner of the rectangle.
+ * @param {number} y - y coordinate of the top left corner of the rectangle.
+ * @param {number} w - width of the rectangle.
+ * @param {number} h - height of the rectangle.
  */
-static JSVAL context_get_matrix(JSARGS args) {
+static JSVAL context_rectangle(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_matrix_t *matrix = new cairo_matrix_t;
-    cairo_get_matrix(context, matrix);
-    return External::New(matrix);
+    
+    record_command(context, COMMAND_RECTANGLE, args, 4);
+    cairo_rectangle(context,
+              args[1]->NumberValue(),  // x
+              args[2]->NumberValue(),  // y
+              args[3]->NumberValue(),  // w
+              args[4]->NumberValue()   // h
+    );
+    return Undefined();
 }
 
 /**
- * @function cairo.context_identity_matrix
+ * @function cairo.context_glyph_path
  * 
  * ### Synopsis
  * 
- * cairo.context_identity_matrix(context);
+ * cairo.context_glyph_path(context, glyphs);
  * 
- * Resets the current transformation matrix (CTM) by setting it equal to the identity matrix. 
+ * Adds closed paths for the glyphs to the current path. 
  * 
- * That is, the user-space and device-space axes will be aligned and one user-space unit will transform to one device-space unit.
+ * The generated path if filled, achieves an effect similar to that of cairo.context_show_glyphs().
+ * 
+ * The glyphs argument is an array of objects of the following form:
+ * 
+ * + {int} index - glyph index in the font.  The exact interpretation of the glyph index depends on the font technology being used.
+ * + {number} x - the offset in the x direction between the origin used for drawing or measuring the string and the origin of this glyph.
+ * + {number} y - the offset in the y direction between the origin used for drawing or measuring the string and the origin of this glyph.
+ * 
+ * The above structure holds information about a single glyph when drawing or measuring text. A font is (in simple terms) a collection of shapes used to draw text. A glyph is one of these shapes. There can be multiple glyphs for a single character (alternates to be used in different contexts, for example), or a glyph can be a ligature of multiple characters. Cairo doesn't expose any way of converting input text into glyphs, so in order to use the Cairo interfaces that take arrays of glyphs, you must directly access the appropriate underlying font system.
+ * 
+ * Note that the offsets given by x and y are not cumulative. When drawing or measuring text, each glyph is individually positioned with respect to the overall origin
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {array} glyphs - array of objects as described above.
  */
-static JSVAL context_identity_matrix(JSARGS args) {
+static JSVAL context_glyph_path(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_identity_matrix(context);
+    if (command_list_for(context)) {
+        return not_recordable("context_glyph_path");
+    }
+    Handle<Array>glyphs = Handle<Array>::Cast(args[1]->ToObject());
+    int num_glyphs = glyphs->Length();
+    cairo_glyph_t *c_glyphs = new cairo_glyph_t[num_glyphs];
+    // 
+    Local<String>index = String::New("index");
+    Local<String>x = String::New("x");
+    Local<String>y = String::New("y");
+    
+    for (int i=0; i<num_glyphs; i++) {
+        JSOBJ o = glyphs->Get(i)->ToObject();
+        c_glyphs[i].index = o->Get(index)->IntegerValue();
+        c_glyphs[i].x = o->Get(x)->NumberValue();
+        c_glyphs[i].y = o->Get(y)->NumberValue();
+    }
+    cairo_glyph_path(context, c_glyphs, num_glyphs);
+    delete [] c_glyphs;
     return Undefined();
 }
 
 /**
- * @function cairo.context_user_to_device
+ * @function cairo.context_text_path
  * 
  * ### Synopsis
  * 
- * var vector = cairo.context_user_to_device(context, vector);
+ * cairo.context_text_path(context, str);
  * 
- * Transform a coordinate from user space to device space by multiplying the given point by the current transformation matrix (CTM).
+ * Adds closed paths for text to the current path. 
  * 
- * The input vector and output vector are the same object, of the form:
+ * The generated path if filled, achieves an effect similar to that of cairo.context__show_text().
  * 
- * + {number} x - x coordinate.
- * + {number} y - y coordinate
+ * Text conversion and positioning is done similar to cairo.context_show_text().
  * 
- * The dx,dy members are modified by this routine.
+ * Like cairo.context_show_text(), After this call the current point is moved to the origin of where the next glyph would be placed in this same progression. That is, the current point will be at the origin of the final glyph offset by its advance values. This allows for chaining multiple calls to to cairo.context_text_path() without having to set current point in between.
+ * 
+ * Note: The cairo.context_text_path() function call is part of what the cairo designers call the "toy" text API. It is convenient for short demos and simple programs, but it is not expected to be adequate for serious text-using applications. See cairo.context_glyph_path() for the "real" text path API in cairo.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {object} vector - JavaScript object of the form described above.
- * @return {object} vector - JavaScript object of the form described above.
+ * @param {string} str - text
  */
-static JSVAL context_user_to_device(JSARGS args) {
+static JSVAL context_text_path(JSARGS args) {
+    MetricsTimer timer(METRICS_TEXT, "text_path");
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    Local<String>_x = String::New("x");
-    Local<String>_y = String::New("y");
-    JSOBJ o = args[1]->ToObject();
-    double x = o->Get(_x)->NumberValue();
-    double y = o->Get(_y)->NumberValue();
-    cairo_user_to_device(context, &x, &y);
-    o->Set(_x, Number::New(x));
-    o->Set(_y, Number::New(y));
-    return o;
+    String::Utf8Value str(args[1]->ToString());
+    timer.arg("text", *str);
+    Command *command = record_command(context, COMMAND_TEXT_PATH, args, 0);
+    if (command) {
+        command->data = strdup(*str);
+    }
+    cairo_text_path(context, *str);
+    return Undefined();
 }
 
 /**
- * @function cairo.context_user_to_device_distance
+ * @function cairo.context_rel_curve_to
  * 
  * ### Synopsis
  * 
- * var vector = cairo.context_user_to_device_distance(context, vector);
- * 
- * Transform a distance vector from user space to device space. 
+ * cairo.context_rel_curve_to(context, dx1,dy1, dx2,dy2, dx3,dy3);
  * 
- * This function is similar to cairo.context_user_to_device() except that the translation components of the CTM will be ignored when transforming (dx,dy).
+ * Relative-coordinate version of cairo.context_curve_to(). 
  * 
- * The input vector and output vector are the same object, of the form:
+ * All offsets are relative to the current point. Adds a cubic Bézier spline to the path from the current point to a point offset from the current point by (dx3, dy3), using points offset by (dx1, dy1) and (dx2, dy2) as the control points. After this call the current point will be offset by (dx3, dy3).
  * 
- * + {number} dx - x component of distance vector.
- * + {number} dy - y component of distance vector.
+ * Given a current point of (x, y), cairo.context_rel_curve_to(context, dx1, dy1, dx2, dy2, dx3, dy3) is logically equivalent to cairo.context_curve_to(context, x+dx1, y+dy1, x+dx2, y+dy2, x+dx3, y+dy3).
  * 
- * The dx,dy members are modified by this routine.
+ * It is an error to call this function with no current point. Doing so will cause context to shutdown with a status of cairo.STATUS_NO_CURRENT_POINT.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {object} vector - JavaScript object of the form described above.
- * @return {object} vector - JavaScript object of the form described above.
+ * @param {number} dx1 - x offset to the first control point.
+ * @param {number} dy1 - y offset to the first control point.
+ * @param {number} dx2 - x offset to the second control point.
+ * @param {number} dy2 - y offset to the second control point.
+ * @param {number} dx3 - x offset to the third control point.
+ * @param {number} dy3 - y offset to the third control point.
  */
-static JSVAL context_user_to_device_distance(JSARGS args) {
+static JSVAL context_rel_curve_to(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    Local<String>_dx = String::New("dx");
-    Local<String>_dy = String::New("dy");
-    JSOBJ o = args[1]->ToObject();
-    double dx = o->Get(_dx)->NumberValue();
-    double dy = o->Get(_dy)->NumberValue();
-    cairo_user_to_device_distance(context, &dx, &dy);
-    o->Set(_dx, Number::New(dx));
-    o->Set(_dy, Number::New(dy));
-    return o;
+    record_command(context, COMMAND_REL_CURVE_TO, args, 6);
+    cairo_rel_curve_to(context,
+              args[1]->NumberValue(),   // dx1
+              args[2]->NumberValue(),   // dy1
+              args[3]->NumberValue(),   // dx2
+              args[4]->NumberValue(),   // dy2
+              args[5]->NumberValue(),   // dx3
+              args[6]->NumberValue()    // dy3
+    );
+    return Undefined();
 }
 
 /**
- * @function cairo.context_device_to_user
+ * @function cairo.context_rel_line_to
  * 
  * ### Synopsis
  * 
- * var vector = cairo.context_device_to_user(context, vector);
+ * cairo.context_rel_line_to(context, dx,dy);
  * 
- * Transform a coordinate from device space to user space by multiplying the given point by the inverse of the current transformation matrix (CTM).
+ * Relative-coordinate version of cairo.context__line_to(). 
  * 
- * The input vector and output vector are the same object, of the form:
+ * Adds a line to the path from the current point to a point that is offset from the current point by (dx, dy) in user space. After this call the current point will be offset by (dx, dy).
  * 
- * + {number} x - x component of distance vector.
- * + {number} y - y component of distance vector.
+ * Given a current point of (x, y), cairo.context_rel_line_to(context, dx, dy) is logically equivalent to cairo.context_line_to(context, x + dx, y + dy).
  * 
- * The dx,dy members are modified by this routine.
+ * It is an error to call this function with no current point. Doing so will cause context to shutdown with a status of cairo.STATUS_NO_CURRENT_POINT.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {object} vector - JavaScript object of the form described above.
- * @return {object} vector - JavaScript object of the form described above.
+ * @param {number} dx - x offset to the end of the new line.
+ * @param {number} dy - y offset to the end of the new line.
  */
-static JSVAL context_device_to_user(JSARGS args) {
+static JSVAL context_rel_line_to(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    Local<String>_x = String::New("x");
-    Local<String>_y = String::New("y");
-    JSOBJ o = args[1]->ToObject();
-    double x = o->Get(_x)->NumberValue();
-    double y = o->Get(_y)->NumberValue();
-    cairo_device_to_user(context, &x, &y);
-    o->Set(_x, Number::New(x));
-    o->Set(_y, Number::New(y));
-    return o;
+    record_command(context, COMMAND_REL_LINE_TO, args, 2);
+    cairo_rel_line_to(context,
+              args[1]->NumberValue(),   // dx
+              args[2]->NumberValue()    // dy
+    );
+    return Undefined();
 }
 
 /**
- * @function cairo.context_device_to_user_distance
+ * @function cairo.context_rel_move_to
  * 
  * ### Synopsis
  * 
- * var vector = cairo.context_device_to_user_distance(context, vector);
- * 
- * Transform a distance vector from device space to user space. 
+ * cairo.context_rel_move_to(context, dx,dy);
  * 
- * This function is similar to cairo.context_device_to_user() except that the translation components of the inverse CTM will be ignored when transforming (dx,dy).
+ * Begin a new sub-path. 
  * 
- * The input vector and output vector are the same object, of the form:
+ * After this call the current point will offset by (x, y).
  * 
- * + {number} dx - x component of distance vector.
- * + {number} dy - y component of distance vector.
+ * Given a current point of (x, y), cairo.context_rel_move_to(context, dx, dy) is logically equivalent to cairo.context_move_to(context, x + dx, y + dy).
  * 
- * The dx,dy members are modified by this routine.
+ * It is an error to call this function with no current point. Doing so will cause context to shutdown with a status of cairo.STATUS_NO_CURRENT_POINT.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {object} vector - JavaScript object of the form described above.
- * @return {object} vector - JavaScript object of the form described above.
+ * @param {number} dx - x offset to the end of the new position.
+ * @param {number} dy - y offset to the end of the new position.
  */
-static JSVAL context_device_to_user_distance(JSARGS args) {
+static JSVAL context_rel_move_to(JSARGS args) {
+    MetricsTimer timer(METRICS_PATH);
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    Local<String>_dx = String::New("dx");
-    Local<String>_dy = String::New("dy");
-    JSOBJ o = args[1]->ToObject();
-    double dx = o->Get(_dx)->NumberValue();
-    double dy = o->Get(_dy)->NumberValue();
-    cairo_device_to_user_distance(context, &dx, &dy);
-    o->Set(_dx, Number::New(dx));
-    o->Set(_dy, Number::New(dy));
-    return o;
+    
+    record_command(context, COMMAND_REL_MOVE_TO, args, 2);
+    cairo_rel_move_to(context,
+              args[1]->NumberValue(),   // dx
+              args[2]->NumberValue()    // dy
+    );
+    return Undefined();
 }
 
-
-
-////////////////////////// PATHS
-// http://www.cairographics.org/manual/cairo-Paths.html
-
-// functions to return cario_path_t and manipulate them not done.
-
-
 /**
- * @function cairo.context_copy_path
+ * @function cairo.context_path_extents
  * 
  * ### Synopsis
  * 
- * var path = cairo.context_copy_path(context);
+ * var extents = cairo.context_path_extents(context);
+ * var extents = cairo.context_path_extents(context, out);
  * 
- * Creates a copy of the current path.
+ * Computes a bounding box in user-space coordinates covering the points on the current path. 
  * 
- * The caller owns the returned object and should call cairo.path_destroy() when finished with it.
+ * If the current path is empty, returns an empty rectangle ((0,0), (0,0)). Stroke parameters, fill rule, surface dimensions and clipping are not taken into account.
+ * 
+ * Contrast with cairo.context_fill_extents() and cairo.context_stroke_extents() which return the extents of only the area that would be "inked" by the corresponding drawing operations.
+ * 
+ * The result of cairo.context_path_extents() is defined as equivalent to the limit of cairo.context_stroke_extents() with cairo.LINE_CAP_ROUND as the line width approaches 0.0, (but never reaching the empty-rectangle returned by cairo.context_stroke_extents() for a line width of 0.0).
+ * 
+ * Specifically, this means that zero-area sub-paths such as cairo.context_move_to(); cairo.context_line_to() segments, (even degenerate cases where the coordinates to both calls are identical), will be considered as contributing to the extents. However, a lone cairo.context_move_to() will not contribute to the results of cairo.context_path_extents().
+ * 
+ * The object returned has the following members:
+ * 
+ * + x1: x coordinate of the top left corner of the resulting extents.
+ * + y1: y coordinate of the top left corner of the resulting extents.
+ * + x2: x coordinate of the lower right corner of the resulting extents.
+ * + y2: y coordinate of the lower right corner of the resulting extents.
+ * 
+ * If the optional out argument is given, it must be a Float64Array of at least 4 elements.  The extents are written to it as [x1, y1, x2, y2] and out is returned instead of a new object.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} path - opaque handle to a cairo path
+ * @param {Float64Array} out - optional array to receive [x1, y1, x2, y2].
+ * @return {object} extents - see object description above.
  */
-static JSVAL context_copy_path(JSARGS args) {
+static JSVAL context_path_extents(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return External::New(cairo_copy_path(context));
+    double x1,y1, x2,y2;
+    cairo_path_extents(context, &x1,&y1, &x2,&y2);
+    
+    if (args.Length() > 1) {
+        double *out = float64_array_data(args[1], 4);
+        if (out == NULL) {
+            return throw_bad_out_array("context_path_extents", 4);
+        }
+        out[0] = x1;
+        out[1] = y1;
+        out[2] = x2;
+        out[3] = y2;
+        return args[1];
+    }
+    JSOBJ o = Object::New();
+    o->Set(String::New("x1"), Number::New(x1));
+    o->Set(String::New("y1"), Number::New(y1));
+    o->Set(String::New("x2"), Number::New(x2));
+    o->Set(String::New("y2"), Number::New(y2));
+    return o;
 }
 
 /**
- * @function cairo.context_copy_path_flat
+ * @function cairo.context_path_device_extents
  * 
  * ### Synopsis
  * 
- * var path = cairo.context_copy_path_flat(context);
+ * var rect = cairo.context_path_device_extents(context, stroke);
  * 
- * Creates a copy of the current path.
+ * Computes the device-space pixel rectangle that filling, and optionally stroking, the current path could touch.
  * 
- * Gets a flattened copy of the current path and returns it to the user as a cairo_path_t. See cairo_path_data_t for hints on how to iterate over the returned data structure.
+ * The extents are those of cairo.context_fill_extents(), united with cairo.context_stroke_extents() if stroke is true, transformed to device space, rounded out to whole pixels and grown by one pixel for antialiasing.  Clipping is not taken into account.
  * 
- * This function is like cairo.context_copy_path() except that any curves in the path will be approximated with piecewise-linear approximations, (accurate to within the current tolerance value). 
+ * The object returned has the following members:
  * 
- * That is, the result is guaranteed to not have any elements of type cairo.PATH_CURVE_TO which will instead be replaced by a series of cairo.PATH_LINE_TO elements.
+ * + x: x coordinate of the top left corner.
+ * + y: y coordinate of the top left corner.
+ * + width: width of the rectangle.
+ * + height: height of the rectangle.
  * 
- * The caller owns the returned object and should call cairo.path_destroy() when finished with it.
+ * If nothing would be drawn, null is returned.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} path - opaque handle to a cairo path
+ * @param {boolean} stroke - true to include the area a stroke would cover.
+ * @return {object} rect - see object description above, or null.
  */
-static JSVAL context_copy_path_flat(JSARGS args) {
+static JSVAL context_path_device_extents(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return External::New(cairo_copy_path_flat(context));
+    double x1, y1, x2, y2;
+    cairo_fill_extents(context, &x1, &y1, &x2, &y2);
+    if (args[1]->BooleanValue()) {
+        double sx1, sy1, sx2, sy2;
+        cairo_stroke_extents(context, &sx1, &sy1, &sx2, &sy2);
+        if (sx1 < sx2 && sy1 < sy2) {
+            if (x1 < x2 && y1 < y2) {
+                x1 = x1 < sx1 ? x1 : sx1;
+                y1 = y1 < sy1 ? y1 : sy1;
+                x2 = x2 > sx2 ? x2 : sx2;
+                y2 = y2 > sy2 ? y2 : sy2;
+            }
+            else {
+                x1 = sx1, y1 = sy1, x2 = sx2, y2 = sy2;
+            }
+        }
+    }
+    if (!(x1 < x2 && y1 < y2)) {
+        return Null();
+    }
+    double device[4];
+    user_rect_to_device(context, x1, y1, x2, y2, device);
+    int x = (int) floor(device[0]) - 1;
+    int y = (int) floor(device[1]) - 1;
+
+    JSOBJ o = Object::New();
+    o->Set(String::New("x"), Integer::New(x));
+    o->Set(String::New("y"), Integer::New(y));
+    o->Set(String::New("width"), Integer::New((int) ceil(device[2]) + 1 - x));
+    o->Set(String::New("height"), Integer::New((int) ceil(device[3]) + 1 - y));
+    return o;
 }
 
+////////////////////////// TEXT AND GLYPHS
+
 /**
- * @function cairo.context_append_path
+ * @function cairo.context_select_font_face
  * 
  * ### Synopsis
  * 
- * cairo.context_append_path(context, path);
+ * cairo.context_select_font_face(context, family, slant, weight);
  * 
- * Append the path onto the current path.
+ * Selects a family and style of font from a simplified description as a family name, slant and weight. 
  * 
- * The path may be either the return value from one of cairo.context_copy_path() or cairo.context_copy_path_flat()
+ * Cairo provides no operation to list available family names on the system (this is a "toy", remember), but the standard CSS2 generic family names, ("serif", "sans-serif", "cursive", "fantasy", "monospace"), are likely to work as expected.
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {object} path - opaque handle to a cairo path
- */
-static JSVAL context_append_path(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_path_t *path = (cairo_path_t *)JSEXTERN(args[1]);
-    cairo_append_path(context, path);
-    return Undefined();
-}
-
-/**
- * @functino cairo.path_destroy
+ * If family starts with the string "cairo:", or if no native font backends are compiled in, cairo will use an internal font family. The internal font family recognizes many modifiers in the family string, most notably, it recognizes the string "monospace". That is, the family name "cairo:monospace" will use the monospace version of the internal font family.
  * 
- * ### Synopsis
+ * For "real" font selection, see the font-backend-specific font_face_create functions for the font backend you are using. (For example, if you are using the freetype-based cairo-ft font backend, see cairo.ft_font_face_create_for_ft_face() or cairo.ft_font_face_create_for_pattern().) The resulting font face could then be used with cairo.scaled_font_create() and cairo.context_set_scaled_font().
  * 
- * cairo.path_dstroy(path);
+ * Similarly, when using the "real" font support, you can call directly into the underlying font system, (such as fontconfig or freetype), for operations such as listing available fonts, etc.
  * 
- * Immediately releases all memory associated with path. 
+ * It is expected that most applications will need to use a more comprehensive font handling and text layout library, (for example, pango), in conjunction with cairo.
  * 
- * After a call to cairo.path_destroy() the path pointer is no longer valid and should not be used further.
+ * If text is drawn without a call to cairo.context_select_font_face(), (nor cairo.context_set_font_face() nor cairo.context_set_scaled_font()), the default family is platform-specific, but is essentially "sans-serif". Default slant is cairo.FONT_SLANT_NORMAL, and default weight is cairo.FONT_WEIGHT_NORMAL.
  * 
- * @param {object} path - opaque handle to a cairo path
- */
-static JSVAL path_destroy(JSARGS args) {
-    cairo_path_t *path = (cairo_path_t *)JSEXTERN(args[0]);
-    cairo_path_destroy(path);
-    return Undefined();
-}
-
-/**
- * @function cairo.context_has_current_point
+ * This function is equivalent to a call to cairo_toy_font_face_create() followed by cairo.context_set_font_face().
  * 
- * ### Synopsis
+ * Note: The cairo_select_font_face() function call is part of what the cairo designers call the "toy" text API. It is convenient for short demos and simple programs, but it is not expected to be adequate for serious text-using applications.
  * 
- * var hasPoint = cairo.context_has_current_point(context);
+ * The slant argument may be one of:
  * 
- * Returns whether a current point is defined on the current path. 
+ * + cairo.FONT_SLANT_NORMAL - Upright font style
+ * + cairo.FONT_SLANT_ITALIC - Italic font style
+ * + cairo.FONT_SLANT_OBLIQUE - Oblique font style
  * 
- * See cairo.context_get_current_point() for details on the current point.
+ * The weight argument may be one of:
+ * 
+ * + cairo.FONT_WEIGHT_NORMAL - Normal font weight.
+ * + cairo.FONT_WEIGHT_BOLD - Bold font weight.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {boolean} hasPoint - true if a current point is defined.
+ * @param {string} family - font family name.
+ * @param {int} slant - the slant for the font.
+ * @param {int} weight - the font weight for the font.
  */
-static JSVAL context_has_current_point(JSARGS args) {
+static JSVAL context_select_font_face(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return cairo_has_current_point(context) ? True() : False();
+    String::Utf8Value family(args[1]->ToString());
+    Command *command = record_command(context, COMMAND_SELECT_FONT_FACE, args, 0);
+    if (command) {
+        command->args[0] = args[2]->IntegerValue();
+        command->args[1] = args[3]->IntegerValue();
+        command->data = strdup(*family);
+    }
+    cairo_select_font_face(context, *family, (cairo_font_slant_t)args[2]->IntegerValue(), (cairo_font_weight_t)args[3]->IntegerValue());
+    return Undefined();
 }
 
 /**
- * @function cairo.context_get_current_point
+ * @function cairo.context_set_font_size
  * 
  * ### Synopsis
  * 
- * var point = cairo.context_get_current_point(context);
- * 
- * Gets the current point of the current path, which is conceptually the final point reached by the path so far.
- * 
- * The current point is returned in the user-space coordinate system. If there is no defined current point or if context is in an error status, x and y will both be set to 0.0. It is possible to check this in advance with cairo.context_has_current_point().
- * 
- * Most path construction functions alter the current point. 
- * 
- * See the following for details on how they affect the current point: cairo.context_new_path(), cairo.context_new_sub_path(), cairo.context_append_path(), cairo.context_close_path(), cairo.context_move_to(), cairo.context_line_to(), cairo.context_curve_to(), cairo.context_rel_move_to(), cairo.context_rel_line_to(), cairo.context_rel_curve_to(), cairo.context_arc(), cairo.context_arc_negative(), cairo.context_rectangle(), cairo.context_text_path(), cairo.context_glyph_path(), cairo_stroke_to_path().
- * 
- * Some functions use and alter the current point but do not otherwise change current path: cairo.context_show_text().
+ * cairo.context_set_font_size(context, size);
  * 
- * Some functions unset the current path and as a result, current point: cairo.context_fill(), cairo.context_stroke().
+ * Sets the current font matrix to a scale by a factor of size, replacing any font matrix previously set with cairo.context_set_font_size() or cairo.context_set_font_matrix(). 
  * 
- * The object returned has just two members:
+ * This results in a font size of size user space units. (More precisely, this matrix will result in the font's em-square being a size by size square in user space.)
  * 
- * + {number} x: x coordinate of the current point
- * + {number} y: y coordinate of the current point
+ * If text is drawn without a call to cairo.context_set_font_size(), (nor cairo.context_set_font_matrix() nor cairo.context_set_scaled_font()), the default font size is 10.0.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} point - object of the form described above.
+ * @param {number} size - the new font size, in user space units.
  */
-static JSVAL context_get_current_point(JSARGS args) {
+static JSVAL context_set_font_size(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    double x,y;
-    
-    cairo_get_current_point(context, &x, &y);
-    JSOBJ o = Object::New();
-    o->Set(String::New("x"), Number::New(x));
-    o->Set(String::New("y"), Number::New(y));
-    return o;
+    record_command(context, COMMAND_SET_FONT_SIZE, args, 1);
+    cairo_set_font_size(context, args[1]->NumberValue());
+    return Undefined();
 }
 
 /**
- * @function cairo.context_new_path
+ * @function cairo.context_set_font_matrix
  * 
  * ### Synopsis
  * 
- * cairo.context_new_path(context);
+ * cairo.context_set_font_matrix(context, matrix);
  * 
- * Clears the current path. After this call there will be no path and no current point.
+ * Sets the current font matrix to matrix. The font matrix gives a transformation from the design space of the font (in this space, the em-square is 1 unit by 1 unit) to user space. 
+ * 
+ * Normally, a simple scale is used (see cairo_set_font_size()), but a more complex font matrix can be used to shear the font or stretch it unequally along the two axes.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {object} matrix - opaque handle to a cairo matrix.
  */
-static JSVAL context_new_path(JSARGS args) {
+static JSVAL context_set_font_matrix(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_new_path(context);
+    if (command_list_for(context)) {
+        return not_recordable("context_set_font_matrix");
+    }
+    cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[1]);
+    cairo_set_font_matrix(context, matrix);
     return Undefined();
 }
 
 /**
- * @function cairo.context_new_sub_path
+ * @function cairo.context_get_font_matrix
  * 
  * ### Synopsis
  * 
- * cairo.context_new_sub_path(context);
- * 
- * Begin a new sub-path. 
- * 
- * Note that the existing path is not affected. After this call there will be no current point.
+ * var matrix = cairo.context_get_font_matrix(context);
  * 
- * In many cases, this call is not needed since new sub-paths are frequently started with cairo.context_move_to().
+ * Gets the current font matrix.
  * 
- * A call to cairo.context_new_sub_path() is particularly useful when beginning a new sub-path with one of the cairo.context_arc() calls. This makes things easier as it is no longer necessary to manually compute the arc's initial coordinates for a call to cairo.context_move_to().
+ * The matrix returned is owned by the caller and must be released by calling cairo.matrix_destroy() when it is no longer needed.
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @return {object} matrix - opaque handle to a cairo matrix.
  */
-static JSVAL context_new_sub_path(JSARGS args) {
+static JSVAL context_get_font_matrix(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_new_sub_path(context);
-    return Undefined();
+    cairo_matrix_t *matrix = matrix_new();
+    cairo_get_font_matrix(context, matrix);
+    return External::New(matrix);
 }
 
 /**
- * @function cairo.context_close_path
+ * @function cairo.context_set_font_options
  * 
  * ### Synopsis
  * 
- * cairo.context_close_path(context);
+ * cairo.context_set_font_options(context, options);
  * 
- * Adds a line segment to the path from the current point to the beginning of the current sub-path, (the most recent point passed to cairo.context_move_to()), and closes this sub-path. After this call the current point will be at the joined endpoint of the sub-path.
+ * Sets a set of custom font rendering options for the context. 
  * 
- * The behavior of cairo.context_close_path() is distinct from simply calling cairo.context_line_to() with the equivalent coordinate in the case of stroking. When a closed sub-path is stroked, there are no caps on the ends of the sub-path. Instead, there is a line join connecting the final and initial segments of the sub-path.
+ * Rendering options are derived by merging these options with the options derived from underlying surface; if the value in options has a default value (like cairo.ANTIALIAS_DEFAULT), then the value from the surface is used.
  * 
- * If there is no current point before the call to cairo.context_close_path(), this function will have no effect.
+ * See font_options methods for creating the font options object.
  * 
- * Note: As of cairo version 1.2.4 any call to cairo.context_close_path() will place an explicit MOVE_TO element into the path immediately after the CLOSE_PATH element, (which can be seen in cairo.context_copy_path() for example). This can simplify path processing in some cases as it may not be necessary to save the "last move_to point" during processing as the MOVE_TO immediately after the CLOSE_PATH will provide that point.
+ * The options object is an opaque structure holding all options that are used when rendering fonts.
+ * 
+ * Individual features of a cairo font_options object can be set or accessed using functions named cairo.font_options_set_feature_name() and cairo.font_options_get_feature_name(), like cairo.font_options_set_antialias() and cairo.font_options_get_antialias().
+ * 
+ * New features may be added to a cairo font_options object in the future. For this reason, cairo.font_options_copy(), cairo.font_options_equal(), cairo.font_options_merge(), and cairo.font_options_hash() should be used to copy, check for equality, merge, or compute a hash value of cairo font_options objects. 
  * 
  * @param {object} context - opaque handle to a cairo context.
+ * @param {object} options - opaque handle to a cairo font options object.
  */
-static JSVAL context_close_path(JSARGS args) {
+static JSVAL context_set_font_options(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_close_path(context);
+    if (command_list_for(context)) {
+        return not_recordable("context_set_font_options");
+    }
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[1]);
+    cairo_set_font_options(context, options);
     return Undefined();
 }
 
 /**
- * @function cairo.context_arc
+ * @function cairo.context_get_font_options
  * 
  * ### Synopsis
  * 
- * cairo.context_arc(context, xc,yc, radius, angle1, angle2);
- * 
- * Adds a circular arc of the given radius to the current path. 
- * 
- * The arc is centered at (xc, yc), begins at angle1 and proceeds in the direction of increasing angles to end at angle2. If angle2 is less than angle1 it will be progressively increased by 2*M_PI until it is greater than angle1.
+ * var options = cairo.context_get_font_options(context);
  * 
- * If there is a current point, an initial line segment will be added to the path to connect the current point to the beginning of the arc. If this initial line is undesired, it can be avoided by calling cairo.context__new_sub_path() before calling cairo.context_arc().
+ * Retrieves font rendering options set via cairo.context_set_font_options. 
  * 
- * Angles are measured in radians. An angle of 0.0 is in the direction of the positive X axis (in user space). An angle of M_PI/2.0 radians (90 degrees) is in the direction of the positive Y axis (in user space). Angles increase in the direction from the positive X axis toward the positive Y axis. So with the default transformation matrix, angles increase in a clockwise direction.
+ * Note that the returned options do not include any options derived from the underlying surface; they are literally the options passed to cairo.context_set_font_options().
  * 
- * (To convert from degrees to radians, use degrees * (M_PI / 180.).)
+ * The caller owns the returned opaque handle to the font options.  It must be freed by calling cairo.font_options_destroy().
  * 
- * This function gives the arc in the direction of increasing angles; see cairo.context_arc_negative() to get the arc in the direction of decreasing angles.
+ * The options object is an opaque structure holding all options that are used when rendering fonts.
  * 
- * The arc is circular in user space. To achieve an elliptical arc, you can scale the current transformation matrix by different amounts in the X and Y directions. For example, to draw an ellipse in the box given by x, y, width, height:
+ * Individual features of a cairo font_options object can be set or accessed using functions named cairo.font_options_set_feature_name() and cairo.font_options_get_feature_name(), like cairo.font_options_set_antialias() and cairo.font_options_get_antialias().
  * 
- * ```
- * cairo_save (context);
- * cairo_translate (context, x + width / 2., y + height / 2.);
- * cairo_scale (context, width / 2., height / 2.);
- * cairo_arc (context, 0., 0., 1., 0., 2 * M_PI);
- * cairo_restore (context);
- * ```
+ * New features may be added to a cairo font_options object in the future. For this reason, cairo.font_options_copy(), cairo.font_options_equal(), cairo.font_options_merge(), and cairo.font_options_hash() should be used to copy, check for equality, merge, or compute a hash value of cairo font_options objects. 
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} xc - x coordinate of the center of the arc.
- * @param {number} yc - y coordinate of the center of the arc.
- * @param {number} radius - radius of the arc.
- * @param {number} angle1 - start angle in radians.
- * @param {number} angle2 - end angle in radians.
+ * @return {object} options - opaque handle to a cairo font options object.
  */
-static JSVAL context_arc(JSARGS args) {
+static JSVAL context_get_font_options(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_arc(context,
-              args[1]->NumberValue(),   // xc
-              args[2]->NumberValue(),   // yc
-              args[3]->NumberValue(),   // radius
-              args[4]->NumberValue(),   // angle1
-              args[5]->NumberValue()   // angle2
-    );
-    return Undefined();
+    cairo_font_options_t *options = track_font_options(cairo_font_options_create());
+    cairo_get_font_options(context, options);
+    return External::New(options);
 }
 
 /**
- * @function cairo.context_arc_negative
+ * @function cairo.context_set_font_face
  * 
  * ### Synopsis
  * 
- * cairo.context_arc_negative(context, xc,yc, radius, angle1, angle2);
+ * cairo.context_set_font_face(context, face);
  * 
- * Adds a circular arc of the given radius to the current path. 
+ * Replaces the current cairo_font_face_t object in the cairo_t with font_face. 
  * 
- * The arc is centered at (xc, yc), begins at angle1 and proceeds in the direction of decreasing angles to end at angle2. If angle2 is greater than angle1 it will be progressively decreased by 2*M_PI until it is less than angle1.
+ * The replaced font face in the context will be destroyed if there are no other references to it.
  * 
- * See cairo.context_arc() for more details. This function differs only in the direction of the arc between the two angles.
+ * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {number} xc - x coordinate of the center of the arc.
- * @param {number} yc - y coordinate of the center of the arc.
- * @param {number} radius - radius of the arc.
- * @param {number} angle1 - start angle in radians.
- * @param {number} angle2 - end angle in radians.
+ * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
+ * 
+ * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
+ * 
+ * See also the font_face methods.
+ * 
+ * @param {object} context - opaque handle to a cairo context.
+ * @param {object} face - opaque handle to a cairo font face object.
  */
-static JSVAL context_arc_negative(JSARGS args) {
+static JSVAL context_set_font_face(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_arc_negative(context,
-              args[1]->NumberValue(),   // xc
-              args[2]->NumberValue(),   // yc
-              args[3]->NumberValue(),   // radius
-              args[4]->NumberValue(),   // angle1
-              args[5]->NumberValue()   // angle2
-    );
+    if (command_list_for(context)) {
+        return not_recordable("context_set_font_face");
+    }
+    cairo_font_face_t *face = (cairo_font_face_t *)JSEXTERN(args[1]);
+    cairo_set_font_face(context, face);
     return Undefined();
 }
 
 /**
- * @function cairo.context_curve_to
+ * @function cairo.context_get_font_face
  * 
  * ### Synopsis
  * 
- * cairo.context_curve_to(context, x1,y1, x2,y2, x3,y3);
+ * var font_face = cairo.context_get_font_face(context);
  * 
- * Adds a cubic Bézier spline to the path from the current point to position (x3, y3) in user-space coordinates, using (x1, y1) and (x2, y2) as the control points. 
+ * Gets the current font face for a context.
  * 
- * After this call the current point will be (x3, y3).
+ * The returned object is owned by cairo. To keep a reference to it, you must call cairo.font_face_reference(). 
  * 
- * If there is no current point before the call to cairo_curve_to() this function will behave as if preceded by a call to cairo.context_move_to(cr, x1, y1).
+ * This function never returns NULL. 
+ * 
+ * If memory cannot be allocated, a special "nil" font face object will be returned on which cairo.font_face_status() returns cairo.STATUS_NO_MEMORY. 
+ * 
+ * Using this nil object will cause its error state to propagate to other objects it is passed to, (for example, calling cairo.context_set_font_face() with a nil font will trigger an error that will shutdown the context object).
+ * 
+ * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
+ * 
+ * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
+ * 
+ * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
+ * 
+ * See also the font_face methods.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} x1 - x coordinate of the first control point.
- * @param {number} y1 - y coordinate of the first control point.
- * @param {number} x2 - x coordinate of the second control point.
- * @param {number} y2 - y coordinate of the second control point.
- * @param {number} x3 - x coordinate of the third control point.
- * @param {number} y3 - y coordinate of the third control point.
+ * @return {object} font_face  - opaque handle to a cairo font face object.
  */
-static JSVAL context_curve_to(JSARGS args) {
+static JSVAL context_get_font_face(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_curve_to(context,
-              args[1]->NumberValue(),   // x1
-              args[2]->NumberValue(),   // y1
-              args[3]->NumberValue(),   // x2
-              args[4]->NumberValue(),   // y2
-              args[5]->NumberValue(),   // x3
-              args[6]->NumberValue()   // y3
-    );
-    return Undefined();
+    return External::New(cairo_get_font_face(context));
 }
 
 /**
- * @function cairo.context_line_to
+ * @function cairo.context_set_scaled_font
  * 
  * ### Synopsis
  * 
- * cairo.context_line_to(context, x,y);
+ * cairo.context_set_scaled_font(context, scaled_font);
  * 
- * Adds a line to the path from the current point to position (x, y) in user-space coordinates. 
+ * Replaces the current font face, font matrix, and font options in the context with those of the scaled_font. 
  * 
- * After this call the current point will be (x, y).
+ * Except for some translation, the current CTM of the context should be the same as that of the scaled_font, which can be accessed using cairo.scaled_font_get_ctm().
  * 
- * If there is no current point before the call to cairo.context_line_to() this function will behave as cairo.context_move_to(context, x, y).
+ * A cairo scaled_font is a font scaled to a particular size and device resolution. A cairo scaled_font is most useful for low-level font usage where a library or application wants to cache a reference to a scaled font to speed up the computation of metrics.
+ * 
+ * There are various types of scaled fonts, depending on the font backend they use. The type of a scaled font can be queried using cairo.scaled_font_get_type().
+ * 
+ * Memory management of cairo scaled_font is done with cairo.scaled_font_reference() and cairo.scaled_font_destroy().
+ * 
+ * See also the scaled_font methods.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} x - x coordinate of the end of the new line.
- * @param {number} y - y coordinate of the end of the new line.
+ * @param {object} scaled_font - opaque handle to a cairo scaled font object.
  */
-static JSVAL context_line_to(JSARGS args) {
+static JSVAL context_set_scaled_font(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_line_to(context,
-              args[1]->NumberValue(),   // x
-              args[2]->NumberValue()   // y
-    );
+    if (command_list_for(context)) {
+        return not_recordable("context_set_scaled_font");
+    }
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[1]);
+    cairo_set_scaled_font(context, scaled_font);
     return Undefined();
 }
 
 /**
- * @function cairo.context_move_to
+ * @function cairo.context_get_scaled_font
  * 
  * ### Synopsis
  * 
- * cairo.context_move_to(context, x,y);
+ * var scaled_font = cairo.context_get_scaled_font(context);
  * 
- * Adds a line to the path from the current point to position (x, y) in user-space coordinates. 
+ * Gets the current scaled font for a context.
  * 
- * After this call the current point will be (x, y).
+ * The returned object is owned by cairo. To keep a reference to it, you must call cairo.scaled_font_reference(). 
  * 
- * If there is no current point before the call to cairo.context_line_to() this function will behave as cairo.context_move_to(context, x, y).
+ * This function never returns NULL. 
+ * 
+ * If memory cannot be allocated, a special "nil" scaled font object will be returned on which cairo.scaled_font_status() returns cairo.STATUS_NO_MEMORY. 
+ * 
+ * Using this nil object will cause its error state to propagate to other objects it is passed to, (for example, calling cairo.context_set_scaled_font() with a nil font will trigger an error that will shutdown the context object).
+ * 
+ * A cairo scaled_font is a font scaled to a particular size and device resolution. A cairo scaled_font is most useful for low-level font usage where a library or application wants to cache a reference to a scaled font to speed up the computation of metrics.
+ * 
+ * There are various types of scaled fonts, depending on the font backend they use. The type of a scaled font can be queried using cairo.scaled_font_get_type().
+ * 
+ * Memory management of cairo scaled_font is done with cairo.scaled_font_reference() and cairo.scaled_font_destroy().
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} x - x coordinate of the end of the new position.
- * @param {number} y - y coordinate of the end of the new position.
+ * @return {object} scaled_font  - opaque handle to a cairo scaled font object.
  */
-static JSVAL context_move_to(JSARGS args) {
+static JSVAL context_get_scaled_font(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    
-    cairo_move_to(context,
-              args[1]->NumberValue(),   // x
-              args[2]->NumberValue()   // y
-    );
-    return Undefined();
+    return External::New(cairo_get_scaled_font(context));
 }
 
 /**
- * @function cairo.context_rectangle
+ * @function cairo.context_show_text
  * 
  * ### Synopsis
  * 
- * cairo.context_rectangle(context, x,y, w,h);
+ * cairo.context_show_text(context, text);
  * 
- * Adds a closed sub-path rectangle of the given size to the current path at position (x, y) in user-space coordinates.
+ * A drawing operator that generates the shape from a string of UTF-8 characters, rendered according to the current font_face, font_size (font_matrix), and font_options.
  * 
- * This is logically equivalent to:
+ * This function first computes a set of glyphs for the string of text. The first glyph is placed so that its origin is at the current point. The origin of each subsequent glyph is offset from that of the previous glyph by the advance values of the previous glyph.
+ * 
+ * After this call the current point is moved to the origin of where the next glyph would be placed in this same progression. That is, the current point will be at the origin of the final glyph offset by its advance values. This allows for easy display of a single logical string with multiple calls to cairo.context_show_text().
+ * 
+ * Note: The cairo.context_show_text() function call is part of what the cairo designers call the "toy" text API. It is convenient for short demos and simple programs, but it is not expected to be adequate for serious text-using applications. See cairo.context_show_glyphs() for the "real" text display API in cairo.
  * 
- * ```
- * cairo_move_to context, x, y);
- * cairo_rel_line_to (context, width, 0);
- * cairo_rel_line_to context, 0, height);
- * cairo_rel_line_to (context, -width, 0);
- * cairo_close_path (context);
- * ```
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} x - x coordinate of the top left corner of the rectangle.
- * @param {number} y - y coordinate of the top left corner of the rectangle.
- * @param {number} w - width of the rectangle.
- * @param {number} h - height of the rectangle.
+ * @param {string} text - text to render.
  */
-static JSVAL context_rectangle(JSARGS args) {
+static JSVAL context_show_text(JSARGS args) {
+    MetricsTimer timer(METRICS_TEXT, "show_text");
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    
-    cairo_rectangle(context,
-              args[1]->NumberValue(),  // x
-              args[2]->NumberValue(),  // y
-              args[3]->NumberValue(),  // w
-              args[4]->NumberValue()   // h
-    );
+    String::Utf8Value text(args[1]->ToString());
+    timer.arg("text", *text);
+    Command *command = record_draw(context, COMMAND_SHOW_TEXT, 0);
+    if (command) {
+        command->data = strdup(*text);
+        advance_past_text(context, *text);
+        return Undefined();
+    }
+    cairo_show_text(context, *text);
     return Undefined();
 }
 
 /**
- * @function cairo.context_glyph_path
+ * @function cairo.context_show_glyphs
  * 
  * ### Synopsis
  * 
- * cairo.context_glyph_path(context, glyphs);
- * 
- * Adds closed paths for the glyphs to the current path. 
+ * cairo.context_show_glyphs(context, glyphs);
  * 
- * The generated path if filled, achieves an effect similar to that of cairo.context_show_glyphs().
+ * A drawing operator that generates the shape from an array of glyphs, rendered according to the current font face, font size (font matrix), and font options.
  * 
  * The glyphs argument is an array of objects of the following form:
  * 
@@ -2899,8 +7376,11 @@ static JSVAL context_rectangle(JSARGS args) {
  * @param {object} context - opaque handle to a cairo context.
  * @param {array} glyphs - array of objects as described above.
  */
-static JSVAL context_glyph_path(JSARGS args) {
+static JSVAL context_show_glyphs(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+    if (command_list_for(context)) {
+        return not_recordable("context_show_glyphs");
+    }
     Handle<Array>glyphs = Handle<Array>::Cast(args[1]->ToObject());
     int num_glyphs = glyphs->Length();
     cairo_glyph_t *c_glyphs = new cairo_glyph_t[num_glyphs];
@@ -2915,197 +7395,273 @@ static JSVAL context_glyph_path(JSARGS args) {
         c_glyphs[i].x = o->Get(x)->NumberValue();
         c_glyphs[i].y = o->Get(y)->NumberValue();
     }
-    cairo_glyph_path(context, c_glyphs, num_glyphs);
-    delete [] c_glyphs;
+    cairo_show_glyphs(context, c_glyphs, num_glyphs);
+    delete c_glyphs;
     return Undefined();
 }
 
 /**
- * @function cairo.context_text_path
+ * @function cairo.context_show_text_glyphs
  * 
  * ### Synopsis
  * 
- * cairo.context_text_path(context, str);
- * 
- * Adds closed paths for text to the current path. 
- * 
- * The generated path if filled, achieves an effect similar to that of cairo.context__show_text().
- * 
- * Text conversion and positioning is done similar to cairo.context_show_text().
+ * cairo.context_show_text_glyphs(context, text, glyphs, clusters, cluster_flags);
  * 
- * Like cairo.context_show_text(), After this call the current point is moved to the origin of where the next glyph would be placed in this same progression. That is, the current point will be at the origin of the final glyph offset by its advance values. This allows for chaining multiple calls to to cairo.context_text_path() without having to set current point in between.
+ * This operation has rendering effects similar to cairo.context_show_glyphs() but, if the target surface supports it, uses the provided text and cluster mapping to embed the text for the glyphs shown in the output. 
  * 
- * Note: The cairo.context_text_path() function call is part of what the cairo designers call the "toy" text API. It is convenient for short demos and simple programs, but it is not expected to be adequate for serious text-using applications. See cairo.context_glyph_path() for the "real" text path API in cairo.
+ * If the target does not support the extended attributes, this function acts like the basic cairo.context_show_glyphs() as if it had been passed glyphs.
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {string} str - text
- */
-static JSVAL context_text_path(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    String::Utf8Value str(args[1]->ToString());
-    cairo_text_path(context, *str);
-    return Undefined();
-}
-
-/**
- * @function cairo.context_rel_curve_to
+ * The mapping between text and glyphs is provided by an array of clusters. Each cluster covers a number of text bytes and glyphs, and neighboring clusters cover neighboring areas of text and glyphs. The clusters should collectively cover text and glyphs in entirety.
  * 
- * ### Synopsis
+ * The first cluster always covers bytes from the beginning of text. If cluster_flags do not have the cairo.TEXT_CLUSTER_FLAG_BACKWARD set, the first cluster also covers the beginning of glyphs, otherwise it covers the end of the glyphs array and following clusters move backward.
  * 
- * cairo.context_rel_curve_to(context, dx1,dy1, dx2,dy2, dx3,dy3);
+ * The glyphs argument is an array of objects of the following form:
  * 
- * Relative-coordinate version of cairo.context_curve_to(). 
+ * + {int} index - glyph index in the font.  The exact interpretation of the glyph index depends on the font technology being used.
+ * + {number} x - the offset in the x direction between the origin used for drawing or measuring the string and the origin of this glyph.
+ * + {number} y - the offset in the y direction between the origin used for drawing or measuring the string and the origin of this glyph.
  * 
- * All offsets are relative to the current point. Adds a cubic Bézier spline to the path from the current point to a point offset from the current point by (dx3, dy3), using points offset by (dx1, dy1) and (dx2, dy2) as the control points. After this call the current point will be offset by (dx3, dy3).
+ * The above structure holds information about a single glyph when drawing or measuring text. A font is (in simple terms) a collection of shapes used to draw text. A glyph is one of these shapes. There can be multiple glyphs for a single character (alternates to be used in different contexts, for example), or a glyph can be a ligature of multiple characters. Cairo doesn't expose any way of converting input text into glyphs, so in order to use the Cairo interfaces that take arrays of glyphs, you must directly access the appropriate underlying font system.
  * 
- * Given a current point of (x, y), cairo.context_rel_curve_to(context, dx1, dy1, dx2, dy2, dx3, dy3) is logically equivalent to cairo.context_curve_to(context, x+dx1, y+dy1, x+dx2, y+dy2, x+dx3, y+dy3).
+ * Note that the offsets given by x and y are not cumulative. When drawing or measuring text, each glyph is individually positioned with respect to the overall origin
  * 
- * It is an error to call this function with no current point. Doing so will cause context to shutdown with a status of cairo.STATUS_NO_CURRENT_POINT.
+ * The clusters argument is an array of objects of the following form:
+ * + {int} num_bytes - the number of bytes of UTF-8 text covered by this cluster.
+ * + {int} num_glyphs - the number of glyphs covered by this cluster.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} dx1 - x offset to the first control point.
- * @param {number} dy1 - y offset to the first control point.
- * @param {number} dx2 - x offset to the second control point.
- * @param {number} dy2 - y offset to the second control point.
- * @param {number} dx3 - x offset to the third control point.
- * @param {number} dy3 - y offset to the third control point.
+ * @param {string} text - a string of text encoded in UTF-8.
+ * @param {array} glyphs - array of glyph objects, described above.
+ * @param {array} clusters - array of objects, cluster mapping information as described above.
+ * @param {int} cluster_flags - currently 0 or cairo.TEXT_CLUSTER_FLAG_BACKWARD.
  */
-static JSVAL context_rel_curve_to(JSARGS args) {
+static JSVAL context_show_text_glyphs(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_rel_curve_to(context,
-              args[1]->NumberValue(),   // dx1
-              args[2]->NumberValue(),   // dy1
-              args[3]->NumberValue(),   // dx2
-              args[4]->NumberValue(),   // dy2
-              args[5]->NumberValue(),   // dx3
-              args[6]->NumberValue()    // dy3
-    );
+    if (command_list_for(context)) {
+        return not_recordable("context_show_text_glyphs");
+    }
+    String::Utf8Value text(args[1]->ToString());
+    Handle<Array>glyphs = Handle<Array>::Cast(args[2]->ToObject());
+    int num_glyphs = glyphs->Length();
+    cairo_glyph_t *c_glyphs = new cairo_glyph_t[num_glyphs];
+    // 
+    Local<String>index = String::New("index");
+    Local<String>_x = String::New("x");
+    Local<String>_y = String::New("y");
+    
+    for (int i=0; i<num_glyphs; i++) {
+        JSOBJ o = glyphs->Get(i)->ToObject();
+        c_glyphs[i].index = o->Get(index)->IntegerValue();
+        c_glyphs[i].x = o->Get(_x)->NumberValue();
+        c_glyphs[i].y = o->Get(_y)->NumberValue();
+    }
+    
+    Handle<Array>clusters = Handle<Array>::Cast(args[3]->ToObject());
+    int num_clusters = clusters->Length();
+    cairo_text_cluster_t *c_clusters = new cairo_text_cluster_t[num_clusters];
+    Local<String>_num_bytes = String::New("num_bytes");
+    Local<String>_num_glyphs = String::New("num_glyphs");
+    for (int i=0; i<num_clusters; i++) {
+        JSOBJ o = clusters->Get(i)->ToObject();
+        c_clusters[i].num_bytes = o->Get(_num_bytes)->NumberValue();
+        c_clusters[i].num_glyphs = o->Get(_num_glyphs)->NumberValue();
+    }
+    cairo_show_text_glyphs(context, *text, -1, c_glyphs, num_glyphs, c_clusters, num_clusters, (cairo_text_cluster_flags_t)args[4]->IntegerValue());
+    delete c_clusters;
+    delete c_glyphs;
     return Undefined();
 }
 
 /**
- * @function cairo.context_rel_line_to
+ * @function cairo.context_font_extents
  * 
  * ### Synopsis
  * 
- * cairo.context_rel_line_to(context, dx,dy);
+ * var extents = cairo.context_font_extents(context);
+ * var out = cairo.context_font_extents(context, out);
  * 
- * Relative-coordinate version of cairo.context__line_to(). 
+ * Gets the font extents for the currently selected font.
  * 
- * Adds a line to the path from the current point to a point that is offset from the current point by (dx, dy) in user space. After this call the current point will be offset by (dx, dy).
+ * The object returned has the following members:
  * 
- * Given a current point of (x, y), cairo.context_rel_line_to(context, dx, dy) is logically equivalent to cairo.context_line_to(context, x + dx, y + dy).
+ * + {number} ascent - the distance that the font extends above the baseline. Note that this is not always exactly equal to the maximum of the extents of all the glyphs in the font, but rather is picked to express the font designer's intent as to how the font should align with elements above it.
+ * + {number} descent - the distance that the font extends below the baseline. This value is positive for typical fonts that include portions below the baseline. Note that this is not always exactly equal to the maximum of the extents of all the glyphs in the font, but rather is picked to express the font designer's intent as to how the font should align with elements below it.
+ * + {number} height - the recommended vertical distance between baselines when setting consecutive lines of text with the font. This is greater than ascent+descent by a quantity known as the line spacing or external leading. When space is at a premium, most fonts can be set with only a distance of ascent+descent between lines.
+ * + {number} max_x_advance - the maximum distance in the X direction that the origin is advanced for any glyph in the font.
+ * + {number} max_y_advance - the maximum distance in the Y direction that the origin is advanced for any glyph in the font. This will be zero for normal fonts used for horizontal writing. (The scripts of East Asia are sometimes written vertically.)
  * 
- * It is an error to call this function with no current point. Doing so will cause context to shutdown with a status of cairo.STATUS_NO_CURRENT_POINT.
+ * If the optional out argument is given, it must be a Float64Array of at least 5 elements.  The extents are written to it as [ascent, descent, height, max_x_advance, max_y_advance] and out is returned.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} dx - x offset to the end of the new line.
- * @param {number} dy - y offset to the end of the new line.
+ * @param {Float64Array} out - optional array to receive the extents.
+ * @return {object} extents - object as described above.
  */
-static JSVAL context_rel_line_to(JSARGS args) {
+static JSVAL context_font_extents(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_rel_line_to(context,
-              args[1]->NumberValue(),   // dx
-              args[2]->NumberValue()    // dy
-    );
-    return Undefined();
+    cairo_font_extents_t extents;
+    cairo_font_extents(context, &extents);
+    if (args.Length() > 1) {
+        double *out = float64_array_data(args[1], 5);
+        if (out == NULL) {
+            return throw_bad_out_array("context_font_extents", 5);
+        }
+        out[0] = extents.ascent;
+        out[1] = extents.descent;
+        out[2] = extents.height;
+        out[3] = extents.max_x_advance;
+        out[4] = extents.max_y_advance;
+        return args[1];
+    }
+    JSOBJ o = Object::New();
+    o->Set(String::New("ascent"), Number::New(extents.ascent));
+    o->Set(String::New("descent"), Number::New(extents.descent));
+    o->Set(String::New("height"), Number::New(extents.height));
+    o->Set(String::New("max_x_advance"), Number::New(extents.max_x_advance));
+    o->Set(String::New("max_y_advance"), Number::New(extents.max_y_advance));
+    return o;
 }
 
 /**
- * @function cairo.context_rel_move_to
+ * @function cairo.context_text_extents
  * 
  * ### Synopsis
  * 
- * cairo.context_rel_move_to(context, dx,dy);
+ * var extents = cairo.context_text_extents(context, text);
+ * var out = cairo.context_text_extents(context, text, out);
  * 
- * Begin a new sub-path. 
+ * Gets the extents for a string of text. The extents describe a user-space rectangle that encloses the "inked" portion of the text, (as it would be drawn by cairo.context_show_text()). 
  * 
- * After this call the current point will offset by (x, y).
+ * Additionally, the x_advance and y_advance values indicate the amount by which the current point would be advanced by cairo.context_show_text().
  * 
- * Given a current point of (x, y), cairo.context_rel_move_to(context, dx, dy) is logically equivalent to cairo.context_move_to(context, x + dx, y + dy).
+ * Note that whitespace characters do not directly contribute to the size of the rectangle (extents.width and extents.height). They do contribute indirectly by changing the position of non-whitespace characters. In particular, trailing whitespace characters are likely to not affect the size of the rectangle, though they will affect the x_advance and y_advance values.
  * 
- * It is an error to call this function with no current point. Doing so will cause context to shutdown with a status of cairo.STATUS_NO_CURRENT_POINT.
+ * The object returned has the following members:
+ * 
+ * + {number} x_bearing - the horizontal distance from the origin to the leftmost part of the glyphs as drawn. Positive if the glyphs lie entirely to the right of the origin.
+ * + {number} y_bearing - the vertical distance from the origin to the topmost part of the glyphs as drawn. Positive only if the glyphs lie completely below the origin; will usually be negative.
+ * + {number} width - width of the glyphs as drawn.
+ * + {number} height - height of the glyphs as drawn.
+ * + {number} x_advance - distance to advance in the X direction after drawing these glyphs.
+ * + {number} y_advance - distance to advance in the Y direction after drawing these glyphs. Will typically be zero except for vertical text layout as found in East-Asian languages.
+ * 
+ * If the optional out argument is given, it must be a Float64Array of at least 6 elements.  The extents are written to it as [x_bearing, y_bearing, width, height, x_advance, y_advance] and out is returned.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @param {number} dx - x offset to the end of the new position.
- * @param {number} dy - y offset to the end of the new position.
+ * @param {string} text - a strng of text encoded in UTF8.
+ * @param {Float64Array} out - optional array to receive the extents.
+ * @return {object} extents - object as described above.
  */
-static JSVAL context_rel_move_to(JSARGS args) {
+static JSVAL context_text_extents(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    
-    cairo_rel_move_to(context,
-              args[1]->NumberValue(),   // dx
-              args[2]->NumberValue()    // dy
-    );
-    return Undefined();
+    String::Utf8Value text(args[1]->ToString());
+    cairo_text_extents_t extents;
+    cairo_text_extents(context, *text, &extents);
+    if (args.Length() > 2) {
+        double *out = float64_array_data(args[2], 6);
+        if (out == NULL) {
+            return throw_bad_out_array("context_text_extents", 6);
+        }
+        out[0] = extents.x_bearing;
+        out[1] = extents.y_bearing;
+        out[2] = extents.width;
+        out[3] = extents.height;
+        out[4] = extents.x_advance;
+        out[5] = extents.y_advance;
+        return args[2];
+    }
+    JSOBJ o = Object::New();
+    o->Set(String::New("x_bearing"), Number::New(extents.x_bearing));
+    o->Set(String::New("y_bearing"), Number::New(extents.y_bearing));
+    o->Set(String::New("width"), Number::New(extents.width));
+    o->Set(String::New("height"), Number::New(extents.height));
+    o->Set(String::New("x_advance"), Number::New(extents.x_advance));
+    o->Set(String::New("y_advance"), Number::New(extents.y_advance));
+    return o;
 }
 
 /**
- * @function cairo.context_path_extents
+ * @function cairo.context_glyph_extents
  * 
  * ### Synopsis
  * 
- * var extents = cairo.context_path_extents(context);
+ * var extents = cairo.context_glyph_extents(context, glyphs);
  * 
- * Computes a bounding box in user-space coordinates covering the points on the current path. 
+ * Gets the extents for an array of glyphs. 
  * 
- * If the current path is empty, returns an empty rectangle ((0,0), (0,0)). Stroke parameters, fill rule, surface dimensions and clipping are not taken into account.
+ * The extents describe a user-space rectangle that encloses the "inked" portion of the glyphs, (as they would be drawn by cairo.context_show_glyphs()). 
  * 
- * Contrast with cairo.context_fill_extents() and cairo.context_stroke_extents() which return the extents of only the area that would be "inked" by the corresponding drawing operations.
+ * Additionally, the x_advance and y_advance values indicate the amount by which the current point would be advanced by cairo.context_show_glyphs().
  * 
- * The result of cairo.context_path_extents() is defined as equivalent to the limit of cairo.context_stroke_extents() with cairo.LINE_CAP_ROUND as the line width approaches 0.0, (but never reaching the empty-rectangle returned by cairo.context_stroke_extents() for a line width of 0.0).
+ * Note that whitespace glyphs do not contribute to the size of the rectangle (extents.width and extents.height).
  * 
- * Specifically, this means that zero-area sub-paths such as cairo.context_move_to(); cairo.context_line_to() segments, (even degenerate cases where the coordinates to both calls are identical), will be considered as contributing to the extents. However, a lone cairo.context_move_to() will not contribute to the results of cairo.context_path_extents().
+ * The glyphs argument is an array of objects of the following form:
+ * 
+ * + {int} index - glyph index in the font.  The exact interpretation of the glyph index depends on the font technology being used.
+ * + {number} x - the offset in the x direction between the origin used for drawing or measuring the string and the origin of this glyph.
+ * + {number} y - the offset in the y direction between the origin used for drawing or measuring the string and the origin of this glyph.
+ * 
+ * The above structure holds information about a single glyph when drawing or measuring text. A font is (in simple terms) a collection of shapes used to draw text. A glyph is one of these shapes. There can be multiple glyphs for a single character (alternates to be used in different contexts, for example), or a glyph can be a ligature of multiple characters. Cairo doesn't expose any way of converting input text into glyphs, so in order to use the Cairo interfaces that take arrays of glyphs, you must directly access the appropriate underlying font system.
+ * 
+ * Note that the offsets given by x and y are not cumulative. When drawing or measuring text, each glyph is individually positioned with respect to the overall origin
  * 
  * The object returned has the following members:
  * 
- * + x1: x coordinate of the top left corner of the resulting extents.
- * + y1: y coordinate of the top left corner of the resulting extents.
- * + x2: x coordinate of the lower right corner of the resulting extents.
- * + y2: y coordinate of the lower right corner of the resulting extents.
+ * + {number} x_bearing - the horizontal distance from the origin to the leftmost part of the glyphs as drawn. Positive if the glyphs lie entirely to the right of the origin.
+ * + {number} y_bearing - the vertical distance from the origin to the topmost part of the glyphs as drawn. Positive only if the glyphs lie completely below the origin; will usually be negative.
+ * + {number} width - width of the glyphs as drawn.
+ * + {number} height - height of the glyphs as drawn.
+ * + {number} x_advance - distance to advance in the X direction after drawing these glyphs.
+ * + {number} y_advance - distance to advance in the Y direction after drawing these glyphs. Will typically be zero except for vertical text layout as found in East-Asian languages.
  * 
  * @param {object} context - opaque handle to a cairo context.
- * @return {object} extents - see object description above.
+ * @param {array} glyphs - array of objects as described above.
+ * @return {object} extents - object as described above.
  */
-static JSVAL context_path_extents(JSARGS args) {
+static JSVAL context_glyph_extents(JSARGS args) {
     cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    double x1,y1, x2,y2;
-    cairo_path_extents(context, &x1,&y1, &x2,&y2);
+    Handle<Array>glyphs = Handle<Array>::Cast(args[2]->ToObject());
+    int num_glyphs = glyphs->Length();
+    cairo_glyph_t *c_glyphs = new cairo_glyph_t[num_glyphs];
+    // 
+    Local<String>index = String::New("index");
+    Local<String>_x = String::New("x");
+    Local<String>_y = String::New("y");
+    
+    for (int i=0; i<num_glyphs; i++) {
+        JSOBJ o = glyphs->Get(i)->ToObject();
+        c_glyphs[i].index = o->Get(index)->IntegerValue();
+        c_glyphs[i].x = o->Get(_x)->NumberValue();
+        c_glyphs[i].y = o->Get(_y)->NumberValue();
+    }
     
+    cairo_text_extents_t extents;
+    cairo_glyph_extents(context, c_glyphs, num_glyphs, &extents);
+    delete [] c_glyphs;
+
     JSOBJ o = Object::New();
-    o->Set(String::New("x1"), Number::New(x1));
-    o->Set(String::New("y1"), Number::New(y1));
-    o->Set(String::New("x2"), Number::New(x2));
-    o->Set(String::New("y2"), Number::New(y2));
+    o->Set(String::New("x_bearing"), Number::New(extents.x_bearing));
+    o->Set(String::New("y_bearing"), Number::New(extents.y_bearing));
+    o->Set(String::New("width"), Number::New(extents.width));
+    o->Set(String::New("height"), Number::New(extents.height));
+    o->Set(String::New("x_advance"), Number::New(extents.x_advance));
+    o->Set(String::New("y_advance"), Number::New(extents.y_advance));
     return o;
 }
 
-////////////////////////// TEXT AND GLYPHS
-
 /**
- * @function cairo.context_select_font_face
+ * @function cairo.toy_font_face_create
  * 
  * ### Synopsis
  * 
- * cairo.context_select_font_face(context, family, slant, weight);
- * 
- * Selects a family and style of font from a simplified description as a family name, slant and weight. 
- * 
- * Cairo provides no operation to list available family names on the system (this is a "toy", remember), but the standard CSS2 generic family names, ("serif", "sans-serif", "cursive", "fantasy", "monospace"), are likely to work as expected.
- * 
- * If family starts with the string "cairo:", or if no native font backends are compiled in, cairo will use an internal font family. The internal font family recognizes many modifiers in the family string, most notably, it recognizes the string "monospace". That is, the family name "cairo:monospace" will use the monospace version of the internal font family.
- * 
- * For "real" font selection, see the font-backend-specific font_face_create functions for the font backend you are using. (For example, if you are using the freetype-based cairo-ft font backend, see cairo.ft_font_face_create_for_ft_face() or cairo.ft_font_face_create_for_pattern().) The resulting font face could then be used with cairo.scaled_font_create() and cairo.context_set_scaled_font().
- * 
- * Similarly, when using the "real" font support, you can call directly into the underlying font system, (such as fontconfig or freetype), for operations such as listing available fonts, etc.
+ * var font_face = cairo.toy_font_face_create(family, slant, weight);
  * 
- * It is expected that most applications will need to use a more comprehensive font handling and text layout library, (for example, pango), in conjunction with cairo.
+ * Creates a font face from a triplet of family, slant, and weight. 
  * 
- * If text is drawn without a call to cairo.context_select_font_face(), (nor cairo.context_set_font_face() nor cairo.context_set_scaled_font()), the default family is platform-specific, but is essentially "sans-serif". Default slant is cairo.FONT_SLANT_NORMAL, and default weight is cairo.FONT_WEIGHT_NORMAL.
+ * These font faces are used in implementation of the the cairo_t "toy" font API.
  * 
- * This function is equivalent to a call to cairo_toy_font_face_create() followed by cairo.context_set_font_face().
+ * If family is the zero-length string "", the platform-specific default family is assumed. The default family then can be queried using cairo.toy_font_face_get_family().
  * 
- * Note: The cairo_select_font_face() function call is part of what the cairo designers call the "toy" text API. It is convenient for short demos and simple programs, but it is not expected to be adequate for serious text-using applications.
+ * The cairo.context_select_font_face() function uses this to create font faces. See that function for limitations and other details of toy font faces.
  * 
  * The slant argument may be one of:
  * 
@@ -3118,407 +7674,364 @@ static JSVAL context_path_extents(JSARGS args) {
  * + cairo.FONT_WEIGHT_NORMAL - Normal font weight.
  * + cairo.FONT_WEIGHT_BOLD - Bold font weight.
  * 
- * @param {object} context - opaque handle to a cairo context.
+ * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
+ * 
+ * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
+ * 
+ * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
+ * 
+ * See also the font_face methods.
+ * 
+ * AVAILABLE IN CAIRO 1.8 OR NEWER
+ * 
  * @param {string} family - font family name.
  * @param {int} slant - the slant for the font.
  * @param {int} weight - the font weight for the font.
+ * @return {object} font_face - opaque handle to a cairo font face object.
  */
-static JSVAL context_select_font_face(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    String::Utf8Value family(args[1]->ToString());
-    cairo_select_font_face(context, *family, (cairo_font_slant_t)args[2]->IntegerValue(), (cairo_font_weight_t)args[3]->IntegerValue());
-    return Undefined();
+#if CAIRO_VERSION_MINOR >= 8
+static JSVAL toy_font_face_create(JSARGS args) {
+    String::Utf8Value family(args[0]->ToString());
+    cairo_font_face_t *font_face = cairo_toy_font_face_create(*family, (cairo_font_slant_t)args[1]->IntegerValue(), (cairo_font_weight_t)args[2]->IntegerValue());
+    return External::New(track_font_face(font_face));
 }
+#endif
 
 /**
- * @function cairo.context_set_font_size
+ * @function cairo.toy_font_face_get_family
  * 
  * ### Synopsis
  * 
- * cairo.context_set_font_size(context, size);
+ * var family = cairo.toy_font_face_get_family(font_face);
  * 
- * Sets the current font matrix to a scale by a factor of size, replacing any font matrix previously set with cairo.context_set_font_size() or cairo.context_set_font_matrix(). 
+ * Gets the family name of a toy font.
  * 
- * This results in a font size of size user space units. (More precisely, this matrix will result in the font's em-square being a size by size square in user space.)
+ * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
  * 
- * If text is drawn without a call to cairo.context_set_font_size(), (nor cairo.context_set_font_matrix() nor cairo.context_set_scaled_font()), the default font size is 10.0.
+ * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {number} size - the new font size, in user space units.
+ * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
+ * 
+ * See also the font_face methods.
+ * 
+ * AVAILABLE IN CAIRO 1.8 OR NEWER
+ * 
+ * @param {object} font_face - opaque handle to a cairo font face object.
+ * @return {string} family - The family name.
  */
-static JSVAL context_set_font_size(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_set_font_size(context, args[1]->NumberValue());
-    return Undefined();
+#if CAIRO_VERSION_MINOR >= 8
+static JSVAL toy_font_face_get_family(JSARGS args) {
+    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
+    return String::New(cairo_toy_font_face_get_family(font_face));
 }
+#endif
 
 /**
- * @function cairo.context_set_font_matrix
+ * @function cairo.toy_font_face_get_slant
  * 
  * ### Synopsis
  * 
- * cairo.context_set_font_matrix(context, matrix);
+ * var slant = cairo.toy_font_face_get_slant(font_face);
  * 
- * Sets the current font matrix to matrix. The font matrix gives a transformation from the design space of the font (in this space, the em-square is 1 unit by 1 unit) to user space. 
+ * Gets the slant of a toy font.
  * 
- * Normally, a simple scale is used (see cairo_set_font_size()), but a more complex font matrix can be used to shear the font or stretch it unequally along the two axes.
+ * The slant returned may be one of:
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {object} matrix - opaque handle to a cairo matrix.
- */
-static JSVAL context_set_font_matrix(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[1]);
-    cairo_set_font_matrix(context, matrix);
-    return Undefined();
-}
-
-/**
- * @function cairo.context_get_font_matrix
+ * + cairo.FONT_SLANT_NORMAL - Upright font style
+ * + cairo.FONT_SLANT_ITALIC - Italic font style
+ * + cairo.FONT_SLANT_OBLIQUE - Oblique font style
  * 
- * ### Synopsis
+ * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
+ * 
+ * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
  * 
- * var matrix = cairo.context_get_font_matrix(context);
+ * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
  * 
- * Gets the current font matrix.
+ * See also the font_face methods.
  * 
- * The matrix returned is owned by the caller and must be released by calling cairo.matrix_destroy() when it is no longer needed.
+ * AVAILABLE IN CAIRO 1.8 OR NEWER
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @return {object} matrix - opaque handle to a cairo matrix.
+ * @param {object} font_face - opaque handle to a cairo font face object.
+ * @return {int} slant - The family name.
  */
-static JSVAL context_get_font_matrix(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_matrix_t *matrix = new cairo_matrix_t;
-    cairo_get_font_matrix(context, matrix);
-    return External::New(matrix);
+#if CAIRO_VERSION_MINOR >= 8
+static JSVAL toy_font_face_get_slant(JSARGS args) {
+    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_toy_font_face_get_slant(font_face));
 }
+#endif
 
 /**
- * @function cairo.context_set_font_options
+ * @function cairo.toy_font_face_get_weight
  * 
  * ### Synopsis
  * 
- * cairo.context_set_font_options(context, options);
+ * var weight = cairo.toy_font_face_get_weight(font_face);
  * 
- * Sets a set of custom font rendering options for the context. 
+ * Gets the slant of a toy font.
  * 
- * Rendering options are derived by merging these options with the options derived from underlying surface; if the value in options has a default value (like cairo.ANTIALIAS_DEFAULT), then the value from the surface is used.
+ * The weight returned may be one of:
  * 
- * See font_options methods for creating the font options object.
+ * + cairo.FONT_WEIGHT_NORMAL - Normal font weight.
+ * + cairo.FONT_WEIGHT_BOLD - Bold font weight.
  * 
- * The options object is an opaque structure holding all options that are used when rendering fonts.
+ * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
  * 
- * Individual features of a cairo font_options object can be set or accessed using functions named cairo.font_options_set_feature_name() and cairo.font_options_get_feature_name(), like cairo.font_options_set_antialias() and cairo.font_options_get_antialias().
+ * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
  * 
- * New features may be added to a cairo font_options object in the future. For this reason, cairo.font_options_copy(), cairo.font_options_equal(), cairo.font_options_merge(), and cairo.font_options_hash() should be used to copy, check for equality, merge, or compute a hash value of cairo font_options objects. 
+ * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {object} options - opaque handle to a cairo font options object.
+ * See also the font_face methods.
+ * 
+ * AVAILABLE IN CAIRO 1.8 OR NEWER
+ * 
+ * @param {object} font_face - opaque handle to a cairo font face object.
+ * @return {int} weight - font weight.
  */
-static JSVAL context_set_font_options(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[1]);
-    cairo_set_font_options(context, options);
-    return Undefined();
+#if CAIRO_VERSION_MINOR >= 8
+static JSVAL toy_font_face_get_weight(JSARGS args) {
+    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_toy_font_face_get_weight(font_face));
 }
+#endif
+
+////////////////////////// FONT FACES
 
 /**
- * @function cairo.context_get_font_options
+ * @function cairo.font_face_reference
  * 
  * ### Synopsis
  * 
- * var options = cairo.context_get_font_options(context);
- * 
- * Retrieves font rendering options set via cairo.context_set_font_options. 
- * 
- * Note that the returned options do not include any options derived from the underlying surface; they are literally the options passed to cairo.context_set_font_options().
- * 
- * The caller owns the returned opaque handle to the font options.  It must be freed by calling cairo.font_options_destroy().
+ * var font_face = cairo.font_face_reference(font_face);
  * 
- * The options object is an opaque structure holding all options that are used when rendering fonts.
+ * Increases the reference count on font_face by one. 
  * 
- * Individual features of a cairo font_options object can be set or accessed using functions named cairo.font_options_set_feature_name() and cairo.font_options_get_feature_name(), like cairo.font_options_set_antialias() and cairo.font_options_get_antialias().
+ * This prevents font_face from being destroyed until a matching call to cairo.font_face_destroy() is made.
  * 
- * New features may be added to a cairo font_options object in the future. For this reason, cairo.font_options_copy(), cairo.font_options_equal(), cairo.font_options_merge(), and cairo.font_options_hash() should be used to copy, check for equality, merge, or compute a hash value of cairo font_options objects. 
+ * The number of references to a cairo font_face can be get using cairo.font_face_get_reference_count().
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @return {object} options - opaque handle to a cairo font options object.
+ * @param {object} font_face - opaque handle to a cairo font face object.
+ * @return {object} font_face - opaque handle to the referenced cairo font face object.
  */
-static JSVAL context_get_font_options(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_font_options_t *options = cairo_font_options_create();
-    cairo_get_font_options(context, options);
-    return External::New(options);
+static JSVAL font_face_reference(JSARGS args) {
+    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
+    return External::New(cairo_font_face_reference(font_face));
 }
 
 /**
- * @function cairo.context_set_font_face
+ * @function cairo.font_face_destroy
  * 
  * ### Synopsis
  * 
- * cairo.context_set_font_face(context, face);
+ * cairo.font_face_destroy(font_face);
  * 
- * Replaces the current cairo_font_face_t object in the cairo_t with font_face. 
+ * Decreases the reference count on font_face by one. 
  * 
- * The replaced font face in the context will be destroyed if there are no other references to it.
+ * If the result is zero, then font_face and all associated resources are freed. See cairo.font_face_reference().
  * 
- * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
+ * @param {object} font_face - opaque handle to a cairo font face object.
+ */
+static JSVAL font_face_destroy(JSARGS args) {
+    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
+    cairo_font_face_destroy(font_face);
+    return Undefined();
+}
+
+/**
+ * @function cairo.font_face_status
  * 
- * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
+ * ### Synopsis
  * 
- * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
+ * var status = cairo.font_face_status(font_face);
  * 
- * See also the font_face methods.
+ * Checks whether an error has previously occurred for this font face
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {object} face - opaque handle to a cairo font face object.
+ * @param {object} font_face - opaque handle to a cairo font face object.
+ * @return {int} status - cairo.STATUS_SUCCESS or another error such as cairo.STATUS_NO_MEMORY.
  */
-static JSVAL context_set_font_face(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_font_face_t *face = (cairo_font_face_t *)JSEXTERN(args[1]);
-    cairo_set_font_face(context, face);
-    return Undefined();
+static JSVAL font_face_status(JSARGS args) {
+    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_font_face_status(font_face));
 }
 
 /**
- * @function cairo.context_get_font_face
+ * @function cairo.font_face_get_type
  * 
  * ### Synopsis
  * 
- * var font_face = cairo.context_get_font_face(context);
+ * var type = cairo.font_face_get_type(font_face);
  * 
- * Gets the current font face for a context.
+ * This function returns the type of the backend used to create a font face.
  * 
- * The returned object is owned by cairo. To keep a reference to it, you must call cairo.font_face_reference(). 
+ * The font types are also known as "font backends" within cairo.
  * 
- * This function never returns NULL. 
+ * The type of a font face is determined by the function used to create it, which will generally be of the form cairo.type_font_face_create(). The font face type can be queried with cairo.font_face_get_type()
  * 
- * If memory cannot be allocated, a special "nil" font face object will be returned on which cairo.font_face_status() returns cairo.STATUS_NO_MEMORY. 
+ * The various cairo font_face functions can be used with a font face of any type.
  * 
- * Using this nil object will cause its error state to propagate to other objects it is passed to, (for example, calling cairo.context_set_font_face() with a nil font will trigger an error that will shutdown the context object).
+ * The type of a scaled font is determined by the type of the font face passed to cairo.scaled_font_create(). The scaled font type can be queried with cairo.scaled_font_get_type().
  * 
- * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
+ * The various cairo scaled_font functions can be used with scaled fonts of any type, but some font backends also provide type-specific functions that must only be called with a scaled font of the appropriate type. These functions have names that begin with cairo.type_scaled_font() such as cairo.ft_scaled_font_lock_face().
  * 
- * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
+ * The behavior of calling a type-specific function with a scaled font of the wrong type is undefined.
  * 
- * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
+ * New entries may be added in future versions.
  * 
- * See also the font_face methods.
+ * cairo.FONT_TYPE_TOY - The font was created using cairo's toy font API (Since: 1.2).
+ * cairo.FONT_TYPE_FT - The font is of type FreeType (Since: 1.2).
+ * cairo.FONT_TYPE_WIN32 - The font is of type Win32 (Since: 1.2).
+ * cairo.FONT_TYPE_QUARTZ - The font is of type Quartz (Since: 1.6, in 1.2 and 1.4 it was named cairo.FONT_TYPE_ATSUI).
+ * cairo.FONT_TYPE_ATSUI - The font is of type Quartz (since 1.2, backward compatibility for cairo.FONT_TYPE_ATSUI).
+ * cairo.FONT_TYPE_USER - The font was create using cairo's user font API (Since: 1.8).
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @return {object} font_face  - opaque handle to a cairo font face object.
+ * @param {object} font_face - opaque handle to a cairo font face object.
+ * @return {int} type - one of the above types.
  */
-static JSVAL context_get_font_face(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return External::New(cairo_get_font_face(context));
+static JSVAL font_face_get_type(JSARGS args) {
+    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_font_face_get_type(font_face));
 }
 
 /**
- * @function cairo.context_set_scaled_font
+ * @function cairo.font_face_get_reference_count
  * 
  * ### Synopsis
  * 
- * cairo.context_set_scaled_font(context, scaled_font);
- * 
- * Replaces the current font face, font matrix, and font options in the context with those of the scaled_font. 
- * 
- * Except for some translation, the current CTM of the context should be the same as that of the scaled_font, which can be accessed using cairo.scaled_font_get_ctm().
- * 
- * A cairo scaled_font is a font scaled to a particular size and device resolution. A cairo scaled_font is most useful for low-level font usage where a library or application wants to cache a reference to a scaled font to speed up the computation of metrics.
- * 
- * There are various types of scaled fonts, depending on the font backend they use. The type of a scaled font can be queried using cairo.scaled_font_get_type().
- * 
- * Memory management of cairo scaled_font is done with cairo.scaled_font_reference() and cairo.scaled_font_destroy().
+ * var count = cairo.font_face_get_reference_count(font_face);
  * 
- * See also the scaled_font methods.
+ * Get the current reference count of font_face.
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {object} scaled_font - opaque handle to a cairo scaled font object.
+ * @param {object} font_face - opaque handle to a cairo font face object.
+ * @return {int} count - current reference count of font_face.  If a nil font_face, 0 will be returned.
  */
-static JSVAL context_set_scaled_font(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[1]);
-    cairo_set_scaled_font(context, scaled_font);
-    return Undefined();
+static JSVAL font_face_get_reference_count(JSARGS args) {
+    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_font_face_get_reference_count(font_face));
 }
 
+////////////////////////// SCALED FONTS
+
 /**
- * @function cairo.context_get_scaled_font
+ * @function cairo.scaled_font_create
  * 
  * ### Synopsis
  * 
- * var scaled_font = cairo.context_get_scaled_font(context);
+ * var scaled_font = cairo.scaled_font_create(font_face, font_matrix, ctm, options);
  * 
- * Gets the current scaled font for a context.
+ * Create a cairo scaled_font object from a font_face and matrices that describe the size of the font and the environment in which it will be used.
  * 
- * The returned object is owned by cairo. To keep a reference to it, you must call cairo.scaled_font_reference(). 
+ * A cairo scaled_font is a font scaled to a particular size and device resolution. A cairo scaled_font is most useful for low-level font usage where a library or application wants to cache a reference to a scaled font to speed up the computation of metrics.
  * 
- * This function never returns NULL. 
+ * There are various types of scaled fonts, depending on the font backend they use. The type of a scaled font can be queried using cairo.scaled_font_get_type().
  * 
- * If memory cannot be allocated, a special "nil" scaled font object will be returned on which cairo.scaled_font_status() returns cairo.STATUS_NO_MEMORY. 
+ * Memory management of cairo scaled_font is done with cairo.scaled_font_reference() and cairo.scaled_font_destroy().
  * 
- * Using this nil object will cause its error state to propagate to other objects it is passed to, (for example, calling cairo.context_set_scaled_font() with a nil font will trigger an error that will shutdown the context object).
+ * The font_matrix argument is a font space to user space transformation matrix for the font. In the simplest case of a N point font, this matrix is just a scale by N, but it can also be used to shear the font or stretch it unequally along the two axes. See cairo.context_set_font_matrix().
  * 
- * A cairo scaled_font is a font scaled to a particular size and device resolution. A cairo scaled_font is most useful for low-level font usage where a library or application wants to cache a reference to a scaled font to speed up the computation of metrics.
+ * The options object is an opaque structure holding all options that are used when rendering fonts.
  * 
- * There are various types of scaled fonts, depending on the font backend they use. The type of a scaled font can be queried using cairo.scaled_font_get_type().
+ * Individual features of a cairo font_options object can be set or accessed using functions named cairo.font_options_set_feature_name() and cairo.font_options_get_feature_name(), like cairo.font_options_set_antialias() and cairo.font_options_get_antialias().
  * 
- * Memory management of cairo scaled_font is done with cairo.scaled_font_reference() and cairo.scaled_font_destroy().
+ * New features may be added to a cairo font_options object in the future. For this reason, cairo.font_options_copy(), cairo.font_options_equal(), cairo.font_options_merge(), and cairo.font_options_hash() should be used to copy, check for equality, merge, or compute a hash value of cairo font_options objects. 
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @return {object} scaled_font  - opaque handle to a cairo scaled font object.
+ * @param {object} font_face - opaque handle to a cairo font face object.
+ * @param {object} font_matrix - opaque handle to a cairo matrix, described above.
+ * @param {object} ctm - opaque handle to a cairo matrix; user to device transformation matrix with which the font will be used.
+ * @param {object} options - opaque handle to a cairo font options object.
+ * @return {object} scaled_font - opaque handle to a scaled font.
  */
-static JSVAL context_get_scaled_font(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    return External::New(cairo_get_scaled_font(context));
+static JSVAL scaled_font_create(JSARGS args) {
+    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
+    cairo_matrix_t *font_matrix = (cairo_matrix_t *) JSEXTERN(args[1]);
+    cairo_matrix_t *ctm = (cairo_matrix_t *) JSEXTERN(args[2]);
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[3]);
+    return External::New(track_scaled_font(cairo_scaled_font_create(font_face, font_matrix, ctm, options)));
 }
 
 /**
- * @function cairo.context_show_text
+ * @function cairo.scaled_font_reference
  * 
  * ### Synopsis
  * 
- * cairo.context_show_text(context, text);
- * 
- * A drawing operator that generates the shape from a string of UTF-8 characters, rendered according to the current font_face, font_size (font_matrix), and font_options.
+ * cairo.scaled_font_reference(scaled_font);
  * 
- * This function first computes a set of glyphs for the string of text. The first glyph is placed so that its origin is at the current point. The origin of each subsequent glyph is offset from that of the previous glyph by the advance values of the previous glyph.
+ * Increases the reference count on scaled_font by one. 
  * 
- * After this call the current point is moved to the origin of where the next glyph would be placed in this same progression. That is, the current point will be at the origin of the final glyph offset by its advance values. This allows for easy display of a single logical string with multiple calls to cairo.context_show_text().
+ * This prevents scaled_font from being destroyed until a matching call to cairo.scaled_font_destroy() is made.
  * 
- * Note: The cairo.context_show_text() function call is part of what the cairo designers call the "toy" text API. It is convenient for short demos and simple programs, but it is not expected to be adequate for serious text-using applications. See cairo.context_show_glyphs() for the "real" text display API in cairo.
+ * The number of references to a scaled_font can be get using cairo.scaled_font_get_reference_count().
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {string} text - text to render.
+ * @param {object} scaled_font - opaque handle to a scaled font.
+ * @return {object} scaled_font - opaque handle to referenced scaled font.
  */
-static JSVAL context_show_text(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    String::Utf8Value text(args[1]->ToString());
-    cairo_show_text(context, *text);
-    return Undefined();
+static JSVAL scaled_font_reference(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
+    return External::New(cairo_scaled_font_reference(scaled_font));
 }
 
 /**
- * @function cairo.context_show_glyphs
- * 
- * ### Synopsis
- * 
- * cairo.context_show_glyphs(context, glyphs);
- * 
- * A drawing operator that generates the shape from an array of glyphs, rendered according to the current font face, font size (font matrix), and font options.
+ * @function cairo.scaled_font_destroy
  * 
- * The glyphs argument is an array of objects of the following form:
+ * ### Synopsis
  * 
- * + {int} index - glyph index in the font.  The exact interpretation of the glyph index depends on the font technology being used.
- * + {number} x - the offset in the x direction between the origin used for drawing or measuring the string and the origin of this glyph.
- * + {number} y - the offset in the y direction between the origin used for drawing or measuring the string and the origin of this glyph.
+ * cairo.scaled_font_destroy(scaled_font);
  * 
- * The above structure holds information about a single glyph when drawing or measuring text. A font is (in simple terms) a collection of shapes used to draw text. A glyph is one of these shapes. There can be multiple glyphs for a single character (alternates to be used in different contexts, for example), or a glyph can be a ligature of multiple characters. Cairo doesn't expose any way of converting input text into glyphs, so in order to use the Cairo interfaces that take arrays of glyphs, you must directly access the appropriate underlying font system.
+ * Decreases the reference count on scaled_font by one. 
  * 
- * Note that the offsets given by x and y are not cumulative. When drawing or measuring text, each glyph is individually positioned with respect to the overall origin
+ * If the result is zero, then scaled_font and all associated resources are freed. See cairo.scaled_font_reference().
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {array} glyphs - array of objects as described above.
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
  */
-static JSVAL context_show_glyphs(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    Handle<Array>glyphs = Handle<Array>::Cast(args[1]->ToObject());
-    int num_glyphs = glyphs->Length();
-    cairo_glyph_t *c_glyphs = new cairo_glyph_t[num_glyphs];
-    // 
-    Local<String>index = String::New("index");
-    Local<String>x = String::New("x");
-    Local<String>y = String::New("y");
-    
-    for (int i=0; i<num_glyphs; i++) {
-        JSOBJ o = glyphs->Get(i)->ToObject();
-        c_glyphs[i].index = o->Get(index)->IntegerValue();
-        c_glyphs[i].x = o->Get(x)->NumberValue();
-        c_glyphs[i].y = o->Get(y)->NumberValue();
-    }
-    cairo_show_glyphs(context, c_glyphs, num_glyphs);
-    delete c_glyphs;
+static JSVAL scaled_font_destroy(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
+    cairo_scaled_font_destroy(scaled_font);
     return Undefined();
 }
 
 /**
- * @function cairo.context_show_text_glyphs
+ * @function cairo.scaled_font_get_reference_count
  * 
  * ### Synopsis
  * 
- * cairo.context_show_text_glyphs(context, text, glyphs, clusters, cluster_flags);
- * 
- * This operation has rendering effects similar to cairo.context_show_glyphs() but, if the target surface supports it, uses the provided text and cluster mapping to embed the text for the glyphs shown in the output. 
- * 
- * If the target does not support the extended attributes, this function acts like the basic cairo.context_show_glyphs() as if it had been passed glyphs.
- * 
- * The mapping between text and glyphs is provided by an array of clusters. Each cluster covers a number of text bytes and glyphs, and neighboring clusters cover neighboring areas of text and glyphs. The clusters should collectively cover text and glyphs in entirety.
- * 
- * The first cluster always covers bytes from the beginning of text. If cluster_flags do not have the cairo.TEXT_CLUSTER_FLAG_BACKWARD set, the first cluster also covers the beginning of glyphs, otherwise it covers the end of the glyphs array and following clusters move backward.
+ * var count = cairo.scaled_font_get_reference_count(scaled_font);
  * 
- * The glyphs argument is an array of objects of the following form:
+ * Get the current reference count of scaled_font.
  * 
- * + {int} index - glyph index in the font.  The exact interpretation of the glyph index depends on the font technology being used.
- * + {number} x - the offset in the x direction between the origin used for drawing or measuring the string and the origin of this glyph.
- * + {number} y - the offset in the y direction between the origin used for drawing or measuring the string and the origin of this glyph.
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
+ * @return {int} count - current reference count of scaled_font.  If a nil scaled_font, 0 will be returned.
+ */
+#if CAIRO_VERSION_MINOR >= 4
+static JSVAL scaled_font_get_reference_count(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_scaled_font_get_reference_count(scaled_font));
+}
+#endif
+
+/**
+ * @function cairo.scaled_font_status
  * 
- * The above structure holds information about a single glyph when drawing or measuring text. A font is (in simple terms) a collection of shapes used to draw text. A glyph is one of these shapes. There can be multiple glyphs for a single character (alternates to be used in different contexts, for example), or a glyph can be a ligature of multiple characters. Cairo doesn't expose any way of converting input text into glyphs, so in order to use the Cairo interfaces that take arrays of glyphs, you must directly access the appropriate underlying font system.
+ * ### Synopsis
  * 
- * Note that the offsets given by x and y are not cumulative. When drawing or measuring text, each glyph is individually positioned with respect to the overall origin
+ * var status = cairo.scaled_font_status(scaled_font);
  * 
- * The clusters argument is an array of objects of the following form:
- * + {int} num_bytes - the number of bytes of UTF-8 text covered by this cluster.
- * + {int} num_glyphs - the number of glyphs covered by this cluster.
+ * Checks whether an error has previously occurred for this scaled_font.
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {string} text - a string of text encoded in UTF-8.
- * @param {array} glyphs - array of glyph objects, described above.
- * @param {array} clusters - array of objects, cluster mapping information as described above.
- * @param {int} cluster_flags - currently 0 or cairo.TEXT_CLUSTER_FLAG_BACKWARD.
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
+ * @return {int} status - cairo.STATUS_SUCCESS or another error such as cairo.STATUS_NO_MEMORY.
  */
-static JSVAL context_show_text_glyphs(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
-    String::Utf8Value text(args[1]->ToString());
-    Handle<Array>glyphs = Handle<Array>::Cast(args[2]->ToObject());
-    int num_glyphs = glyphs->Length();
-    cairo_glyph_t *c_glyphs = new cairo_glyph_t[num_glyphs];
-    // 
-    Local<String>index = String::New("index");
-    Local<String>_x = String::New("x");
-    Local<String>_y = String::New("y");
-    
-    for (int i=0; i<num_glyphs; i++) {
-        JSOBJ o = glyphs->Get(i)->ToObject();
-        c_glyphs[i].index = o->Get(index)->IntegerValue();
-        c_glyphs[i].x = o->Get(_x)->NumberValue();
-        c_glyphs[i].y = o->Get(_y)->NumberValue();
-    }
-    
-    Handle<Array>clusters = Handle<Array>::Cast(args[3]->ToObject());
-    int num_clusters = clusters->Length();
-    cairo_text_cluster_t *c_clusters = new cairo_text_cluster_t[num_clusters];
-    Local<String>_num_bytes = String::New("num_bytes");
-    Local<String>_num_glyphs = String::New("num_glyphs");
-    for (int i=0; i<num_clusters; i++) {
-        JSOBJ o = clusters->Get(i)->ToObject();
-        c_clusters[i].num_bytes = o->Get(_num_bytes)->NumberValue();
-        c_clusters[i].num_glyphs = o->Get(_num_glyphs)->NumberValue();
-    }
-    cairo_show_text_glyphs(context, *text, -1, c_glyphs, num_glyphs, c_clusters, num_clusters, (cairo_text_cluster_flags_t)args[4]->IntegerValue());
-    delete c_clusters;
-    delete c_glyphs;
-    return Undefined();
+static JSVAL scaled_font_status(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_scaled_font_status(scaled_font));
 }
 
 /**
- * @function cairo.context_font_extents
+ * @function cairo.scaled_font_extents
  * 
  * ### Synopsis
  * 
- * var extents = cairo.context_font_extents(context);
+ * var extents = cairo.scaled_font_extents(scaled_font);
  * 
- * Gets the font extents for the currently selected font.
+ * Gets the font extents for scaled_font.
  * 
  * The object returned has the following members:
  * 
@@ -3528,13 +8041,13 @@ static JSVAL context_show_text_glyphs(JSARGS args) {
  * + {number} max_x_advance - the maximum distance in the X direction that the origin is advanced for any glyph in the font.
  * + {number} max_y_advance - the maximum distance in the Y direction that the origin is advanced for any glyph in the font. This will be zero for normal fonts used for horizontal writing. (The scripts of East Asia are sometimes written vertically.)
  * 
- * @param {object} context - opaque handle to a cairo context.
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
  * @return {object} extents - object as described above.
  */
-static JSVAL context_font_extents(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+static JSVAL scaled_font_extents(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
     cairo_font_extents_t extents;
-    cairo_font_extents(context, &extents);
+    cairo_scaled_font_extents(scaled_font, &extents);
     JSOBJ o = Object::New();
     o->Set(String::New("ascent"), Number::New(extents.ascent));
     o->Set(String::New("descent"), Number::New(extents.descent));
@@ -3545,11 +8058,11 @@ static JSVAL context_font_extents(JSARGS args) {
 }
 
 /**
- * @function cairo.context_text_extents
+ * @function cairo.scaled_font_text_extents
  * 
  * ### Synopsis
  * 
- * var extents = cairo.context_text_extents(context, text);
+ * var extents = cairo.scaled_font_text_extents(scaled_font, text);
  * 
  * Gets the extents for a string of text. The extents describe a user-space rectangle that encloses the "inked" portion of the text, (as it would be drawn by cairo.context_show_text()). 
  * 
@@ -3566,15 +8079,16 @@ static JSVAL context_font_extents(JSARGS args) {
  * + {number} x_advance - distance to advance in the X direction after drawing these glyphs.
  * + {number} y_advance - distance to advance in the Y direction after drawing these glyphs. Will typically be zero except for vertical text layout as found in East-Asian languages.
  * 
- * @param {object} context - opaque handle to a cairo context.
- * @param {string} text - a strng of text encoded in UTF8.
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
+ * @param {string} text - a stirng of text encoded in UTF8.
  * @return {object} extents - object as described above.
  */
-static JSVAL context_text_extents(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+#if CAIRO_VERSION_MINOR >= 2
+static JSVAL scaled_font_text_extents(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
     String::Utf8Value text(args[1]->ToString());
     cairo_text_extents_t extents;
-    cairo_text_extents(context, *text, &extents);
+    cairo_scaled_font_text_extents(scaled_font, *text, &extents);
     JSOBJ o = Object::New();
     o->Set(String::New("x_bearing"), Number::New(extents.x_bearing));
     o->Set(String::New("y_bearing"), Number::New(extents.y_bearing));
@@ -3584,13 +8098,14 @@ static JSVAL context_text_extents(JSARGS args) {
     o->Set(String::New("y_advance"), Number::New(extents.y_advance));
     return o;
 }
+#endif
 
 /**
- * @function cairo.context_glyph_extents
+ * @function cairo.scaled_font_glyph_extents
  * 
  * ### Synopsis
  * 
- * var extents = cairo.context_glyph_extents(context, glyphs);
+ * var extents = cairo.scaled_font_glyph_extents(scaled_font, glyphs);
  * 
  * Gets the extents for an array of glyphs. 
  * 
@@ -3619,12 +8134,12 @@ static JSVAL context_text_extents(JSARGS args) {
  * + {number} x_advance - distance to advance in the X direction after drawing these glyphs.
  * + {number} y_advance - distance to advance in the Y direction after drawing these glyphs. Will typically be zero except for vertical text layout as found in East-Asian languages.
  * 
- * @param {object} context - opaque handle to a cairo context.
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font.
  * @param {array} glyphs - array of objects as described above.
  * @return {object} extents - object as described above.
  */
-static JSVAL context_glyph_extents(JSARGS args) {
-    cairo_t *context = (cairo_t *) JSEXTERN(args[0]);
+static JSVAL scaled_font_glyph_extents(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
     Handle<Array>glyphs = Handle<Array>::Cast(args[2]->ToObject());
     int num_glyphs = glyphs->Length();
     cairo_glyph_t *c_glyphs = new cairo_glyph_t[num_glyphs];
@@ -3641,7 +8156,7 @@ static JSVAL context_glyph_extents(JSARGS args) {
     }
     
     cairo_text_extents_t extents;
-    cairo_glyph_extents(context, c_glyphs, num_glyphs, &extents);
+    cairo_scaled_font_glyph_extents(scaled_font, c_glyphs, num_glyphs, &extents);
     delete [] c_glyphs;
 
     JSOBJ o = Object::New();
@@ -3655,219 +8170,138 @@ static JSVAL context_glyph_extents(JSARGS args) {
 }
 
 /**
- * @function cairo.toy_font_face_create
- * 
- * ### Synopsis
- * 
- * var font_face = cairo.toy_font_face_create(family, slant, weight);
- * 
- * Creates a font face from a triplet of family, slant, and weight. 
- * 
- * These font faces are used in implementation of the the cairo_t "toy" font API.
- * 
- * If family is the zero-length string "", the platform-specific default family is assumed. The default family then can be queried using cairo.toy_font_face_get_family().
- * 
- * The cairo.context_select_font_face() function uses this to create font faces. See that function for limitations and other details of toy font faces.
- * 
- * The slant argument may be one of:
- * 
- * + cairo.FONT_SLANT_NORMAL - Upright font style
- * + cairo.FONT_SLANT_ITALIC - Italic font style
- * + cairo.FONT_SLANT_OBLIQUE - Oblique font style
- * 
- * The weight argument may be one of:
- * 
- * + cairo.FONT_WEIGHT_NORMAL - Normal font weight.
- * + cairo.FONT_WEIGHT_BOLD - Bold font weight.
- * 
- * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
- * 
- * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
- * 
- * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
- * 
- * See also the font_face methods.
- * 
- * AVAILABLE IN CAIRO 1.8 OR NEWER
- * 
- * @param {string} family - font family name.
- * @param {int} slant - the slant for the font.
- * @param {int} weight - the font weight for the font.
- * @return {object} font_face - opaque handle to a cairo font face object.
- */
-#if CAIRO_VERSION_MINOR >= 8
-static JSVAL toy_font_face_create(JSARGS args) {
-    String::Utf8Value family(args[0]->ToString());
-    cairo_font_face_t *font_face = cairo_toy_font_face_create(*family, (cairo_font_slant_t)args[1]->IntegerValue(), (cairo_font_weight_t)args[2]->IntegerValue());
-    return External::New(font_face);
-}
-#endif
-
-/**
- * @function cairo.toy_font_face_get_family
- * 
- * ### Synopsis
- * 
- * var family = cairo.toy_font_face_get_family(font_face);
- * 
- * Gets the family name of a toy font.
- * 
- * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
- * 
- * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
- * 
- * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
- * 
- * See also the font_face methods.
- * 
- * AVAILABLE IN CAIRO 1.8 OR NEWER
- * 
- * @param {object} font_face - opaque handle to a cairo font face object.
- * @return {string} family - The family name.
- */
-#if CAIRO_VERSION_MINOR >= 8
-static JSVAL toy_font_face_get_family(JSARGS args) {
-    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
-    return String::New(cairo_toy_font_face_get_family(font_face));
-}
-#endif
-
-/**
- * @function cairo.toy_font_face_get_slant
+ * @function cairo.scaled_font_get_font_face
  * 
  * ### Synopsis
  * 
- * var slant = cairo.toy_font_face_get_slant(font_face);
- * 
- * Gets the slant of a toy font.
- * 
- * The slant returned may be one of:
- * 
- * + cairo.FONT_SLANT_NORMAL - Upright font style
- * + cairo.FONT_SLANT_ITALIC - Italic font style
- * + cairo.FONT_SLANT_OBLIQUE - Oblique font style
- * 
- * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
- * 
- * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
- * 
- * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
+ * var font_face = cairo.scaled_font_get_font_face(scaled_font);
  * 
- * See also the font_face methods.
+ * Gets the font face that this scaled font uses. 
  * 
- * AVAILABLE IN CAIRO 1.8 OR NEWER
+ * This might be the font face passed to cairo.scaled_font_create(), but this does not hold true for all possible cases.
  * 
- * @param {object} font_face - opaque handle to a cairo font face object.
- * @return {int} slant - The family name.
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font.
+ * @return {object} font_face  - opaque handle to a cairo font face object.
  */
-#if CAIRO_VERSION_MINOR >= 8
-static JSVAL toy_font_face_get_slant(JSARGS args) {
-    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_toy_font_face_get_slant(font_face));
+#if CAIRO_VERSION_MINOR >= 2
+static JSVAL scaled_font_get_font_face(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
+    return External::New(cairo_scaled_font_get_font_face(scaled_font));
 }
 #endif
 
 /**
- * @function cairo.toy_font_face_get_weight
+ * @function cairo.scaled_font_get_font_options
  * 
  * ### Synopsis
  * 
- * var weight = cairo.toy_font_face_get_weight(font_face);
- * 
- * Gets the slant of a toy font.
- * 
- * The weight returned may be one of:
- * 
- * + cairo.FONT_WEIGHT_NORMAL - Normal font weight.
- * + cairo.FONT_WEIGHT_BOLD - Bold font weight.
+ * var options = cairo.scaled_font_get_font_options(context);
  * 
- * A cairo font_face specifies all aspects of a font other than the size or font matrix (a font matrix is used to distort a font by shearing it or scaling it unequally in the two directions) . A font face can be set on a context by using cairo.context_set_font_face(); the size and font matrix are set with cairo.context_set_font_size() and cairo.context_set_font_matrix().
+ * Get the font options with which scaled_font was created.
  * 
- * There are various types of font faces, depending on the font backend they use. The type of a font face can be queried using cairo.font_face_get_type().
+ * NOTE: the resulting options object should be freed with cairo.font_options_destroy().
  * 
- * Memory management of cairo font_faces is done with cairo.font_face_reference() and cairo.font_face_destroy().
+ * The options object returned is an opaque structure holding all options that are used when rendering fonts.
  * 
- * See also the font_face methods.
+ * Individual features of a cairo font_options object can be set or accessed using functions named cairo.font_options_set_feature_name() and cairo.font_options_get_feature_name(), like cairo.font_options_set_antialias() and cairo.font_options_get_antialias().
  * 
- * AVAILABLE IN CAIRO 1.8 OR NEWER
+ * New features may be added to a cairo font_options object in the future. For this reason, cairo.font_options_copy(), cairo.font_options_equal(), cairo.font_options_merge(), and cairo.font_options_hash() should be used to copy, check for equality, merge, or compute a hash value of cairo font_options objects. 
  * 
- * @param {object} font_face - opaque handle to a cairo font face object.
- * @return {int} weight - font weight.
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font.
+ * @return {object} options - opaque handle to a cairo font options object.
  */
-#if CAIRO_VERSION_MINOR >= 8
-static JSVAL toy_font_face_get_weight(JSARGS args) {
-    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_toy_font_face_get_weight(font_face));
+#if CAIRO_VERSION_MINOR >= 2
+static JSVAL scaled_font_get_font_options(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
+    cairo_font_options_t *options = track_font_options(cairo_font_options_create());
+    cairo_scaled_font_get_font_options(scaled_font, options);
+    return External::New(options);
 }
 #endif
 
-////////////////////////// FONT FACES
-
 /**
- * @function cairo.font_face_reference
+ * @function cairo.scaled_font_get_font_matrix
  * 
  * ### Synopsis
  * 
- * var font_face = cairo.font_face_reference(font_face);
- * 
- * Increases the reference count on font_face by one. 
+ * var matrix = cairo.scaled_font_get_font_matrix(scaled_font);
  * 
- * This prevents font_face from being destroyed until a matching call to cairo.font_face_destroy() is made.
+ * Gets the font matrix with which scaled_font was created.
  * 
- * The number of references to a cairo font_face can be get using cairo.font_face_get_reference_count().
+ * The matrix returned is owned by the caller and must be released by calling cairo.matrix_destroy() when it is no longer needed.
  * 
- * @param {object} font_face - opaque handle to a cairo font face object.
- * @return {object} font_face - opaque handle to the referenced cairo font face object.
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font.
+ * @return {object} matrix - opaque handle to a cairo matrix.
  */
-static JSVAL font_face_reference(JSARGS args) {
-    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
-    return External::New(cairo_font_face_reference(font_face));
+#if CAIRO_VERSION_MINOR >= 2
+static JSVAL scaled_font_get_font_matrix(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
+    cairo_matrix_t *matrix = matrix_new();
+    cairo_scaled_font_get_font_matrix(scaled_font, matrix);
+    return External::New(matrix);
 }
+#endif
 
 /**
- * @function cairo.font_face_destroy
+ * @function cairo.scaled_font_get_ctm
  * 
  * ### Synopsis
  * 
- * cairo.font_face_destroy(font_face);
+ * var matrix = cairo.scaled_font_get_ctm(scaled_font);
  * 
- * Decreases the reference count on font_face by one. 
+ * Gets the CTM with which scaled_font was created. 
  * 
- * If the result is zero, then font_face and all associated resources are freed. See cairo.font_face_reference().
+ * Note that the translation offsets (x0, y0) of the CTM are ignored by cairo.scaled_font_create(). So, the matrix this function returns always has 0,0 as x0,y0.
  * 
- * @param {object} font_face - opaque handle to a cairo font face object.
+ * The matrix returned is owned by the caller and must be released by calling cairo.matrix_destroy() when it is no longer needed.
+ * 
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font.
+ * @return {object} matrix - opaque handle to a cairo matrix.
  */
-static JSVAL font_face_destroy(JSARGS args) {
-    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
-    cairo_font_face_destroy(font_face);
-    return Undefined();
+#if CAIRO_VERSION_MINOR >= 2
+static JSVAL scaled_font_get_ctm(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
+    cairo_matrix_t *matrix = matrix_new();
+    cairo_scaled_font_get_ctm(scaled_font, matrix);
+    return External::New(matrix);
 }
+#endif
 
 /**
- * @function cairo.font_face_status
+ * @function cairo.scaled_font_get_scale_matrix
  * 
  * ### Synopsis
  * 
- * var status = cairo.font_face_status(font_face);
+ * var matrix = cairo.scaled_font_get_scale_matrix(scaled_font);
  * 
- * Checks whether an error has previously occurred for this font face
+ * Stores the scale matrix of scaled_font into matrix. 
  * 
- * @param {object} font_face - opaque handle to a cairo font face object.
- * @return {int} status - cairo.STATUS_SUCCESS or another error such as cairo.STATUS_NO_MEMORY.
+ * The scale matrix is product of the font matrix and the ctm associated with the scaled font, and hence is the matrix mapping from font space to device space.
+ * 
+ * The matrix returned is owned by the caller and must be released by calling cairo.matrix_destroy() when it is no longer needed.
+ * 
+ * AVAILABLE IN CAIRO 1.8 OR NEWER
+ * 
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font.
+ * @return {object} matrix - opaque handle to a cairo matrix.
  */
-static JSVAL font_face_status(JSARGS args) {
-    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_font_face_status(font_face));
+#if CAIRO_VERSION_MINOR >= 8
+static JSVAL scaled_font_get_scale_matrix(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
+    cairo_matrix_t *matrix = matrix_new();
+    cairo_scaled_font_get_scale_matrix(scaled_font, matrix);
+    return External::New(matrix);
 }
+#endif
 
 /**
- * @function cairo.font_face_get_type
+ * @function cairo.scaled_font_get_type
  * 
  * ### Synopsis
  * 
- * var type = cairo.font_face_get_type(font_face);
+ * var type = cairo.scaled_font_get_type(scaled_font);
  * 
- * This function returns the type of the backend used to create a font face.
+ * This function returns the type of the backend used to create a scaled font. 
  * 
  * The font types are also known as "font backends" within cairo.
  * 
@@ -3883,858 +8317,2173 @@ static JSVAL font_face_status(JSARGS args) {
  * 
  * New entries may be added in future versions.
  * 
- * cairo.FONT_TYPE_TOY - The font was created using cairo's toy font API (Since: 1.2).
  * cairo.FONT_TYPE_FT - The font is of type FreeType (Since: 1.2).
  * cairo.FONT_TYPE_WIN32 - The font is of type Win32 (Since: 1.2).
  * cairo.FONT_TYPE_QUARTZ - The font is of type Quartz (Since: 1.6, in 1.2 and 1.4 it was named cairo.FONT_TYPE_ATSUI).
  * cairo.FONT_TYPE_ATSUI - The font is of type Quartz (since 1.2, backward compatibility for cairo.FONT_TYPE_ATSUI).
  * cairo.FONT_TYPE_USER - The font was create using cairo's user font API (Since: 1.8).
  * 
- * @param {object} font_face - opaque handle to a cairo font face object.
- * @return {int} type - one of the above types.
- */
-static JSVAL font_face_get_type(JSARGS args) {
-    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_font_face_get_type(font_face));
-}
-
-/**
- * @function cairo.font_face_get_reference_count
- * 
- * ### Synopsis
- * 
- * var count = cairo.font_face_get_reference_count(font_face);
- * 
- * Get the current reference count of font_face.
+ * _This function never returns cairo.FONT_TYPE_TOY._
  * 
- * @param {object} font_face - opaque handle to a cairo font face object.
- * @return {int} count - current reference count of font_face.  If a nil font_face, 0 will be returned.
+ * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
+ * @return {int} type - one of the above types.
  */
-static JSVAL font_face_get_reference_count(JSARGS args) {
-    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_font_face_get_reference_count(font_face));
+#if CAIRO_VERSION_MINOR >= 2
+static JSVAL scaled_font_get_type(JSARGS args) {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_scaled_font_get_type(scaled_font));
 }
+#endif
 
-////////////////////////// SCALED FONTS
-
-/**
- * @function cairo.scaled_font_create
- * 
- * ### Synopsis
- * 
- * var scaled_font = cairo.scaled_font_create(font_face, font_matrix, ctm, options);
- * 
- * Create a cairo scaled_font object from a font_face and matrices that describe the size of the font and the environment in which it will be used.
- * 
- * A cairo scaled_font is a font scaled to a particular size and device resolution. A cairo scaled_font is most useful for low-level font usage where a library or application wants to cache a reference to a scaled font to speed up the computation of metrics.
- * 
- * There are various types of scaled fonts, depending on the font backend they use. The type of a scaled font can be queried using cairo.scaled_font_get_type().
- * 
- * Memory management of cairo scaled_font is done with cairo.scaled_font_reference() and cairo.scaled_font_destroy().
- * 
- * The font_matrix argument is a font space to user space transformation matrix for the font. In the simplest case of a N point font, this matrix is just a scale by N, but it can also be used to shear the font or stretch it unequally along the two axes. See cairo.context_set_font_matrix().
- * 
- * The options object is an opaque structure holding all options that are used when rendering fonts.
- * 
- * Individual features of a cairo font_options object can be set or accessed using functions named cairo.font_options_set_feature_name() and cairo.font_options_get_feature_name(), like cairo.font_options_set_antialias() and cairo.font_options_get_antialias().
- * 
- * New features may be added to a cairo font_options object in the future. For this reason, cairo.font_options_copy(), cairo.font_options_equal(), cairo.font_options_merge(), and cairo.font_options_hash() should be used to copy, check for equality, merge, or compute a hash value of cairo font_options objects. 
- * 
- * @param {object} font_face - opaque handle to a cairo font face object.
- * @param {object} font_matrix - opaque handle to a cairo matrix, described above.
- * @param {object} ctm - opaque handle to a cairo matrix; user to device transformation matrix with which the font will be used.
- * @param {object} options - opaque handle to a cairo font options object.
- * @return {object} scaled_font - opaque handle to a scaled font.
- */
-static JSVAL scaled_font_create(JSARGS args) {
-    cairo_font_face_t *font_face = (cairo_font_face_t *)JSEXTERN(args[0]);
-    cairo_matrix_t *font_matrix = (cairo_matrix_t *) JSEXTERN(args[1]);
-    cairo_matrix_t *ctm = (cairo_matrix_t *) JSEXTERN(args[2]);
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[3]);
-    return External::New(cairo_scaled_font_create(font_face, font_matrix, ctm, options));
-}
 
-/**
- * @function cairo.scaled_font_reference
- * 
- * ### Synopsis
- * 
- * cairo.scaled_font_reference(scaled_font);
- * 
- * Increases the reference count on scaled_font by one. 
- * 
- * This prevents scaled_font from being destroyed until a matching call to cairo.scaled_font_destroy() is made.
- * 
- * The number of references to a scaled_font can be get using cairo.scaled_font_get_reference_count().
- * 
- * @param {object} scaled_font - opaque handle to a scaled font.
- * @return {object} scaled_font - opaque handle to referenced scaled font.
- */
-static JSVAL scaled_font_reference(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    return External::New(cairo_scaled_font_reference(scaled_font));
-}
 
-/**
- * @function cairo.scaled_font_destroy
- * 
- * ### Synopsis
- * 
- * cairo.scaled_font_destroy(scaled_font);
- * 
- * Decreases the reference count on scaled_font by one. 
- * 
- * If the result is zero, then scaled_font and all associated resources are freed. See cairo.scaled_font_reference().
- * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
- */
-static JSVAL scaled_font_destroy(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    cairo_scaled_font_destroy(scaled_font);
-    return Undefined();
-}
+////////////////////////// FONT OPTIONS
 
 /**
- * @function cairo.scaled_font_get_reference_count
+ * @function cairo.font_options_create
  * 
  * ### Synopsis
  * 
- * var count = cairo.scaled_font_get_reference_count(scaled_font);
- * 
- * Get the current reference count of scaled_font.
- * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
- * @return {int} count - current reference count of scaled_font.  If a nil scaled_font, 0 will be returned.
- */
-#if CAIRO_VERSION_MINOR >= 4
-static JSVAL scaled_font_get_reference_count(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_scaled_font_get_reference_count(scaled_font));
-}
-#endif
-
-/**
- * @function cairo.scaled_font_status
- * 
- * ### Synopsis
+ * var options = cairo.font_options_create();
  * 
- * var status = cairo.scaled_font_status(scaled_font);
+ * Allocates a new font options object with all options initialized to default values.
  * 
- * Checks whether an error has previously occurred for this scaled_font.
+ * Free the returned object with cairo.font_options_destroy(). 
  * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
- * @return {int} status - cairo.STATUS_SUCCESS or another error such as cairo.STATUS_NO_MEMORY.
+ * This function always returns a valid pointer; if memory cannot be allocated, then a special error object is returned where all operations on the object do nothing. You can check for this with cairo.font_options_status().
+ * 
+ * @return {object} options - opaque handle to a font options object.
  */
-static JSVAL scaled_font_status(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_scaled_font_status(scaled_font));
+static JSVAL font_options_create(JSARGS args) {
+    return External::New(track_font_options(cairo_font_options_create()));
 }
 
 /**
- * @function cairo.scaled_font_extents
+ * @function cairo.font_options_copy
  * 
  * ### Synopsis
  * 
- * var extents = cairo.scaled_font_extents(scaled_font);
+ * var copy = cairo.font_options_copy(original);
  * 
- * Gets the font extents for scaled_font.
+ * Allocates a new font options object copying the option values from original.
  * 
- * The object returned has the following members:
+ * Free the returned object with cairo.font_options_destroy(). 
  * 
- * + {number} ascent - the distance that the font extends above the baseline. Note that this is not always exactly equal to the maximum of the extents of all the glyphs in the font, but rather is picked to express the font designer's intent as to how the font should align with elements above it.
- * + {number} descent - the distance that the font extends below the baseline. This value is positive for typical fonts that include portions below the baseline. Note that this is not always exactly equal to the maximum of the extents of all the glyphs in the font, but rather is picked to express the font designer's intent as to how the font should align with elements below it.
- * + {number} height - the recommended vertical distance between baselines when setting consecutive lines of text with the font. This is greater than ascent+descent by a quantity known as the line spacing or external leading. When space is at a premium, most fonts can be set with only a distance of ascent+descent between lines.
- * + {number} max_x_advance - the maximum distance in the X direction that the origin is advanced for any glyph in the font.
- * + {number} max_y_advance - the maximum distance in the Y direction that the origin is advanced for any glyph in the font. This will be zero for normal fonts used for horizontal writing. (The scripts of East Asia are sometimes written vertically.)
+ * This function always returns a valid pointer; if memory cannot be allocated, then a special error object is returned where all operations on the object do nothing. You can check for this with cairo.font_options_status().
  * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
- * @return {object} extents - object as described above.
+ * @param {object} original- opaque handle to a font options object.
+ * @return {object} copy - opaque handle to a copy of the original font options object.
  */
-static JSVAL scaled_font_extents(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    cairo_font_extents_t extents;
-    cairo_scaled_font_extents(scaled_font, &extents);
-    JSOBJ o = Object::New();
-    o->Set(String::New("ascent"), Number::New(extents.ascent));
-    o->Set(String::New("descent"), Number::New(extents.descent));
-    o->Set(String::New("height"), Number::New(extents.height));
-    o->Set(String::New("max_x_advance"), Number::New(extents.max_x_advance));
-    o->Set(String::New("max_y_advance"), Number::New(extents.max_y_advance));
-    return o;
+static JSVAL font_options_copy(JSARGS args) {
+    cairo_font_options_t *original = (cairo_font_options_t *)JSEXTERN(args[0]);
+    return External::New(track_font_options(cairo_font_options_copy(original)));
 }
 
 /**
- * @function cairo.scaled_font_text_extents
+ * @functino cairo.font_options_destroy
  * 
  * ### Synopsis
  * 
- * var extents = cairo.scaled_font_text_extents(scaled_font, text);
+ * cairo.font_options_destroy(options);
  * 
- * Gets the extents for a string of text. The extents describe a user-space rectangle that encloses the "inked" portion of the text, (as it would be drawn by cairo.context_show_text()). 
+ * Destroys a cairo font_options object created with cairo.font_options_create() or cairo.font_options_copy().
  * 
- * Additionally, the x_advance and y_advance values indicate the amount by which the current point would be advanced by cairo.context_show_text().
+ * @return {object} options - opaque handle to a font options object.
+ * @return 
+ */
+static JSVAL font_options_destroy(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    memory_untrack_untagged(MEMORY_FONT_OPTIONS, options, 0);
+    cairo_font_options_destroy(options);
+    return Undefined();
+}
+
+/**
+ * @function cairo.font_options_status
  * 
- * Note that whitespace characters do not directly contribute to the size of the rectangle (extents.width and extents.height). They do contribute indirectly by changing the position of non-whitespace characters. In particular, trailing whitespace characters are likely to not affect the size of the rectangle, though they will affect the x_advance and y_advance values.
+ * ### Synopsis
  * 
- * The object returned has the following members:
+ * var status = cairo.font_options_status(options);
  * 
- * + {number} x_bearing - the horizontal distance from the origin to the leftmost part of the glyphs as drawn. Positive if the glyphs lie entirely to the right of the origin.
- * + {number} y_bearing - the vertical distance from the origin to the topmost part of the glyphs as drawn. Positive only if the glyphs lie completely below the origin; will usually be negative.
- * + {number} width - width of the glyphs as drawn.
- * + {number} height - height of the glyphs as drawn.
- * + {number} x_advance - distance to advance in the X direction after drawing these glyphs.
- * + {number} y_advance - distance to advance in the Y direction after drawing these glyphs. Will typically be zero except for vertical text layout as found in East-Asian languages.
+ * Checks whether an error has previously occurred for this font options object
  * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
- * @param {string} text - a stirng of text encoded in UTF8.
- * @return {object} extents - object as described above.
+ * @param {object} options - opaque handle to a font options object.
+ * @return {int} status - one of cairo.STATUS_SUCCESS or cairo.STATUS_NO_MEMORY.
  */
-#if CAIRO_VERSION_MINOR >= 2
-static JSVAL scaled_font_text_extents(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    String::Utf8Value text(args[1]->ToString());
-    cairo_text_extents_t extents;
-    cairo_scaled_font_text_extents(scaled_font, *text, &extents);
-    JSOBJ o = Object::New();
-    o->Set(String::New("x_bearing"), Number::New(extents.x_bearing));
-    o->Set(String::New("y_bearing"), Number::New(extents.y_bearing));
-    o->Set(String::New("width"), Number::New(extents.width));
-    o->Set(String::New("height"), Number::New(extents.height));
-    o->Set(String::New("x_advance"), Number::New(extents.x_advance));
-    o->Set(String::New("y_advance"), Number::New(extents.y_advance));
-    return o;
+static JSVAL font_options_status(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_font_options_status(options));
 }
-#endif
 
 /**
- * @function cairo.scaled_font_glyph_extents
+ * @function cairo.font_options_merge
  * 
  * ### Synopsis
  * 
- * var extents = cairo.scaled_font_glyph_extents(scaled_font, glyphs);
+ * cairo.font_options_merge(options, other);
  * 
- * Gets the extents for an array of glyphs. 
+ * Merges non-default options from other into options, replacing existing values. 
  * 
- * The extents describe a user-space rectangle that encloses the "inked" portion of the glyphs, (as they would be drawn by cairo.context_show_glyphs()). 
+ * This operation can be thought of as somewhat similar to compositing other onto options with the operation of cairo.OPERATOR_OVER.
  * 
- * Additionally, the x_advance and y_advance values indicate the amount by which the current point would be advanced by cairo.context_show_glyphs().
+ * @param {object} options - opaque handle to a font options object.
+ * @param {object} other - opaque handle to a font options object.
+ */
+static JSVAL font_options_merge(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    cairo_font_options_t *other = (cairo_font_options_t *)JSEXTERN(args[1]);
+    cairo_font_options_merge(options, other);
+    return Undefined();
+}
+
+/**
+ * @function cairo.font_options_hash
  * 
- * Note that whitespace glyphs do not contribute to the size of the rectangle (extents.width and extents.height).
+ * ### Synopsis
  * 
- * The glyphs argument is an array of objects of the following form:
+ * var hash = cairo.font_options_hash(options);
  * 
- * + {int} index - glyph index in the font.  The exact interpretation of the glyph index depends on the font technology being used.
- * + {number} x - the offset in the x direction between the origin used for drawing or measuring the string and the origin of this glyph.
- * + {number} y - the offset in the y direction between the origin used for drawing or measuring the string and the origin of this glyph.
+ * Compute a hash for the font options object; this value will be useful when storing an object containing a cairo font_options in a hash table.
  * 
- * The above structure holds information about a single glyph when drawing or measuring text. A font is (in simple terms) a collection of shapes used to draw text. A glyph is one of these shapes. There can be multiple glyphs for a single character (alternates to be used in different contexts, for example), or a glyph can be a ligature of multiple characters. Cairo doesn't expose any way of converting input text into glyphs, so in order to use the Cairo interfaces that take arrays of glyphs, you must directly access the appropriate underlying font system.
+ * @return {object} options - opaque handle to a font options object.
+ * @return {int} hash - the hash value for the font options object, cast to a 32-bit value.
+ */
+static JSVAL font_options_hash(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_font_options_hash(options));
+}
+
+/**
+ * @function cairo.font_options_equal
  * 
- * Note that the offsets given by x and y are not cumulative. When drawing or measuring text, each glyph is individually positioned with respect to the overall origin
+ * ### Synopsis
  * 
- * The object returned has the following members:
+ * var is_equal = cairo.font_options_equal(options, other);
  * 
- * + {number} x_bearing - the horizontal distance from the origin to the leftmost part of the glyphs as drawn. Positive if the glyphs lie entirely to the right of the origin.
- * + {number} y_bearing - the vertical distance from the origin to the topmost part of the glyphs as drawn. Positive only if the glyphs lie completely below the origin; will usually be negative.
- * + {number} width - width of the glyphs as drawn.
- * + {number} height - height of the glyphs as drawn.
- * + {number} x_advance - distance to advance in the X direction after drawing these glyphs.
- * + {number} y_advance - distance to advance in the Y direction after drawing these glyphs. Will typically be zero except for vertical text layout as found in East-Asian languages.
+ * Compare two font options objects for equality.
  * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font.
- * @param {array} glyphs - array of objects as described above.
- * @return {object} extents - object as described above.
+ * @param {object} options - opaque handle to a font options object.
+ * @param {object} other - opaque handle to a font options object.
+ * @return {boolean} is_equal - true if the two font options objects are equal.
  */
-static JSVAL scaled_font_glyph_extents(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    Handle<Array>glyphs = Handle<Array>::Cast(args[2]->ToObject());
-    int num_glyphs = glyphs->Length();
-    cairo_glyph_t *c_glyphs = new cairo_glyph_t[num_glyphs];
-    // 
-    Local<String>index = String::New("index");
-    Local<String>_x = String::New("x");
-    Local<String>_y = String::New("y");
-    
-    for (int i=0; i<num_glyphs; i++) {
-        JSOBJ o = glyphs->Get(i)->ToObject();
-        c_glyphs[i].index = o->Get(index)->IntegerValue();
-        c_glyphs[i].x = o->Get(_x)->NumberValue();
-        c_glyphs[i].y = o->Get(_y)->NumberValue();
-    }
-    
-    cairo_text_extents_t extents;
-    cairo_scaled_font_glyph_extents(scaled_font, c_glyphs, num_glyphs, &extents);
-    delete [] c_glyphs;
-
-    JSOBJ o = Object::New();
-    o->Set(String::New("x_bearing"), Number::New(extents.x_bearing));
-    o->Set(String::New("y_bearing"), Number::New(extents.y_bearing));
-    o->Set(String::New("width"), Number::New(extents.width));
-    o->Set(String::New("height"), Number::New(extents.height));
-    o->Set(String::New("x_advance"), Number::New(extents.x_advance));
-    o->Set(String::New("y_advance"), Number::New(extents.y_advance));
-    return o;
+static JSVAL font_options_equal(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    cairo_font_options_t *other = (cairo_font_options_t *)JSEXTERN(args[1]);
+    return cairo_font_options_equal(options, other) ? True() : False();
 }
 
 /**
- * @function cairo.scaled_font_get_font_face
+ * @function cairo.font_options_set_antialias
  * 
- * ### Synopsis
+ * Synopsis:
  * 
- * var font_face = cairo.scaled_font_get_font_face(scaled_font);
+ * cairo.font_options_set_antialias(options, mode);
  * 
- * Gets the font face that this scaled font uses. 
+ * Sets the antialiasing mode for the font options object. 
  * 
- * This might be the font face passed to cairo.scaled_font_create(), but this does not hold true for all possible cases.
+ * This specifies the type of antialiasing to do when rendering text.
  * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font.
- * @return {object} font_face  - opaque handle to a cairo font face object.
+ * Valid modes are:
+ * 
+ * + cairo.ANTIALIAS_DEFAULT - use the default antialiasing for the subsystem and target device.
+ * + cairo.ANTIALIAS_NONE - use a bilevel alpha mask.
+ * + cairo.ANTIALIAS_GRAY - perform single-color antialiasing (using shades of gray for black text on a white background, for example).
+ * + cairo.ANTIALIAS_SUBPIXEL - perform antialiasing by taking advantage of the order of subpixel elements on devices such as LCD panels.
+ * + cairo_ANTIALIAS_FAST - Hint that the backend should perform some antialiasing but prefer speed over quality, since 1.12.
+ * + cairo.ANTIALIAS_GOOD - The backend should balance quality against performance, since 1.12.
+ * + CAIRO_ANTIALIAS_BEST - Hint that the backend should render at the highest quality, sacrificing speed if necessary, since 1.12
+* 
+ * @param {object} options - opaque handle to a font options object.
+ * @param {int} mode - one of the above modes.
  */
-#if CAIRO_VERSION_MINOR >= 2
-static JSVAL scaled_font_get_font_face(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    return External::New(cairo_scaled_font_get_font_face(scaled_font));
+static JSVAL font_options_set_antialias(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    cairo_font_options_set_antialias(options, (cairo_antialias_t)args[1]->IntegerValue());
+    return Undefined();
 }
-#endif
-
 /**
- * @function cairo.scaled_font_get_font_options
- * 
- * ### Synopsis
- * 
- * var options = cairo.scaled_font_get_font_options(context);
+ * @function cairo.font_options_get_antialias
  * 
- * Get the font options with which scaled_font was created.
+ * Synopsis:
  * 
- * NOTE: the resulting options object should be freed with cairo.font_options_destroy().
+ * var mode = cairo.font_options_get_antialias(options);
  * 
- * The options object returned is an opaque structure holding all options that are used when rendering fonts.
+ * Gets the antialiasing mode for the font options object. 
  * 
- * Individual features of a cairo font_options object can be set or accessed using functions named cairo.font_options_set_feature_name() and cairo.font_options_get_feature_name(), like cairo.font_options_set_antialias() and cairo.font_options_get_antialias().
+ * Valid modes are:
  * 
- * New features may be added to a cairo font_options object in the future. For this reason, cairo.font_options_copy(), cairo.font_options_equal(), cairo.font_options_merge(), and cairo.font_options_hash() should be used to copy, check for equality, merge, or compute a hash value of cairo font_options objects. 
+ * + cairo.ANTIALIAS_DEFAULT - use the default antialiasing for the subsystem and target device.
+ * + cairo.ANTIALIAS_NONE - use a bilevel alpha mask.
+ * + cairo.ANTIALIAS_GRAY - perform single-color antialiasing (using shades of gray for black text on a white background, for example).
+ * + cairo.ANTIALIAS_SUBPIXEL - perform antialiasing by taking advantage of the order of subpixel elements on devices such as LCD panels.
+ * + cairo_ANTIALIAS_FAST - Hint that the backend should perform some antialiasing but prefer speed over quality, since 1.12.
+ * + cairo.ANTIALIAS_GOOD - The backend should balance quality against performance, since 1.12.
+ * + CAIRO_ANTIALIAS_BEST - Hint that the backend should render at the highest quality, sacrificing speed if necessary, since 1.12
  * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font.
- * @return {object} options - opaque handle to a cairo font options object.
+ * @param {object} options - opaque handle to a font options object.
+ * @return {int} mode - one of the above modes.
  */
-#if CAIRO_VERSION_MINOR >= 2
-static JSVAL scaled_font_get_font_options(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    cairo_font_options_t *options = cairo_font_options_create();
-    cairo_scaled_font_get_font_options(scaled_font, options);
-    return External::New(options);
+static JSVAL font_options_get_antialias(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_font_options_get_antialias(options));
 }
-#endif
 
 /**
- * @function cairo.scaled_font_get_font_matrix
+ * @function cairo.font_options_set_subpixel_order
  * 
  * ### Synopsis
  * 
- * var matrix = cairo.scaled_font_get_font_matrix(scaled_font);
+ * cairo.font_options_set_subpixel_order(options, subpixel_order);
+ * 
+ * Sets the subpixel order for the font options object. 
+ * 
+ * The subpixel order specifies the order of color elements within each pixel on the display device when rendering with an antialiasing mode of cairo.ANTIALIAS_SUBPIXEL.
  * 
- * Gets the font matrix with which scaled_font was created.
+ * The value of subpixel_order may be one of the following:
  * 
- * The matrix returned is owned by the caller and must be released by calling cairo.matrix_destroy() when it is no longer needed.
+ * + cairo.SUBPIXEL_ORDER_DEFAULT - Use the default subpixel order for for the target device.
+ * + cairo.SUBPIXEL_ORDER_RGB - Subpixel elements are arranged horizontally with red at the left.
+ * + cairo.SUBPIXEL_ORDER_BGR - Subpixel elements are arranged horizontally with blue at the left.
+ * + cairo.SUBPIXEL_ORDER_VRGB - Subpixel elements are arranged vertically with red at the top.
+ * + cairo.SUBPIXEL_ORDER_VBGR - Subpixel elements are arranged vertically with blue at the top.
  * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font.
- * @return {object} matrix - opaque handle to a cairo matrix.
+ * @param {object} options - opaque handle to a font options object.
+ * @return {int} subpixel_order - one of the above values.
  */
-#if CAIRO_VERSION_MINOR >= 2
-static JSVAL scaled_font_get_font_matrix(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    cairo_matrix_t *matrix = new cairo_matrix_t;
-    cairo_scaled_font_get_font_matrix(scaled_font, matrix);
-    return External::New(matrix);
+static JSVAL font_options_set_subpixel_order(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    cairo_font_options_set_subpixel_order(options, (cairo_subpixel_order_t)args[1]->IntegerValue());
+    return Undefined();
 }
-#endif
 
 /**
- * @function cairo.scaled_font_get_ctm
+ * @function cairo.font_options_get_subpixel_order
  * 
  * ### Synopsis
  * 
- * var matrix = cairo.scaled_font_get_ctm(scaled_font);
+ * var subpixel_order = cairo.font_options_get_subpixel_order(options);
  * 
- * Gets the CTM with which scaled_font was created. 
+ * Get the subpixel order for the font options object.
  * 
- * Note that the translation offsets (x0, y0) of the CTM are ignored by cairo.scaled_font_create(). So, the matrix this function returns always has 0,0 as x0,y0.
+ * The return value may be one of:
  * 
- * The matrix returned is owned by the caller and must be released by calling cairo.matrix_destroy() when it is no longer needed.
+ * + cairo.SUBPIXEL_ORDER_DEFAULT - Use the default subpixel order for for the target device.
+ * + cairo.SUBPIXEL_ORDER_RGB - Subpixel elements are arranged horizontally with red at the left.
+ * + cairo.SUBPIXEL_ORDER_BGR - Subpixel elements are arranged horizontally with blue at the left.
+ * + cairo.SUBPIXEL_ORDER_VRGB - Subpixel elements are arranged vertically with red at the top.
+ * + cairo.SUBPIXEL_ORDER_VBGR - Subpixel elements are arranged vertically with blue at the top.
  * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font.
- * @return {object} matrix - opaque handle to a cairo matrix.
+ * @param {object} options - opaque handle to a font options object.
+ * @return {int} subpixel_order - one of the above values.
  */
-#if CAIRO_VERSION_MINOR >= 2
-static JSVAL scaled_font_get_ctm(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    cairo_matrix_t *matrix = new cairo_matrix_t;
-    cairo_scaled_font_get_ctm(scaled_font, matrix);
-    return External::New(matrix);
+static JSVAL font_options_get_subpixel_order(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_font_options_get_subpixel_order(options));
 }
-#endif
 
 /**
- * @function cairo.scaled_font_get_scale_matrix
+ * @function cairo.font_options_set_hint_style
  * 
  * ### Synopsis
  * 
- * var matrix = cairo.scaled_font_get_scale_matrix(scaled_font);
+ * cairo.font_options_set_hint_style(options, hint_style);
  * 
- * Stores the scale matrix of scaled_font into matrix. 
+ * Sets the hint style for font outlines for the font options object. 
  * 
- * The scale matrix is product of the font matrix and the ctm associated with the scaled font, and hence is the matrix mapping from font space to device space.
+ * This controls whether to fit font outlines to the pixel grid, and if so, whether to optimize for fidelity or contrast. 
  * 
- * The matrix returned is owned by the caller and must be released by calling cairo.matrix_destroy() when it is no longer needed.
+ * The value of hint_style may be one of the following:
  * 
- * AVAILABLE IN CAIRO 1.8 OR NEWER
+ * + cairo.HINT_STYLE_DEFAULT - Use the default hint style for font backend and target device.
+ * + cairo.HINT_STYLE_NONE - Do not hint outlines.
+ * + cairo.HINT_STYLE_SLIGHT - Hint outlines slightly to improve contrast while retaining good fidelity to the original shapes.
+ * + cairo.HINT_STYLE_MEDIUM - Hint outlines with medium strength giving a compromise between fidelity to the original shapes and contrast.
+ * + cairo.HINT_STYLE_FULL - Hint outlines to maximize contrast.
  * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font.
- * @return {object} matrix - opaque handle to a cairo matrix.
+ * @param {object} options - opaque handle to a font options object.
+ * @return {int} hint_style - one of the above values.
  */
-#if CAIRO_VERSION_MINOR >= 8
-static JSVAL scaled_font_get_scale_matrix(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    cairo_matrix_t *matrix = new cairo_matrix_t;
-    cairo_scaled_font_get_scale_matrix(scaled_font, matrix);
-    return External::New(matrix);
+static JSVAL font_options_set_hint_style(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    cairo_font_options_set_hint_style(options, (cairo_hint_style_t)args[1]->IntegerValue());
+    return Undefined();
 }
-#endif
 
 /**
- * @function cairo.scaled_font_get_type
+ * @function cairo.font_options_get_hint_style
  * 
  * ### Synopsis
  * 
- * var type = cairo.scaled_font_get_type(scaled_font);
+ * var hint_style = cairo.font_options_get_hint_style(options);
  * 
- * This function returns the type of the backend used to create a scaled font. 
+ * Get the hint style for the font options object.
  * 
- * The font types are also known as "font backends" within cairo.
+ * The return value may be one of:
  * 
- * The type of a font face is determined by the function used to create it, which will generally be of the form cairo.type_font_face_create(). The font face type can be queried with cairo.font_face_get_type()
+ * + cairo.HINT_STYLE_DEFAULT - Use the default hint style for font backend and target device.
+ * + cairo.HINT_STYLE_NONE - Do not hint outlines.
+ * + cairo.HINT_STYLE_SLIGHT - Hint outlines slightly to improve contrast while retaining good fidelity to the original shapes.
+ * + cairo.HINT_STYLE_MEDIUM - Hint outlines with medium strength giving a compromise between fidelity to the original shapes and contrast.
+ * + cairo.HINT_STYLE_FULL - Hint outlines to maximize contrast.
  * 
- * The various cairo font_face functions can be used with a font face of any type.
+ * @param {object} options - opaque handle to a font options object.
+ * @return {int} hint_style - one of the above values.
+ */
+static JSVAL font_options_get_hint_style(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_font_options_get_hint_style(options));
+}
+
+/**
+ * @function cairo.font_options_set_hint_metrics
  * 
- * The type of a scaled font is determined by the type of the font face passed to cairo.scaled_font_create(). The scaled font type can be queried with cairo.scaled_font_get_type().
+ * ### Synopsis
  * 
- * The various cairo scaled_font functions can be used with scaled fonts of any type, but some font backends also provide type-specific functions that must only be called with a scaled font of the appropriate type. These functions have names that begin with cairo.type_scaled_font() such as cairo.ft_scaled_font_lock_face().
+ * cairo.font_options_set_hint_metrics(options, hint_metrics);
  * 
- * The behavior of calling a type-specific function with a scaled font of the wrong type is undefined.
+ * Sets the metrics hinting mode for the font options object. 
  * 
- * New entries may be added in future versions.
+ * This controls whether metrics are quantized to integer values in device units.
  * 
- * cairo.FONT_TYPE_FT - The font is of type FreeType (Since: 1.2).
- * cairo.FONT_TYPE_WIN32 - The font is of type Win32 (Since: 1.2).
- * cairo.FONT_TYPE_QUARTZ - The font is of type Quartz (Since: 1.6, in 1.2 and 1.4 it was named cairo.FONT_TYPE_ATSUI).
- * cairo.FONT_TYPE_ATSUI - The font is of type Quartz (since 1.2, backward compatibility for cairo.FONT_TYPE_ATSUI).
- * cairo.FONT_TYPE_USER - The font was create using cairo's user font API (Since: 1.8).
+ * Hinting font metrics means quantizing them so that they are integer values in device space. Doing this improves the consistency of letter and line spacing, however it also means that text will be laid out differently at different zoom factors.
  * 
- * _This function never returns cairo.FONT_TYPE_TOY._
+ * The value of hint_metrics may be one of the following:
  * 
- * @param {object} scaled_font - opaque handle to a cairo scaled_font object.
- * @return {int} type - one of the above types.
+ * + cairo.HINT_METRICS_DEFAULT - Hint metrics in the default manner for the font backend and target device.
+ * + cairo.HINT_METRICS_OFF - Do not hint font metrics.
+ * + cairo.HINT_METRICS_ON - Hint font metrics.
+ * 
+ * @param {object} options - opaque handle to a font options object.
+ * @return {int} hint_metrics - one of the above values.
  */
-#if CAIRO_VERSION_MINOR >= 2
-static JSVAL scaled_font_get_type(JSARGS args) {
-    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_scaled_font_get_type(scaled_font));
+static JSVAL font_options_set_hint_metrics(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    cairo_font_options_set_hint_metrics(options, (cairo_hint_metrics_t)args[1]->IntegerValue());
+    return Undefined();
 }
-#endif
-
-
-
-////////////////////////// FONT OPTIONS
 
 /**
- * @function cairo.font_options_create
+ * @function cairo.font_options_get_hint_metrics
  * 
  * ### Synopsis
  * 
- * var options = cairo.font_options_create();
+ * var hint_metrics = cairo.font_options_get_hint_metrics(options);
  * 
- * Allocates a new font options object with all options initialized to default values.
+ * Get the hint metrics for the font options object.
  * 
- * Free the returned object with cairo.font_options_destroy(). 
+ * The return value may be one of:
  * 
- * This function always returns a valid pointer; if memory cannot be allocated, then a special error object is returned where all operations on the object do nothing. You can check for this with cairo.font_options_status().
+ * + cairo.HINT_METRICS_DEFAULT - Hint metrics in the default manner for the font backend and target device.
+ * + cairo.HINT_METRICS_OFF - Do not hint font metrics.
+ * + cairo.HINT_METRICS_ON - Hint font metrics.
  * 
- * @return {object} options - opaque handle to a font options object.
+ * @param {object} options - opaque handle to a font options object.
+ * @return {int} hint_metrics - one of the above values.
  */
-static JSVAL font_options_create(JSARGS args) {
-    return External::New(cairo_font_options_create());
+static JSVAL font_options_get_hint_metrics(JSARGS args) {
+    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
+    return Integer::New(cairo_font_options_get_hint_metrics(options));
+}
+
+////////////////////////// THREAD POOL
+
+// A fixed set of worker threads, started on first use, that share the tasks of one job at
+// a time with the calling thread.  thread_pool_run() returns when every task is done.
+// Workers are numbered from 0; the calling thread is worker thread_pool_size().
+// Between jobs, idle workers also run background work queued by thread_pool_submit(),
+// which returns at once.
+typedef void (*thread_pool_task)(void *closure, int task, int worker);
+typedef void (*thread_pool_background)(void *closure);
+
+struct ThreadPoolItem {
+    thread_pool_background fn;
+    void *closure;
+    ThreadPoolItem *next;
+};
+
+struct ThreadPool {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    int threads;
+    unsigned generation;
+    thread_pool_task fn;
+    void *closure;
+    int tasks;
+    int next;
+    int running;
+    int limit;      // workers numbered below this take part in the current job
+    ThreadPoolItem *queue;
+    ThreadPoolItem *queueTail;
+};
+
+static ThreadPool thread_pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, -1 };
+
+// take and run tasks until there are none left; called and returns with the lock held
+static void thread_pool_work(ThreadPool *pool, int worker) {
+    while (pool->next < pool->tasks) {
+        int task = pool->next++;
+        pool->running++;
+        pthread_mutex_unlock(&pool->lock);
+        pool->fn(pool->closure, task, worker);
+        pthread_mutex_lock(&pool->lock);
+        pool->running--;
+    }
+    if (pool->running == 0) {
+        pthread_cond_broadcast(&pool->idle);
+    }
+}
+
+static void *thread_pool_worker(void *arg) {
+    ThreadPool *pool = &thread_pool;
+    int worker = (int) (intptr_t) arg;
+    unsigned seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->queue) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->generation != seen) {
+            seen = pool->generation;
+            if (worker < pool->limit) {
+                thread_pool_work(pool, worker);
+            }
+            continue;
+        }
+        ThreadPoolItem *item = pool->queue;
+        pool->queue = item->next;
+        if (!pool->queue) {
+            pool->queueTail = NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        item->fn(item->closure);
+        delete item;
+        pthread_mutex_lock(&pool->lock);
+    }
+    return NULL;
+}
+
+static int thread_pool_size() {
+    ThreadPool *pool = &thread_pool;
+    if (pool->threads < 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        pool->threads = 0;
+        for (int i = 0; i < cpus - 1; i++) {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, thread_pool_worker, (void *) (intptr_t) i) != 0) {
+                break;
+            }
+            pthread_detach(thread);
+            pool->threads++;
+        }
+    }
+    return pool->threads;
+}
+
+// Run tasks 0 .. tasks-1 on at most concurrency threads, the caller included.
+static void thread_pool_run(int tasks, int concurrency, thread_pool_task fn, void *closure) {
+    ThreadPool *pool = &thread_pool;
+    int worker = thread_pool_size();
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->closure = closure;
+    pool->tasks = tasks;
+    pool->next = 0;
+    pool->running = 0;
+    pool->limit = concurrency > 0 ? concurrency - 1 : pool->threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    thread_pool_work(pool, worker);
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Queue fn(closure) to run on a worker thread, or run it now if there are no workers.
+static void thread_pool_submit(thread_pool_background fn, void *closure) {
+    ThreadPool *pool = &thread_pool;
+    if (thread_pool_size() == 0) {
+        fn(closure);
+        return;
+    }
+    ThreadPoolItem *item = new ThreadPoolItem;
+    item->fn = fn;
+    item->closure = closure;
+    item->next = NULL;
+    pthread_mutex_lock(&pool->lock);
+    if (pool->queueTail) {
+        pool->queueTail->next = item;
+    }
+    else {
+        pool->queue = item;
+    }
+    pool->queueTail = item;
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
 }
 
+////////////////////////// PNG SUPPORT
+
 /**
- * @function cairo.font_options_copy
+ * @function cairo.image_surface_create_from_png
  * 
  * ### Synopsis
  * 
- * var copy = cairo.font_options_copy(original);
+ * var surface = cairo.image_surface_create_from_png(filename);
  * 
- * Allocates a new font options object copying the option values from original.
+ * Creates a new image surface and initializes the contents to the given PNG file.
  * 
- * Free the returned object with cairo.font_options_destroy(). 
+ * If an error occurs, this function returns a "nil" surface.  A nil surface can be checked for with cairo.surface_status(surface) which may return one of the following values: cairo.STATUS_NO_MEMORY, cairo.STATUS_FILE_NOT_FOUND, or  cairo.STATUS_READ_ERROR.
  * 
- * This function always returns a valid pointer; if memory cannot be allocated, then a special error object is returned where all operations on the object do nothing. You can check for this with cairo.font_options_status().
+ * Alternatively, you can allow errors to propagate through the drawing operations and check the status on the context upon completion using cairo.context_status()..
  * 
- * @param {object} original- opaque handle to a font options object.
- * @return {object} copy - opaque handle to a copy of the original font options object.
+ * @param {string} filename - name of PNG file to load.
+ * @return {object} surface - opaque handle to a newly created surface.
  */
-static JSVAL font_options_copy(JSARGS args) {
-    cairo_font_options_t *original = (cairo_font_options_t *)JSEXTERN(args[0]);
-    return External::New(cairo_font_options_copy(original));
+static JSVAL image_surface_create_from_png(JSARGS args) {
+    MetricsTimer timer(METRICS_IMAGE_DECODE, "decode");
+    String::Utf8Value filename(args[0]->ToString());
+    timer.arg("filename", *filename);
+    timer.arg("decoder", "cairo");
+    return External::New(track_surface(cairo_image_surface_create_from_png(*filename)));
+}
+
+// PNG decoder.  Reads 8 bit non-interlaced grayscale, RGB, palette, gray+alpha and RGBA images
+// (the common cases) straight into a premultiplied ARGB32 or RGB24 surface: as each scanline
+// is inflated, it is unfiltered and each pixel converted and premultiplied in the same loop,
+// instead of libpng's separate unfilter, transform and premultiply passes.  The surface comes
+// from large_surface_create(), so big images get aligned rows and huge pages.  Anything else
+// (16 bit, sub-byte depths, interlacing, color-key transparency) returns NULL, and so do
+// corrupt files, leaving the caller to fall back to cairo's reader.
+typedef bool (*png_read_func)(void *closure, uint8_t *data, size_t length);
+
+static bool png_read_file(void *closure, uint8_t *data, size_t length) {
+    return fread(data, 1, length, (FILE *) closure) == length;
+}
+
+static uint32_t png_get_uint32(const uint8_t *p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+// (c * a) / 255, rounded, as cairo premultiplies
+static inline uint32_t png_premultiply(uint32_t c, uint32_t a) {
+    uint32_t t = c * a + 0x80;
+    return ((t >> 8) + t) >> 8;
+}
+
+#define PNG_ROW_PAD 8   // zeroes before each scanline, so the left neighbour of the first pixel needs no test
+
+struct PngReader {
+    png_read_func read;
+    void *closure;
+    int width;
+    int height;
+    int colorType;
+    int bpp;            // bytes per pixel
+    size_t rowBytes;
+    uint32_t palette[256];
+    int paletteSize;
+    bool alpha;
+    uint8_t *row;       // PNG_ROW_PAD + rowBytes; the filter byte is inflated into row[PNG_ROW_PAD - 1]
+    uint8_t *prev;
+    size_t filled;      // bytes of the current scanline inflated so far, including the filter byte
+    int y;
+    cairo_surface_t *surface;
+    uint8_t *data;
+    int stride;
+    bool refused;       // over the memory limits
+};
+
+// Paeth predictor
+static inline int png_paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+}
+
+static inline uint32_t png_pixel(PngReader *png, const uint8_t *p) {
+    switch (png->colorType) {
+        case 0:
+            return 0xff000000 | ((uint32_t) p[0] * 0x010101);
+        case 2:
+            return 0xff000000 | ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+        case 3:
+            return png->palette[p[0]];
+        case 4: {
+            uint32_t g = png_premultiply(p[0], p[1]);
+            return ((uint32_t) p[1] << 24) | (g * 0x010101);
+        }
+        default: {
+            uint32_t a = p[3];
+            if (a == 255) {
+                return 0xff000000 | ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+            }
+            return (a << 24) | (png_premultiply(p[0], a) << 16) | (png_premultiply(p[1], a) << 8) | png_premultiply(p[2], a);
+        }
+    }
+}
+
+// Unfilter the scanline just inflated, writing each pixel to the surface as soon as its bytes are reconstructed.
+static bool png_decode_row(PngReader *png) {
+    uint8_t *row = png->row + PNG_ROW_PAD;
+    const uint8_t *prev = png->prev + PNG_ROW_PAD;
+    int filter = row[-1], bpp = png->bpp;
+    uint32_t *out = (uint32_t *) (png->data + (size_t) png->y * png->stride);
+    row[-1] = 0;
+    if (filter > 4) {
+        return false;
+    }
+    size_t i = 0;
+    for (int x = 0; x < png->width; x++) {
+        for (size_t end = i + bpp; i < end; i++) {
+            switch (filter) {
+                case 1:
+                    row[i] += row[i - bpp];
+                    break;
+                case 2:
+                    row[i] += prev[i];
+                    break;
+                case 3:
+                    row[i] += (row[i - bpp] + prev[i]) >> 1;
+                    break;
+                case 4:
+                    row[i] += png_paeth(row[i - bpp], prev[i], prev[i - bpp]);
+                    break;
+            }
+        }
+        out[x] = png_pixel(png, row + i - bpp);
+    }
+    uint8_t *t = png->row;
+    png->row = png->prev;
+    png->prev = t;
+    png->y++;
+    return true;
+}
+
+// Inflate compressed image data, decoding each scanline as it completes.
+static bool png_inflate(PngReader *png, z_stream *zs, uint8_t *data, size_t length) {
+    zs->next_in = data;
+    zs->avail_in = length;
+    while (zs->avail_in > 0 && png->y < png->height) {
+        zs->next_out = png->row + PNG_ROW_PAD - 1 + png->filled;
+        zs->avail_out = 1 + png->rowBytes - png->filled;
+        int ret = inflate(zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END) {
+            return false;
+        }
+        png->filled = 1 + png->rowBytes - zs->avail_out;
+        if (png->filled == 1 + png->rowBytes) {
+            png->filled = 0;
+            if (!png_decode_row(png)) {
+                return false;
+            }
+        }
+        if (ret == Z_STREAM_END) {
+            break;
+        }
+    }
+    return true;
+}
+
+static bool png_reader_header(PngReader *png, const uint8_t *ihdr, size_t length) {
+    if (length != 13) {
+        return false;
+    }
+    uint32_t width = png_get_uint32(ihdr), height = png_get_uint32(ihdr + 4);
+    int depth = ihdr[8];
+    png->colorType = ihdr[9];
+    if (width == 0 || height == 0 || width > 32767 || height > 32767) {
+        return false;
+    }
+    char msg[256];
+    if (!memory_admit("png_decode", width, height, msg, sizeof(msg))) {
+        png->refused = true;
+        return false;
+    }
+    if (depth != 8 || ihdr[10] != 0 || ihdr[11] != 0 || ihdr[12] != 0) {
+        return false;
+    }
+    switch (png->colorType) {
+        case 0: png->bpp = 1; break;
+        case 2: png->bpp = 3; break;
+        case 3: png->bpp = 1; break;
+        case 4: png->bpp = 2; break;
+        case 6: png->bpp = 4; break;
+        default: return false;
+    }
+    png->width = width;
+    png->height = height;
+    png->rowBytes = (size_t) width * png->bpp;
+    png->alpha = png->colorType == 4 || png->colorType == 6;
+    for (int i = 0; i < 256; i++) {
+        png->palette[i] = 0xff000000;
+    }
+    return true;
+}
+
+static bool png_reader_palette(PngReader *png, const uint8_t *plte, size_t length) {
+    if (length % 3 || length > 768) {
+        return false;
+    }
+    png->paletteSize = length / 3;
+    for (int i = 0; i < png->paletteSize; i++) {
+        png->palette[i] = 0xff000000 | ((uint32_t) plte[i * 3] << 16) | ((uint32_t) plte[i * 3 + 1] << 8) | plte[i * 3 + 2];
+    }
+    return true;
+}
+
+static bool png_reader_transparency(PngReader *png, const uint8_t *trns, size_t length) {
+    if (png->colorType != 3 || (int) length > png->paletteSize) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        uint32_t a = trns[i], c = png->palette[i];
+        png->palette[i] = (a << 24) | (png_premultiply((c >> 16) & 0xff, a) << 16)
+            | (png_premultiply((c >> 8) & 0xff, a) << 8) | png_premultiply(c & 0xff, a);
+    }
+    png->alpha = true;
+    return true;
+}
+
+static bool png_reader_begin_image(PngReader *png) {
+    png->surface = large_surface_create(png->alpha ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24, png->width, png->height);
+    if (cairo_surface_status(png->surface) != CAIRO_STATUS_SUCCESS) {
+        return false;
+    }
+    png->data = cairo_image_surface_get_data(png->surface);
+    png->stride = cairo_image_surface_get_stride(png->surface);
+    png->row = (uint8_t *) calloc(1, PNG_ROW_PAD + png->rowBytes);
+    png->prev = (uint8_t *) calloc(1, PNG_ROW_PAD + png->rowBytes);
+    return png->row && png->prev;
+}
+
+// Returns NULL for images it does not handle and for errors; *refused is set if the image is
+// over the memory limits, and should not be read any other way either.
+static cairo_surface_t *png_decode(png_read_func read, void *closure, bool *refused) {
+    static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    const size_t bufferSize = 64 * 1024;
+    PngReader png;
+    memset(&png, 0, sizeof(png));
+    png.read = read;
+    png.closure = closure;
+
+    uint8_t header[8];
+    if (!read(closure, header, 8) || memcmp(header, signature, 8) != 0) {
+        return NULL;
+    }
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit(&zs) != Z_OK) {
+        return NULL;
+    }
+    uint8_t *buffer = (uint8_t *) malloc(bufferSize);
+    bool ok = buffer != NULL, done = false, header_seen = false;
+    while (ok && !done) {
+        uint8_t crcBytes[4];
+        if (!read(closure, header, 8)) {
+            ok = false;
+            break;
+        }
+        size_t length = png_get_uint32(header);
+        const uint8_t *type = header + 4;
+        bool idat = memcmp(type, "IDAT", 4) == 0;
+        uLong crc = crc32(0, type, 4);
+        if (!header_seen && memcmp(type, "IHDR", 4) != 0) {
+            ok = false;
+            break;
+        }
+        if (idat && !png.surface) {
+            if ((png.colorType == 3 && png.paletteSize == 0) || !png_reader_begin_image(&png)) {
+                ok = false;
+                break;
+            }
+        }
+        // chunks stream through the buffer; the ones interpreted below are small enough to fit whole
+        size_t offset = 0;
+        do {
+            size_t n = length - offset < bufferSize ? length - offset : bufferSize;
+            if (n && !read(closure, buffer, n)) {
+                ok = false;
+                break;
+            }
+            crc = crc32(crc, buffer, n);
+            offset += n;
+            if (idat) {
+                ok = png_inflate(&png, &zs, buffer, n);
+            }
+        } while (ok && offset < length);
+        if (!ok || !read(closure, crcBytes, 4) || png_get_uint32(crcBytes) != crc) {
+            ok = false;
+            break;
+        }
+        if (memcmp(type, "IHDR", 4) == 0) {
+            ok = !header_seen && png_reader_header(&png, buffer, length);
+            header_seen = true;
+        }
+        else if (memcmp(type, "PLTE", 4) == 0) {
+            ok = png_reader_palette(&png, buffer, length);
+        }
+        else if (memcmp(type, "tRNS", 4) == 0) {
+            ok = !png.surface && png_reader_transparency(&png, buffer, length);
+        }
+        else if (memcmp(type, "IEND", 4) == 0) {
+            done = true;
+        }
+        else if (!idat && (type[0] & 0x20) == 0) {
+            // unknown critical chunk
+            ok = false;
+        }
+    }
+    inflateEnd(&zs);
+    free(buffer);
+    free(png.row);
+    free(png.prev);
+    *refused = png.refused;
+    if (!ok || png.y < png.height) {
+        if (png.surface) {
+            cairo_surface_destroy(png.surface);
+        }
+        return NULL;
+    }
+    cairo_surface_mark_dirty(png.surface);
+    return png.surface;
 }
 
 /**
- * @functino cairo.font_options_destroy
+ * @function cairo.image_surface_decode_png
  * 
  * ### Synopsis
  * 
- * cairo.font_options_destroy(options);
+ * var surface = cairo.image_surface_decode_png(filename);
  * 
- * Destroys a cairo font_options object created with cairo.font_options_create() or cairo.font_options_copy().
+ * Creates a new image surface and initializes the contents to the given PNG file, like cairo.image_surface_create_from_png(), but faster.
  * 
- * @return {object} options - opaque handle to a font options object.
- * @return 
+ * 8 bit images that are not interlaced, which is nearly all of them, are decoded directly into premultiplied pixels in one pass over each row, into a surface allocated like cairo.image_surface_create() allocates one.  Other images, and files that cannot be read, are handed to cairo.image_surface_create_from_png(), so the result and the errors reported are the same.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {string} filename - name of PNG file to load.
+ * @return {object} surface - opaque handle to a newly created surface.
  */
-static JSVAL font_options_destroy(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    cairo_font_options_destroy(options);
-    return Undefined();
+static cairo_surface_t *png_load(const char *filename) {
+    MetricsTimer timer(METRICS_IMAGE_DECODE, "decode");
+    timer.arg("filename", filename);
+    FILE *fp = fopen(filename, "rb");
+    if (fp) {
+        bool refused = false;
+        cairo_surface_t *surface = png_decode(png_read_file, fp, &refused);
+        fclose(fp);
+        if (surface) {
+            return surface;
+        }
+        if (refused) {
+            // an error surface, without allocating anything
+            return cairo_image_surface_create(CAIRO_FORMAT_ARGB32, -1, -1);
+        }
+    }
+    return cairo_image_surface_create_from_png(filename);
+}
+
+static JSVAL image_surface_decode_png(JSARGS args) {
+    String::Utf8Value filename(args[0]->ToString());
+    return External::New(track_surface(png_load(*filename)));
 }
 
 /**
- * @function cairo.font_options_status
+ * @function cairo.image_png_size
  * 
  * ### Synopsis
  * 
- * var status = cairo.font_options_status(options);
+ * var size = cairo.image_png_size(filename);
  * 
- * Checks whether an error has previously occurred for this font options object
+ * Reads just the header of a PNG file to find the image's dimensions, without decoding it.
  * 
- * @param {object} options - opaque handle to a font options object.
- * @return {int} status - one of cairo.STATUS_SUCCESS or cairo.STATUS_NO_MEMORY.
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {string} filename - name of PNG file.
+ * @return {object} size - {width, height}, or null if the file cannot be read or is not a PNG.
  */
-static JSVAL font_options_status(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_font_options_status(options));
+static JSVAL image_png_size(JSARGS args) {
+    static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    String::Utf8Value filename(args[0]->ToString());
+    FILE *fp = fopen(*filename, "rb");
+    if (!fp) {
+        return Null();
+    }
+    // signature, then IHDR's length, type, width and height
+    uint8_t header[24];
+    bool ok = fread(header, 1, 24, fp) == 24
+        && memcmp(header, signature, 8) == 0
+        && memcmp(header + 12, "IHDR", 4) == 0;
+    fclose(fp);
+    if (!ok) {
+        return Null();
+    }
+    JSOBJ o = Object::New();
+    o->Set(String::New("width"), Integer::New(png_get_uint32(header + 16)));
+    o->Set(String::New("height"), Integer::New(png_get_uint32(header + 20)));
+    return o;
+}
+
+// Background image loads.  The file is decoded on a thread pool worker while JavaScript
+// carries on; the surface is collected with image_load_finish().
+struct ImageLoad {
+    char *filename;
+    cairo_surface_t *surface;
+    bool done;
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+};
+
+static void image_load_run(void *closure) {
+    ImageLoad *load = (ImageLoad *) closure;
+    cairo_surface_t *surface = png_load(load->filename);
+    pthread_mutex_lock(&load->lock);
+    load->surface = surface;
+    load->done = true;
+    pthread_cond_broadcast(&load->finished);
+    pthread_mutex_unlock(&load->lock);
 }
 
 /**
- * @function cairo.font_options_merge
+ * @function cairo.image_load_start
  * 
  * ### Synopsis
  * 
- * cairo.font_options_merge(options, other);
+ * var load = cairo.image_load_start(filename);
  * 
- * Merges non-default options from other into options, replacing existing values. 
+ * Starts decoding a PNG file, as cairo.image_surface_decode_png() would, on a background thread, and returns at once.
  * 
- * This operation can be thought of as somewhat similar to compositing other onto options with the operation of cairo.OPERATOR_OVER.
+ * Use cairo.image_load_done() to find out whether the decode has finished, and cairo.image_load_finish() to collect the surface.  Many loads may be in progress at once; they are spread over the native thread pool.
  * 
- * @param {object} options - opaque handle to a font options object.
- * @param {object} other - opaque handle to a font options object.
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {string} filename - name of PNG file to load.
+ * @return {object} load - opaque handle to the load, which must be passed to cairo.image_load_finish().
  */
-static JSVAL font_options_merge(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    cairo_font_options_t *other = (cairo_font_options_t *)JSEXTERN(args[1]);
-    cairo_font_options_merge(options, other);
-    return Undefined();
+static JSVAL image_load_start(JSARGS args) {
+    String::Utf8Value filename(args[0]->ToString());
+    ImageLoad *load = new ImageLoad;
+    load->filename = strdup(*filename);
+    load->surface = NULL;
+    load->done = false;
+    pthread_mutex_init(&load->lock, NULL);
+    pthread_cond_init(&load->finished, NULL);
+    thread_pool_submit(image_load_run, load);
+    return External::New(load);
 }
 
 /**
- * @function cairo.font_options_hash
+ * @function cairo.image_load_done
  * 
  * ### Synopsis
  * 
- * var hash = cairo.font_options_hash(options);
+ * var done = cairo.image_load_done(load);
  * 
- * Compute a hash for the font options object; this value will be useful when storing an object containing a cairo font_options in a hash table.
+ * Determine whether a load started with cairo.image_load_start() has finished decoding, without waiting for it.
  * 
- * @return {object} options - opaque handle to a font options object.
- * @return {int} hash - the hash value for the font options object, cast to a 32-bit value.
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} load - opaque handle to the load.
+ * @return {boolean} done - true if cairo.image_load_finish() will return without waiting.
  */
-static JSVAL font_options_hash(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_font_options_hash(options));
+static JSVAL image_load_done(JSARGS args) {
+    ImageLoad *load = (ImageLoad *) JSEXTERN(args[0]);
+    pthread_mutex_lock(&load->lock);
+    bool done = load->done;
+    pthread_mutex_unlock(&load->lock);
+    return done ? True() : False();
 }
 
 /**
- * @function cairo.font_options_equal
+ * @function cairo.image_load_finish
  * 
  * ### Synopsis
  * 
- * var is_equal = cairo.font_options_equal(options, other);
+ * var surface = cairo.image_load_finish(load);
  * 
- * Compare two font options objects for equality.
+ * Waits for a load started with cairo.image_load_start() to finish, releases the load, and returns the decoded surface.
  * 
- * @param {object} options - opaque handle to a font options object.
- * @param {object} other - opaque handle to a font options object.
- * @return {boolean} is_equal - true if the two font options objects are equal.
+ * As with cairo.image_surface_create_from_png(), errors are reported by returning a "nil" surface; check it with cairo.surface_status().
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} load - opaque handle to the load; it may not be used afterwards.
+ * @return {object} surface - opaque handle to a newly created surface.
  */
-static JSVAL font_options_equal(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    cairo_font_options_t *other = (cairo_font_options_t *)JSEXTERN(args[1]);
-    return cairo_font_options_equal(options, other) ? True() : False();
+static JSVAL image_load_finish(JSARGS args) {
+    ImageLoad *load = (ImageLoad *) JSEXTERN(args[0]);
+    pthread_mutex_lock(&load->lock);
+    while (!load->done) {
+        pthread_cond_wait(&load->finished, &load->lock);
+    }
+    pthread_mutex_unlock(&load->lock);
+    cairo_surface_t *surface = load->surface;
+    pthread_mutex_destroy(&load->lock);
+    pthread_cond_destroy(&load->finished);
+    free(load->filename);
+    delete load;
+    return External::New(track_surface(surface));
 }
 
 /**
- * @function cairo.font_options_set_antialias
+ * @function cairo.surface_write_to_png
  * 
- * Synopsis:
+ * ### Synopsis
  * 
- * cairo.font_options_set_antialias(options, mode);
+ * var status = cairo.surface_write_to_png(surface, filename);
  * 
- * Sets the antialiasing mode for the font options object. 
+ * Writes the contents of surface to a new file filename as a PNG image.
  * 
- * This specifies the type of antialiasing to do when rendering text.
+ * If an error occurs, the value returned may be:
  * 
- * Valid modes are:
+ * + cairo.STATUS_NO_MEMORY if memory could not be allocated for the operation.
+ * + cairo.STATUS_SURFACE_TYPE_MISMATCH if the surface does not have pixel contents.
+ * + cairo.STATUS_WRITE_ERROR if an I/O error occurs while attempting to write the file..
  * 
- * + cairo.ANTIALIAS_DEFAULT - use the default antialiasing for the subsystem and target device.
- * + cairo.ANTIALIAS_NONE - use a bilevel alpha mask.
- * + cairo.ANTIALIAS_GRAY - perform single-color antialiasing (using shades of gray for black text on a white background, for example).
- * + cairo.ANTIALIAS_SUBPIXEL - perform antialiasing by taking advantage of the order of subpixel elements on devices such as LCD panels.
- * + cairo_ANTIALIAS_FAST - Hint that the backend should perform some antialiasing but prefer speed over quality, since 1.12.
- * + cairo.ANTIALIAS_GOOD - The backend should balance quality against performance, since 1.12.
- * + CAIRO_ANTIALIAS_BEST - Hint that the backend should render at the highest quality, sacrificing speed if necessary, since 1.12
-* 
- * @param {object} options - opaque handle to a font options object.
- * @param {int} mode - one of the above modes.
+ * @param {object} surface - opaque handle to a cairo surface.
+ * @return {int} status - either cairo.STATUS_SUCCESS, or one of the above values if an error occurred.
  */
-static JSVAL font_options_set_antialias(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    cairo_font_options_set_antialias(options, (cairo_antialias_t)args[1]->IntegerValue());
-    return Undefined();
+static JSVAL surface_write_to_png(JSARGS args) {
+    MetricsTimer timer(METRICS_PNG_ENCODE, "write_to_png");
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    String::Utf8Value filename(args[1]->ToString());
+    timer.arg("filename", *filename);
+    return Integer::New(cairo_surface_write_to_png(surface, *filename));
+}
+
+// Streaming PNG encoder.  Rows are fed one at a time and compressed as they arrive, and
+// each block of deflate output is emitted as its own IDAT chunk, so neither the image
+// nor the compressed stream is ever held in memory as a whole.  Output is 8-bit RGBA,
+// non-interlaced, with filter type None.
+//
+// Bytes are handed to the write callback, which returns false on error.
+typedef bool (*png_write_func)(void *closure, const uint8_t *data, size_t length);
+
+struct PngWriter {
+    png_write_func write;
+    void *closure;
+    z_stream zs;
+    int width;
+    int height;
+    int rows;
+    uint8_t *row;
+    uint8_t *out;
+    size_t outSize;
+    bool failed;
+};
+
+static bool png_write_file(void *closure, const uint8_t *data, size_t length) {
+    return fwrite(data, 1, length, (FILE *) closure) == length;
+}
+
+static void png_put_uint32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void png_writer_chunk(PngWriter *png, const char *type, const uint8_t *data, size_t length) {
+    uint8_t header[8], trailer[4];
+    png_put_uint32(header, length);
+    memcpy(header + 4, type, 4);
+    uLong crc = crc32(0, header + 4, 4);
+    if (length) {
+        crc = crc32(crc, data, length);
+    }
+    png_put_uint32(trailer, crc);
+    if (png->failed
+        || !png->write(png->closure, header, 8)
+        || (length && !png->write(png->closure, data, length))
+        || !png->write(png->closure, trailer, 4)) {
+        png->failed = true;
+    }
 }
+
+// Run deflate over whatever input is pending, emitting an IDAT chunk each time the output buffer fills.
+static void png_writer_deflate(PngWriter *png, int flush) {
+    for (;;) {
+        int ret = deflate(&png->zs, flush);
+        if (ret == Z_STREAM_ERROR) {
+            png->failed = true;
+            return;
+        }
+        if (png->zs.avail_out == 0 || ret == Z_STREAM_END) {
+            png_writer_chunk(png, "IDAT", png->out, png->outSize - png->zs.avail_out);
+            png->zs.next_out = png->out;
+            png->zs.avail_out = png->outSize;
+        }
+        if (ret == Z_STREAM_END || (flush != Z_FINISH && png->zs.avail_in == 0 && png->zs.avail_out != 0)) {
+            return;
+        }
+    }
+}
+
+// Write the signature and IHDR chunk.
+static void png_writer_header(PngWriter *png) {
+    static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    uint8_t ihdr[13];
+    png_put_uint32(ihdr, png->width);
+    png_put_uint32(ihdr + 4, png->height);
+    ihdr[8] = 8;        // bit depth
+    ihdr[9] = 6;        // color type RGBA
+    ihdr[10] = 0;       // deflate
+    ihdr[11] = 0;       // adaptive filtering
+    ihdr[12] = 0;       // not interlaced
+    if (!png->write(png->closure, signature, 8)) {
+        png->failed = true;
+    }
+    png_writer_chunk(png, "IHDR", ihdr, 13);
+}
+
+// Convert a row of cairo pixels (ARGB32, premultiplied, or RGB24) to a PNG scanline:
+// the filter type byte followed by straight RGBA.
+static void png_convert_row(uint8_t *p, const uint32_t *pixels, int width, cairo_format_t format) {
+    *p++ = 0;           // filter type None
+    for (int x = 0; x < width; x++) {
+        uint32_t pixel = pixels[x];
+        uint8_t a = format == CAIRO_FORMAT_RGB24 ? 255 : pixel >> 24;
+        if (a == 0) {
+            p[0] = p[1] = p[2] = p[3] = 0;
+        }
+        else if (a == 255) {
+            p[0] = pixel >> 16;
+            p[1] = pixel >> 8;
+            p[2] = pixel;
+            p[3] = 255;
+        }
+        else {
+            p[0] = (((pixel >> 16) & 0xff) * 255 + a / 2) / a;
+            p[1] = (((pixel >> 8) & 0xff) * 255 + a / 2) / a;
+            p[2] = ((pixel & 0xff) * 255 + a / 2) / a;
+            p[3] = a;
+        }
+        p += 4;
+    }
+}
+
+static bool png_writer_begin(PngWriter *png, png_write_func write, void *closure, int width, int height, int level) {
+    memset(png, 0, sizeof(PngWriter));
+    png->write = write;
+    png->closure = closure;
+    png->width = width;
+    png->height = height;
+    if (deflateInit(&png->zs, level) != Z_OK) {
+        return false;
+    }
+    png->row = (uint8_t *) malloc(1 + (size_t) width * 4);
+    png->outSize = 64 * 1024;
+    png->out = (uint8_t *) malloc(png->outSize);
+    if (!png->row || !png->out) {
+        png->failed = true;
+        return false;
+    }
+    png->zs.next_out = png->out;
+    png->zs.avail_out = png->outSize;
+    png_writer_header(png);
+    return !png->failed;
+}
+
+// Add one row of cairo pixels (ARGB32, premultiplied, or RGB24) to the image.
+static void png_writer_row(PngWriter *png, const uint32_t *pixels, cairo_format_t format) {
+    png_convert_row(png->row, pixels, png->width, format);
+    png->zs.next_in = png->row;
+    png->zs.avail_in = 1 + (size_t) png->width * 4;
+    png_writer_deflate(png, Z_NO_FLUSH);
+    png->rows++;
+}
+
+// Finish the image and release the encoder.  Returns false if anything failed along the way.
+static bool png_writer_end(PngWriter *png) {
+    if (!png->failed && png->rows == png->height) {
+        png->zs.next_in = NULL;
+        png->zs.avail_in = 0;
+        png_writer_deflate(png, Z_FINISH);
+        png_writer_chunk(png, "IEND", NULL, 0);
+    }
+    else {
+        png->failed = true;
+    }
+    deflateEnd(&png->zs);
+    free(png->row);
+    free(png->out);
+    return !png->failed;
+}
+
+// Parallel PNG encoder, after pigz.  The scanlines are cut into chunks of about 128KB that
+// are compressed independently on the thread pool, each as raw deflate primed with the last
+// 32KB of the scanlines before it, so the compression ratio stays close to a single stream.
+// Every chunk but the last ends with a sync flush, which byte-aligns it, so the compressed
+// chunks concatenate into one valid deflate stream.  The zlib header goes in front and the
+// Adler-32 of the whole, combined from the chunks' checksums, at the end.  Chunks are
+// compressed a wave at a time and written in order, which bounds the memory in use.
+//
+// This runs tasks on the thread pool, so it must not be called from a pool task.
+#define PNG_CHUNK_BYTES (128 * 1024)
+#define PNG_WINDOW_BYTES (32 * 1024)
+
+struct PngParallel {
+    const uint8_t *data;
+    int stride;
+    cairo_format_t format;
+    int width;
+    int height;
+    int level;
+    int chunkRows;
+    int chunks;
+    int first;          // first chunk of the current wave
+    // per chunk of the wave
+    uint8_t **out;
+    size_t *outLength;
+    uLong *adler;
+    size_t *rawLength;
+    bool *failed;
+};
+
+static void png_parallel_task(void *closure, int task, int worker) {
+    PngParallel *job = (PngParallel *) closure;
+    int chunk = job->first + task;
+    size_t rowBytes = 1 + (size_t) job->width * 4;
+    int y0 = chunk * job->chunkRows;
+    int y1 = y0 + job->chunkRows < job->height ? y0 + job->chunkRows : job->height;
+    // scanlines before the chunk, for the dictionary
+    int dictRows = (int) ((PNG_WINDOW_BYTES + rowBytes - 1) / rowBytes);
+    int d0 = y0 - dictRows > 0 ? y0 - dictRows : 0;
+    bool last = chunk == job->chunks - 1;
+
+    job->out[task] = NULL;
+    job->failed[task] = true;
+    uint8_t *raw = (uint8_t *) malloc((size_t) (y1 - d0) * rowBytes);
+    if (!raw) {
+        return;
+    }
+    for (int y = d0; y < y1; y++) {
+        png_convert_row(raw + (size_t) (y - d0) * rowBytes, (const uint32_t *) (job->data + (size_t) y * job->stride), job->width, job->format);
+    }
+    uint8_t *input = raw + (size_t) (y0 - d0) * rowBytes;
+    size_t inputLength = (size_t) (y1 - y0) * rowBytes;
+    job->rawLength[task] = inputLength;
+    job->adler[task] = adler32(adler32(0, NULL, 0), input, inputLength);
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, job->level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        free(raw);
+        return;
+    }
+    if (y0 > d0) {
+        size_t dictLength = (size_t) (y0 - d0) * rowBytes;
+        if (dictLength > PNG_WINDOW_BYTES) {
+            dictLength = PNG_WINDOW_BYTES;
+        }
+        deflateSetDictionary(&zs, input - dictLength, dictLength);
+    }
+    // room for the zlib header in front of the first chunk and the checksum after the last
+    size_t size = deflateBound(&zs, inputLength) + 16;
+    uint8_t *out = (uint8_t *) malloc(size + 6);
+    if (out) {
+        zs.next_in = input;
+        zs.avail_in = inputLength;
+        zs.next_out = out + 2;
+        zs.avail_out = size;
+        int ret = deflate(&zs, last ? Z_FINISH : Z_SYNC_FLUSH);
+        if (ret == (last ? Z_STREAM_END : Z_OK) && zs.avail_in == 0) {
+            job->out[task] = out;
+            job->outLength[task] = size - zs.avail_out;
+            job->failed[task] = false;
+        }
+        else {
+            free(out);
+        }
+    }
+    deflateEnd(&zs);
+    free(raw);
+}
+
+// Write an image surface's pixels as a PNG, compressing on up to threads threads (0 for all).
+static cairo_status_t png_write_parallel(png_write_func write, void *closure, cairo_surface_t *surface, int level, int threads) {
+    cairo_format_t format = cairo_image_surface_get_format(surface);
+    if (cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE
+        || (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24)) {
+        return CAIRO_STATUS_SURFACE_TYPE_MISMATCH;
+    }
+    cairo_surface_flush(surface);
+
+    PngParallel job;
+    memset(&job, 0, sizeof(job));
+    job.data = cairo_image_surface_get_data(surface);
+    job.stride = cairo_image_surface_get_stride(surface);
+    job.format = format;
+    job.width = cairo_image_surface_get_width(surface);
+    job.height = cairo_image_surface_get_height(surface);
+    job.level = level;
+    size_t rowBytes = 1 + (size_t) job.width * 4;
+    job.chunkRows = rowBytes >= PNG_CHUNK_BYTES ? 1 : (int) (PNG_CHUNK_BYTES / rowBytes);
+    job.chunks = (job.height + job.chunkRows - 1) / job.chunkRows;
+    if (job.chunks == 0) {
+        return CAIRO_STATUS_INVALID_SIZE;
+    }
+    int wave = (thread_pool_size() + 1) * 4;
+    job.out = (uint8_t **) calloc(wave, sizeof(uint8_t *));
+    job.outLength = (size_t *) calloc(wave, sizeof(size_t));
+    job.adler = (uLong *) calloc(wave, sizeof(uLong));
+    job.rawLength = (size_t *) calloc(wave, sizeof(size_t));
+    job.failed = (bool *) calloc(wave, sizeof(bool));
+
+    PngWriter png;
+    memset(&png, 0, sizeof(png));
+    png.write = write;
+    png.closure = closure;
+    png.width = job.width;
+    png.height = job.height;
+    png_writer_header(&png);
+
+    // zlib header: deflate with a 32K window, and the level hint zlib itself would use
+    int levelHint = level == Z_DEFAULT_COMPRESSION || level == 6 ? 2 : level < 2 ? 0 : level < 6 ? 1 : 3;
+    int header = (0x78 << 8) | (levelHint << 6);
+    header += 31 - header % 31;
+    uLong adler = adler32(0, NULL, 0);
+
+    cairo_status_t status = CAIRO_STATUS_SUCCESS;
+    if (!job.out || !job.outLength || !job.adler || !job.rawLength || !job.failed) {
+        status = CAIRO_STATUS_NO_MEMORY;
+    }
+    for (job.first = 0; status == CAIRO_STATUS_SUCCESS && !png.failed && job.first < job.chunks; job.first += wave) {
+        int count = job.chunks - job.first < wave ? job.chunks - job.first : wave;
+        thread_pool_run(count, threads, png_parallel_task, &job);
+        for (int i = 0; i < count; i++) {
+            if (job.failed[i]) {
+                status = CAIRO_STATUS_NO_MEMORY;
+                break;
+            }
+            uint8_t *out = job.out[i] + 2;
+            size_t length = job.outLength[i];
+            adler = adler32_combine(adler, job.adler[i], job.rawLength[i]);
+            if (job.first + i == 0) {
+                out -= 2;
+                length += 2;
+                out[0] = header >> 8;
+                out[1] = header;
+            }
+            if (job.first + i == job.chunks - 1) {
+                png_put_uint32(out + length, adler);
+                length += 4;
+            }
+            png_writer_chunk(&png, "IDAT", out, length);
+        }
+        for (int i = 0; i < count; i++) {
+            free(job.out[i]);
+            job.out[i] = NULL;
+        }
+    }
+    if (status == CAIRO_STATUS_SUCCESS && !png.failed) {
+        png_writer_chunk(&png, "IEND", NULL, 0);
+    }
+    free(job.out);
+    free(job.outLength);
+    free(job.adler);
+    free(job.rawLength);
+    free(job.failed);
+    if (status == CAIRO_STATUS_SUCCESS && png.failed) {
+        status = CAIRO_STATUS_WRITE_ERROR;
+    }
+    return status;
+}
+
 /**
- * @function cairo.font_options_get_antialias
+ * @function cairo.surface_write_to_png_parallel
  * 
- * Synopsis:
+ * ### Synopsis
  * 
- * var mode = cairo.font_options_get_antialias(options);
+ * var status = cairo.surface_write_to_png_parallel(surface, filename);
+ * var status = cairo.surface_write_to_png_parallel(surface, filename, level);
+ * var status = cairo.surface_write_to_png_parallel(surface, filename, level, threads);
  * 
- * Gets the antialiasing mode for the font options object. 
+ * Writes the contents of an image surface to a new file filename as a PNG image, compressing on several threads at once.
  * 
- * Valid modes are:
+ * The rows are cut into chunks of about 128KB that are compressed in parallel on the native thread pool, each primed with the 32KB of image before it, and stitched into a single standard PNG.  The file is a little larger than a single-threaded encode, by a few bytes per chunk, and takes a fraction of the time on a multicore machine.
  * 
- * + cairo.ANTIALIAS_DEFAULT - use the default antialiasing for the subsystem and target device.
- * + cairo.ANTIALIAS_NONE - use a bilevel alpha mask.
- * + cairo.ANTIALIAS_GRAY - perform single-color antialiasing (using shades of gray for black text on a white background, for example).
- * + cairo.ANTIALIAS_SUBPIXEL - perform antialiasing by taking advantage of the order of subpixel elements on devices such as LCD panels.
- * + cairo_ANTIALIAS_FAST - Hint that the backend should perform some antialiasing but prefer speed over quality, since 1.12.
- * + cairo.ANTIALIAS_GOOD - The backend should balance quality against performance, since 1.12.
- * + CAIRO_ANTIALIAS_BEST - Hint that the backend should render at the highest quality, sacrificing speed if necessary, since 1.12
+ * The surface must be an ARGB32 or RGB24 image surface.  If an error occurs, the value returned may be:
  * 
- * @param {object} options - opaque handle to a font options object.
- * @return {int} mode - one of the above modes.
+ * + cairo.STATUS_NO_MEMORY if memory could not be allocated for the operation.
+ * + cairo.STATUS_SURFACE_TYPE_MISMATCH if the surface is not a supported image surface.
+ * + cairo.STATUS_WRITE_ERROR if an I/O error occurs while attempting to write the file.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} surface - opaque handle to an image surface.
+ * @param {string} filename - name of the PNG file to write.
+ * @param {int} level - optional zlib compression level, 0-9 or -1 for the default.
+ * @param {int} threads - optional most threads to use, 0 for all (the default).
+ * @return {int} status - either cairo.STATUS_SUCCESS, or one of the above values if an error occurred.
  */
-static JSVAL font_options_get_antialias(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_font_options_get_antialias(options));
+static JSVAL surface_write_to_png_parallel(JSARGS args) {
+    MetricsTimer timer(METRICS_PNG_ENCODE, "write_to_png");
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    String::Utf8Value filename(args[1]->ToString());
+    timer.arg("filename", *filename);
+    int level = args.Length() > 2 ? args[2]->IntegerValue() : Z_DEFAULT_COMPRESSION;
+    int threads = args.Length() > 3 ? args[3]->IntegerValue() : 0;
+    timer.arg("mode", "parallel");
+    FILE *fp = fopen(*filename, "wb");
+    if (!fp) {
+        return Integer::New(CAIRO_STATUS_WRITE_ERROR);
+    }
+    cairo_status_t status = png_write_parallel(png_write_file, fp, surface, level, threads);
+    if (fclose(fp) != 0 && status == CAIRO_STATUS_SUCCESS) {
+        status = CAIRO_STATUS_WRITE_ERROR;
+    }
+    return Integer::New(status);
+}
+
+// In-memory PNG output, for data URLs.
+struct PngBuffer {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+};
+
+static bool png_write_buffer(void *closure, const uint8_t *data, size_t length) {
+    PngBuffer *buffer = (PngBuffer *) closure;
+    if (buffer->length + length > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity * 2 : 64 * 1024;
+        while (capacity < buffer->length + length) {
+            capacity *= 2;
+        }
+        uint8_t *data = (uint8_t *) realloc(buffer->data, capacity);
+        if (!data) {
+            return false;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    return true;
+}
+
+static cairo_status_t png_write_buffer_cairo(void *closure, const unsigned char *data, unsigned int length) {
+    return png_write_buffer(closure, data, length) ? CAIRO_STATUS_SUCCESS : CAIRO_STATUS_WRITE_ERROR;
+}
+
+// Base64.  With SSSE3, 12 input bytes become 16 characters per step: pshufb spreads each
+// 3-byte group over 4 bytes, multiplies shift the 6-bit fields into place, and a second
+// pshufb maps each field's range to the offset that turns it into its character (after
+// Wojciech Muła).  Otherwise a 4096-entry table turns each 12 bits into two characters.
+static const char base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static size_t base64_encode(char *out, const uint8_t *src, size_t length) {
+    static uint16_t pairs[4096];
+    static bool initialized = false;
+    if (!initialized) {
+        for (int i = 0; i < 4096; i++) {
+            char p[2] = { base64_alphabet[i >> 6], base64_alphabet[i & 63] };
+            memcpy(&pairs[i], p, 2);
+        }
+        initialized = true;
+    }
+    char *start = out;
+    size_t i = 0;
+#ifdef __SSSE3__
+    const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    // the load reads 16 bytes to use 12
+    for (; i + 16 <= length; i += 12, out += 16) {
+        __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (src + i)), spread);
+        __m128i hi = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+        __m128i lo = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+        __m128i indices = _mm_or_si128(hi, lo);
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+        _mm_storeu_si128((__m128i *) out, _mm_add_epi8(indices, _mm_shuffle_epi8(shift, range)));
+    }
+#endif
+    for (; i + 3 <= length; i += 3, out += 4) {
+        uint32_t v = ((uint32_t) src[i] << 16) | ((uint32_t) src[i + 1] << 8) | src[i + 2];
+        memcpy(out, &pairs[v >> 12], 2);
+        memcpy(out + 2, &pairs[v & 0xfff], 2);
+    }
+    if (i < length) {
+        uint32_t v = (uint32_t) src[i] << 16;
+        if (i + 1 < length) {
+            v |= (uint32_t) src[i + 1] << 8;
+        }
+        out[0] = base64_alphabet[v >> 18];
+        out[1] = base64_alphabet[(v >> 12) & 63];
+        out[2] = i + 1 < length ? base64_alphabet[(v >> 6) & 63] : '=';
+        out[3] = '=';
+        out += 4;
+    }
+    return out - start;
 }
 
 /**
- * @function cairo.font_options_set_subpixel_order
+ * @function cairo.surface_to_data_url
  * 
  * ### Synopsis
  * 
- * cairo.font_options_set_subpixel_order(options, subpixel_order);
+ * var url = cairo.surface_to_data_url(surface);
+ * var url = cairo.surface_to_data_url(surface, level);
  * 
- * Sets the subpixel order for the font options object. 
+ * Encodes the contents of a surface as a PNG image in memory and returns it as a data: URL.
  * 
- * The subpixel order specifies the order of color elements within each pixel on the display device when rendering with an antialiasing mode of cairo.ANTIALIAS_SUBPIXEL.
+ * The PNG is written to a memory buffer and base64-encoded directly into the characters of the returned string, which JavaScript reads in place, so the image never touches the disk and is not copied again.
  * 
- * The value of subpixel_order may be one of the following:
+ * ### Note
  * 
- * + cairo.SUBPIXEL_ORDER_DEFAULT - Use the default subpixel order for for the target device.
- * + cairo.SUBPIXEL_ORDER_RGB - Subpixel elements are arranged horizontally with red at the left.
- * + cairo.SUBPIXEL_ORDER_BGR - Subpixel elements are arranged horizontally with blue at the left.
- * + cairo.SUBPIXEL_ORDER_VRGB - Subpixel elements are arranged vertically with red at the top.
- * + cairo.SUBPIXEL_ORDER_VBGR - Subpixel elements are arranged vertically with blue at the top.
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
  * 
- * @param {object} options - opaque handle to a font options object.
- * @return {int} subpixel_order - one of the above values.
+ * @param {object} surface - opaque handle to a surface.
+ * @param {int} level - optional zlib compression level, 0-9 or -1 for the default.
+ * @return {string} url - "data:image/png;base64,..." or null if the surface could not be encoded.
  */
-static JSVAL font_options_set_subpixel_order(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    cairo_font_options_set_subpixel_order(options, (cairo_subpixel_order_t)args[1]->IntegerValue());
-    return Undefined();
+static JSVAL surface_to_data_url(JSARGS args) {
+    MetricsTimer timer(METRICS_PNG_ENCODE, "to_data_url");
+    static const char prefix[] = "data:image/png;base64,";
+    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
+    int level = args.Length() > 1 ? args[1]->IntegerValue() : Z_DEFAULT_COMPRESSION;
+    PngBuffer png = { NULL, 0, 0 };
+    cairo_status_t status = png_write_parallel(png_write_buffer, &png, surface, level, 0);
+    if (status == CAIRO_STATUS_SURFACE_TYPE_MISMATCH) {
+        png.length = 0;
+        status = cairo_surface_write_to_png_stream(surface, png_write_buffer_cairo, &png);
+    }
+    char *url = NULL;
+    size_t length = sizeof(prefix) - 1 + (png.length + 2) / 3 * 4;
+    if (status == CAIRO_STATUS_SUCCESS) {
+        url = (char *) malloc(length);
+    }
+    if (!url) {
+        free(png.data);
+        return Null();
+    }
+    memcpy(url, prefix, sizeof(prefix) - 1);
+    base64_encode(url + sizeof(prefix) - 1, png.data, png.length);
+    free(png.data);
+    return String::NewExternal(new MallocAsciiString(url, length));
 }
 
+////////////////////////// RECORDING SURFACES
+
 /**
- * @function cairo.font_options_get_subpixel_order
+ * @function cairo.recording_surface_create
  * 
  * ### Synopsis
  * 
- * var subpixel_order = cairo.font_options_get_subpixel_order(options);
- * 
- * Get the subpixel order for the font options object.
+ * var surface = cairo.recording_surface_create(content);
+ * var surface = cairo.recording_surface_create(content, x, y, width, height);
  * 
- * The return value may be one of:
+ * Creates a recording-surface which can be used to record all drawing operations at the highest level (that is, the level of paint, mask, stroke, fill and show_text_glyphs).  The recording surface can then be "replayed" against any target surface by using it as a source to drawing operations.
  * 
- * + cairo.SUBPIXEL_ORDER_DEFAULT - Use the default subpixel order for for the target device.
- * + cairo.SUBPIXEL_ORDER_RGB - Subpixel elements are arranged horizontally with red at the left.
- * + cairo.SUBPIXEL_ORDER_BGR - Subpixel elements are arranged horizontally with blue at the left.
- * + cairo.SUBPIXEL_ORDER_VRGB - Subpixel elements are arranged vertically with red at the top.
- * + cairo.SUBPIXEL_ORDER_VBGR - Subpixel elements are arranged vertically with blue at the top.
+ * If the extents are given, the recording surface is bounded to them; otherwise it is unbounded.
  * 
- * @param {object} options - opaque handle to a font options object.
- * @return {int} subpixel_order - one of the above values.
- */
-static JSVAL font_options_get_subpixel_order(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_font_options_get_subpixel_order(options));
+ * The content parameter is one of cairo.CONTENT_COLOR, cairo.CONTENT_ALPHA, or cairo.CONTENT_COLOR_ALPHA.
+ * 
+ * @param {int} content - the content of the recording surface.
+ * @param {number} x - left of the extents rectangle.
+ * @param {number} y - top of the extents rectangle.
+ * @param {number} width - width of the extents rectangle.
+ * @param {number} height - height of the extents rectangle.
+ * @return {object} surface - opaque handle to the newly created surface. The caller owns the surface and should call cairo.surface_destroy() when done with it.
+ */
+#if CAIRO_VERSION_MINOR >= 10
+static JSVAL recording_surface_create(JSARGS args) {
+    cairo_content_t content = (cairo_content_t) args[0]->IntegerValue();
+    if (args.Length() < 5) {
+        return External::New(track_surface(cairo_recording_surface_create(content, NULL)));
+    }
+    cairo_rectangle_t extents;
+    extents.x = args[1]->NumberValue();
+    extents.y = args[2]->NumberValue();
+    extents.width = args[3]->NumberValue();
+    extents.height = args[4]->NumberValue();
+    return External::New(track_surface(cairo_recording_surface_create(content, &extents)));
+}
+#endif
+
+// Banded output.  The recording is rasterized into one of two strip buffers while an encoder
+// thread compresses the other, so encoding a band overlaps rasterizing the next one.
+// rows[i] is the number of rows waiting in band buffer i, or 0 if the buffer is free.
+struct BandEncoder {
+    PngWriter png;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    cairo_surface_t *bands[2];
+    int rows[2];
+    bool done;
+};
+
+static void *band_encoder_thread(void *arg) {
+    BandEncoder *encoder = (BandEncoder *) arg;
+    for (int i = 0; ; i++) {
+        int b = i & 1;
+        pthread_mutex_lock(&encoder->lock);
+        while (encoder->rows[b] == 0 && !encoder->done) {
+            pthread_cond_wait(&encoder->cond, &encoder->lock);
+        }
+        int rows = encoder->rows[b];
+        pthread_mutex_unlock(&encoder->lock);
+        if (rows == 0) {
+            break;
+        }
+
+        cairo_surface_t *band = encoder->bands[b];
+        const uint8_t *data = cairo_image_surface_get_data(band);
+        int stride = cairo_image_surface_get_stride(band);
+        for (int y = 0; y < rows && !encoder->png.failed; y++) {
+            png_writer_row(&encoder->png, (const uint32_t *) (data + y * stride), CAIRO_FORMAT_ARGB32);
+        }
+
+        pthread_mutex_lock(&encoder->lock);
+        encoder->rows[b] = 0;
+        pthread_cond_broadcast(&encoder->cond);
+        pthread_mutex_unlock(&encoder->lock);
+    }
+    return NULL;
 }
 
 /**
- * @function cairo.font_options_set_hint_style
+ * @function cairo.recording_surface_write_to_png
  * 
  * ### Synopsis
  * 
- * cairo.font_options_set_hint_style(options, hint_style);
+ * var ok = cairo.recording_surface_write_to_png(recording, filename, width, height);
+ * var ok = cairo.recording_surface_write_to_png(recording, filename, width, height, bandHeight);
  * 
- * Sets the hint style for font outlines for the font options object. 
+ * Render the area (0, 0, width, height) of a recording surface to a PNG file, one horizontal band of bandHeight rows at a time.
  * 
- * This controls whether to fit font outlines to the pixel grid, and if so, whether to optimize for fidelity or contrast. 
+ * Each band is replayed from the recording into a strip buffer and handed to an encoder thread, which compresses it and writes the PNG data out while the next band is rasterized.  Only two strips are ever allocated, so memory use is proportional to the band height rather than the image height.
  * 
- * The value of hint_style may be one of the following:
+ * ### Note
  * 
- * + cairo.HINT_STYLE_DEFAULT - Use the default hint style for font backend and target device.
- * + cairo.HINT_STYLE_NONE - Do not hint outlines.
- * + cairo.HINT_STYLE_SLIGHT - Hint outlines slightly to improve contrast while retaining good fidelity to the original shapes.
- * + cairo.HINT_STYLE_MEDIUM - Hint outlines with medium strength giving a compromise between fidelity to the original shapes and contrast.
- * + cairo.HINT_STYLE_FULL - Hint outlines to maximize contrast.
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
  * 
- * @param {object} options - opaque handle to a font options object.
- * @return {int} hint_style - one of the above values.
+ * @param {object} recording - opaque handle to a recording surface.
+ * @param {string} filename - name of PNG file to write.
+ * @param {int} width - width of the image, in pixels.
+ * @param {int} height - height of the image, in pixels.
+ * @param {int} bandHeight - rows rasterized per band (default 256).
+ * @return {boolean} ok - true if the file was written successfully.
  */
-static JSVAL font_options_set_hint_style(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    cairo_font_options_set_hint_style(options, (cairo_hint_style_t)args[1]->IntegerValue());
-    return Undefined();
+#if CAIRO_VERSION_MINOR >= 10
+static JSVAL recording_surface_write_to_png(JSARGS args) {
+    MetricsTimer timer(METRICS_PNG_ENCODE, "write_to_png");
+    cairo_surface_t *recording = (cairo_surface_t *) JSEXTERN(args[0]);
+    String::Utf8Value filename(args[1]->ToString());
+    timer.arg("filename", *filename);
+    timer.arg("mode", "banded");
+    int width = args[2]->IntegerValue();
+    int height = args[3]->IntegerValue();
+    int bandHeight = args.Length() > 4 ? args[4]->IntegerValue() : 256;
+    if (width <= 0 || height <= 0) {
+        return ThrowException(String::New("recording_surface_write_to_png: invalid size"));
+    }
+    if (bandHeight <= 0 || bandHeight > height) {
+        bandHeight = height;
+    }
+    cairo_surface_flush(recording);
+
+    FILE *fp = fopen(*filename, "wb");
+    if (!fp) {
+        return False();
+    }
+    BandEncoder encoder;
+    encoder.bands[0] = track_surface(large_surface_create(CAIRO_FORMAT_ARGB32, width, bandHeight));
+    encoder.bands[1] = track_surface(large_surface_create(CAIRO_FORMAT_ARGB32, width, bandHeight));
+    encoder.rows[0] = encoder.rows[1] = 0;
+    encoder.done = false;
+    bool ok = cairo_surface_status(encoder.bands[0]) == CAIRO_STATUS_SUCCESS
+        && cairo_surface_status(encoder.bands[1]) == CAIRO_STATUS_SUCCESS;
+    ok = png_writer_begin(&encoder.png, png_write_file, fp, width, height, Z_DEFAULT_COMPRESSION) && ok;
+
+    pthread_t thread;
+    pthread_mutex_init(&encoder.lock, NULL);
+    pthread_cond_init(&encoder.cond, NULL);
+    if (ok && pthread_create(&thread, NULL, band_encoder_thread, &encoder) != 0) {
+        ok = false;
+    }
+    if (ok) {
+        for (int y = 0, i = 0; y < height; y += bandHeight, i++) {
+            int b = i & 1;
+            pthread_mutex_lock(&encoder.lock);
+            while (encoder.rows[b] != 0) {
+                pthread_cond_wait(&encoder.cond, &encoder.lock);
+            }
+            pthread_mutex_unlock(&encoder.lock);
+
+            cairo_surface_t *band = encoder.bands[b];
+            cairo_surface_flush(band);
+            memset(cairo_image_surface_get_data(band), 0, (size_t) cairo_image_surface_get_stride(band) * bandHeight);
+            cairo_surface_mark_dirty(band);
+            cairo_t *context = cairo_create(band);
+            cairo_set_source_surface(context, recording, 0, -y);
+            cairo_paint(context);
+            cairo_destroy(context);
+            cairo_surface_flush(band);
+
+            pthread_mutex_lock(&encoder.lock);
+            encoder.rows[b] = height - y < bandHeight ? height - y : bandHeight;
+            pthread_cond_broadcast(&encoder.cond);
+            pthread_mutex_unlock(&encoder.lock);
+        }
+        pthread_mutex_lock(&encoder.lock);
+        encoder.done = true;
+        pthread_cond_broadcast(&encoder.cond);
+        pthread_mutex_unlock(&encoder.lock);
+        pthread_join(thread, NULL);
+    }
+    ok = png_writer_end(&encoder.png) && ok;
+    pthread_cond_destroy(&encoder.cond);
+    pthread_mutex_destroy(&encoder.lock);
+    cairo_surface_destroy(encoder.bands[0]);
+    cairo_surface_destroy(encoder.bands[1]);
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+    return ok ? True() : False();
+}
+#endif
+
+////////////////////////// TILED SURFACES
+
+// A tiled surface is an ARGB32 image too large for memory.  Its pixels live in an unlinked
+// temporary file as square tiles of tileSize x tileSize pixels, tile after tile in row-major
+// order.  Rendering maps (MAP_SHARED) one tile at a time and unmaps it when done; the pages
+// are left in the page cache and written back to the file as the kernel sees fit, so the
+// process's footprint is one tile however large the image is.  Tiles that nothing is drawn
+// on are never mapped, and stay holes in the sparse file that read back as zeros.
+struct TiledSurface {
+    int fd;
+    int width;
+    int height;
+    int tileSize;
+    int tilesX;
+    int tilesY;
+    size_t tileBytes;
+    bool *painted;      // per tile: holds pixels from a previous render
+};
+
+// Return a painted tile to transparent black, releasing its blocks where the file system
+// can punch holes.
+static bool tiled_surface_clear(TiledSurface *tiled, int tile) {
+    off_t offset = (off_t) tile * tiled->tileBytes;
+#ifdef FALLOC_FL_PUNCH_HOLE
+    if (fallocate(tiled->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, tiled->tileBytes) == 0) {
+        tiled->painted[tile] = false;
+        return true;
+    }
+#endif
+    void *addr = mmap(NULL, tiled->tileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, tiled->fd, offset);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    memset(addr, 0, tiled->tileBytes);
+    munmap(addr, tiled->tileBytes);
+    tiled->painted[tile] = false;
+    return true;
 }
 
 /**
- * @function cairo.font_options_get_hint_style
+ * @function cairo.tiled_surface_create
  * 
  * ### Synopsis
  * 
- * var hint_style = cairo.font_options_get_hint_style(options);
+ * var tiled = cairo.tiled_surface_create(width, height);
+ * var tiled = cairo.tiled_surface_create(width, height, tileSize);
  * 
- * Get the hint style for the font options object.
+ * Create an ARGB32 image of any size, stored out of core in a temporary file as square tiles.  Only the tile being rendered is mapped into memory.
  * 
- * The return value may be one of:
+ * A tiled surface cannot be drawn on directly.  Drawing is recorded on a recording surface and rendered into the tiles with cairo.tiled_surface_render(), one band of tiles at a time; the result is written out with cairo.tiled_surface_write_to_png().
  * 
- * + cairo.HINT_STYLE_DEFAULT - Use the default hint style for font backend and target device.
- * + cairo.HINT_STYLE_NONE - Do not hint outlines.
- * + cairo.HINT_STYLE_SLIGHT - Hint outlines slightly to improve contrast while retaining good fidelity to the original shapes.
- * + cairo.HINT_STYLE_MEDIUM - Hint outlines with medium strength giving a compromise between fidelity to the original shapes and contrast.
- * + cairo.HINT_STYLE_FULL - Hint outlines to maximize contrast.
+ * The tiled surface should be released with cairo.tiled_surface_destroy().
  * 
- * @param {object} options - opaque handle to a font options object.
- * @return {int} hint_style - one of the above values.
- */
-static JSVAL font_options_get_hint_style(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_font_options_get_hint_style(options));
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {int} width - width of the image, in pixels.
+ * @param {int} height - height of the image, in pixels.
+ * @param {int} tileSize - width and height of a tile, in pixels; a multiple of 64 (default 512).
+ * @return {object} tiled - opaque handle to the tiled surface.
+ */
+static JSVAL tiled_surface_create(JSARGS args) {
+    int width = args[0]->IntegerValue();
+    int height = args[1]->IntegerValue();
+    int tileSize = args.Length() > 2 ? args[2]->IntegerValue() : 512;
+    if (width <= 0 || height <= 0) {
+        return ThrowException(String::New("tiled_surface_create: invalid size"));
+    }
+    if (tileSize <= 0 || tileSize % 64) {
+        return ThrowException(String::New("tiled_surface_create: tileSize must be a multiple of 64"));
+    }
+
+    const char *tmpdir = getenv("TMPDIR");
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/silkjs-canvas-XXXXXX", tmpdir ? tmpdir : "/tmp");
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        return ThrowException(String::New("tiled_surface_create: could not create temporary file"));
+    }
+    unlink(path);
+
+    TiledSurface *tiled = new TiledSurface;
+    tiled->fd = fd;
+    tiled->width = width;
+    tiled->height = height;
+    tiled->tileSize = tileSize;
+    tiled->tilesX = (width + tileSize - 1) / tileSize;
+    tiled->tilesY = (height + tileSize - 1) / tileSize;
+    tiled->tileBytes = (size_t) tileSize * tileSize * 4;
+    tiled->painted = (bool *) calloc(tiled->tilesX * tiled->tilesY, sizeof(bool));
+    // the file starts out as one hole; tiled_surface_render() only writes the tiles it draws on
+    if (!tiled->painted || ftruncate(fd, (off_t) tiled->tilesX * tiled->tilesY * tiled->tileBytes) == -1) {
+        free(tiled->painted);
+        close(fd);
+        delete tiled;
+        return ThrowException(String::New("tiled_surface_create: could not allocate tile storage"));
+    }
+    return External::New(tiled);
 }
 
 /**
- * @function cairo.font_options_set_hint_metrics
+ * @function cairo.tiled_surface_render
  * 
  * ### Synopsis
  * 
- * cairo.font_options_set_hint_metrics(options, hint_metrics);
- * 
- * Sets the metrics hinting mode for the font options object. 
+ * cairo.tiled_surface_render(tiled, recording);
  * 
- * This controls whether metrics are quantized to integer values in device units.
+ * Render the drawing recorded on a recording surface into the tiles, replacing their previous contents.
  * 
- * Hinting font metrics means quantizing them so that they are integer values in device space. Doing this improves the consistency of letter and line spacing, however it also means that text will be laid out differently at different zoom factors.
+ * Only the tiles that meet the recording's ink extents are rendered.  The recording is replayed into each of them in turn, band by band from the top, clipped to the tile; cairo skips recorded operations that fall outside the tile.  The other tiles are left as, or returned to, holes in the file, so nothing is written for the empty parts of a sparse image.
  * 
- * The value of hint_metrics may be one of the following:
+ * ### Note
  * 
- * + cairo.HINT_METRICS_DEFAULT - Hint metrics in the default manner for the font backend and target device.
- * + cairo.HINT_METRICS_OFF - Do not hint font metrics.
- * + cairo.HINT_METRICS_ON - Hint font metrics.
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
  * 
- * @param {object} options - opaque handle to a font options object.
- * @return {int} hint_metrics - one of the above values.
+ * @param {object} tiled - opaque handle to a tiled surface.
+ * @param {object} recording - opaque handle to a recording surface.
  */
-static JSVAL font_options_set_hint_metrics(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    cairo_font_options_set_hint_metrics(options, (cairo_hint_metrics_t)args[1]->IntegerValue());
+static JSVAL tiled_surface_render(JSARGS args) {
+    TiledSurface *tiled = (TiledSurface *) JSEXTERN(args[0]);
+    cairo_surface_t *recording = (cairo_surface_t *) JSEXTERN(args[1]);
+    int tileSize = tiled->tileSize;
+    cairo_surface_flush(recording);
+
+    // tiles wholly outside [inkLeft, inkRight) x [inkTop, inkBottom) would come out blank
+    double inkLeft = 0, inkTop = 0, inkRight = tiled->width, inkBottom = tiled->height;
+#if CAIRO_VERSION_MINOR >= 10
+    double inkWidth, inkHeight;
+    cairo_recording_surface_ink_extents(recording, &inkLeft, &inkTop, &inkWidth, &inkHeight);
+    inkRight = inkLeft + inkWidth;
+    inkBottom = inkTop + inkHeight;
+#endif
+
+    for (int ty = 0; ty < tiled->tilesY; ty++) {
+        for (int tx = 0; tx < tiled->tilesX; tx++) {
+            int tile = ty * tiled->tilesX + tx;
+            if (tiled->painted[tile] && !tiled_surface_clear(tiled, tile)) {
+                return ThrowException(String::New("tiled_surface_render: could not clear tile"));
+            }
+            int x = tx * tileSize, y = ty * tileSize;
+            if (x >= inkRight || x + tileSize <= inkLeft || y >= inkBottom || y + tileSize <= inkTop) {
+                continue;
+            }
+            void *addr = mmap(NULL, tiled->tileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, tiled->fd, (off_t) tile * tiled->tileBytes);
+            if (addr == MAP_FAILED) {
+                return ThrowException(String::New("tiled_surface_render: could not map tile"));
+            }
+            cairo_surface_t *surface = cairo_image_surface_create_for_data((uint8_t *) addr, CAIRO_FORMAT_ARGB32, tileSize, tileSize, tileSize * 4);
+            cairo_t *context = cairo_create(surface);
+            cairo_set_source_surface(context, recording, -x, -y);
+            cairo_paint(context);
+            cairo_destroy(context);
+            cairo_surface_finish(surface);
+            cairo_surface_destroy(surface);
+            munmap(addr, tiled->tileBytes);
+            tiled->painted[tile] = true;
+        }
+    }
     return Undefined();
 }
 
 /**
- * @function cairo.font_options_get_hint_metrics
+ * @function cairo.tiled_surface_write_to_png
  * 
  * ### Synopsis
  * 
- * var hint_metrics = cairo.font_options_get_hint_metrics(options);
+ * var ok = cairo.tiled_surface_write_to_png(tiled, filename);
  * 
- * Get the hint metrics for the font options object.
+ * Write the contents of a tiled surface to a PNG file.
  * 
- * The return value may be one of:
+ * The image is assembled and compressed one row at a time, reading the rows of each tile straight from the backing file, so memory use is a single row regardless of image size.
  * 
- * + cairo.HINT_METRICS_DEFAULT - Hint metrics in the default manner for the font backend and target device.
- * + cairo.HINT_METRICS_OFF - Do not hint font metrics.
- * + cairo.HINT_METRICS_ON - Hint font metrics.
+ * ### Note
  * 
- * @param {object} options - opaque handle to a font options object.
- * @return {int} hint_metrics - one of the above values.
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} tiled - opaque handle to a tiled surface.
+ * @param {string} filename - name of PNG file to write.
+ * @return {boolean} ok - true if the file was written successfully.
  */
-static JSVAL font_options_get_hint_metrics(JSARGS args) {
-    cairo_font_options_t *options = (cairo_font_options_t *)JSEXTERN(args[0]);
-    return Integer::New(cairo_font_options_get_hint_metrics(options));
+static JSVAL tiled_surface_write_to_png(JSARGS args) {
+    MetricsTimer timer(METRICS_PNG_ENCODE, "write_to_png");
+    TiledSurface *tiled = (TiledSurface *) JSEXTERN(args[0]);
+    String::Utf8Value filename(args[1]->ToString());
+    timer.arg("filename", *filename);
+    timer.arg("mode", "tiled");
+    int tileSize = tiled->tileSize;
+    size_t tileRowBytes = (size_t) tileSize * 4;
+
+    FILE *fp = fopen(*filename, "wb");
+    if (!fp) {
+        return False();
+    }
+    // whole tiles per row, so reads never need to be trimmed at the right edge
+    uint32_t *row = (uint32_t *) malloc(tiled->tilesX * tileRowBytes);
+    PngWriter png;
+    bool ok = row != NULL && png_writer_begin(&png, png_write_file, fp, tiled->width, tiled->height, Z_DEFAULT_COMPRESSION);
+    for (int y = 0; ok && y < tiled->height; y++) {
+        int ty = y / tileSize;
+        for (int tx = 0; tx < tiled->tilesX; tx++) {
+            off_t offset = (off_t) (ty * tiled->tilesX + tx) * tiled->tileBytes + (off_t) (y % tileSize) * tileRowBytes;
+            if (pread(tiled->fd, (uint8_t *) row + tx * tileRowBytes, tileRowBytes, offset) != (ssize_t) tileRowBytes) {
+                ok = false;
+                break;
+            }
+        }
+        if (ok) {
+            png_writer_row(&png, row, CAIRO_FORMAT_ARGB32);
+        }
+    }
+    if (row) {
+        ok = png_writer_end(&png) && ok;
+    }
+    free(row);
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+    return ok ? True() : False();
 }
 
-////////////////////////// PNG SUPPORT
-
 /**
- * @function cairo.image_surface_create_from_png
+ * @function cairo.tiled_surface_destroy
  * 
  * ### Synopsis
  * 
- * var surface = cairo.image_surface_create_from_png(filename);
+ * cairo.tiled_surface_destroy(tiled);
  * 
- * Creates a new image surface and initializes the contents to the given PNG file.
+ * Release the storage of a tiled surface.
  * 
- * If an error occurs, this function returns a "nil" surface.  A nil surface can be checked for with cairo.surface_status(surface) which may return one of the following values: cairo.STATUS_NO_MEMORY, cairo.STATUS_FILE_NOT_FOUND, or  cairo.STATUS_READ_ERROR.
+ * ### Note
  * 
- * Alternatively, you can allow errors to propagate through the drawing operations and check the status on the context upon completion using cairo.context_status()..
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
  * 
- * @param {string} filename - name of PNG file to load.
- * @return {object} surface - opaque handle to a newly created surface.
+ * @param {object} tiled - opaque handle to a tiled surface.
  */
-static JSVAL image_surface_create_from_png(JSARGS args) {
-    String::Utf8Value filename(args[0]->ToString());
-    return External::New(cairo_image_surface_create_from_png(*filename));
+static JSVAL tiled_surface_destroy(JSARGS args) {
+    TiledSurface *tiled = (TiledSurface *) JSEXTERN(args[0]);
+    free(tiled->painted);
+    close(tiled->fd);
+    delete tiled;
+    return Undefined();
+}
+
+////////////////////////// BATCH RENDERING
+
+// one call to commands_render_batch(); each task renders and encodes one job
+struct BatchRender {
+    CommandList *list;
+    int width;
+    int height;
+    int level;
+    int slots;
+    ParameterValue *values;     // slots values per job
+    char **filenames;
+    bool *ok;
+    cairo_surface_t **surfaces; // one per worker, reused from job to job
+};
+
+static void batch_render_task(void *closure, int task, int worker) {
+    BatchRender *batch = (BatchRender *) closure;
+    cairo_surface_t *surface = batch->surfaces[worker];
+    if (!surface) {
+        surface = batch->surfaces[worker] = large_surface_create(CAIRO_FORMAT_ARGB32, batch->width, batch->height);
+        if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+            batch->ok[task] = false;
+            return;
+        }
+        count_surface(surface, 1);
+    }
+    else if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        batch->ok[task] = false;
+        return;
+    }
+    else {
+        cairo_surface_flush(surface);
+        memset(cairo_image_surface_get_data(surface), 0, (size_t) cairo_image_surface_get_stride(surface) * batch->height);
+        cairo_surface_mark_dirty(surface);
+    }
+
+    cairo_t *context = cairo_create(surface);
+    command_list_replay(batch->list, context, batch->values + (size_t) task * batch->slots);
+    bool ok = cairo_status(context) == CAIRO_STATUS_SUCCESS;
+    cairo_destroy(context);
+    cairo_surface_flush(surface);
+
+    FILE *fp = ok ? fopen(batch->filenames[task], "wb") : NULL;
+    if (!fp) {
+        batch->ok[task] = false;
+        return;
+    }
+    const uint8_t *data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    PngWriter png;
+    ok = png_writer_begin(&png, png_write_file, fp, batch->width, batch->height, batch->level);
+    for (int y = 0; ok && y < batch->height; y++) {
+        png_writer_row(&png, (const uint32_t *) (data + (size_t) y * stride), CAIRO_FORMAT_ARGB32);
+    }
+    ok = png_writer_end(&png) && ok;
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+    batch->ok[task] = ok;
 }
 
 /**
- * @function cairo.surface_write_to_png
+ * @function cairo.commands_render_batch
  * 
  * ### Synopsis
  * 
- * var status = cairo.surface_write_to_png(surface, filename);
+ * var results = cairo.commands_render_batch(commands, width, height, jobs, filenames);
+ * var results = cairo.commands_render_batch(commands, width, height, jobs, filenames, threads);
+ * var results = cairo.commands_render_batch(commands, width, height, jobs, filenames, threads, level);
  * 
- * Writes the contents of surface to a new file filename as a PNG image.
+ * Render a command list once per job, each with its own parameters, and write each result to a PNG file.
  * 
- * If an error occurs, the value returned may be:
+ * Each job is an array of parameter values indexed by the slots given to cairo.commands_bind_parameter(): a number, an array of up to 6 numbers, or a string.  A missing or undefined value leaves the recorded value in place.
  * 
- * + cairo.STATUS_NO_MEMORY if memory could not be allocated for the operation.
- * + cairo.STATUS_SURFACE_TYPE_MISMATCH if the surface does not have pixel contents.
- * + cairo.STATUS_WRITE_ERROR if an I/O error occurs while attempting to write the file..
+ * The jobs are spread over a pool of native threads, one per CPU, with the calling thread taking part; the call returns when all jobs are done.  Each thread renders into one ARGB32 surface of the given size that it reuses for all of its jobs.  These surfaces are checked against the limits set by cairo.memory_set_limits() before any job starts, all together against the budget, and an exception is thrown if they do not fit.
  * 
- * @param {object} surface - opaque handle to a cairo surface.
- * @return {int} status - either cairo.STATUS_SUCCESS, or one of the above values if an error occurred.
- */
-static JSVAL surface_write_to_png(JSARGS args) {
-    cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    String::Utf8Value filename(args[1]->ToString());
-    return Integer::New(cairo_surface_write_to_png(surface, *filename));
+ * The command list must not be changed or replayed into a recording context while the batch runs.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} commands - opaque handle to a command list.
+ * @param {int} width - width of each image.
+ * @param {int} height - height of each image.
+ * @param {array} jobs - array of arrays of parameter values.
+ * @param {array} filenames - array of output filenames, one per job.
+ * @param {int} threads - optional most threads to use, 0 for all (the default).
+ * @param {int} level - optional zlib compression level, 0-9 or -1 for the default.
+ * @return {array} results - true for each job that was written successfully, false otherwise.
+ */
+static JSVAL commands_render_batch(JSARGS args) {
+    CommandList *list = (CommandList *) JSEXTERN(args[0]);
+    Handle<Array>jobs = Handle<Array>::Cast(args[3]->ToObject());
+    Handle<Array>filenames = Handle<Array>::Cast(args[4]->ToObject());
+    int count = jobs->Length();
+    if ((int) filenames->Length() < count) {
+        return ThrowException(String::New("commands_render_batch: a filename is needed for each job"));
+    }
+
+    int width = args[1]->IntegerValue();
+    int height = args[2]->IntegerValue();
+    int threads = args.Length() > 5 ? args[5]->IntegerValue() : 0;
+    // one surface per thread that can take a job: the caller, and as many pool threads as allowed
+    int helpers = thread_pool_size();
+    if (threads > 0 && threads - 1 < helpers) {
+        helpers = threads - 1;
+    }
+    int workers = count < helpers + 1 ? count : helpers + 1;
+    char msg[256];
+    if (workers > 0 && !memory_admit("commands_render_batch", width, height, msg, sizeof(msg), workers)) {
+        return ThrowException(String::New(msg));
+    }
+
+    BatchRender batch;
+    batch.list = list;
+    batch.width = width;
+    batch.height = height;
+    batch.level = args.Length() > 6 ? args[6]->IntegerValue() : Z_DEFAULT_COMPRESSION;
+    batch.slots = 0;
+    for (int i = 0; i < list->bindingCount; i++) {
+        if (list->bindings[i].slot >= batch.slots) {
+            batch.slots = list->bindings[i].slot + 1;
+        }
+    }
+
+    // everything the threads need is converted up front; they cannot touch JavaScript values
+    batch.values = (ParameterValue *) calloc((size_t) count * batch.slots + 1, sizeof(ParameterValue));
+    batch.filenames = (char **) calloc(count + 1, sizeof(char *));
+    batch.ok = (bool *) calloc(count + 1, sizeof(bool));
+    for (int i = 0; i < count; i++) {
+        String::Utf8Value filename(filenames->Get(i)->ToString());
+        batch.filenames[i] = strdup(*filename);
+        JSVAL job = jobs->Get(i);
+        if (!job->IsArray()) {
+            continue;
+        }
+        Handle<Array>values = Handle<Array>::Cast(job->ToObject());
+        for (int slot = 0; slot < batch.slots && slot < (int) values->Length(); slot++) {
+            ParameterValue *value = &batch.values[(size_t) i * batch.slots + slot];
+            JSVAL v = values->Get(slot);
+            if (v->IsString()) {
+                String::Utf8Value text(v);
+                value->text = strdup(*text);
+            }
+            else if (v->IsArray()) {
+                Handle<Array>numbers = Handle<Array>::Cast(v->ToObject());
+                for (int k = 0; k < 6 && k < (int) numbers->Length(); k++) {
+                    value->values[value->count++] = numbers->Get(k)->NumberValue();
+                }
+            }
+            else if (v->IsNumber()) {
+                value->values[value->count++] = v->NumberValue();
+            }
+        }
+    }
+    batch.surfaces = (cairo_surface_t **) calloc(thread_pool_size() + 1, sizeof(cairo_surface_t *));
+
+    thread_pool_run(count, threads, batch_render_task, &batch);
+
+    Handle<Array>results = Array::New(count);
+    for (int i = 0; i < count; i++) {
+        results->Set(i, batch.ok[i] ? True() : False());
+        free(batch.filenames[i]);
+    }
+    for (size_t i = 0; i < (size_t) count * batch.slots; i++) {
+        free(batch.values[i].text);
+    }
+    for (int i = 0; i <= thread_pool_size(); i++) {
+        if (batch.surfaces[i]) {
+            if (cairo_surface_status(batch.surfaces[i]) == CAIRO_STATUS_SUCCESS) {
+                count_surface(batch.surfaces[i], -1);
+            }
+            cairo_surface_destroy(batch.surfaces[i]);
+        }
+    }
+    free(batch.surfaces);
+    free(batch.values);
+    free(batch.filenames);
+    free(batch.ok);
+    return results;
 }
 
 ////////////////////////// PATTERNS
@@ -4903,11 +10652,11 @@ static JSVAL pattern_get_color_stop_rgba(JSARGS args) {
  * @return {object} pattern - opaque handle to newly created pattern.
  */
 static JSVAL pattern_create_rgb(JSARGS args) {
-    return External::New(cairo_pattern_create_rgb(
+    return External::New(track_pattern(cairo_pattern_create_rgb(
         args[1]->NumberValue(),     // red
         args[2]->NumberValue(),     // green
         args[3]->NumberValue()      // blue
-     ));
+     )));
 }
 
 /**
@@ -4932,12 +10681,12 @@ static JSVAL pattern_create_rgb(JSARGS args) {
  * @return {object} pattern - opaque handle to newly created pattern.
  */
 static JSVAL pattern_create_rgba(JSARGS args) {
-    return External::New(cairo_pattern_create_rgba(
+    return External::New(track_pattern(cairo_pattern_create_rgba(
         args[1]->NumberValue(),     // red
         args[2]->NumberValue(),     // green
         args[3]->NumberValue(),     // blue
         args[4]->NumberValue()      // alpha
-     ));
+     )));
 }
 
 /**
@@ -4996,7 +10745,7 @@ static JSVAL pattern_get_rgba(JSARGS args) {
  */
 static JSVAL pattern_create_for_surface(JSARGS args) {
     cairo_surface_t *surface = (cairo_surface_t *) JSEXTERN(args[0]);
-    return External::New(cairo_pattern_create_for_surface(surface));
+    return External::New(track_pattern(cairo_pattern_create_for_surface(surface)));
 }
 
 /**
@@ -5051,12 +10800,12 @@ static JSVAL pattern_get_surface(JSARGS args) {
  * @return {object} pattern - opaque handle to newly created pattern.
  */
 static JSVAL pattern_create_linear(JSARGS args) {
-    return External::New(cairo_pattern_create_linear(
+    return External::New(track_pattern(cairo_pattern_create_linear(
         args[0]->NumberValue(),     // x0
         args[1]->NumberValue(),     // y0
         args[2]->NumberValue(),     // x1
         args[3]->NumberValue()      // y1
-    ));
+    )));
 }
 
 /**
@@ -5065,6 +10814,7 @@ static JSVAL pattern_create_linear(JSARGS args) {
  * ### Synopsis
  * 
  * var points = cairo.pattern_get_linear_points(pattern);
+ * var out = cairo.pattern_get_linear_points(pattern, out);
  * 
  * Gets the gradient endpoints for a linear gradient pattern.
  * 
@@ -5075,7 +10825,10 @@ static JSVAL pattern_create_linear(JSARGS args) {
  * + {number} x1 - x coordinate of the second point.
  * + {number} y1 - y coordinate of the second point.
  * 
+ * If the optional out argument is given, it must be a Float64Array of at least 4 elements.  The values are written to it as [x0, y0, x1, y1] and out is returned.
+ * 
  * @param {object} pattern - opaque handle to a cairo pattern.
+ * @param {Float64Array} out - optional array to receive [x0, y0, x1, y1].
  * @return {object} points - object of the form described above.
  * 
  * ### Note
@@ -5087,7 +10840,18 @@ static JSVAL pattern_get_linear_points(JSARGS args) {
     double x0,y0, x1,y1;
     cairo_status_t status = cairo_pattern_get_linear_points(pattern, &x0,&y0, &x1,&y1);
     if (status != CAIRO_STATUS_SUCCESS) {
-        ThrowException(String::New(cairo_status_to_string(status)));
+        return ThrowException(String::New(cairo_status_to_string(status)));
+    }
+    if (args.Length() > 1) {
+        double *out = float64_array_data(args[1], 4);
+        if (out == NULL) {
+            return throw_bad_out_array("pattern_get_linear_points", 4);
+        }
+        out[0] = x0;
+        out[1] = y0;
+        out[2] = x1;
+        out[3] = y1;
+        return args[1];
     }
     JSOBJ o = Object::New();
     o->Set(String::New("x0"), Number::New(x0));
@@ -5123,14 +10887,14 @@ static JSVAL pattern_get_linear_points(JSARGS args) {
  * @return {object} pattern - opaque handle to newly created pattern.
  */
 static JSVAL pattern_create_radial(JSARGS args) {
-    return External::New(cairo_pattern_create_radial(
+    return External::New(track_pattern(cairo_pattern_create_radial(
         args[0]->NumberValue(),     // cx0
         args[1]->NumberValue(),     // cy0
         args[2]->NumberValue(),     // radius0
         args[3]->NumberValue(),     // cx1
         args[4]->NumberValue(),     // cy1
         args[5]->NumberValue()      // radius1
-    ));
+    )));
 }
 
 /**
@@ -5139,6 +10903,7 @@ static JSVAL pattern_create_radial(JSARGS args) {
  * ### Synopsis
  * 
  * var circles = cairo.pattern_get_radial_circles(pattern);
+ * var out = cairo.pattern_get_radial_circles(pattern, out);
  * 
  * Gets the gradient endpoint circles for a radial gradient, each specified as a center coordinate and radius.
  * 
@@ -5151,7 +10916,10 @@ static JSVAL pattern_create_radial(JSARGS args) {
  * + {number} y1 - y coordinate of the center of the second circle.
  * + {number} r1 - radius the second circle.
  * 
+ * If the optional out argument is given, it must be a Float64Array of at least 6 elements.  The values are written to it as [x0, y0, r0, x1, y1, r1] and out is returned.
+ * 
  * @param {object} pattern - opaque handle to a cairo pattern.
+ * @param {Float64Array} out - optional array to receive [x0, y0, r0, x1, y1, r1].
  * @return {object} circles - object of the form described above.
  * 
  * ### Note
@@ -5163,7 +10931,20 @@ static JSVAL pattern_get_radial_circles(JSARGS args) {
     double x0,y0,r0, x1,y1,r1;
     cairo_status_t status = cairo_pattern_get_radial_circles(pattern, &x0,&y0,&r0, &x1,&y1,&r1);
     if (status != CAIRO_STATUS_SUCCESS) {
-        ThrowException(String::New(cairo_status_to_string(status)));
+        return ThrowException(String::New(cairo_status_to_string(status)));
+    }
+    if (args.Length() > 1) {
+        double *out = float64_array_data(args[1], 6);
+        if (out == NULL) {
+            return throw_bad_out_array("pattern_get_radial_circles", 6);
+        }
+        out[0] = x0;
+        out[1] = y0;
+        out[2] = r0;
+        out[3] = x1;
+        out[4] = y1;
+        out[5] = r1;
+        return args[1];
     }
     JSOBJ o = Object::New();
     o->Set(String::New("x0"), Number::New(x0));
@@ -5175,6 +10956,36 @@ static JSVAL pattern_get_radial_circles(JSARGS args) {
     return o;
 }
 
+/**
+ * @function cairo.pattern_create_with_alpha
+ * 
+ * ### Synopsis
+ * 
+ * var variant = cairo.pattern_create_with_alpha(pattern, alpha);
+ * 
+ * Creates a copy of a linear or radial gradient with the alpha of every color stop multiplied by alpha.  The points or circles, extend, filter and matrix are copied as well.
+ * 
+ * Drawing with the copy gives what drawing with the gradient through cairo.context_paint_with_alpha() would, without a group surface, which is how Canvas applies globalAlpha to gradient fills and strokes.
+ * 
+ * The caller owns the returned handle and should call cairo.pattern_destroy() when finished with it.
+ * 
+ * ### Note
+ * 
+ * This is a helper function to implement Canvas class; it is not a part of Cairo.
+ * 
+ * @param {object} pattern - opaque handle to a gradient pattern.
+ * @param {number} alpha - factor for the alpha of the color stops, 0 to 1.
+ * @return {object} variant - opaque handle to the new pattern, or null if pattern is not a gradient.
+ */
+static JSVAL pattern_create_with_alpha(JSARGS args) {
+    cairo_pattern_t *pattern = (cairo_pattern_t *) JSEXTERN(args[0]);
+    cairo_pattern_type_t type = cairo_pattern_get_type(pattern);
+    if (type != CAIRO_PATTERN_TYPE_LINEAR && type != CAIRO_PATTERN_TYPE_RADIAL) {
+        return Null();
+    }
+    return External::New(track_pattern(pattern_copy(pattern, args[1]->NumberValue())));
+}
+
 /**
  * @function cairo.pattern_reference
  * 
@@ -5384,7 +11195,7 @@ static JSVAL pattern_set_matrix(JSARGS args) {
  */
 static JSVAL pattern_get_matrix(JSARGS args) {
     cairo_pattern_t *pattern = (cairo_pattern_t *) JSEXTERN(args[0]);
-    cairo_matrix_t *matrix = new cairo_matrix_t;
+    cairo_matrix_t *matrix = matrix_new();
     cairo_pattern_get_matrix(pattern, matrix);
     return External::New(matrix);
 }
@@ -5472,7 +11283,7 @@ static JSVAL pattern_get_reference_count(JSARGS args) {
  * @return {object} matrix - opaque handle to a matrix.
  */
 static JSVAL matrix_create(JSARGS args) {
-    cairo_matrix_t *matrix = new cairo_matrix_t;
+    cairo_matrix_t *matrix = matrix_new();
     cairo_matrix_init_identity(matrix);
     return External::New(matrix);
 }
@@ -5532,7 +11343,7 @@ static JSVAL matrix_init(JSARGS args) {
  */
 static JSVAL matrix_clone(JSARGS args) {
     cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[0]);
-    cairo_matrix_t *clone = new cairo_matrix_t;
+    cairo_matrix_t *clone = matrix_new();
     memcpy(clone, matrix, sizeof(cairo_matrix_t));
     return External::New(clone);
 }
@@ -5720,7 +11531,7 @@ static JSVAL matrix_invert(JSARGS args) {
 static JSVAL matrix_multiply(JSARGS args) {
     cairo_matrix_t *a = (cairo_matrix_t *) JSEXTERN(args[0]);
     cairo_matrix_t *b = (cairo_matrix_t *) JSEXTERN(args[1]);
-    cairo_matrix_t *result = new cairo_matrix_t;
+    cairo_matrix_t *result = matrix_new();
     cairo_matrix_multiply(result, a, b);
     return External::New(result);
 }
@@ -5754,12 +11565,19 @@ static JSVAL matrix_multiply(JSARGS args) {
  * 
  * If (x1,y1) transforms to (x2,y2) then (x1+dx1,y1+dy1) will transform to (x1+dx2,y1+dy2) for all values of x1 and x2.
  * 
+ * The vector may instead be a Float64Array of at least 2 elements holding [dx, dy], which is transformed in place and returned.
+ * 
  * @param {object} matrix - opaque handle to a matrix.
  * @param {object} vector - object with dx,dy input values.
  * @return {object} vector - object with modified dx,dy values.
  */
 static JSVAL matrix_transform_distance(JSARGS args) {
     cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[0]);
+    double *v = float64_array_data(args[1], 2);
+    if (v != NULL) {
+        cairo_matrix_transform_distance(matrix, &v[0], &v[1]);
+        return args[1];
+    }
     Local<String>_dx = String::New("dx");
     Local<String>_dy = String::New("dy");
     JSOBJ o = args[1]->ToObject();
@@ -5787,12 +11605,19 @@ static JSVAL matrix_transform_distance(JSARGS args) {
  * 
  * The x,y members are modified by this routine.
  * 
+ * The point may instead be a Float64Array of at least 2 elements holding [x, y], which is transformed in place and returned.
+ * 
  * @param {object} matrix - opaque handle to a matrix.
  * @param {object} point - object with x,y input values.
  * @return {object} point - object with modified x,y values.
  */
 static JSVAL matrix_transform_point(JSARGS args) {
     cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[0]);
+    double *v = float64_array_data(args[1], 2);
+    if (v != NULL) {
+        cairo_matrix_transform_point(matrix, &v[0], &v[1]);
+        return args[1];
+    }
     Local<String>_x = String::New("x");
     Local<String>_y = String::New("y");
     JSOBJ o = args[1]->ToObject();
@@ -5804,6 +11629,35 @@ static JSVAL matrix_transform_point(JSARGS args) {
     return o;
 }
 
+/**
+ * @function cairo.matrix_transform_points
+ * 
+ * ### Synopsis
+ * 
+ * var points = cairo.matrix_transform_points(matrix, points);
+ * var points = cairo.matrix_transform_points(matrix, points, count);
+ * 
+ * Transforms many points by matrix in one call.
+ * 
+ * The points argument is a Float64Array of interleaved coordinates: [x0, y0, x1, y1, ...].  The points are transformed in place and the same array is returned.
+ * 
+ * This is equivalent to calling cairo.matrix_transform_point() once per point.
+ * 
+ * @param {object} matrix - opaque handle to a matrix.
+ * @param {Float64Array} points - interleaved x,y coordinates.
+ * @param {int} count - optional number of points to transform; defaults to all of them (points.length / 2).
+ * @return {Float64Array} points - the transformed points.
+ */
+static JSVAL matrix_transform_points(JSARGS args) {
+    cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[0]);
+    int count = batch_point_count(args, "matrix_transform_points");
+    if (count < 0) {
+        return Undefined();
+    }
+    transform_points(matrix, float64_array_data(args[1], 0), count);
+    return args[1];
+}
+
 /**
  * @function cairo.matrix_destroy
  * 
@@ -5815,7 +11669,7 @@ static JSVAL matrix_transform_point(JSARGS args) {
  */
 static JSVAL matrix_destroy(JSARGS args) {
     cairo_matrix_t *matrix = (cairo_matrix_t *) JSEXTERN(args[0]);
-    delete matrix;
+    matrix_delete(matrix);
     return Undefined();
 }
 
@@ -5843,7 +11697,7 @@ static JSVAL matrix_destroy(JSARGS args) {
  */
 #if CAIRO_VERSION_MINOR >= 10
 static JSVAL region_create(JSARGS args) {
-    return External::New(cairo_region_create());
+    return External::New(track_region(cairo_region_create()));
 }
 #endif
 
@@ -5887,7 +11741,7 @@ static JSVAL region_create_rectangle(JSARGS args) {
         o->Get(_w)->IntegerValue(),
         o->Get(_h)->IntegerValue()
     };
-    return External::New(cairo_region_create_rectangle(&rect));
+    return External::New(track_region(cairo_region_create_rectangle(&rect)));
 }
 #endif
 
@@ -5938,7 +11792,7 @@ static JSVAL region_create_rectangles(JSARGS args) {
     }
     cairo_region_t *region = cairo_region_create_rectangles(rects, numRectangles);
     delete [] rects;
-    return External::New(region);
+    return External::New(track_region(region));
     
 }
 #endif
@@ -5966,7 +11820,7 @@ static JSVAL region_create_rectangles(JSARGS args) {
 #if CAIRO_VERSION_MINOR >= 10
 static JSVAL region_copy(JSARGS args) {
     cairo_region_t *region = (cairo_region_t *) JSEXTERN(args[0]);
-    return External::New(cairo_region_copy(region));
+    return External::New(track_region(cairo_region_copy(region)));
 }
 #endif
 
@@ -5989,7 +11843,7 @@ static JSVAL region_copy(JSARGS args) {
 #if CAIRO_VERSION_MINOR >= 10
 static JSVAL region_reference(JSARGS args) {
     cairo_region_t *region = (cairo_region_t *) JSEXTERN(args[0]);
-    return External::New(cairo_region_reference(region));
+    return External::New(track_region(cairo_region_reference(region)));
 }
 #endif
 
@@ -6009,6 +11863,7 @@ static JSVAL region_reference(JSARGS args) {
 #if CAIRO_VERSION_MINOR >= 10
 static JSVAL region_destroy(JSARGS args) {
     cairo_region_t *region = (cairo_region_t *) JSEXTERN(args[0]);
+    memory_untrack_untagged(MEMORY_REGION, region, 0);
     cairo_region_destroy(region);
     return Undefined();
 }
@@ -6208,7 +12063,7 @@ static JSVAL region_contains_rectangle(JSARGS args) {
     Local<String>_y = String::New("y");
     Local<String>_w = String::New("width");
     Local<String>_h = String::New("height");
-    JSOBJ o = args[0]->ToObject();
+    JSOBJ o = args[1]->ToObject();
     cairo_rectangle_int_t rect = { 
         o->Get(_x)->IntegerValue(),
         o->Get(_y)->IntegerValue(),
@@ -6317,7 +12172,7 @@ static JSVAL region_intersect_rectangle(JSARGS args) {
     Local<String>_y = String::New("y");
     Local<String>_w = String::New("width");
     Local<String>_h = String::New("height");
-    JSOBJ o = args[0]->ToObject();
+    JSOBJ o = args[1]->ToObject();
     cairo_rectangle_int_t rect = { 
         o->Get(_x)->IntegerValue(),
         o->Get(_y)->IntegerValue(),
@@ -6380,7 +12235,7 @@ static JSVAL region_subtract_rectangle(JSARGS args) {
     Local<String>_y = String::New("y");
     Local<String>_w = String::New("width");
     Local<String>_h = String::New("height");
-    JSOBJ o = args[0]->ToObject();
+    JSOBJ o = args[1]->ToObject();
     cairo_rectangle_int_t rect = { 
         o->Get(_x)->IntegerValue(),
         o->Get(_y)->IntegerValue(),
@@ -6443,7 +12298,7 @@ static JSVAL region_union_rectangle(JSARGS args) {
     Local<String>_y = String::New("y");
     Local<String>_w = String::New("width");
     Local<String>_h = String::New("height");
-    JSOBJ o = args[0]->ToObject();
+    JSOBJ o = args[1]->ToObject();
     cairo_rectangle_int_t rect = { 
         o->Get(_x)->IntegerValue(),
         o->Get(_y)->IntegerValue(),
@@ -6510,7 +12365,7 @@ static JSVAL region_xor_rectangle(JSARGS args) {
     Local<String>_y = String::New("y");
     Local<String>_w = String::New("width");
     Local<String>_h = String::New("height");
-    JSOBJ o = args[0]->ToObject();
+    JSOBJ o = args[1]->ToObject();
     cairo_rectangle_int_t rect = { 
         o->Get(_x)->IntegerValue(),
         o->Get(_y)->IntegerValue(),
@@ -6743,7 +12598,21 @@ extern "C" JSOBJ getExports () {
 //    net->Set(String::New("sendFile"), FunctionTemplate::New(net_sendfile));
 
     cairo->Set(String::New("status_to_string"), FunctionTemplate::New(status_to_string));
+    cairo->Set(String::New("memory_stats"), FunctionTemplate::New(memory_stats));
+    cairo->Set(String::New("memory_debug"), FunctionTemplate::New(memory_debug));
+    cairo->Set(String::New("memory_live_objects"), FunctionTemplate::New(memory_live_objects));
+    cairo->Set(String::New("memory_set_limits"), FunctionTemplate::New(memory_set_limits));
+    cairo->Set(String::New("memory_get_limits"), FunctionTemplate::New(memory_get_limits));
+    cairo->Set(String::New("memory_check"), FunctionTemplate::New(memory_check));
+    cairo->Set(String::New("metrics_text"), FunctionTemplate::New(metrics_text));
+    cairo->Set(String::New("metrics_enable"), FunctionTemplate::New(metrics_enable));
+    cairo->Set(String::New("metrics_reset"), FunctionTemplate::New(metrics_reset));
+    cairo->Set(String::New("trace_begin"), FunctionTemplate::New(trace_begin));
+    cairo->Set(String::New("trace_end"), FunctionTemplate::New(trace_end));
     cairo->Set(String::New("surface_create_similar"), FunctionTemplate::New(surface_create_similar));
+#if CAIRO_VERSION_MINOR >= 10
+    cairo->Set(String::New("surface_create_for_rectangle"), FunctionTemplate::New(surface_create_for_rectangle));
+#endif
     cairo->Set(String::New("surface_reference"), FunctionTemplate::New(surface_reference));
     cairo->Set(String::New("surface_status"), FunctionTemplate::New(surface_status));
     cairo->Set(String::New("surface_destroy"), FunctionTemplate::New(surface_destroy));
@@ -6766,15 +12635,33 @@ extern "C" JSOBJ getExports () {
     cairo->Set(String::New("surface_show_page"), FunctionTemplate::New(surface_show_page));
     cairo->Set(String::New("surface_has_show_text_glyphs"), FunctionTemplate::New(surface_has_show_text_glyphs));
     cairo->Set(String::New("image_surface_create"), FunctionTemplate::New(image_surface_create));
+    cairo->Set(String::New("image_surface_configure_allocator"), FunctionTemplate::New(image_surface_configure_allocator));
+    cairo->Set(String::New("image_surface_allocator_stats"), FunctionTemplate::New(image_surface_allocator_stats));
     cairo->Set(String::New("image_surface_get_format"), FunctionTemplate::New(image_surface_get_format));
     cairo->Set(String::New("image_surface_get_width"), FunctionTemplate::New(image_surface_get_width));
     cairo->Set(String::New("image_surface_get_height"), FunctionTemplate::New(image_surface_get_height));
     cairo->Set(String::New("image_surface_get_data"), FunctionTemplate::New(image_surface_get_data));
+    cairo->Set(String::New("surface_read_pixels"), FunctionTemplate::New(surface_read_pixels));
     cairo->Set(String::New("surface_blur"), FunctionTemplate::New(surface_blur));
+    cairo->Set(String::New("surface_content_bounds"), FunctionTemplate::New(surface_content_bounds));
+    cairo->Set(String::New("surface_clear"), FunctionTemplate::New(surface_clear));
+    cairo->Set(String::New("snapshot_create"), FunctionTemplate::New(snapshot_create));
+    cairo->Set(String::New("snapshot_create_surface"), FunctionTemplate::New(snapshot_create_surface));
+    cairo->Set(String::New("snapshot_restore"), FunctionTemplate::New(snapshot_restore));
+    cairo->Set(String::New("snapshot_destroy"), FunctionTemplate::New(snapshot_destroy));
+    cairo->Set(String::New("commands_create"), FunctionTemplate::New(commands_create));
+    cairo->Set(String::New("commands_get_context"), FunctionTemplate::New(commands_get_context));
+    cairo->Set(String::New("commands_count"), FunctionTemplate::New(commands_count));
+    cairo->Set(String::New("commands_bind_parameter"), FunctionTemplate::New(commands_bind_parameter));
+    cairo->Set(String::New("commands_optimize"), FunctionTemplate::New(commands_optimize));
+    cairo->Set(String::New("commands_replay"), FunctionTemplate::New(commands_replay));
+    cairo->Set(String::New("commands_clear"), FunctionTemplate::New(commands_clear));
+    cairo->Set(String::New("commands_destroy"), FunctionTemplate::New(commands_destroy));
     cairo->Set(String::New("context_create"), FunctionTemplate::New(context_create));
     cairo->Set(String::New("context_reference"), FunctionTemplate::New(context_reference));
     cairo->Set(String::New("context_get_reference_count"), FunctionTemplate::New(context_get_reference_count));
     cairo->Set(String::New("context_destroy"), FunctionTemplate::New(context_destroy));
+    cairo->Set(String::New("context_reset"), FunctionTemplate::New(context_reset));
     cairo->Set(String::New("context_status"), FunctionTemplate::New(context_status));
     cairo->Set(String::New("context_save"), FunctionTemplate::New(context_save));
     cairo->Set(String::New("context_restore"), FunctionTemplate::New(context_restore));
@@ -6784,6 +12671,7 @@ extern "C" JSOBJ getExports () {
     cairo->Set(String::New("context_pop_group"), FunctionTemplate::New(context_pop_group));
     cairo->Set(String::New("context_pop_group_to_source"), FunctionTemplate::New(context_pop_group_to_source));
     cairo->Set(String::New("context_get_group_target"), FunctionTemplate::New(context_get_group_target));
+    cairo->Set(String::New("context_blur_group"), FunctionTemplate::New(context_blur_group));
     cairo->Set(String::New("context_set_source_rgb"), FunctionTemplate::New(context_set_source_rgb));
     cairo->Set(String::New("context_set_source_rgba"), FunctionTemplate::New(context_set_source_rgba));
     cairo->Set(String::New("context_set_source"), FunctionTemplate::New(context_set_source));
@@ -6817,6 +12705,7 @@ extern "C" JSOBJ getExports () {
     cairo->Set(String::New("context_reset_clip"), FunctionTemplate::New(context_reset_clip));
     cairo->Set(String::New("context_fill"), FunctionTemplate::New(context_fill));
     cairo->Set(String::New("context_fill_preserve"), FunctionTemplate::New(context_fill_preserve));
+    cairo->Set(String::New("context_fill_rectangle"), FunctionTemplate::New(context_fill_rectangle));
     cairo->Set(String::New("context_fill_extents"), FunctionTemplate::New(context_fill_extents));
     cairo->Set(String::New("context_in_fill"), FunctionTemplate::New(context_in_fill));
     cairo->Set(String::New("context_mask"), FunctionTemplate::New(context_mask));
@@ -6840,6 +12729,8 @@ extern "C" JSOBJ getExports () {
     cairo->Set(String::New("context_user_to_device_distance"), FunctionTemplate::New(context_user_to_device_distance));
     cairo->Set(String::New("context_device_to_user"), FunctionTemplate::New(context_device_to_user));
     cairo->Set(String::New("context_device_to_user_distance"), FunctionTemplate::New(context_device_to_user_distance));
+    cairo->Set(String::New("context_user_to_device_points"), FunctionTemplate::New(context_user_to_device_points));
+    cairo->Set(String::New("context_device_to_user_points"), FunctionTemplate::New(context_device_to_user_points));
 
     cairo->Set(String::New("context_copy_path"), FunctionTemplate::New(context_copy_path));
     cairo->Set(String::New("context_copy_path_flat"), FunctionTemplate::New(context_copy_path_flat));
@@ -6862,6 +12753,7 @@ extern "C" JSOBJ getExports () {
     cairo->Set(String::New("context_rel_line_to"), FunctionTemplate::New(context_rel_line_to));
     cairo->Set(String::New("context_rel_move_to"), FunctionTemplate::New(context_rel_move_to));
     cairo->Set(String::New("context_path_extents"), FunctionTemplate::New(context_path_extents));
+    cairo->Set(String::New("context_path_device_extents"), FunctionTemplate::New(context_path_device_extents));
     cairo->Set(String::New("context_select_font_face"), FunctionTemplate::New(context_select_font_face));
     cairo->Set(String::New("context_set_font_size"), FunctionTemplate::New(context_set_font_size));
     cairo->Set(String::New("context_set_font_matrix"), FunctionTemplate::New(context_set_font_matrix));
@@ -6917,7 +12809,23 @@ extern "C" JSOBJ getExports () {
     cairo->Set(String::New("font_options_set_hint_metrics"), FunctionTemplate::New(font_options_set_hint_metrics));
     cairo->Set(String::New("font_options_get_hint_metrics"), FunctionTemplate::New(font_options_get_hint_metrics));
     cairo->Set(String::New("image_surface_create_from_png"), FunctionTemplate::New(image_surface_create_from_png));
+    cairo->Set(String::New("image_surface_decode_png"), FunctionTemplate::New(image_surface_decode_png));
+    cairo->Set(String::New("image_png_size"), FunctionTemplate::New(image_png_size));
+    cairo->Set(String::New("image_load_start"), FunctionTemplate::New(image_load_start));
+    cairo->Set(String::New("image_load_done"), FunctionTemplate::New(image_load_done));
+    cairo->Set(String::New("image_load_finish"), FunctionTemplate::New(image_load_finish));
     cairo->Set(String::New("surface_write_to_png"), FunctionTemplate::New(surface_write_to_png));
+    cairo->Set(String::New("surface_write_to_png_parallel"), FunctionTemplate::New(surface_write_to_png_parallel));
+    cairo->Set(String::New("surface_to_data_url"), FunctionTemplate::New(surface_to_data_url));
+#if CAIRO_VERSION_MINOR >= 10
+    cairo->Set(String::New("recording_surface_create"), FunctionTemplate::New(recording_surface_create));
+    cairo->Set(String::New("recording_surface_write_to_png"), FunctionTemplate::New(recording_surface_write_to_png));
+#endif
+    cairo->Set(String::New("tiled_surface_create"), FunctionTemplate::New(tiled_surface_create));
+    cairo->Set(String::New("tiled_surface_render"), FunctionTemplate::New(tiled_surface_render));
+    cairo->Set(String::New("tiled_surface_write_to_png"), FunctionTemplate::New(tiled_surface_write_to_png));
+    cairo->Set(String::New("tiled_surface_destroy"), FunctionTemplate::New(tiled_surface_destroy));
+    cairo->Set(String::New("commands_render_batch"), FunctionTemplate::New(commands_render_batch));
     cairo->Set(String::New("pattern_add_color_stop_rgb"), FunctionTemplate::New(pattern_add_color_stop_rgb));
     cairo->Set(String::New("pattern_add_color_stop_rgba"), FunctionTemplate::New(pattern_add_color_stop_rgba));
     cairo->Set(String::New("pattern_get_stop_color_count"), FunctionTemplate::New(pattern_get_stop_color_count));
@@ -6931,6 +12839,7 @@ extern "C" JSOBJ getExports () {
     cairo->Set(String::New("pattern_get_linear_points"), FunctionTemplate::New(pattern_get_linear_points));
     cairo->Set(String::New("pattern_create_radial"), FunctionTemplate::New(pattern_create_radial));
     cairo->Set(String::New("pattern_get_radial_circles"), FunctionTemplate::New(pattern_get_radial_circles));
+    cairo->Set(String::New("pattern_create_with_alpha"), FunctionTemplate::New(pattern_create_with_alpha));
     cairo->Set(String::New("pattern_reference"), FunctionTemplate::New(pattern_reference));
     cairo->Set(String::New("pattern_status"), FunctionTemplate::New(pattern_status));
     cairo->Set(String::New("pattern_set_extend"), FunctionTemplate::New(pattern_set_extend));
@@ -6955,6 +12864,7 @@ extern "C" JSOBJ getExports () {
     cairo->Set(String::New("matrix_multiply"), FunctionTemplate::New(matrix_multiply));
     cairo->Set(String::New("matrix_transform_distance"), FunctionTemplate::New(matrix_transform_distance));
     cairo->Set(String::New("matrix_transform_point"), FunctionTemplate::New(matrix_transform_point));
+    cairo->Set(String::New("matrix_transform_points"), FunctionTemplate::New(matrix_transform_points));
     cairo->Set(String::New("matrix_destroy"), FunctionTemplate::New(matrix_destroy));
 #if CAIRO_VERSION_MINOR >= 10
     cairo->Set(String::New("region_create"), FunctionTemplate::New(region_create));